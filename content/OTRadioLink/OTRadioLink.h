@@ -28,6 +28,7 @@ Author(s) / Copyright (s): Damon Hart-Davis 2015--2016
 #include "utility/OTRadioLink_FrameType.h"
 #include "utility/OTRadioLink_SecureableFrameType.h"
 #include "utility/OTRadioLink_SecureableFrameType_V0p2Impl.h"
+#include "utility/OTRadioLink_SecureableFrameType_AESGCMImpl.h"
 #include "utility/OTRadioLink_Messaging.h"
 
 // Radio Link base class definition.
@@ -36,4 +37,16 @@ Author(s) / Copyright (s): Damon Hart-Davis 2015--2016
 // Radio Link Null class definition.
 #include "utility/OTRadioLink_OTNullRadioLink.h"
 
+// Aggregated RX over several radio links.
+#include "utility/OTRadioLink_OTRadioLinkRXAggregator.h"
+
+// Bounded asynchronous TX queue for radio links.
+#include "utility/OTRadioLink_TXQueue.h"
+
+// Multi-threaded message queue handler (not on Arduino).
+#include "utility/OTRadioLink_MessagingThreaded.h"
+
+// Simulated radio medium for load testing (not on Arduino).
+#include "utility/OTRadioLink_VirtualEther.h"
+
 #endif
@@ -0,0 +1,257 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * Streaming of RFM23B frames through its 64-byte FIFOs in chunks.
+ *
+ * Frames are moved as the RX FIFO almost-full and TX FIFO almost-empty
+ * interrupts arrive rather than all at once, so a frame may be longer
+ * than the FIFO and the FIFO need not be serviced within one frame time.
+ * The service routines here are those the driver ISR runs.
+ */
+
+#ifndef OTRFM23BLINK_FIFOSTREAM_H
+#define OTRFM23BLINK_FIFOSTREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "OTRadioLink_OTRadioLink.h"
+#include "OTRFM23BLink_SPI.h"
+
+namespace OTRFM23BLink
+    {
+    // Size of each of the RFM23B TX and RX FIFOs.
+    static constexpr uint8_t RFM23B_FIFO_BYTES = 64;
+    // TX FIFO almost-empty threshold register.
+    static constexpr uint8_t RFM23B_REG_TX_FIFO_CTRL2 = 0x7d;
+    // RX FIFO almost-full threshold register.
+    static constexpr uint8_t RFM23B_REG_RX_FIFO_CTRL = 0x7e;
+    // Interrupt status 1 register and the bits used for streaming.
+    static constexpr uint8_t RFM23B_REG_INT_STATUS1 = 3;
+    static constexpr uint8_t RFM23B_S1_IFFERROR = 0x80;
+    static constexpr uint8_t RFM23B_S1_ITXFFAEM = 0x20;
+    static constexpr uint8_t RFM23B_S1_IRXFFAFULL = 0x10;
+    static constexpr uint8_t RFM23B_S1_IPKSENT = 0x04;
+    static constexpr uint8_t RFM23B_S1_IPKVALID = 0x02;
+
+    // Outcome of servicing the RX side of the radio in packet-handler mode.
+    // For anything but RFM23B_RX_NONE the frame is finished with
+    // and the radio should be put back into RX mode.
+    enum RFM23BRXResult : uint8_t
+        {
+        RFM23B_RX_NONE,     // Nothing more to do yet.
+        RFM23B_RX_QUEUED,   // Frame queued.
+        RFM23B_RX_FILTERED, // Frame rejected by the RX filter.
+        RFM23B_RX_DROPPED,  // Frame dropped: no space in the queue, or too long.
+        RFM23B_RX_OVERRUN   // Frame lost to an RX FIFO overrun.
+        };
+
+    // Streams one inbound (packet-handler mode) frame out of the RX FIFO
+    // straight into the RX queue's buffer for the next frame.
+    // The RX FIFO almost-full threshold must be set to chunkBytes
+    // and the almostFull interrupts (irqEnable1) enabled.
+    // After each almost-full event the radio must be serviced within
+    // (RFM23B_FIFO_BYTES - chunkBytes) byte times to avoid overrun.
+    // Frames can be up to maxFrameBytes long,
+    // which must be no more than the queue's maximum frame size;
+    // with maxFrameBytes 0 streaming is disabled and this is empty.
+    // The queue buffer is taken at the first chunk of each frame
+    // and loaded across several calls,
+    // which is safe as only the producer (this) moves the queue's next slot.
+    // Not thread-/ISR- safe: use from the radio's poll/ISR only.
+    template<uint8_t maxFrameBytes>
+    class RFM23BRXStream final
+        {
+        public:
+            // Bytes moved from the RX FIFO per almost-full event.
+            static constexpr uint8_t chunkBytes = 32;
+            static constexpr bool enabled = true;
+            // Interrupt enable 1 bits to set while streaming.
+            static constexpr uint8_t irqEnable1 = RFM23B_S1_IFFERROR | RFM23B_S1_IRXFFAFULL | RFM23B_S1_IPKVALID;
+
+        private:
+            // Queue buffer for the current frame; NULL if the queue was full.
+            volatile uint8_t *buf = NULL;
+            // Bytes of the current frame read so far (saturating).
+            uint8_t got = 0;
+            // True once the current frame has been started.
+            bool started = false;
+            // True if any of the current frame could not be kept.
+            bool overflowed = false;
+
+            // Take the queue buffer for a new frame.
+            template<class Queue_t>
+            void _start(Queue_t &q)
+                {
+                if(started) { return; }
+                buf = q._getRXBufForInbound();
+                started = true;
+                }
+
+            // Read n bytes from the RX FIFO, keeping what fits.
+            template<class SPI_t>
+            void _read(SPI_t &spi, const uint8_t n)
+                {
+                const uint8_t space = ((NULL == buf) || (got >= maxFrameBytes)) ? 0 : (maxFrameBytes - got);
+                const uint8_t keep = (n > space) ? space : n;
+                spi.select();
+                spi.io(RFM23B_REG_FIFO & 0x7f); // Force to read.
+                for(uint8_t i = 0; i < keep; ++i) { buf[got + i] = spi.io(0); }
+                // Discard the rest.
+                for(uint8_t i = n - keep; i-- > 0; ) { spi.io(0); }
+                spi.deselect();
+                if((keep != n) || (n > (uint8_t)(255 - got))) { overflowed = true; got = 255; }
+                else { got += n; }
+                }
+
+            // Read the length of the frame just received.
+            template<class SPI_t>
+            static uint8_t _readLength(SPI_t &spi)
+                {
+                constexpr uint8_t REG_HEADER_CONTROL2 = 0x33;
+                constexpr uint8_t FIXPKLEN = 0x08;
+                constexpr uint8_t REG_PACKET_LENGTH = 0x3e;
+                constexpr uint8_t REG_RECEIVED_PACKET_LENGTH = 0x4b;
+                uint8_t v;
+                burstRead(spi, REG_HEADER_CONTROL2, &v, 1);
+                burstRead(spi, (FIXPKLEN & v) ? REG_PACKET_LENGTH : REG_RECEIVED_PACKET_LENGTH, &v, 1);
+                return(v);
+                }
+
+        public:
+            // Start afresh, eg when (re)entering RX mode.
+            // Abandons any partly-loaded queue buffer.
+            void reset() { buf = NULL; got = 0; started = false; overflowed = false; }
+
+            // Service the radio given its interrupt status register 1:
+            // on almost-full move chunkBytes from the RX FIFO into the queue,
+            // and on packet-valid move the rest of the frame
+            // then filter (if filter is not NULL) and queue it.
+            // A frame for which the queue had no space is noted as dropped full.
+            // The radio must be back in RX mode and the RX FIFO clear
+            // before the next frame, eg after any result but RFM23B_RX_NONE.
+            template<class SPI_t, class Queue_t>
+            RFM23BRXResult service(SPI_t &spi, Queue_t &q, const uint8_t status1,
+                                   ::OTRadioLink::quickFrameFilter_t *const filter)
+                {
+                if(status1 & RFM23B_S1_IFFERROR) { reset(); return(RFM23B_RX_OVERRUN); } // ERROR
+                if(status1 & RFM23B_S1_IRXFFAFULL) { _start(q); _read(spi, chunkBytes); }
+                if(!(status1 & RFM23B_S1_IPKVALID)) { return(RFM23B_RX_NONE); }
+                _start(q);
+                uint8_t len = _readLength(spi);
+                if(len >= got) { _read(spi, len - got); }
+                volatile uint8_t *const b = buf;
+                const bool whole = (len == got) && !overflowed;
+                reset();
+                // Frames too long to receive never reach the queue.
+                if(len > maxFrameBytes) { return(RFM23B_RX_DROPPED); }
+                if(NULL == b) { q._noteDroppedFull(); return(RFM23B_RX_DROPPED); }
+                // Should not happen unless the radio misbehaved.
+                if(!whole) { return(RFM23B_RX_OVERRUN); } // ERROR
+                if((NULL != filter) && !filter(b, len)) { return(RFM23B_RX_FILTERED); }
+                q._loadedBuf(len);
+                return(RFM23B_RX_QUEUED);
+                }
+
+            // Bytes of the current frame read so far.
+            uint8_t getBytesSoFar() const { return(got); }
+        };
+    // Streaming disabled: takes no space.
+    template<>
+    class RFM23BRXStream<0> final
+        {
+        public:
+            static constexpr uint8_t chunkBytes = 0;
+            static constexpr bool enabled = false;
+            static constexpr uint8_t irqEnable1 = 0;
+            void reset() { }
+            template<class SPI_t, class Queue_t>
+            RFM23BRXResult service(SPI_t &, Queue_t &, uint8_t, ::OTRadioLink::quickFrameFilter_t *) { return(RFM23B_RX_NONE); }
+            uint8_t getBytesSoFar() const { return(0); }
+        };
+
+    // Streams one outbound frame into the TX FIFO.
+    // The TX FIFO almost-empty threshold must be set to almostEmptyBytes
+    // while a frame longer than the FIFO is sent,
+    // and the radio must be serviced within almostEmptyBytes byte times
+    // of each almost-empty event to avoid underrun,
+    // eg by calling serviceIRQ() from the ISR with irqEnable1 enabled.
+    // The frame must remain unchanged until sent.
+    // Not thread-/ISR- safe.
+    class RFM23BTXStream final
+        {
+        public:
+            // TX FIFO almost-empty threshold for streaming.
+            static constexpr uint8_t almostEmptyBytes = 16;
+            // Interrupt enable 1 bits to set while streaming from the ISR.
+            static constexpr uint8_t irqEnable1 = RFM23B_S1_IFFERROR | RFM23B_S1_ITXFFAEM | RFM23B_S1_IPKSENT;
+
+        private:
+            // Next byte to queue and number of bytes left to queue.
+            const uint8_t *volatile next = NULL;
+            volatile uint8_t remaining = 0;
+
+        public:
+            // Queue as much of the frame as fits in the (empty) TX FIFO.
+            // Returns true if there is more to queue as the frame is sent.
+            template<class SPI_t>
+            bool start(SPI_t &spi, const uint8_t *const buf, const uint8_t len)
+                {
+                const uint8_t n = (len > RFM23B_FIFO_BYTES) ? RFM23B_FIFO_BYTES : len;
+                burstWrite(spi, RFM23B_REG_FIFO, buf, n);
+                next = buf + n;
+                remaining = len - n;
+                return(0 != remaining);
+                }
+
+            // Handle the TX FIFO almost-empty event by topping up the FIFO.
+            // Does nothing if the whole frame is already queued.
+            template<class SPI_t>
+            void almostEmpty(SPI_t &spi)
+                {
+                const uint8_t r = remaining; // Cache volatile value.
+                if(0 == r) { return; }
+                constexpr uint8_t space = RFM23B_FIFO_BYTES - almostEmptyBytes;
+                const uint8_t n = (r > space) ? space : r;
+                const uint8_t *const p = next;
+                burstWrite(spi, RFM23B_REG_FIFO, p, n);
+                next = p + n;
+                remaining = r - n;
+                }
+
+            // Service the radio interrupt while the frame is sent:
+            // reads (so clears) interrupt status register 1
+            // and tops up the TX FIFO on almost-empty.
+            // Returns the status read so the caller can see
+            // RFM23B_S1_IPKSENT (sent) or RFM23B_S1_IFFERROR (underrun).
+            template<class SPI_t>
+            uint8_t serviceIRQ(SPI_t &spi)
+                {
+                uint8_t status1;
+                burstRead(spi, RFM23B_REG_INT_STATUS1, &status1, 1);
+                if(status1 & RFM23B_S1_ITXFFAEM) { almostEmpty(spi); }
+                return(status1);
+                }
+
+            // Bytes of the frame not yet queued.
+            uint8_t getRemaining() const { return(remaining); }
+        };
+
+    }
+#endif
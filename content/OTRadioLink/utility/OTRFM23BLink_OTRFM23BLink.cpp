@@ -76,28 +76,17 @@ if(!isOK) { V0P2BASE_DEBUG_SERIAL_PRINTLN_FLASHSTRING("RFM23 bad"); }
     }
 
 // Configure the radio from a list of register/value pairs in readonly PROGMEM/Flash, terminating with an 0xff register value.
+// Runs of consecutive registers are written as single bursts.
+// Entries marked in the optional skip bitmap may be left unwritten.
 // NOTE: argument is not a pointer into SRAM, it is into PROGMEM!
-void OTRFM23BLinkBase::_registerBlockSetup(const uint8_t registerValues[][2])
+void OTRFM23BLinkBase::_registerBlockSetup(const uint8_t registerValues[][2], const uint8_t *const skip)
     {
     // Lock out interrupts.
     ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
         {
         const bool neededEnable = _upSPI_();
-        for( ; ; )
-            {
-            const uint8_t reg = pgm_read_byte(&(registerValues[0][0]));
-            const uint8_t val = pgm_read_byte(&(registerValues[0][1]));
-            if(0xff == reg) { break; }
-#if 0 && defined(V0P2BASE_DEBUG)
-            V0P2BASE_DEBUG_SERIAL_PRINT_FLASHSTRING("RFM23 reg 0x");
-            V0P2BASE_DEBUG_SERIAL_PRINTFMT(reg, HEX);
-            V0P2BASE_DEBUG_SERIAL_PRINT_FLASHSTRING(" = 0x");
-            V0P2BASE_DEBUG_SERIAL_PRINTFMT(val, HEX);
-            V0P2BASE_DEBUG_SERIAL_PRINTLN();
-#endif
-            _writeReg8Bit_(reg, val);
-            ++registerValues;
-            }
+        _SPIPort spi = { *this };
+        writeRegisterBlock(spi, registerValues, skip);
         if(neededEnable) { _downSPI_(); }
         }
     }
@@ -113,6 +102,8 @@ void OTRFM23BLinkBase::_clearTXFIFO()
 // Clears the RFM23B TX FIFO and queues the supplied frame to send via the TX FIFO.
 // This routine does not change the frame area.
 // This uses an efficient burst write.
+// A frame longer than the TX FIFO is queued as far as fits and the rest
+// is streamed in as it is sent (see _TXFIFO()).
 void OTRFM23BLinkBase::_queueFrameInTXFIFO(const uint8_t *bptr, uint8_t buflen)
     {
 #if 0 && defined(V0P2BASE_DEBUG)
@@ -125,12 +116,13 @@ void OTRFM23BLinkBase::_queueFrameInTXFIFO(const uint8_t *bptr, uint8_t buflen)
         // Clear the TX FIFO.
         _clearTXFIFO();
 
-        // Select RFM23B for duration of batch/burst write.
-        _SELECT_();
-        _wr(REG_FIFO | 0x80); // Start burst write to TX FIFO.
-        while(buflen-- > 0) { _wr(*bptr++); }
-        // Burst write finished; deselect RFM23B.
-        _DESELECT_();
+        // Burst write to TX FIFO, selecting RFM23B for the duration.
+        _SPIPort spi = { *this };
+        if(_txStream.start(spi, bptr, buflen))
+            {
+            // Ask to be told when the rest is needed.
+            _writeReg8Bit_(RFM23B_REG_TX_FIFO_CTRL2, RFM23BTXStream::almostEmptyBytes);
+            }
 
         if(neededEnable) { _downSPI_(); }
         }
@@ -139,20 +131,30 @@ void OTRFM23BLinkBase::_queueFrameInTXFIFO(const uint8_t *bptr, uint8_t buflen)
 // Transmit contents of on-chip TX FIFO: caller should revert to low-power standby mode (etc) if required.
 // Returns true if packet apparently sent correctly/fully.
 // Does not clear TX FIFO (so possible to re-send immediately).
+// The rest of a streamed frame is queued by the ISR on the TX FIFO
+// almost-empty interrupt where there is an interrupt line,
+// else as the status is polled here.
 bool OTRFM23BLinkBase::_TXFIFO()
     {
     const bool neededEnable = _upSPI_();
 
+    // Top up a streamed frame from the ISR if possible.
+    const bool viaISR = hasIRQLine && (0 != _txStream.getRemaining());
+
     // Lock out interrupts while fiddling with interrupts and starting the TX.
     ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
         {
     //    // Enable interrupt on packet send ONLY.
     //    _writeReg8Bit_(REG_INT_ENABLE1, 4);
     //    _writeReg8Bit_(REG_INT_ENABLE2, 0);
-        // Disable all interrupts (eg to avoid invoking the RX ISR).
-        _writeReg8Bit_(REG_INT_ENABLE1, 0);
-        _writeReg8Bit_(REG_INT_ENABLE2, 0);
+        // Disable all interrupts (eg to avoid invoking the RX ISR)
+        // other than those needed to stream the frame from the ISR.
+        const uint8_t txInterrupts[2] = { viaISR ? RFM23BTXStream::irqEnable1 : (uint8_t)0, 0 };
+        _SPIPort spi = { *this };
+        burstWrite(spi, REG_INT_ENABLE1, txInterrupts, sizeof(txInterrupts));
         _clearInterrupts_();
+        _txISRStatus = 0;
+        _txViaISR = viaISR;
         // Enable TX mode and transmit TX FIFO contents.
         _modeTX_();
         }
@@ -174,8 +176,30 @@ bool OTRFM23BLinkBase::_TXFIFO()
         // FIXME: RFM23B probably unlikely to exceed 80kbps, thus at least 100uS per byte, so no point sleeping much less.
         OTV0P2BASE_busy_spin_delay(1000);
         // FIXME: don't have nap() support yet // nap(WDTO_15MS, true); // Sleep in low power mode for a short time waiting for bits to be sent...
-        const uint8_t status = _readReg8Bit_(REG_INT_STATUS1); // TODO: could use nIRQ instead if available.
-        if(status & 4) { result = true; break; } // Packet sent!
+        // When streaming from the ISR it reads (and so clears) the status.
+        const uint8_t status = viaISR ? _txISRStatus : _readReg8Bit_(REG_INT_STATUS1); // TODO: could use nIRQ instead if available.
+        if(status & RFM23B_S1_IPKSENT) { result = true; break; } // Packet sent!
+        // Else top up the TX FIFO from a streamed frame as it empties.
+        // At most ~1ms between checks is well within the almost-empty margin
+        // (16 bytes is ~2ms at 57.6kbps).
+        if(!viaISR && (status & RFM23B_S1_ITXFFAEM))
+            {
+            _SPIPort spi = { *this };
+            ATOMIC_BLOCK (ATOMIC_RESTORESTATE) { _txStream.almostEmpty(spi); }
+            }
+        // Give up on FIFO underrun while streaming.
+        if((viaISR || (0 != _txStream.getRemaining())) && (status & RFM23B_S1_IFFERROR)) { break; }
+        }
+    if(viaISR)
+        {
+        // Stop the ISR servicing TX before it sees RX-side interrupts.
+        ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+            {
+            static const uint8_t noInterrupts[2] = { 0, 0 };
+            _SPIPort spi = { *this };
+            burstWrite(spi, REG_INT_ENABLE1, noInterrupts, sizeof(noInterrupts));
+            _txViaISR = false;
+            }
         }
 
     if(neededEnable) { _downSPI_(); }
@@ -251,7 +275,8 @@ bool OTRFM23BLinkBase::sendRaw(const uint8_t *const buf, const uint8_t buflen, c
 //        ::OTV0P2BASE::delay_ms(15); // FIXME: seems a shame to burn cycles/juice here...
 #endif
 
-        // Resend the frame.
+        // Resend the frame, reloading it if it was streamed.
+        if(buflen > RFM23B_FIFO_BYTES) { _queueFrameInTXFIFO(buf, buflen); }
         if(!_TXFIFO()) { result = false; }
         }
     // TODO: listen-after-send if requested.
@@ -366,8 +391,9 @@ void OTRFM23BLinkBase::_setChannel(const uint8_t channel)
     // Reject out-of-range channel requests.
     if(channel >= nChannels) { return; }
 
-    // Set up registers for new config.
-    _registerBlockSetup((regValPair_t *) (channelConfig[channel].config));
+    // Set up registers for new config,
+    // writing only those that differ from the current config if known.
+    _registerBlockSetup((regValPair_t *) (channelConfig[channel].config), _getChannelDeltaSkip(channel));
 
 #if 0 && defined(MILENKO_DEBUG)
       V0P2BASE_DEBUG_SERIAL_PRINT("C:");
@@ -380,6 +406,17 @@ void OTRFM23BLinkBase::_setChannel(const uint8_t channel)
     _currentChannel = channel;
     }
 
+// Precompute the register deltas between channels 0 and 1 if both are present.
+void OTRFM23BLinkBase::ChannelDeltas::compute(const ::OTRadioLink::OTRadioChannelConfig *const channelConfig, const uint8_t nChannels)
+    {
+    valid = false;
+    if(nChannels < 2) { return; }
+    const regValPair_t *const c0 = (const regValPair_t *) (channelConfig[0].config);
+    const regValPair_t *const c1 = (const regValPair_t *) (channelConfig[1].config);
+    valid = computeRegisterDelta(c0, c1, skip[1], sizeof(skip[1])) &&
+            computeRegisterDelta(c1, c0, skip[0], sizeof(skip[0]));
+    }
+
 #if 0 && defined(MILENKO_DEBUG)
 void OTRFM23BLinkBase::printHex(int val)  
     {
@@ -443,7 +480,9 @@ bool OTRFM23BLinkBase::begin()
     //if(1 != nChannels) { return(false); } // Can only handle a single channel.
     if(!_checkConnected()) { return(false); }
     // Set registers for default (0) channel.
+    // The deltas assume the radio holds the current channel's config.
     _registerBlockSetup((regValPair_t *) (channelConfig[0].config));
+    _currentChannel = 0;
     _modeStandbyAndClearState_();
     return(true);
     }
@@ -457,7 +496,7 @@ bool OTRFM23BLinkBase::end()
     return(true);
     }
 
-
+#endif // OTRFM23BLinkBase_DEFINED
 
 
 
@@ -932,7 +971,6 @@ const uint8_t StandardRegSettingsJeeLabs[][2] PROGMEM =
 //   0x7F   N/A               R/W - FIFO Access
    { 0xff, 0xff } // End of settings.
   };
-#endif // OTRFM23BLinkBase_DEFINED
 
 
 }
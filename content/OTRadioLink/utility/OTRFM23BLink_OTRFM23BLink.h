@@ -41,6 +41,8 @@ Author(s) / Copyright (s): Damon Hart-Davis 2013--2017
 #include <OTV0p2Base.h>
 #include <OTRadioLink.h>
 #include "OTRadioLink_ISRRXQueue.h"
+#include "OTRFM23BLink_SPI.h"
+#include "OTRFM23BLink_FIFOStream.h"
 
 namespace OTRFM23BLink
     {
@@ -65,15 +67,19 @@ namespace OTRFM23BLink
         {
         protected:
             // Configure the radio from a list of register/value pairs in readonly PROGMEM/Flash, terminating with an 0xff register value.
+            // Runs of consecutive registers are written as single bursts.
+            // Entries marked in the optional skip bitmap may be left unwritten
+            // (see writeRegisterBlock()).
             // NOTE: argument is not a pointer into SRAM, it is into PROGMEM!
             typedef uint8_t regValPair_t[2];
-            void _registerBlockSetup(const regValPair_t* registerValues);
+            void _registerBlockSetup(const regValPair_t* registerValues, const uint8_t *skip = NULL);
 
         public:
             // Maximum raw RX message size in bytes.
             static constexpr int MaxRXMsgLen = 64;
             // Maximum rawTX message size in bytes.
-            static constexpr int MaxTXMsgLen = 64;
+            // Frames longer than the 64-byte TX FIFO are streamed into it as sent.
+            static constexpr int MaxTXMsgLen = 255;
 
             // Maximum allowed TX time, milliseconds.
             // Attempting a longer TX will result in a timeout.
@@ -109,6 +115,40 @@ namespace OTRFM23BLink
             // Currently configured channel; starts at default 0.
             uint8_t _currentChannel = 0;
 
+            // Remainder of a frame too long for the TX FIFO, queued as it is sent.
+            RFM23BTXStream _txStream;
+            // True while the ISR is to top up the TX FIFO from _txStream (see _TXFIFO()),
+            // and the interrupt status 1 bits the ISR has seen meanwhile.
+            volatile bool _txViaISR = false;
+            volatile uint8_t _txISRStatus = 0;
+
+            // Maximum entries in a channel config for a precomputed delta.
+            static constexpr uint8_t MAX_DELTA_CONFIG_ENTRIES = 96;
+            // Config entries that need not be rewritten on switching
+            // between channels 0 and 1, indexed by the channel switched to.
+            // Only this pair is covered to bound RAM use;
+            // other switches rewrite the whole config.
+            // Costs ~25 bytes of RAM so only held if enabled (channelDeltas).
+            struct ChannelDeltas
+                {
+                uint8_t skip[2][MAX_DELTA_CONFIG_ENTRIES/8];
+                // True if skip is valid for the current configuration.
+                bool valid = false;
+                // Precompute from the channel 0 and 1 configs if both are present.
+                // A config too long for the bitmap just disables the deltas.
+                void compute(const ::OTRadioLink::OTRadioChannelConfig *channelConfig, uint8_t nChannels);
+                const uint8_t *get(const uint8_t from, const uint8_t to) const
+                    { return((valid && (from <= 1) && (to <= 1)) ? skip[to] : NULL); }
+                };
+            // Stand-in when deltas are not enabled; always rewrites the whole config.
+            struct NoChannelDeltas
+                {
+                void compute(const ::OTRadioLink::OTRadioChannelConfig *, uint8_t) { }
+                const uint8_t *get(uint8_t, uint8_t) const { return(NULL); }
+                };
+            // Config entries to skip on switching to the given channel, or NULL to write all.
+            virtual const uint8_t *_getChannelDeltaSkip(uint8_t /*channel*/) const { return(NULL); }
+
             // RFM23B_REG_03_INTERRUPT_STATUS1
             static constexpr uint16_t RFM23B_IFFERROR   = 0x80<<8;
             static constexpr uint16_t RFM23B_ITXFFAFULL = 0x40<<8;
@@ -206,9 +246,13 @@ namespace OTRFM23BLink
 
             // If true (the default) then allow RX operations.
             const bool allowRXOps = true;
+            // If true then the radio interrupt line is serviced by an ISR,
+            // which then also tops up the TX FIFO for streamed frames.
+            const bool hasIRQLine = false;
 
             // Constructor only available to deriving class.
-            constexpr OTRFM23BLinkBase(bool _allowRX = true) : allowRXOps(_allowRX) { }
+            constexpr OTRFM23BLinkBase(bool _allowRX = true, bool _hasIRQLine = false)
+              : allowRXOps(_allowRX), hasIRQLine(_hasIRQLine) { }
 
             // Write/read one byte over SPI...
             // SPI must already be configured and running.
@@ -225,6 +269,15 @@ namespace OTRFM23BLink
             // At lowest SPI clock prescale (x2) this is likely to spin for ~16 CPU cycles (8 bits each taking 2 cycles).
             inline void _wr(const uint8_t data) __attribute__((always_inline)) { SPDR = data; while (!(SPSR & _BV(SPIF))) { } }
 
+            // Adapts the SPI primitives above to the transport used by the burst routines.
+            struct _SPIPort final
+                {
+                OTRFM23BLinkBase &l;
+                void select() { l._SELECT_(); }
+                void deselect() { l._DESELECT_(); }
+                uint8_t io(const uint8_t data) { return(l._io(data)); }
+                };
+
             // Internal routines to enable/disable RFM23B on the the SPI bus.
             // Versions accessible to the base class...
             virtual void _SELECT_() const = 0;
@@ -268,11 +321,16 @@ namespace OTRFM23BLink
             // Clears the RFM23B TX FIFO and queues the supplied frame to send via the TX FIFO.
             // This routine does not change the frame area.
             // This uses an efficient burst write.
+            // A frame longer than the TX FIFO is queued as far as fits and the rest
+            // is streamed in as it is sent (see _TXFIFO()), so the frame must not change until sent.
             void _queueFrameInTXFIFO(const uint8_t *bptr, uint8_t buflen);
 
             // Transmit contents of on-chip TX FIFO: caller should revert to low-power standby mode (etc) if required.
             // Returns true if packet apparently sent correctly/fully.
-            // Does not clear TX FIFO (so possible to re-send immediately).
+            // Does not clear TX FIFO (so possible to re-send immediately)
+            // unless the frame was streamed.
+            // The rest of a streamed frame is queued from the ISR on the TX FIFO almost-empty
+            // interrupt if there is an interrupt line, else by polling while waiting.
             bool _TXFIFO();
 
             // Switch listening off, on to selected channel.
@@ -368,9 +426,19 @@ namespace OTRFM23BLink
     //         - PCMSK0 interrupts may be enabled during a call to poll().
     // Set the targetISRRXMinQueueCapacity to at least 2, or 3 if RAM space permits, for busy RF channels.
     // With allowRX == false as much as possible of the receive side is disabled.
+    // With streamRXFrameBytes non-zero, in packet-handling mode inbound frames
+    // are streamed out of the RX FIFO in chunks as it fills (see RFM23BRXStream)
+    // straight into the RX queue, so frames may be up to that long
+    // and need not be serviced within the time to fill the FIFO;
+    // the RX queue is limited to 256 bytes so it must still hold
+    // targetISRRXMinQueueCapacity frames of streamRXFrameBytes,
+    // eg 1 of up to 255 bytes or 3 of up to 84 bytes.
+    // With channelDeltas true, switching between channels 0 and 1
+    // rewrites only the registers that differ (see ChannelDeltas),
+    // at a cost of ~25 bytes of RAM.
 #define OTRFM23BLink_DEFINED
     static constexpr uint8_t DEFAULT_RFM23B_RX_QUEUE_CAPACITY = 3;
-    template <uint8_t SPI_nSS_DigitalPin, int8_t RFM_nIRQ_DigitalPin = -1, uint8_t targetISRRXMinQueueCapacity = 3, bool allowRX = true>
+    template <uint8_t SPI_nSS_DigitalPin, int8_t RFM_nIRQ_DigitalPin = -1, uint8_t targetISRRXMinQueueCapacity = 3, bool allowRX = true, uint8_t streamRXFrameBytes = 0, bool channelDeltas = false>
     class OTRFM23BLink final : public OTRFM23BLinkBase
         {
         private:
@@ -383,7 +451,24 @@ namespace OTRFM23BLink
               struct typeIf<true, TypeTrue, TypeFalse> { typedef TypeTrue t; };
             template <typename TypeTrue, typename TypeFalse>
               struct typeIf<false, TypeTrue, TypeFalse> { typedef TypeFalse t; };
-            typename typeIf<allowRX, ::OTRadioLink::ISRRXQueueVarLenMsg<MaxRXMsgLen, targetISRRXMinQueueCapacity>, ::OTRadioLink::ISRRXQueueNULL>::t queueRX;
+            // Longest frame that can be received.
+            static constexpr uint8_t maxRXFrameBytes = (streamRXFrameBytes > MaxRXMsgLen) ? streamRXFrameBytes : MaxRXMsgLen;
+            typename typeIf<allowRX, ::OTRadioLink::ISRRXQueueVarLenMsg<maxRXFrameBytes, targetISRRXMinQueueCapacity>, ::OTRadioLink::ISRRXQueueNULL>::t queueRX;
+            // Channel each queued frame was received on.
+            ::OTRadioLink::RXChannelRuns<> rxChannels;
+            // Frame being streamed in from the RX FIFO; empty unless streaming.
+            typedef RFM23BRXStream<allowRX ? streamRXFrameBytes : 0> rxStream_t;
+            rxStream_t rxStream;
+            static constexpr bool streamRX = rxStream_t::enabled;
+            // Streaming long frames must not cut the RX queue capacity asked for.
+            static_assert(!streamRX || (::OTRadioLink::ISRRXQueueVarLenMsg<maxRXFrameBytes, targetISRRXMinQueueCapacity>::MinQueueCapacityMsgs >= targetISRRXMinQueueCapacity),
+                "streamRXFrameBytes too long to queue targetISRRXMinQueueCapacity frames");
+            // Register deltas between channels 0 and 1, if enabled.
+            typename typeIf<channelDeltas, ChannelDeltas, NoChannelDeltas>::t deltas;
+            virtual const uint8_t *_getChannelDeltaSkip(const uint8_t channel) const override
+                { return(deltas.get(_currentChannel, channel)); }
+            // Precompute the channel 0/1 deltas when configured.
+            virtual bool _doconfig() override { deltas.compute(channelConfig, nChannels); return(true); }
 
             // Internal routines to enable/disable RFM23B on the the SPI bus.
             // These depend only on the (constant) SPI_nSS_DigitalPin template parameter
@@ -408,6 +493,15 @@ namespace OTRFM23BLink
             virtual bool _upSPI_() const override { return(_upSPI()); }
             virtual void _downSPI_() const override { _downSPI(); }
 
+            // Inlined SPI transport for the burst/stream routines, for use in the ISR.
+            struct _InlineSPIPort final
+                {
+                const OTRFM23BLink &l;
+                void select() { l._SELECT(); }
+                void deselect() { l._DESELECT(); }
+                uint8_t io(const uint8_t data) { return(l._io(data)); }
+                };
+
             // Write to 8-bit register on RFM23B.
             // SPI must already be configured and running.
             inline void _writeReg8Bit (const uint8_t addr, const uint8_t val) __attribute__((always_inline))
@@ -573,7 +667,13 @@ V0P2BASE_DEBUG_SERIAL_PRINTLN_FLASHSTRING("RFM23 reset...");
                     // Do this regardless of hardware interrupt support on the board.
                     // Check if packet handling in RFM23B is enabled and enable interrupts accordingly.
                     if ( _readReg8Bit(REG_30_DATA_ACCESS_CONTROL) & RFM23B_ENPACRX )  {
-                       _writeReg8Bit(REG_INT_ENABLE1, RFM23B_ENPKVALID);
+                       if(streamRX) {
+                          // Stream the frame out as the RX FIFO fills, and catch overruns.
+                          _writeReg8Bit(REG_RX_FIFO_CTRL, rxStream_t::chunkBytes);
+                          _writeReg8Bit(REG_INT_ENABLE1, rxStream_t::irqEnable1);
+                       } else {
+                          _writeReg8Bit(REG_INT_ENABLE1, RFM23B_ENPKVALID);
+                       }
                        _writeReg8Bit(REG_INT_ENABLE2, 0);
                        if ((_readReg8Bit(REG_33_HEADER_CONTROL2) & RFM23B_FIXPKLEN ) == RFM23B_FIXPKLEN )
                           _writeReg8Bit(REG_3E_PACKET_LENGTH, maxTypicalFrameBytes);
@@ -688,8 +788,7 @@ V0P2BASE_DEBUG_SERIAL_PRINTLN_FLASHSTRING("RFM23 reset...");
                     _writeReg8Bit(REG_OP_CTRL2, 3); // FFCLRRX | FFCLRTX
                     _writeReg8Bit(REG_OP_CTRL2, 0); // Needs both writes to clear.
                     // Disable all interrupts.
-                    _writeReg8Bit(REG_INT_ENABLE1, 0);
-                    _writeReg8Bit(REG_INT_ENABLE2, 0); // TODO: possibly combine in burst write with previous...
+                    _writeReg16Bit0(REG_INT_ENABLE1);
                     // Clear any interrupts already/still pending...
                     _clearInterrupts();
                     if(neededEnable) { _downSPI(); }
@@ -703,6 +802,8 @@ V0P2BASE_DEBUG_SERIAL_PRINTLN_FLASHSTRING("RFM23 reset...");
                 {
                 // Unconditionally stop listening and go into low-power standby mode.
                 _modeStandbyAndClearState();
+                // Discard any partly-streamed frame.
+                rxStream.reset();
                 // Capture possible (near) peak of stack usage, eg when called from ISR,
                 OTV0P2BASE::MemoryChecks::recordIfMinSP();
                 // Nothing further to do if RX not allowed.
@@ -729,8 +830,12 @@ V0P2BASE_DEBUG_SERIAL_PRINTLN_FLASHSTRING("RFM23 reset...");
                     if(neededEnable) { _downSPI(); }
                     }
                 }
-            // Version accessible to base class.
-            virtual void _dolisten() { _dolistenNonVirtual(); }
+            // Version accessible to base class, called on a change of listen channel.
+            virtual void _dolisten()
+                {
+                rxChannels.listening(getListenChannel(), queueRX.getRXMsgsQueued());
+                _dolistenNonVirtual();
+                }
 
             // Common handling of polling and ISR code.
             // NOT RENTRANT: interrupts must be blocked when this is called.
@@ -746,6 +851,16 @@ V0P2BASE_DEBUG_SERIAL_PRINTLN_FLASHSTRING("RFM23 reset...");
                 _disableIRQ(false);
 #endif // RFM23B_IRQ_CONTROL
 
+                // While a streamed frame is sent, service only the TX FIFO.
+                if(_txViaISR)
+                    {
+                    const bool neededEnable = _upSPI();
+                    _InlineSPIPort spi = { *this };
+                    _txISRStatus |= _txStream.serviceIRQ(spi);
+                    if(neededEnable) { _downSPI(); }
+                    return;
+                    }
+
                 // Nothing to do if RX is not allowed.
                 if(!allowRX) { return; }
 
@@ -762,7 +877,25 @@ V0P2BASE_DEBUG_SERIAL_PRINTLN_FLASHSTRING("RFM23 reset...");
                 if(rxMode & RFM23B_ENPACRX)
                     {
                     // Packet-handling mode...
-                    if(status & RFM23B_IPKVALID) // Packet received OK
+                    if(streamRX)
+                        {
+                        // Stream the frame straight into the RX queue as it arrives.
+                        const bool neededEnable = _upSPI();
+                        _InlineSPIPort spi = { *this };
+                        const RFM23BRXResult r = rxStream.service(spi, queueRX, uint8_t(status >> 8), filterRXISR);
+                        switch(r)
+                            {
+                            case RFM23B_RX_NONE: { break; }
+                            case RFM23B_RX_FILTERED: { ++filteredRXedMessageCountRecent; break; }
+                            case RFM23B_RX_DROPPED: { ++droppedRXedMessageCountRecent; lastRXErr = RXErr_DroppedFrame; break; }
+                            case RFM23B_RX_OVERRUN: { lastRXErr = RXErr_RXOverrun; break; }
+                            default: { break; }
+                            }
+                        // Clear up and force back to listening once done with a frame.
+                        if(RFM23B_RX_NONE != r) { _dolistenNonVirtual(); }
+                        if(neededEnable) { _downSPI(); }
+                        }
+                    else if(status & RFM23B_IPKVALID) // Packet received OK
                         {
                         const bool neededEnable = _upSPI();
                         // Extract packet/frame length...
@@ -776,7 +909,7 @@ V0P2BASE_DEBUG_SERIAL_PRINTLN_FLASHSTRING("RFM23 reset...");
                         // Received frame.
                         // If there is space in the queue then read in the frame,
                         // else discard it.
-                        volatile uint8_t *const bufferRX = (lengthRX > MaxRXMsgLen) ? NULL :
+                        volatile uint8_t *const bufferRX = (lengthRX > maxRXFrameBytes) ? NULL :
                             queueRX._getRXBufForInbound();
                         if(NULL != bufferRX)
                             {
@@ -800,6 +933,8 @@ V0P2BASE_DEBUG_SERIAL_PRINTLN_FLASHSTRING("RFM23 reset...");
                         else
                             {
                             // DISCARD/drop frame that there is no room to RX.
+                            // Frames too long to receive never reach the queue.
+                            if(lengthRX <= maxRXFrameBytes) { queueRX._noteDroppedFull(); }
                             uint8_t tmpbuf[1];
                             _RXFIFO(tmpbuf, sizeof(tmpbuf));
                             ++droppedRXedMessageCountRecent;
@@ -866,6 +1001,7 @@ V0P2BASE_DEBUG_SERIAL_PRINTLN_FLASHSTRING("RFM23 reset...");
                         else
                             {
                             // DISCARD/drop frame that there is no room to RX.
+                            queueRX._noteDroppedFull();
                             uint8_t tmpbuf[1];
                             _RXFIFO(tmpbuf, sizeof(tmpbuf));
                             ++droppedRXedMessageCountRecent;
@@ -894,7 +1030,7 @@ V0P2BASE_DEBUG_SERIAL_PRINTLN_FLASHSTRING("RFM23 reset...");
             // Should be a compile-time constant.
             static constexpr bool hasInterruptSupport = (RFM_nIRQ_DigitalPin >= 0);
 
-            constexpr OTRFM23BLink() : OTRFM23BLinkBase(allowRX) { }
+            constexpr OTRFM23BLink() : OTRFM23BLinkBase(allowRX, hasInterruptSupport) { }
 
             // Do very minimal pre-initialisation, eg at power up, to get radio to safe low-power mode.
             // Argument is read-only pre-configuration data;
@@ -946,7 +1082,7 @@ V0P2BASE_DEBUG_SERIAL_PRINTLN_FLASHSTRING("RFM23 reset...");
             // - Reordering _up/_downSPI calls reduced total time by ~2 ms.
             bool _handleInterruptNonVirtual()
             {
-                if(!allowRX) { return(false); }
+                if(!allowRX && !_txViaISR) { return(false); }
                 if(interruptLineIsEnabledAndInactive()) { return(false); }
                 _poll();
                 return(true);
@@ -1018,7 +1154,21 @@ V0P2BASE_DEBUG_SERIAL_PRINTLN_FLASHSTRING("RFM23 reset...");
             // Typically used after peekRXMessage().
             // Does nothing if the queue is empty.
             // Not intended to be called from an ISR.
-            virtual void removeRXMsg() override { queueRX.removeRXMsg(); }
+            virtual void removeRXMsg() override
+                {
+                if(NULL == queueRX.peekRXMsg()) { return; }
+                queueRX.removeRXMsg();
+                rxChannels.removed();
+                }
+
+            // Channel the frame returned by peekRXMsg() was received on, or -1 if unknown.
+            virtual int8_t getRXMsgChannel() const override { return(rxChannels.oldest()); }
+
+            // Fetch a snapshot of the RX queue health counters.
+            // Frames too long to receive are dropped before reaching the queue,
+            // so count as dropped (getRXMsgsDroppedRecent()) rather than truncated.
+            virtual bool getRXQueueHealth(::OTRadioLink::ISRRXQueueHealth &h) const override { return(queueRX.getHealth(h)); }
+            virtual void resetRXQueueHealth() override { queueRX.resetHealth(); }
 
 #if 0 // Defining the virtual destructor uses ~800+ bytes of Flash by forcing use of malloc()/free().
             // Ensure safe instance destruction when derived from.
@@ -1029,6 +1179,7 @@ V0P2BASE_DEBUG_SERIAL_PRINTLN_FLASHSTRING("RFM23 reset...");
 #define OTRFM23BLINK_NO_VIRT_DEST // Beware, no virtual destructor so be careful of use via base pointers.
 #endif
         };
+#endif // ARDUINO_ARCH_AVR
 
 
     // Library of common RFM23B configurations.
@@ -1039,20 +1190,19 @@ V0P2BASE_DEBUG_SERIAL_PRINTLN_FLASHSTRING("RFM23 reset...");
     // Consists of a sequence of (reg#,value) pairs terminated with a 0xff register number.  The reg#s are <128, ie top bit clear.
     // Magic numbers c/o Mike Stirling!
     // Note that this assumes default register settings in the RFM23B when powered up.
-    extern const OTRFM23BLinkBase::RFM23_Reg_Values_t FHT8V_RFM23_Reg_Values;
+    extern const uint8_t FHT8V_RFM23_Reg_Values[][2] PROGMEM;
 
     // Full register settings for 868.5MHz (EU band 48) GFSK 57.6kbps.
     // Full config including all default values, so safe for dynamic switching.
-    extern const OTRFM23BLinkBase::RFM23_Reg_Values_t StandardRegSettingsGFSK57600;
+    extern const uint8_t StandardRegSettingsGFSK57600[][2] PROGMEM;
 
     // Full register settings for FS20 (FHT8B) 868.35MHz (EU band 48) OOK 5kbps carrier, no packet handler.
     // Full config including all default values, so safe for dynamic switching.
-    extern const OTRFM23BLinkBase::RFM23_Reg_Values_t StandardRegSettingsOOK5000;
+    extern const uint8_t StandardRegSettingsOOK5000[][2] PROGMEM;
 
     // Full register settings for 868.0MHz (EU band 48) GFSK 49.26 kbps.
     // Full config including all default values, so safe for dynamic switching.
-    extern const OTRFM23BLinkBase::RFM23_Reg_Values_t StandardRegSettingsJeeLabs;
-#endif // ARDUINO_ARCH_AVR
+    extern const uint8_t StandardRegSettingsJeeLabs[][2] PROGMEM;
 
 
     }
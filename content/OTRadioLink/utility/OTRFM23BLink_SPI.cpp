@@ -0,0 +1,57 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * RFM23B SPI transfers independent of the SPI hardware.
+ */
+
+#include "OTRFM23BLink_SPI.h"
+
+namespace OTRFM23BLink {
+
+// Work out which entries of register list to need not be written
+// when switching to it from register list from.
+bool computeRegisterDelta(const uint8_t from[][2], const uint8_t to[][2],
+                          uint8_t *const skip, const uint8_t skipBytes)
+    {
+    memset(skip, 0, skipBytes);
+    // Count the entries in to.
+    uint16_t n = 0;
+    while(0xff != uint8_t(pgm_read_byte(&(to[n][0])))) { ++n; }
+    if((n > 8U * skipBytes) || (n > 255)) { return(false); } // FAIL
+    for(uint8_t i = 0; i < n; ++i)
+        {
+        const uint8_t reg = pgm_read_byte(&(to[i][0]));
+        if(isDynamicRegister(reg)) { continue; }
+        // Always write registers that to sets more than once.
+        bool repeated = false;
+        for(uint8_t j = 0; j < n; ++j)
+            { if((j != i) && (reg == uint8_t(pgm_read_byte(&(to[j][0]))))) { repeated = true; break; } }
+        if(repeated) { continue; }
+        // Find the value that from last set, if any.
+        bool set = false;
+        uint8_t val = 0;
+        for(const uint8_t (*p)[2] = from; 0xff != uint8_t(pgm_read_byte(&((*p)[0]))); ++p)
+            { if(reg == uint8_t(pgm_read_byte(&((*p)[0])))) { set = true; val = uint8_t(pgm_read_byte(&((*p)[1]))); } }
+        if(set && (val == uint8_t(pgm_read_byte(&(to[i][1])))))
+            { skip[i >> 3] |= uint8_t(1U << (i & 7)); }
+        }
+    return(true);
+    }
+
+}
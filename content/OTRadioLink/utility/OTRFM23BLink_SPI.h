@@ -0,0 +1,370 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * RFM23B SPI transfers independent of the SPI hardware.
+ *
+ * The burst routines are templated on the SPI transport so that the
+ * driver's inline AVR primitives and the host register model share them.
+ */
+
+#ifndef OTRFM23BLINK_SPI_H
+#define OTRFM23BLINK_SPI_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <OTV0p2Base.h>
+
+namespace OTRFM23BLink
+    {
+    // An SPI transport (SPI_t below) to a single RFM23B provides:
+    //   void select();     assert nSEL, starting a transaction
+    //   void deselect();   release nSEL, ending the transaction
+    //   uint8_t io(uint8_t data);  exchange one byte
+    // The first byte of a transaction is the register address,
+    // with the top bit set for a write.
+    // The address auto-increments for each further byte (a burst),
+    // except at the FIFO register which stays put.
+    // SPI must already be configured and running for all of these routines.
+
+    // TX FIFO on write, RX FIFO on read.
+    static constexpr uint8_t RFM23B_REG_FIFO = 0x7f;
+
+    // Burst write n bytes starting at register addr in one transaction.
+    // With addr RFM23B_REG_FIFO all n bytes go to the TX FIFO.
+    template<class SPI_t>
+    inline void burstWrite(SPI_t &spi, const uint8_t addr, const uint8_t *buf, uint8_t n)
+        {
+        spi.select();
+        spi.io(addr | 0x80); // Force to write.
+        while(n-- > 0) { spi.io(*buf++); }
+        spi.deselect();
+        }
+
+    // Burst read n bytes starting at register addr in one transaction.
+    // With addr RFM23B_REG_FIFO all n bytes come from the RX FIFO.
+    template<class SPI_t>
+    inline void burstRead(SPI_t &spi, const uint8_t addr, uint8_t *buf, uint8_t n)
+        {
+        spi.select();
+        spi.io(addr & 0x7f); // Force to read.
+        while(n-- > 0) { *buf++ = spi.io(0); }
+        spi.deselect();
+        }
+
+    // Write a list of register/value pairs in readonly PROGMEM/Flash,
+    // terminating with an 0xff register value.
+    // Each run of consecutive register numbers is sent as one burst,
+    // so the registers are written in list order as if one at a time.
+    // A run never extends onto the FIFO register.
+    // If skip is not NULL then entries whose bit is set in it
+    // (entry i is bit (i & 7) of skip[i >> 3]) are not written
+    // where they lead or trail a run; a run with nothing left is not sent.
+    // Skippable entries inside a run are rewritten with their (unchanged) value
+    // as that is cheaper than splitting the burst.
+    // Returns the number of SPI transactions used.
+    // NOTE: argument is not a pointer into SRAM, it is into PROGMEM!
+    template<class SPI_t>
+    uint8_t writeRegisterBlock(SPI_t &spi, const uint8_t registerValues[][2], const uint8_t *const skip = NULL)
+        {
+        uint8_t transactions = 0;
+        uint8_t i = 0;
+        uint8_t reg = pgm_read_byte(&(registerValues[0][0]));
+        while(0xff != reg)
+            {
+            // Find the end of the run and the part of it to write, [first, last].
+            int16_t first = -1;
+            uint8_t last = 0;
+            for( ; ; )
+                {
+                if((NULL == skip) || !(skip[i >> 3] & (1U << (i & 7))))
+                    {
+                    if(first < 0) { first = i; }
+                    last = i;
+                    }
+                ++i;
+                const uint8_t next = pgm_read_byte(&(registerValues[i][0]));
+                const bool extendsRun = (uint8_t(reg + 1) == next) && (RFM23B_REG_FIFO != next);
+                reg = next;
+                if(!extendsRun) { break; }
+                }
+            if(first < 0) { continue; }
+            spi.select();
+            spi.io(pgm_read_byte(&(registerValues[first][0])) | 0x80); // Force to write.
+            for(uint8_t j = uint8_t(first); j <= last; ++j)
+                { spi.io(pgm_read_byte(&(registerValues[j][1]))); }
+            spi.deselect();
+            ++transactions;
+            }
+        return(transactions);
+        }
+
+    // True for registers that the driver changes outside channel configs
+    // (interrupt enables, operating modes, packet length and FIFO thresholds)
+    // so which must always be written by a channel config that sets them.
+    inline bool isDynamicRegister(const uint8_t reg)
+        { return(((reg >= 5) && (reg <= 8)) || (0x3e == reg) || (0x7d == reg) || (0x7e == reg)); }
+
+    // Work out which entries of register list to need not be written
+    // when switching to it from register list from (both in PROGMEM,
+    // 0xff terminated), ie those where from already left the same value.
+    // The radio must hold the state from left, other than dynamic registers.
+    // Dynamic registers and those that to sets more than once are always written.
+    // Sets the skip bitmap for writeRegisterBlock(), of skipBytes bytes.
+    // Returns false, with nothing marked, if to has too many entries for the bitmap.
+    bool computeRegisterDelta(const uint8_t from[][2], const uint8_t to[][2],
+                              uint8_t *skip, uint8_t skipBytes);
+
+#ifndef ARDUINO
+#define OTRFM23BLINK_PLATFORM_HAS_REGISTER_MODEL
+    // Host model of the RFM23B SPI register interface, usable as SPI_t.
+    // Models the register file, burst addressing, the FIFO register
+    // and the FIFO clear bits of operation and control register 2,
+    // and counts the SPI traffic so that access patterns can be compared.
+    // Also models frames on air a byte time (tick()) at a time:
+    // transmitting from the TX FIFO in TX mode,
+    // filling the RX FIFO from an injected inbound frame in RX mode,
+    // with the FIFO threshold, packet and FIFO error interrupt status bits
+    // latched in status registers 1 and 2 until read.
+    // Registers have no other side effects.
+    class RFM23BRegisterModel final
+        {
+        public:
+            // Size of each of the TX and RX FIFOs.
+            static constexpr uint8_t fifoSize = 64;
+            // Interrupt status registers, cleared on read.
+            static constexpr uint8_t REG_INT_STATUS1 = 3;
+            static constexpr uint8_t REG_INT_STATUS2 = 4;
+            static constexpr uint8_t REG_INT_ENABLE1 = 5;
+            static constexpr uint8_t REG_INT_ENABLE2 = 6;
+            // Operation and control register 1 and its TX and RX mode bits.
+            static constexpr uint8_t REG_OP_CTRL1 = 7;
+            static constexpr uint8_t TXON = 8;
+            static constexpr uint8_t RXON = 4;
+            // Operation and control register 2 and its FIFO clear bits.
+            static constexpr uint8_t REG_OP_CTRL2 = 8;
+            static constexpr uint8_t FFCLRTX = 1;
+            static constexpr uint8_t FFCLRRX = 2;
+            // TX and received packet lengths.
+            static constexpr uint8_t REG_PACKET_LENGTH = 0x3e;
+            static constexpr uint8_t REG_RECEIVED_PACKET_LENGTH = 0x4b;
+            // FIFO thresholds.
+            static constexpr uint8_t REG_TX_FIFO_CTRL2 = 0x7d;
+            static constexpr uint8_t REG_RX_FIFO_CTRL = 0x7e;
+            // Interrupt status 1 bits modelled.
+            static constexpr uint8_t IFFERROR = 0x80;
+            static constexpr uint8_t ITXFFAEM = 0x20;
+            static constexpr uint8_t IRXFFAFULL = 0x10;
+            static constexpr uint8_t IPKSENT = 0x04;
+            static constexpr uint8_t IPKVALID = 0x02;
+
+        private:
+            uint8_t regs[128];
+            uint8_t txFIFO[fifoSize];
+            uint8_t txLen;
+            // RX FIFO holds rxFIFO[rxPos, rxLen).
+            uint8_t rxFIFO[fifoSize];
+            uint8_t rxLen;
+            uint8_t rxPos;
+
+            // Transaction state.
+            bool selected;
+            bool addressed;
+            bool writing;
+            uint8_t addr;
+
+            // Inbound frame on air, and whether any of it has been lost.
+            uint8_t air[255];
+            uint8_t airLen;
+            uint8_t airPos;
+            bool airLost;
+            // Frame most recently sent.
+            uint8_t sent[255];
+            uint8_t sentLen;
+
+            // Traffic counts.
+            uint32_t transactions;
+            uint32_t bytes;
+            uint32_t registerWrites;
+            uint32_t fifoErrors;
+
+            void _writeRegister(const uint8_t r, const uint8_t v)
+                {
+                ++registerWrites;
+                // Status registers are read-only.
+                if((REG_INT_STATUS1 == r) || (REG_INT_STATUS2 == r)) { return; }
+                if((REG_OP_CTRL1 == r) && (v & TXON) && !(regs[r] & TXON)) { sentLen = 0; }
+                regs[r] = v;
+                if(REG_OP_CTRL2 == r)
+                    {
+                    if(v & FFCLRTX) { txLen = 0; }
+                    if(v & FFCLRRX) { rxLen = 0; rxPos = 0; }
+                    }
+                }
+            uint8_t _readRegister(const uint8_t r)
+                {
+                const uint8_t v = regs[r];
+                if((REG_INT_STATUS1 == r) || (REG_INT_STATUS2 == r)) { regs[r] = 0; }
+                return(v);
+                }
+            void _fifoError() { regs[REG_INT_STATUS1] |= IFFERROR; ++fifoErrors; }
+
+        public:
+            RFM23BRegisterModel() { powerOn(); }
+
+            // Revert to power-on state with the supported device type
+            // and version in registers 0 and 1, and zero counts.
+            void powerOn()
+                {
+                memset(regs, 0, sizeof(regs));
+                regs[0] = 0x08;
+                regs[1] = 0x06;
+                txLen = 0;
+                rxLen = 0;
+                rxPos = 0;
+                selected = false;
+                addressed = false;
+                writing = false;
+                addr = 0;
+                airLen = 0;
+                airPos = 0;
+                airLost = false;
+                sentLen = 0;
+                resetCounts();
+                }
+
+            void select() { selected = true; addressed = false; }
+            void deselect() { if(selected) { ++transactions; } selected = false; }
+            uint8_t io(const uint8_t data)
+                {
+                ++bytes;
+                // Bus is ignored by a deselected device.
+                if(!selected) { return(0xff); } // ERROR
+                if(!addressed)
+                    {
+                    addressed = true;
+                    writing = (0 != (data & 0x80));
+                    addr = data & 0x7f;
+                    return(0);
+                    }
+                if(RFM23B_REG_FIFO == addr)
+                    {
+                    if(writing)
+                        {
+                        if(txLen < fifoSize) { txFIFO[txLen++] = data; } else { _fifoError(); }
+                        return(0);
+                        }
+                    if(rxPos < rxLen) { return(rxFIFO[rxPos++]); }
+                    _fifoError();
+                    return(0);
+                    }
+                const uint8_t r = addr;
+                addr = (addr + 1) & 0x7f;
+                if(writing) { _writeRegister(r, data); return(0); }
+                return(_readRegister(r));
+                }
+
+            // Advance n byte times on air.
+            // In TX mode one byte is sent from the TX FIFO per byte time,
+            // to the packet length if non-zero, else until the FIFO empties.
+            // Each byte of an injected inbound frame goes into the RX FIFO
+            // if in RX mode, else is lost.
+            void tick(uint16_t n = 1)
+                {
+                while(n-- > 0)
+                    {
+                    uint8_t &s1 = regs[REG_INT_STATUS1];
+                    if(regs[REG_OP_CTRL1] & TXON)
+                        {
+                        if(0 == txLen) { _fifoError(); regs[REG_OP_CTRL1] &= ~TXON; } // Underrun.
+                        else
+                            {
+                            if(sentLen < sizeof(sent)) { sent[sentLen++] = txFIFO[0]; }
+                            memmove(txFIFO, txFIFO + 1, --txLen);
+                            if(txLen <= regs[REG_TX_FIFO_CTRL2]) { s1 |= ITXFFAEM; }
+                            const uint8_t pl = regs[REG_PACKET_LENGTH];
+                            if((0 != pl) ? (sentLen == pl) : (0 == txLen))
+                                { s1 |= IPKSENT; regs[REG_OP_CTRL1] &= ~TXON; }
+                            }
+                        }
+                    if(airPos < airLen)
+                        {
+                        const uint8_t b = air[airPos++];
+                        if(!(regs[REG_OP_CTRL1] & RXON)) { airLost = true; }
+                        else
+                            {
+                            if((fifoSize == rxLen) && (0 != rxPos))
+                                { rxLen -= rxPos; memmove(rxFIFO, rxFIFO + rxPos, rxLen); rxPos = 0; }
+                            if(fifoSize == rxLen) { _fifoError(); airLost = true; } // Overrun.
+                            else { rxFIFO[rxLen++] = b; }
+                            if(rxLen - rxPos >= regs[REG_RX_FIFO_CTRL]) { s1 |= IRXFFAFULL; }
+                            }
+                        if((airPos == airLen) && !airLost)
+                            { s1 |= IPKVALID; regs[REG_RECEIVED_PACKET_LENGTH] = airLen; }
+                        }
+                    }
+                }
+
+            // Start an inbound frame of len bytes on air, replacing any in progress.
+            void receive(const uint8_t *const buf, const uint8_t len)
+                {
+                memcpy(air, buf, len);
+                airLen = len;
+                airPos = 0;
+                airLost = false;
+                }
+            // True once the inbound frame is completely on air.
+            bool isReceived() const { return(airPos == airLen); }
+
+            // True while nIRQ is asserted, ie an enabled interrupt is pending.
+            bool isIRQ() const
+                { return(0 != ((regs[REG_INT_STATUS1] & regs[REG_INT_ENABLE1]) | (regs[REG_INT_STATUS2] & regs[REG_INT_ENABLE2]))); }
+            // True while in TX mode.
+            bool isTransmitting() const { return(0 != (regs[REG_OP_CTRL1] & TXON)); }
+
+            // Register contents, as last written; status is not cleared.
+            uint8_t getRegister(const uint8_t r) const { return(regs[r & 0x7f]); }
+            void setRegister(const uint8_t r, const uint8_t v) { regs[r & 0x7f] = v; }
+            // Bytes waiting in the TX FIFO.
+            const uint8_t *getTXFIFO(uint8_t &len) const { len = txLen; return(txFIFO); }
+            // Replace the RX FIFO contents, as if a frame had arrived.
+            void setRXFIFO(const uint8_t *const buf, uint8_t len)
+                {
+                if(len > fifoSize) { len = fifoSize; }
+                memcpy(rxFIFO, buf, len);
+                rxLen = len;
+                rxPos = 0;
+                }
+            // Bytes sent on air since TX mode was last entered.
+            const uint8_t *getSent(uint8_t &len) const { len = sentLen; return(sent); }
+
+            // Completed transactions, bytes exchanged (including address bytes),
+            // individual register (non-FIFO) writes,
+            // and FIFO overruns and underruns (on air or over SPI).
+            uint32_t getTransactions() const { return(transactions); }
+            uint32_t getBytes() const { return(bytes); }
+            uint32_t getRegisterWrites() const { return(registerWrites); }
+            uint32_t getFIFOErrors() const { return(fifoErrors); }
+            void resetCounts() { transactions = 0; bytes = 0; registerWrites = 0; fifoErrors = 0; }
+        };
+#endif // ARDUINO
+
+    }
+#endif
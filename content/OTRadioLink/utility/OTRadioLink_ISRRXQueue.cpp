@@ -58,14 +58,12 @@ void ISRRXQueueVarLenMsgBase::removeRXMsg()
 // Typically used after peekRXMessage().
 // Does nothing if the queue is empty.
 // Not intended to be called from an ISR.
-// Not threadsafe in this implementation
+// Not threadsafe in this implementation;
+// see ISRRXQueueVarLenMsgSPSC for a lock-free producer/consumer version.
 void ISRRXQueueVarLenMsgBase::removeRXMsg()
 {
     // Nothing to do if empty.
     if(isEmpty()) { return; }
-    // FIXME: Can this be implemented with atomics?
-    // // May have to inspect and adjust all state, so block interrupts.
-    // ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
     {
         // Advance 'oldest' index to discard oldest length+frame, wrapping if necessary.
         // A wrap will be needed if advancing 'oldest' would take it too close to the buffer end
@@ -78,6 +76,38 @@ void ISRRXQueueVarLenMsgBase::removeRXMsg()
 #endif // ARDUINO_ARCH_AVR
 
 
+// Fetch a snapshot of the health counters, taken with interrupts blocked.
+bool ISRRXQueueVarLenMsgBase::getHealth(ISRRXQueueHealth &h) const
+    {
+#ifdef OTRADIOLINK_ISRRXQUEUE_HEALTH
+    h.bufferBytes = bsm1 + 1U;
+    OTV0P2BASE::RAII_AtomicBlock lock;
+    h.accepted = hAccepted;
+    h.droppedFull = hDroppedFull;
+    h.truncated = hTruncated;
+    h.peakMsgs = hPeakMsgs;
+    h.peakBytes = hPeakBytes;
+    return(true);
+#else
+    (void)h;
+    return(false);
+#endif // OTRADIOLINK_ISRRXQUEUE_HEALTH
+    }
+
+// Reset the health counters and peaks to zero.
+void ISRRXQueueVarLenMsgBase::resetHealth()
+    {
+#ifdef OTRADIOLINK_ISRRXQUEUE_HEALTH
+    OTV0P2BASE::RAII_AtomicBlock lock;
+    hAccepted = 0;
+    hDroppedFull = 0;
+    hTruncated = 0;
+    hPeakMsgs = 0;
+    hPeakBytes = 0;
+#endif // OTRADIOLINK_ISRRXQUEUE_HEALTH
+    }
+
+
 #ifdef ISRRXQueueVarLenMsg_VALIDATE
 // Validate state, dumping diagnostics to Print stream and returning false if problems found.
 // Intended for use in debugging only.
@@ -33,10 +33,41 @@ Author(s) / Copyright (s): Damon Hart-Davis 2015
 #endif
 
 #include "OTV0P2BASE_Util.h"
+#include "OTV0P2BASE_Concurrency.h"
+
+// ISRRXQueueVarLenMsg keeps health counters (see ISRRXQueueHealth) by default;
+// they cost a few cycles per frame queued and 9 bytes of RAM per queue.
+// Define OTRADIOLINK_ISRRXQUEUE_NO_HEALTH to compile them out.
+#ifndef OTRADIOLINK_ISRRXQUEUE_NO_HEALTH
+#define OTRADIOLINK_ISRRXQUEUE_HEALTH
+#endif
 
 // Use namespaces to help avoid collisions.
 namespace OTRadioLink
     {
+    // Snapshot of RX queue health counters, for sizing queues from data.
+    // Counters wrap; peaks stick until reset.
+    // If peakBytes approaches bufferBytes under real load then frames are
+    // likely being dropped and targetISRRXMinQueueCapacity should be raised;
+    // peakBytes / (maxRXMsgLen + 1) is roughly the capacity actually needed.
+    struct ISRRXQueueHealth
+        {
+        // Frames queued.
+        uint16_t accepted;
+        // Frames dropped because the queue was full, as noted by the driver
+        // with _noteDroppedFull().
+        uint16_t droppedFull;
+        // Frames cut to the queue's maximum frame length.
+        uint16_t truncated;
+        // Most frames queued at once.
+        uint8_t peakMsgs;
+        // Most buffer bytes unavailable to new frames at once,
+        // including length bytes and any gap left by wrapping.
+        uint16_t peakBytes;
+        // Total queue buffer size in bytes.
+        uint16_t bufferBytes;
+        };
+
     // Base class for an ISR-based efficient RX packet queue.
     // All queueing operations are fixed (low) cost,
     // designed to be called from an ISR (or with interrupts disabled)
@@ -93,6 +124,15 @@ namespace OTRadioLink
             // Not intended to be called from an ISR.
             virtual void removeRXMsg() = 0;
 
+            // Fetch a snapshot of the health counters into h.
+            // Returns false (leaving h undefined) if this queue does not keep them.
+            // Not intended to be called from an ISR.
+            virtual bool getHealth(ISRRXQueueHealth & /*h*/) const { return(false); }
+
+            // Reset the health counters and peaks to zero, if kept.
+            // Not intended to be called from an ISR.
+            virtual void resetHealth() { }
+
             // Get pointer for inbound/RX frame able to accommodate max frame size; NULL if no space.
             // Call this to get a pointer to load an inbound frame (<=maxRXBytes bytes) into;
             // after uploading the frame call _loadedBuf() to queue the new frame
@@ -116,6 +156,11 @@ namespace OTRadioLink
 #endif // defined(__GNUC__)
                = 0;
 
+            // Call when dropping an RXed frame because _getRXBufForInbound() returned NULL,
+            // so that the health counters count frames lost rather than calls made.
+            // Same calling constraints as _getRXBufForInbound().
+            virtual void _noteDroppedFull() { }
+
 #if 0 // Defining the virtual destructor uses ~800+ bytes of Flash by forcing use of malloc()/free().
             // Ensure safe instance destruction when derived from.
             // by default attempts to shut down the sensor and otherwise free resources when done.
@@ -151,7 +196,7 @@ namespace OTRadioLink
             // 1-deep RX queue and buffer used to accept data during RX.
             // Frame is preceded in memory by its length.
             // Marked as volatile for ISR-/thread- safe (sometimes lock-free) access.
-            volatile uint8_t fullBuf[1 + maxRXBytes];
+            mutable volatile uint8_t fullBuf[1 + maxRXBytes];
 //            volatile uint8_t *const bufferRX = fullBuf + 1; // Alias for frame itself.
 
         public:
@@ -243,9 +288,31 @@ namespace OTRadioLink
             // Offsets to the start of the oldest and next entries in buf.
             // When oldest == next then isEmpty(), ie the queue is empty.
             volatile uint8_t oldest, next;
+#ifdef OTRADIOLINK_ISRRXQUEUE_HEALTH
+            // Health counters, updated on the ISR side; see ISRRXQueueHealth.
+            volatile uint16_t hAccepted;
+            volatile uint16_t hDroppedFull;
+            volatile uint16_t hTruncated;
+            volatile uint8_t hPeakMsgs;
+            volatile uint16_t hPeakBytes;
+            // Record a frame just queued, with c frames now queued.
+            // Must be protected against re-entrance, as for _isFull().
+            inline void _noteQueued(const uint8_t c)
+                {
+                ++hAccepted;
+                if(c > hPeakMsgs) { hPeakMsgs = c; }
+                const uint8_t n = next, o = oldest; // Cache volatile values.
+                // With frames queued, n == o means no free space at all.
+                const uint16_t used = (n > o) ? (uint16_t)(n - o) : (uint16_t)(bsm1 + 1U - o + n);
+                if(used > hPeakBytes) { hPeakBytes = used; }
+                }
+#endif // OTRADIOLINK_ISRRXQUEUE_HEALTH
             // Construct an instance.
             ISRRXQueueVarLenMsgBase(uint8_t maxFrame, volatile uint8_t *bp, uint8_t bsm)
                 : b(bp), mf(maxFrame), bsm1(bsm), lui(bsm - maxFrame), oldest(0), next(0)
+#ifdef OTRADIOLINK_ISRRXQUEUE_HEALTH
+                , hAccepted(0), hDroppedFull(0), hTruncated(0), hPeakMsgs(0), hPeakBytes(0)
+#endif // OTRADIOLINK_ISRRXQUEUE_HEALTH
                 { }
             // True if the queue is full.
             // True iff _getRXBufForInbound() would return NULL.
@@ -289,6 +356,8 @@ namespace OTRadioLink
             // typically there can be no other activity on the queue until _loadedBuf()
             // or use of the pointer is abandoned.
             // _loadedBuf() should not be called if this returns NULL.
+            // The buffer stays valid across ISR calls until _loadedBuf()
+            // as only the producer moves 'next', so a frame may be loaded in pieces.
             virtual volatile uint8_t *_getRXBufForInbound() const override
                 {
                 // This ISR is kept as short/fast as possible.
@@ -301,19 +370,38 @@ namespace OTRadioLink
             // The argument is the size of the frame loaded into the buffer to be queued.
             // The frame can be no larger than maxRXBytes bytes.
             // It is possible to formally abandon an upload attempt by calling this with 0.
-            // Must still be in the scope of the same (ISR) call as _getRXBufForInbound().
+            // Must follow _getRXBufForInbound() with no other inbound activity in between.
             virtual void _loadedBuf(uint8_t frameLen) override
                 {
                 // This ISR is kept as short/fast as possible.
                 if(0 == frameLen) { return; } // New frame not being uploaded.
-                // PANIC if frameLen > max!
+                if(frameLen > mf)
+                    {
+                    // Be safe: never overrun the space reserved for a max-size frame.
+                    frameLen = mf;
+#ifdef OTRADIOLINK_ISRRXQUEUE_HEALTH
+                    ++hTruncated;
+#endif // OTRADIOLINK_ISRRXQUEUE_HEALTH
+                    }
                 const uint8_t n = next; // Cache volatile value.
                 b[n] = frameLen;
                 next = newIndex(n, frameLen);
-                ++queuedRXedMessageCount;
+                const uint8_t c = queuedRXedMessageCount + 1;
+                queuedRXedMessageCount = c;
+#ifdef OTRADIOLINK_ISRRXQUEUE_HEALTH
+                _noteQueued(c);
+#endif // OTRADIOLINK_ISRRXQUEUE_HEALTH
                 return;
                 }
 
+            // Call when dropping an RXed frame because _getRXBufForInbound() returned NULL.
+            virtual void _noteDroppedFull() override
+                {
+#ifdef OTRADIOLINK_ISRRXQUEUE_HEALTH
+                ++hDroppedFull;
+#endif // OTRADIOLINK_ISRRXQUEUE_HEALTH
+                }
+
             // Peek at first (oldest) queued RX message, returning a pointer or NULL if no message waiting.
             // The pointer returned is NULL if there is no message,
             // else the pointer is to the start of the message/frame
@@ -338,6 +426,13 @@ namespace OTRadioLink
             // Does nothing if the queue is empty.
             // Not intended to be called from an ISR.
             virtual void removeRXMsg() override;
+
+            // Fetch a snapshot of the health counters, taken with interrupts blocked.
+            // Returns false if compiled out with OTRADIOLINK_ISRRXQUEUE_NO_HEALTH.
+            virtual bool getHealth(ISRRXQueueHealth &h) const override;
+
+            // Reset the health counters and peaks to zero.
+            virtual void resetHealth() override;
 #undef ISRRXQueueVarLenMsg_VALIDATE
 #ifdef ISRRXQueueVarLenMsg_VALIDATE
             // Validate state, dumping diagnostics to Print stream and returning false if problems found.
@@ -366,6 +461,136 @@ namespace OTRadioLink
             virtual void getRXCapacity(uint8_t &queueRXMsgsMin, uint8_t &maxRXMsgLen) const override
                 { queueRXMsgsMin = MinQueueCapacityMsgs; maxRXMsgLen = maxRXBytes; }
         };
+
+#ifdef OTV0P2BASE_PLATFORM_HAS_atomic
+    // Lock-free single-producer/single-consumer variant of
+    // ISRRXQueueVarLenMsg for hosts where the radio driver (producer)
+    // and frame handling (consumer) run on different threads.
+    // Same buffer size, variable-length (len,data+) packing and wrap rule.
+    //   * maxRXBytes  a frame to be queued can be up to maxRXBytes bytes long; in the range [1,255]
+    //   * targetISRRXMinQueueCapacity  target number of max-sized frames queueable [1,255], usually [2,4]
+    //
+    // Exactly one thread may call _getRXBufForInbound(), _loadedBuf() and isFull(),
+    // and exactly one other may call peekRXMsg() and removeRXMsg();
+    // the counts may be read from anywhere.
+    // Only the consumer moves 'oldest' and only the producer moves 'next',
+    // and each side publishes its message count with release ordering
+    // after its buffer accesses, so no lock or shared read-modify-write is needed.
+    //
+    // Has the same non-virtual interface as ISRRXQueue rather than deriving from it,
+    // as the inherited count (shared by both sides) cannot be kept without a lock;
+    // use it via the concrete type, eg as a template argument.
+    template<uint8_t maxRXBytes, uint8_t targetISRRXMinQueueCapacity = 2>
+    class ISRRXQueueVarLenMsgSPSC final
+        {
+        private:
+            // Actual buffer size (bytes), as for ISRRXQueueVarLenMsg.
+            static constexpr int ISRRX_BUFSIZ = OTV0P2BASE::fnmin(256, maxRXBytes * (1+(int)targetISRRXMinQueueCapacity));
+            // Last usable index beyond which there is not enough space for len+maxSizeFrame.
+            static constexpr uint8_t lui = (uint8_t)(ISRRX_BUFSIZ - 1 - maxRXBytes);
+            // Circular sequence of (len,data+) segments; see ISRRXQueueVarLenMsg.
+            uint8_t buf[ISRRX_BUFSIZ];
+            // Offset of the next entry; producer only.
+            uint8_t next;
+            // Offset of the oldest entry; written by the consumer only.
+            std::atomic<uint8_t> oldest;
+            // Messages ever queued and removed, mod 256; each written by one side only.
+            // The queue holds far fewer than 256 messages so the difference is the count.
+            std::atomic<uint8_t> pushed;
+            std::atomic<uint8_t> popped;
+
+            // Compute new index given old one and the length of the frame, as for ISRRXQueueVarLenMsgBase.
+            static uint8_t newIndex(const uint8_t prevIndex, const uint8_t frameLen)
+                {
+                const uint16_t newIndex = 1U + (uint16_t)prevIndex + (uint16_t)frameLen;
+                if(newIndex > (uint16_t)lui) { return(0); } // Wrap if too to close to end for a max-size entry.
+                return((uint8_t) newIndex);
+                }
+
+        public:
+            ISRRXQueueVarLenMsgSPSC() : next(0), oldest(0), pushed(0), popped(0) { }
+            ISRRXQueueVarLenMsgSPSC(const ISRRXQueueVarLenMsgSPSC &) = delete;
+            ISRRXQueueVarLenMsgSPSC &operator=(const ISRRXQueueVarLenMsgSPSC &) = delete;
+
+            // Guaranteed minimum number of (full-length) messages that can be queued.
+            static constexpr uint8_t MinQueueCapacityMsgs = ISRRX_BUFSIZ / (maxRXBytes + 1);
+            // Fetches the current inbound RX minimum queue capacity and maximum RX raw message size.
+            void getRXCapacity(uint8_t &queueRXMsgsMin, uint8_t &maxRXMsgLen) const
+                { queueRXMsgsMin = MinQueueCapacityMsgs; maxRXMsgLen = maxRXBytes; }
+
+            // Fetches the current count of queued messages for RX.
+            // Exact from the producer or consumer; a snapshot from elsewhere.
+            uint8_t getRXMsgsQueued() const
+                { return((uint8_t)(pushed.load(std::memory_order_acquire) - popped.load(std::memory_order_acquire))); }
+            // True if the queue is empty.
+            uint8_t isEmpty() const { return(0 == getRXMsgsQueued()); }
+
+            // True if the queue is full.
+            // True iff _getRXBufForInbound() would return NULL.
+            // Producer only.
+            uint8_t isFull() const
+                {
+                // Load the count before 'oldest': the consumer moves 'oldest' first,
+                // so any error is towards seeing less space than there is.
+                const uint8_t c = (uint8_t)(pushed.load(std::memory_order_relaxed) - popped.load(std::memory_order_acquire));
+                const uint8_t o = oldest.load(std::memory_order_acquire);
+                const uint8_t n = next;
+                // 'next' is always wrapped early enough for a max-size frame after it.
+                if(n > o) { return(false); }
+                if(n == o) { return(0 != c); }
+                // Else 'next' is before 'oldest' so check for enough space *including* the leading length.
+                return((uint8_t)(o - n) <= maxRXBytes);
+                }
+
+            // Get pointer for inbound/RX frame able to accommodate max frame size; NULL if no space.
+            // After uploading the frame call _loadedBuf() to queue the new frame.
+            // Producer only.
+            volatile uint8_t *_getRXBufForInbound()
+                {
+                if(isFull()) { return(NULL); }
+                return(buf + next + 1);
+                }
+
+            // Call after loading an RXed frame into the buffer indicated by _getRXBufForInbound().
+            // The frame can be no larger than maxRXBytes bytes.
+            // It is possible to formally abandon an upload attempt by calling this with 0.
+            // Producer only.
+            void _loadedBuf(uint8_t frameLen)
+                {
+                if(0 == frameLen) { return; } // New frame not being uploaded.
+                if(frameLen > maxRXBytes) { frameLen = maxRXBytes; } // Be safe...
+                const uint8_t n = next;
+                buf[n] = frameLen;
+                next = newIndex(n, frameLen);
+                // Publish the frame and its length.
+                pushed.store((uint8_t)(pushed.load(std::memory_order_relaxed) + 1), std::memory_order_release);
+                }
+
+            // Peek at first (oldest) queued RX message, returning a pointer or NULL if no message waiting.
+            // The length is in the byte before the start of the frame.
+            // The returned pointer and length are valid until the next removeRXMsg().
+            // The buffer pointed to MUST NOT be altered.
+            // Consumer only.
+            const volatile uint8_t *peekRXMsg() const
+                {
+                if(pushed.load(std::memory_order_acquire) == popped.load(std::memory_order_relaxed)) { return(NULL); }
+                return(buf + oldest.load(std::memory_order_relaxed) + 1);
+                }
+
+            // Remove the first (oldest) queued RX message.
+            // Does nothing if the queue is empty.
+            // Consumer only.
+            void removeRXMsg()
+                {
+                const uint8_t p = popped.load(std::memory_order_relaxed);
+                if(pushed.load(std::memory_order_acquire) == p) { return; }
+                // Hand back the space only after finishing with the frame.
+                const uint8_t o = oldest.load(std::memory_order_relaxed);
+                oldest.store(newIndex(o, buf[o]), std::memory_order_release);
+                popped.store((uint8_t)(p + 1), std::memory_order_release);
+                }
+        };
+#endif // OTV0P2BASE_PLATFORM_HAS_atomic
     }
 
 
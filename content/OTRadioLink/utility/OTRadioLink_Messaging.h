@@ -50,7 +50,7 @@ typedef bool (frameOperator_fn_t) (const OTDecodeData_T &fd);
  *          could be decoded/decrypted, just that the handler recognised the
  *          frame type.
  */
-typedef bool (frameDecodeHandler_fn_t) (volatile const uint8_t *msg);
+typedef bool (frameDecodeHandler_fn_t) (const uint8_t *msg);
 
 
 
@@ -185,6 +185,9 @@ bool boilerFrameOperation(const OTDecodeData_T &fd)
  * @param   decrypt: Function to decrypt secure frame with.
  * @param   getKey: Function that fills a buffer with the 16 byte secret key. 
  *          Should return true on success.
+ * @param   firstIDMatchOnly: As for SimpleSecureFrame32or0BodyRXBase::decode().
+ *          If false, associations sharing the frame's ID prefix are also
+ *          tried, within a bounded budget.
  * @retval  True if frame successfully authenticated and decoded, else false.
  *
  * Note: the scratch space (workspace) depends on the underlying decrypt
@@ -195,7 +198,8 @@ static constexpr uint8_t authAndDecodeOTSecurableFrameWithWorkspace_scratch_usag
     16; // Primary building key size.
 template <typename sfrx_t,
           SimpleSecureFrame32or0BodyRXBase::fixed32BTextSize12BNonce16BTagSimpleDec_fn_t &decrypt,
-          OTV0P2BASE::GetPrimary16ByteSecretKey_t &getKey>
+          OTV0P2BASE::GetPrimary16ByteSecretKey_t &getKey,
+          bool firstIDMatchOnly = true>
 inline bool authAndDecodeOTSecurableFrame(OTDecodeData_T &fd, OTV0P2BASE::ScratchSpaceL &sW)
 {
     constexpr size_t scratchSpaceNeededHere = authAndDecodeOTSecurableFrameWithWorkspace_scratch_usage;
@@ -215,7 +219,7 @@ inline bool authAndDecodeOTSecurableFrame(OTDecodeData_T &fd, OTV0P2BASE::Scratc
     }
 
     // Create sub-space for callee.
-    OTV0P2BASE::ScratchSpaceL subScratch(sW, scratchSpaceNeededHere);
+    OTV0P2BASE::ScratchSpaceL subScratch(sW, scratchSpaceNeededHere, SCRATCH_SITE_authAndDecodeOTSecurableFrame);
 
     // Now attempt to decrypt.
     // Assumed no need to 'adjust' node ID for this form of RX.
@@ -228,7 +232,7 @@ inline bool authAndDecodeOTSecurableFrame(OTDecodeData_T &fd, OTV0P2BASE::Scratc
                                                       fd,
                                                       decrypt,
                                                       subScratch, key,
-                                                      true));
+                                                      firstIDMatchOnly));
 #if 1 // && defined(DEBUG)
 if(!isOK) {
 // Useful brief network diagnostics.
@@ -256,17 +260,247 @@ OTV0P2BASE::serialPrintlnAndFlush();
     return(isOK); // Return if successfully decoded, authenticated, etc.
 }
 
+/**
+ * @brief   Authenticate and decrypt a batch of secure frames under the
+ *          building primary key. Expects syntax checking and validation to
+ *          already have been done on each frame.
+ *
+ * Batch equivalent of authAndDecodeOTSecurableFrame() for busy hosts: the key
+ * is fetched and expanded once for the whole batch, see decodeBatch().
+ * No per-frame diagnostics are printed.
+ *
+ * @param   fds: Array of nFrames pointers to frames to decrypt.
+ * @param   nFrames: Number of entries in fds and results.
+ * @param   results, OUTPUT: Per-frame result of decode(), 0 on failure.
+ *              May be NULL.
+ * @param   sW: Scratch space. Must hold
+ *              ScratchSpaceL::alignedSize(keyContextSize) bytes more than
+ *              authAndDecodeOTSecurableFrame() would need.
+ * @param   setup: Key setup function matching decrypt.
+ * @param   decrypt: Function to decrypt secure frame with, given the key
+ *              context made by setup.
+ * @param   keyContextSize: Size of the key context made by setup.
+ * @param   getKey: Function that fills a buffer with the 16 byte secret key.
+ *          Should return true on success.
+ * @param   firstIDMatchOnly: As for authAndDecodeOTSecurableFrame().
+ * @retval  Number of frames successfully authenticated and decoded.
+ */
+template <typename sfrx_t,
+          SimpleSecureFrame32or0BodyRXBase::fixed32BTextSize12BNonce16BTagSimpleKeySetup_fn_t &setup,
+          SimpleSecureFrame32or0BodyRXBase::fixed32BTextSize12BNonce16BTagSimpleDecWithContext_fn_t &decrypt,
+          size_t keyContextSize,
+          OTV0P2BASE::GetPrimary16ByteSecretKey_t &getKey,
+          bool firstIDMatchOnly = true>
+inline uint8_t authAndDecodeOTSecurableFrameBatch(
+        OTDecodeData_T *const *fds, const uint8_t nFrames,
+        uint8_t *const results, OTV0P2BASE::ScratchSpaceL &sW)
+{
+    constexpr size_t scratchSpaceNeededHere = authAndDecodeOTSecurableFrameWithWorkspace_scratch_usage;
+    if(sW.bufsize < scratchSpaceNeededHere) { return(0); } // ERROR
+
+    // Use scratch space for 16-byte key, shared by all frames.
+    uint8_t *key = sW.buf;
+    if(!getKey(key)) {
+        OTV0P2BASE::serialPrintlnAndFlush(F("!RX key"));
+        return(0);
+    }
+
+    // Create sub-space for callee.
+    OTV0P2BASE::ScratchSpaceL subScratch(sW, scratchSpaceNeededHere);
+    const uint8_t nOK = sfrx_t::getInstance().decodeBatch(
+                                        fds, nFrames,
+                                        setup, decrypt, keyContextSize,
+                                        subScratch, key,
+                                        results,
+                                        firstIDMatchOnly);
+    // The raw key is no longer needed.
+    OTV0P2BASE::wipeSecret(key, 16);
+    return(nOK);
+}
+
 
 /**
  * @brief   Stub version of a frameOperator_fn_t type function.
  * @retval  Always false.
  * @note    Used as a dummy operation and should be optimised out by the compiler.
  */
-inline bool decodeAndHandleDummyFrame(volatile const uint8_t * const /*msg*/)
+inline bool decodeAndHandleDummyFrame(const uint8_t * const /*msg*/)
 {
     return false;
 }
 
+/**
+ * @brief   Null replay filter for decodeAndHandleOTSecureOFrame().
+ *          Passes every frame and should be optimised out by the compiler.
+ */
+class SecureFrameReplayFilterNull final
+{
+public:
+    static SecureFrameReplayFilterNull &getInstance()
+    {
+        static SecureFrameReplayFilterNull instance;
+        return(instance);
+    }
+    bool isReplay(const OTDecodeData_T & /*fd*/, const SimpleSecureFrame32or0BodyRXBase & /*rx*/) { return(false); }
+    void recordAccepted(const OTDecodeData_T & /*fd*/) { }
+};
+
+/**
+ * @brief   Cheap filter to drop duplicate and replayed secure frames before
+ *          the key is fetched or any decryption is attempted.
+ *
+ * Keeps the highest accepted message counter for the nNodes most recently
+ * heard nodes, plus a hash of the trailers of the nTails most recently
+ * accepted frames (which catches exact duplicates, eg relayed copies, from
+ * nodes that have dropped out of the counter window).
+ *
+ * Only frames that went on to authenticate are recorded, so a forged frame
+ * cannot cause a genuine one to be dropped. Nodes are recorded by their
+ * full ID, and a frame is only treated as stale when the ID prefix in its
+ * header matches exactly one association, and that node has already
+ * accepted an equal or higher counter; frames whose prefix is shared by
+ * several associations are left for decode() to try each candidate.
+ *
+ * Frames rejected here are reported as handled by protocol, as for frames
+ * that fail authentication.
+ * NOT thread-safe.
+ *
+ * @param   nNodes: Number of nodes to track counters for, in [1,255].
+ * @param   nTails: Number of recent frame trailer hashes to keep, in [1,255].
+ */
+template<uint8_t nNodes = 4, uint8_t nTails = 8>
+class SecureFrameReplayFilter final
+{
+private:
+    static_assert(nNodes > 0, "need at least one node entry");
+    static_assert(nTails > 0, "need at least one tail entry");
+
+    struct Node
+    {
+        uint8_t id[OTV0P2BASE::OpenTRV_Node_ID_Bytes];
+        uint8_t counter[SimpleSecureFrame32or0BodyBase::fullMsgCtrBytes];
+        // 0 if unused, else higher is more recently accepted.
+        uint8_t age;
+    };
+    Node nodes[nNodes];
+    uint32_t tails[nTails];
+    uint8_t nextTail = 0;
+    uint8_t tailsUsed = 0;
+
+    uint16_t nPassed = 0;
+    uint16_t nStale = 0;
+    uint16_t nDuplicate = 0;
+
+    // Saturating increment for the statistics.
+    static void inc(uint16_t &c) { if(0xffff != c) { ++c; } }
+
+    // True if the frame carries a full message counter, ie can be filtered.
+    static bool hasCounter(const OTDecodeData_T &fd)
+        { return(!fd.sfh.isInvalid() && (23 == fd.sfh.getTl())); }
+
+    // Message counter in the trailer of the frame. Check hasCounter() first.
+    static const uint8_t *getCounter(const OTDecodeData_T &fd)
+        { return(fd.ctext + fd.sfh.getTrailerOffset()); }
+
+    // FNV-1a hash of the frame trailer (message counter and tag).
+    static uint32_t hashTail(const OTDecodeData_T &fd)
+    {
+        const uint8_t *const t = getCounter(fd);
+        uint32_t h = 2166136261UL;
+        for(uint8_t i = 0; i < 23; ++i) { h = (h ^ t[i]) * 16777619UL; }
+        return(h);
+    }
+
+public:
+    SecureFrameReplayFilter() { clear(); }
+
+    static SecureFrameReplayFilter &getInstance()
+    {
+        static SecureFrameReplayFilter instance;
+        return(instance);
+    }
+
+    // Forget all recorded nodes and frames. Does not reset the statistics.
+    void clear()
+    {
+        memset(nodes, 0, sizeof(nodes));
+        nextTail = 0;
+        tailsUsed = 0;
+    }
+
+    /**
+     * @brief   Check whether a frame is a duplicate or replay, before
+     *          attempting to authenticate it.
+     * @param   fd: Frame data with the header already decoded.
+     * @param   rx: Associations that the frame will be authenticated against.
+     *          Only consulted if a recorded node matches the ID prefix.
+     * @retval  True if the frame should be dropped.
+     */
+    bool isReplay(const OTDecodeData_T &fd, const SimpleSecureFrame32or0BodyRXBase &rx)
+    {
+        if(!hasCounter(fd)) { inc(nPassed); return(false); }
+        // Exact duplicate of a recently accepted frame?
+        const uint32_t h = hashTail(fd);
+        for(uint8_t i = 0; i < tailsUsed; ++i) {
+            if(h == tails[i]) { inc(nDuplicate); return(true); }
+        }
+        // Counter no higher than already accepted from the (only) sender?
+        // Cheap prefix check first, to avoid the association lookup.
+        const uint8_t il = fd.sfh.getIl();
+        bool matched = false;
+        for(uint8_t i = 0; i < nNodes; ++i) {
+            if((0 != nodes[i].age) && (0 == memcmp(nodes[i].id, fd.sfh.id, il))) { matched = true; break; }
+        }
+        uint8_t senderID[OTV0P2BASE::OpenTRV_Node_ID_Bytes];
+        if(!matched || !rx.getUniqueMatchingNodeID(&fd.sfh, senderID)) { inc(nPassed); return(false); }
+        for(uint8_t i = 0; i < nNodes; ++i) {
+            const Node &n = nodes[i];
+            if((0 == n.age) || (0 != memcmp(n.id, senderID, sizeof(n.id)))) { continue; }
+            if(SimpleSecureFrame32or0BodyRXBase::msgcountercmp(getCounter(fd), n.counter) > 0) { break; }
+            inc(nStale);
+            return(true);
+        }
+        inc(nPassed);
+        return(false);
+    }
+
+    /**
+     * @brief   Record a frame that has been authenticated and decoded.
+     * @param   fd: Frame data with fd.id set to the full sender ID.
+     */
+    void recordAccepted(const OTDecodeData_T &fd)
+    {
+        if(!hasCounter(fd)) { return; }
+        tails[nextTail] = hashTail(fd);
+        nextTail = uint8_t((nextTail + 1) % nTails);
+        if(tailsUsed < nTails) { ++tailsUsed; }
+
+        // Update the sender's entry, else replace the least recent.
+        uint8_t slot = 0;
+        for(uint8_t i = 0; i < nNodes; ++i) {
+            if((0 != nodes[i].age) && (0 == memcmp(nodes[i].id, fd.id, sizeof(fd.id)))) { slot = i; break; }
+            if(nodes[i].age < nodes[slot].age) { slot = i; }
+        }
+        // Age everything else, keeping the order of the remaining entries.
+        const uint8_t oldAge = nodes[slot].age;
+        for(uint8_t i = 0; i < nNodes; ++i) {
+            if((0 != nodes[i].age) && ((0 == oldAge) || (nodes[i].age > oldAge))) { --nodes[i].age; }
+        }
+        Node &n = nodes[slot];
+        memcpy(n.id, fd.id, sizeof(n.id));
+        memcpy(n.counter, getCounter(fd), sizeof(n.counter));
+        n.age = 0xff;
+    }
+
+    // Frames passed on for authentication.
+    uint16_t getPassedCount() const { return(nPassed); }
+    // Frames dropped as having a counter no higher than already accepted.
+    uint16_t getStaleCount() const { return(nStale); }
+    // Frames dropped as exact duplicates of a recently accepted frame.
+    uint16_t getDuplicateCount() const { return(nDuplicate); }
+    void resetStats() { nPassed = 0; nStale = 0; nDuplicate = 0; }
+};
+
 /**
  * @brief   Attempt to decode a message as if it is a standard OT secure "O"
  *          type frame. May perform up to two "operations" if the decode
@@ -293,36 +527,51 @@ inline bool decodeAndHandleDummyFrame(volatile const uint8_t * const /*msg*/)
  *          Should return true on success.
  * @param   o1: First operator to be called.
  * @param   o2: Second operator to be called. Defaults to a dummy impl.
- * @param   _msg: Raw RXed message. msgLen should be stored in the byte before
- *          and can be accessed with msg[-1]. This routine is NOT allowed to
- *          alter content of the buffer passed.
- * @param   sW: Scratch space to perform decode routine in. Should be large
- *          enough for both the frame RX type and the underlying decryption
- *          routine.
+ * @param   replayFilter_t: Filter used to drop duplicate and replayed frames
+ *          before authentication, eg SecureFrameReplayFilter<>. Defaults to
+ *          a filter that passes everything.
+ * @param   firstIDMatchOnly: As for authAndDecodeOTSecurableFrame().
+ * @param   msgStart: Raw RXed message. msgLen should be stored in the byte
+ *          before and can be accessed with msgStart[-1]. This routine is NOT
+ *          allowed to alter content of the buffer passed, so it may be a
+ *          pinned RX queue slot (see OTRadioLink::peekRXMsgPinned()).
+ * @param   sW: Scratch space to perform decode routine in. The decrypted body
+ *          is written to the start of it, so it must be
+ *          decodeAndHandleOTSecureOFrame_scratch_usage bytes larger than
+ *          needed by authAndDecodeOTSecurableFrame(), the frame RX type and
+ *          the underlying decryption routine.
  * @retval  False if the frame header could not be decoded, does not match a
  *          secure "O" frame, or the frame is otherwise malformed in any way.
  *          True if the frame is a valid secure frame.
  *          NOTE! A frame that "looks like" a secure "O" frame but can not be
  *          authed or decoded, it will return true.
  */
+// Local scratch: the decrypted body.
+static constexpr uint8_t decodeAndHandleOTSecureOFrame_scratch_usage =
+    OTDecodeData_T::ptextLenMax;
 template<typename sfrx_t,
          SimpleSecureFrame32or0BodyRXBase::fixed32BTextSize12BNonce16BTagSimpleDec_fn_t &decrypt,
          OTV0P2BASE::GetPrimary16ByteSecretKey_t &getKey,
          frameOperator_fn_t &o1,
-         frameOperator_fn_t &o2 = nullFrameOperation>
-bool decodeAndHandleOTSecureOFrame(volatile const uint8_t * const _msg, OTV0P2BASE::ScratchSpaceL &sW)
+         frameOperator_fn_t &o2 = nullFrameOperation,
+         typename replayFilter_t = SecureFrameReplayFilterNull,
+         bool firstIDMatchOnly = true>
+bool decodeAndHandleOTSecureOFrame(const uint8_t * const msgStart, OTV0P2BASE::ScratchSpaceL &sW)
 {
-    const uint8_t * const msg = (const uint8_t * const)_msg - 1;
+    const uint8_t * const msg = msgStart - 1;
     const uint8_t firstByte = msg[1];
     const uint8_t msglen = msg[0];
 
-    // Buffer for receiving secure frame body.
+    constexpr size_t scratchSpaceNeededHere = decodeAndHandleOTSecureOFrame_scratch_usage;
+    if(sW.bufsize < scratchSpaceNeededHere) { return(false); } // ERROR
+
+    // Buffer for receiving secure frame body, from the caller's scratch space.
     // (Non-secure frame bodies should be read directly from the frame buffer.)
-    // FIXME: Should this be passed in by scratch space?
     // TODO: Consider moving this out by one layer and passing it in, to avoid
     // needing to re-decode header in second handler.
-    uint8_t decryptedBodyOut[OTDecodeData_T::ptextLenMax];
+    uint8_t * const decryptedBodyOut = sW.buf;
     OTDecodeData_T fd(msg, decryptedBodyOut);
+    OTV0P2BASE::ScratchSpaceL subScratch(sW, scratchSpaceNeededHere, SCRATCH_SITE_decodeAndHandleOTSecureOFrame);
 
     // Validate structure of header/frame first.
     // This is quick and checks for insane/dangerous values throughout.
@@ -341,9 +590,15 @@ bool decodeAndHandleOTSecureOFrame(volatile const uint8_t * const _msg, OTV0P2BA
     // this routine must return true to avoid another handler
     // attempting to process it.
 
+    // Drop duplicates and replays cheaply, before fetching the key or
+    // attempting to decrypt.
+    replayFilter_t &filter = replayFilter_t::getInstance();
+    if(filter.isReplay(fd, sfrx_t::getInstance())) { return(true); }
+
     // Even if auth fails, we have now handled this frame by protocol.
-    if(!authAndDecodeOTSecurableFrame<sfrx_t, decrypt, getKey>(fd, sW))
+    if(!authAndDecodeOTSecurableFrame<sfrx_t, decrypt, getKey, firstIDMatchOnly>(fd, subScratch))
         { return(true); }
+    filter.recordAccepted(fd);
 
     // Make sure frame is long enough to have useful information in it
     // and then call operations.
@@ -380,7 +635,7 @@ bool decodeAndHandleOTSecureOFrame(volatile const uint8_t * const _msg, OTV0P2BA
  *          By default all operations but h1 will default to a dummy stub operation (decodeAndHandleDummyFrame).
  */
 template<frameDecodeHandler_fn_t &h1, frameDecodeHandler_fn_t &h2 = decodeAndHandleDummyFrame>
-void decodeAndHandleRawRXedMessage(volatile const uint8_t * const msg)
+void decodeAndHandleRawRXedMessage(const uint8_t * const msg)
 {
     const uint8_t msglen = msg[-1];
 
@@ -500,8 +755,9 @@ public:
         // Check for activity on the radio link.
         rl.poll();
 
-        // Pointer to RX message buffer of radio.
-        const volatile uint8_t *pb = rl.peekRXMsg();
+        // Pointer to RX message buffer of radio, decoded in place.
+        // The slot stays pinned until removeRXMsg() below.
+        const uint8_t *pb = rl.peekRXMsgPinned();
         // If pb is a nullptr at this stage, no message has been RXed.
         if(nullptr != pb) {
 #ifdef ARDUINO_ARCH_AVR
@@ -509,8 +765,8 @@ public:
             if(!neededWaking && wakeSerialIfNeeded && OTV0P2BASE::powerUpSerialIfDisabled<baud>()) { neededWaking = true; } // FIXME
 #endif // ARDUINO_ARCH_AVR
             // Don't currently regard anything arriving over the air as 'secure'.
-            // FIXME: shouldn't have to cast away volatile to process the message content.
             decodeAndHandleRawRXedMessage<h1, h2> (pb);
+            // Release the slot only once the handlers are done with it.
             rl.removeRXMsg();
             // Note that some work has been done.
             workDone = true;
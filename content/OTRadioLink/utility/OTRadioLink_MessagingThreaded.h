@@ -0,0 +1,329 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * Multi-threaded message queue handler for hosted (eg Linux) gateways.
+ *
+ * The calling thread drains the radio and hands copies of the frames to a
+ * pool of decode workers. Frames are sharded across workers by sender ID,
+ * so frames from any one node are handled in arrival order (keeping the RX
+ * message counter checks correct) while frames from different nodes are
+ * handled in parallel.
+ *
+ * The RX counter stores, session caches and replay filters are not
+ * thread-safe, so handlers run by the workers should reach them through
+ * SimpleSecureFrame32or0BodyRXLocked and SecureFrameReplayFilterPerWorker.
+ *
+ * Not available on Arduino targets.
+ */
+
+#ifndef UTILITY_OTRADIOLINK_MESSAGINGTHREADED_H_
+#define UTILITY_OTRADIOLINK_MESSAGINGTHREADED_H_
+
+#ifndef ARDUINO
+
+#include <stdint.h>
+#include <string.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "OTRadioLink_Messaging.h"
+#include "OTRadioLink_OTRadioLink.h"
+
+#define OTRADIOLINK_PLATFORM_HAS_OTMessageQueueHandlerThreaded
+
+namespace OTRadioLink
+{
+
+/**
+ * @brief   Thread-safe view of a secure frame RX singleton, for use as the
+ *          sfrx_t of handlers run by OTMessageQueueHandlerThreaded.
+ *
+ * Every association lookup and message counter access is passed on to
+ * rx_t::getInstance() under one mutex, so rx_t (eg a counter store or a
+ * SimpleSecureFrame32or0BodyRXSessionCache over one) is only ever entered
+ * by one thread at a time, while decryption runs in parallel.
+ * Each thread gets its own instance, so the recent sender hints kept by
+ * decode() are per worker.
+ *
+ * @param   rx_t: RX implementation with a static getInstance().
+ */
+template<typename rx_t>
+class SimpleSecureFrame32or0BodyRXLocked final : public SimpleSecureFrame32or0BodyRXBase
+{
+private:
+    // Serialises all access to rx_t::getInstance().
+    static std::mutex &getMutex()
+    {
+        static std::mutex m;
+        return(m);
+    }
+    virtual int8_t _getNextMatchingNodeID(const uint8_t index, const SecurableFrameHeader *const sfh, uint8_t *nodeID) const override
+    {
+        std::lock_guard<std::mutex> lock(getMutex());
+        return(_getNextMatchingNodeIDOf(rx_t::getInstance(), index, sfh, nodeID));
+    }
+
+public:
+    static SimpleSecureFrame32or0BodyRXLocked &getInstance()
+    {
+        thread_local SimpleSecureFrame32or0BodyRXLocked instance;
+        return(instance);
+    }
+    virtual bool getLastRXMsgCtr(const uint8_t * const ID, uint8_t *counter) const override
+    {
+        std::lock_guard<std::mutex> lock(getMutex());
+        return(rx_t::getInstance().getLastRXMsgCtr(ID, counter));
+    }
+    virtual bool authAndUpdateRXMsgCtr(const uint8_t *ID, const uint8_t *newCounterValue) override
+    {
+        std::lock_guard<std::mutex> lock(getMutex());
+        return(rx_t::getInstance().authAndUpdateRXMsgCtr(ID, newCounterValue));
+    }
+};
+
+/**
+ * @brief   Replay filter for handlers run by OTMessageQueueHandlerThreaded,
+ *          giving each worker thread its own filter_t.
+ *
+ * The threaded handler sends all frames from a node to the same worker,
+ * so each worker's filter sees every frame from the nodes it handles and
+ * no locking is needed. Memory use is one filter_t per worker.
+ *
+ * @param   filter_t: Filter type, eg SecureFrameReplayFilter<>.
+ */
+template<typename filter_t>
+class SecureFrameReplayFilterPerWorker final
+{
+public:
+    static SecureFrameReplayFilterPerWorker &getInstance()
+    {
+        static SecureFrameReplayFilterPerWorker instance;
+        return(instance);
+    }
+    // The calling thread's filter.
+    static filter_t &getLocal()
+    {
+        thread_local filter_t filter;
+        return(filter);
+    }
+    bool isReplay(const OTDecodeData_T &fd, const SimpleSecureFrame32or0BodyRXBase &rx)
+        { return(getLocal().isReplay(fd, rx)); }
+    void recordAccepted(const OTDecodeData_T &fd) { getLocal().recordAccepted(fd); }
+};
+
+/**
+ * @brief   Message queue handler that decodes frames on a pool of threads.
+ *
+ * Drop-in alternative to OTMessageQueueHandler for hosted platforms.
+ * Each call to handle() drains every frame queued on the radio, so that the
+ * radio's own (small) queue does not overflow while frames are decoded.
+ *
+ * Frames are assigned to a worker by the first byte of the sender ID in the
+ * frame header; frames with no ID go to the first worker. Each worker takes
+ * its frames in order, so h1 and h2 are never called concurrently for frames
+ * from the same node, but MAY be called concurrently for different nodes.
+ * Any state shared between nodes by the handlers and their frame operators
+ * must therefore be safe for concurrent use: use
+ * SimpleSecureFrame32or0BodyRXLocked for the RX singleton and
+ * SecureFrameReplayFilterPerWorker for any replay filter, and give each
+ * decrypt key context cache and output its own locking.
+ *
+ * @param   pollIO: Function to call before handling inbound messages.
+ * @param   h1: First frame handler to attempt.
+ * @param   h2: Second frame handler to attempt. Defaults to a dummy handler.
+ *          See decodeAndHandleRawRXedMessage() for how handlers are called.
+ * @param   maxWorkers: Maximum number of decode threads.
+ * @param   queueDepth: Frames that may be queued per worker before the
+ *          draining thread blocks waiting for that worker.
+ */
+template<bool (*pollIO) (bool),
+         frameDecodeHandler_fn_t &h1,
+         frameDecodeHandler_fn_t &h2 = decodeAndHandleDummyFrame,
+         uint8_t maxWorkers = 8,
+         uint8_t queueDepth = 16>
+class OTMessageQueueHandlerThreaded final : public OTMessageQueueHandlerBase
+{
+public:
+    // Length byte + 63 byte secure frame.
+    static constexpr uint8_t frameBufSize = 64;
+
+private:
+    static_assert(maxWorkers > 0, "need at least one worker");
+    static_assert(queueDepth > 0, "need a non-empty queue");
+
+    struct Worker
+    {
+        std::thread thread;
+        std::mutex m;
+        // Signalled when a frame is queued or taken, or on shutdown.
+        std::condition_variable cv;
+        // Ring of queued frames, each stored length byte first.
+        uint8_t frames[queueDepth][frameBufSize];
+        uint8_t head = 0;
+        uint8_t count = 0;
+        // True while a frame taken from the queue is being handled.
+        bool busy = false;
+        bool stop = false;
+    };
+
+    const uint8_t nWorkers;
+    Worker workers[maxWorkers];
+
+    // Pick a default thread count from the hardware, within [1,maxWorkers].
+    static uint8_t defaultWorkers()
+    {
+        const unsigned hc = std::thread::hardware_concurrency();
+        if(0 == hc) { return(1); }
+        return((hc > maxWorkers) ? maxWorkers : uint8_t(hc));
+    }
+
+    // Worker thread body: handle frames in queue order until stopped.
+    static void run(Worker *const w)
+    {
+        uint8_t frame[frameBufSize];
+        for( ; ; ) {
+            {
+                std::unique_lock<std::mutex> lock(w->m);
+                w->busy = false;
+                w->cv.notify_all();
+                w->cv.wait(lock, [w]{ return(w->stop || (0 != w->count)); });
+                if(0 == w->count) { return; } // Stopped and drained.
+                memcpy(frame, w->frames[w->head], frameBufSize);
+                w->head = uint8_t((w->head + 1) % queueDepth);
+                --w->count;
+                w->busy = true;
+                w->cv.notify_all();
+            }
+            decodeAndHandleRawRXedMessage<h1, h2>(frame + 1);
+        }
+    }
+
+    // Queue a copy of a frame (length byte first) on worker w,
+    // waiting for space if necessary.
+    void enqueue(Worker &w, const uint8_t *const buf, const uint8_t len)
+    {
+        std::unique_lock<std::mutex> lock(w.m);
+        w.cv.wait(lock, [&w]{ return(w.count < queueDepth); });
+        uint8_t *const slot = w.frames[(w.head + w.count) % queueDepth];
+        memcpy(slot, buf, size_t(len) + 1);
+        ++w.count;
+        w.cv.notify_all();
+    }
+
+public:
+    /**
+     * @brief   Start the decode workers.
+     * @param   nThreads: Number of decode threads, capped at maxWorkers.
+     *          If 0, uses the number of hardware threads.
+     */
+    explicit OTMessageQueueHandlerThreaded(const uint8_t nThreads = 0)
+        : nWorkers((0 == nThreads) ? defaultWorkers() :
+                       ((nThreads > maxWorkers) ? maxWorkers : nThreads))
+    {
+        for(uint8_t i = 0; i < nWorkers; ++i) {
+            workers[i].thread = std::thread(run, &workers[i]);
+        }
+    }
+
+    /**
+     * @brief   Handle any frames still queued, then stop the workers.
+     */
+    ~OTMessageQueueHandlerThreaded()
+    {
+        for(uint8_t i = 0; i < nWorkers; ++i) {
+            {
+                std::lock_guard<std::mutex> lock(workers[i].m);
+                workers[i].stop = true;
+            }
+            workers[i].cv.notify_all();
+        }
+        for(uint8_t i = 0; i < nWorkers; ++i) { workers[i].thread.join(); }
+    }
+
+    OTMessageQueueHandlerThreaded(const OTMessageQueueHandlerThreaded &) = delete;
+    OTMessageQueueHandlerThreaded &operator=(const OTMessageQueueHandlerThreaded &) = delete;
+
+    // Number of decode threads running.
+    uint8_t getWorkerCount() const { return(nWorkers); }
+
+    /**
+     * @brief   Worker that frames in the buffer will be handled by.
+     * @param   buf: Frame buffer, length byte first. Never NULL.
+     */
+    uint8_t getWorkerFor(const uint8_t *const buf) const
+    {
+        // Header is length, type, seq/ID length, ID...
+        const uint8_t len = buf[0];
+        if(len < 3) { return(0); }
+        if(0 == (buf[2] & 0xf)) { return(0); } // No ID.
+        return(uint8_t(buf[3] % nWorkers));
+    }
+
+    /**
+     * @brief   Poll the radio and queue all RXed frames for decoding.
+     *
+     * Handlers are run asynchronously so may not have completed on return;
+     * use flush() to wait for them.
+     * Frames too long to be valid are dropped here.
+     *
+     * @param   rl: Radio to check for new RXed frames.
+     *          Only accessed from the calling thread.
+     * @retval  Returns true if any message was RXed, or if pollIO returns
+     *          true.
+     */
+    virtual bool handle(bool /*wakeSerialIfNeeded*/, OTRadioLink &rl) override
+    {
+        // Deal with any I/O that is queued.
+        bool workDone = pollIO(true);
+
+        // Check for activity on the radio link.
+        rl.poll();
+
+        for(const uint8_t *pb; nullptr != (pb = rl.peekRXMsgPinned()); ) {
+            // Include the length byte before the message.
+            const uint8_t *const buf = pb - 1;
+            const uint8_t len = buf[0];
+            if(len < frameBufSize) { enqueue(workers[getWorkerFor(buf)], buf, len); }
+            rl.removeRXMsg();
+            workDone = true;
+        }
+        return(workDone);
+    }
+
+    /**
+     * @brief   Wait until all queued frames have been handled.
+     *
+     * Must not be called concurrently with handle().
+     */
+    void flush()
+    {
+        for(uint8_t i = 0; i < nWorkers; ++i) {
+            Worker &w = workers[i];
+            std::unique_lock<std::mutex> lock(w.m);
+            w.cv.wait(lock, [&w]{ return((0 == w.count) && !w.busy); });
+        }
+    }
+};
+
+}
+
+#endif // ARDUINO
+
+#endif /* UTILITY_OTRADIOLINK_MESSAGINGTHREADED_H_ */
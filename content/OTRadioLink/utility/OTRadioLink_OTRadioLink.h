@@ -34,6 +34,8 @@ Author(s) / Copyright (s): Damon Hart-Davis 2015--2016
 
 #include <OTV0p2Base.h>
 
+#include "OTRadioLink_ISRRXQueue.h"
+
 
 // Use namespaces to help avoid collisions.
 namespace OTRadioLink
@@ -117,6 +119,62 @@ namespace OTRadioLink
     // Always returns true, ie never rejects a frame outright.
     quickFrameFilter_t frameFilterTrailingZeros;
 
+    // Channel each queued RX frame was received on, for a radio whose
+    // listen channel may change while frames are still queued.
+    // Held as runs of consecutive frames rather than per frame, since
+    // channel changes are rare compared with frames;
+    // frames after the last run were received on the current channel.
+    // Only touched from the non-ISR side of the RX queue.
+    // If more than maxRuns channel changes are outstanding
+    // the channel of the newest run becomes unknown (-1).
+    template<uint8_t maxRuns = 2>
+    class RXChannelRuns final
+        {
+        static_assert(maxRuns > 0, "maxRuns must be non-zero");
+        private:
+            // Channel being received on, or -1.
+            int8_t current = -1;
+            // Number of runs, oldest first.
+            uint8_t n = 0;
+            // Frames covered by the runs.
+            uint8_t total = 0;
+            int8_t channels[maxRuns];
+            uint8_t counts[maxRuns];
+        public:
+            // Call when the radio moves to a new listen channel (or -1),
+            // with queued being the number of frames now queued,
+            // all received before the change.
+            void listening(const int8_t channel, const uint8_t queued)
+                {
+                if(channel == current) { return; }
+                if(queued > total)
+                    {
+                    const uint8_t k = uint8_t(queued - total);
+                    if(n < maxRuns) { channels[n] = current; counts[n] = k; ++n; }
+                    else
+                        {
+                        if(channels[n-1] != current) { channels[n-1] = -1; }
+                        counts[n-1] = uint8_t(counts[n-1] + k);
+                        }
+                    total = queued;
+                    }
+                current = channel;
+                }
+            // Call after each frame is removed from the queue.
+            void removed()
+                {
+                if(0 == n) { return; }
+                --total;
+                if(0 == --counts[0])
+                    {
+                    --n;
+                    for(uint8_t i = 0; i < n; ++i) { channels[i] = channels[i+1]; counts[i] = counts[i+1]; }
+                    }
+                }
+            // Channel the oldest queued frame was received on, or -1 if unknown.
+            int8_t oldest() const { return((0 != n) ? channels[0] : current); }
+        };
+
     // Base class for radio link hardware driver.
     // Radios can support multiple channels and can be (for example) TX-only for leaf nodes.
     // Implementation cannot be assume to either re-entrant or ISR-safe except where stated.
@@ -289,6 +347,16 @@ namespace OTRadioLink
             // ISR-/thread- safe.
             inline uint8_t getRXMsgsFilteredRecent() const { return(filteredRXedMessageCountRecent); }
 
+            // Fetch a snapshot of the RX queue health counters into h,
+            // eg to size the RX queue from data gathered under real load.
+            // Returns false (leaving h undefined) if not available.
+            // Defaults to not available; radios with an ISRRXQueue should forward to it.
+            // Not intended to be called from an ISR.
+            virtual bool getRXQueueHealth(ISRRXQueueHealth & /*h*/) const { return(false); }
+
+            // Reset the RX queue health counters and peaks, if available.
+            virtual void resetRXQueueHealth() { }
+
             // Peek at first (oldest) queued RX message, returning a pointer or NULL if no message waiting.
             // The pointer returned is NULL if there is no message,
             // else the pointer is to the start of the message/frame
@@ -302,12 +370,28 @@ namespace OTRadioLink
             // Not intended to be called from an ISR.
             virtual const volatile uint8_t *peekRXMsg() const = 0;
 
+            // As peekRXMsg() but for reading the message in place as ordinary memory.
+            // A queued message is complete before it is made visible to peekRXMsg()
+            // and its slot is not written again until removeRXMsg(),
+            // so between the two it need not be treated as volatile.
+            // The same validity rules as for peekRXMsg() apply.
+            // Not intended to be called from an ISR.
+            const uint8_t *peekRXMsgPinned() const { return(const_cast<const uint8_t *>(peekRXMsg())); }
+
             // Remove the first (oldest) queued RX message.
             // Typically used after peekRXMessage().
             // Does nothing if the queue is empty.
             // Not intended to be called from an ISR.
             virtual void removeRXMsg() = 0;
 
+            // Channel the frame returned by peekRXMsg() was received on, or -1 if unknown.
+            // Valid until the next removeRXMsg().
+            // Defaults to the current listen channel, which is only right if it
+            // has not changed since the frame was received; radios that can
+            // change channel with frames queued should record it, eg with RXChannelRuns.
+            // Not intended to be called from an ISR.
+            virtual int8_t getRXMsgChannel() const { return(getListenChannel()); }
+
             // Basic RX error numbers in range 0--127 as returned by getRXRerr() (cast to uint8_t).
             // Implementations can provide more specific errors in range 128--255.
             // 0 (zero) means no error.
@@ -363,6 +447,9 @@ namespace OTRadioLink
             //     and thus possibly power or other efforts to get it heard;
             //     this hint may be ignored.
             // Defaults to redirect to sendRaw(), in which case see sendRaw() comments.
+            // Drivers may instead queue frames in an OTRadioLinkTXQueue
+            // and send them from poll(), as OTVirtualEtherRadio can;
+            // see OTRadioLink_TXQueue.h.
             // Should not block unless in a call to sendRaw().
             virtual bool queueToSend(const uint8_t *buf, uint8_t buflen, int8_t channel = 0, TXpower power = TXnormal) { return sendRaw(buf, buflen, channel, power); };
 
@@ -408,6 +495,8 @@ namespace OTRadioLink
 
     // Forward some CRC definitions that were in OTRadioLink for compatibility (DHD20160117).
     inline uint8_t crc7_5B_update(uint8_t crc, uint8_t datum) { return(OTV0P2BASE::crc7_5B_update(crc, datum)); }
+    inline uint8_t crc7_5B_update_block(uint8_t crc, const uint8_t *buf, uint8_t len) { return(OTV0P2BASE::crc7_5B_update_block(crc, buf, len)); }
+    inline void crc7_5B_update_block_x4(uint8_t crc[4], const uint8_t *const buf[4], uint8_t len) { OTV0P2BASE::crc7_5B_update_block_x4(crc, buf, len); }
     static const uint8_t crc7_5B_update_nz_ALT = OTV0P2BASE::crc7_5B_update_nz_ALT;
     inline uint8_t crc7_5B_update_nz_final(uint8_t crc, uint8_t datum) { return(OTV0P2BASE::crc7_5B_update_nz_final(crc, datum)); }
 
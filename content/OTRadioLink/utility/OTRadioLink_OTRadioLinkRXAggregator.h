@@ -0,0 +1,198 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * Aggregated RX queue over several radios, eg for concentrators with an
+ * RFM23B on two channels plus a SIM900 back-haul.
+ */
+
+#ifndef OTRADIOLINK_OTRADIOLINKRXAGGREGATOR_H_
+#define OTRADIOLINK_OTRADIOLINKRXAGGREGATOR_H_
+
+#include <stdint.h>
+
+#include "OTRadioLink_OTRadioLink.h"
+
+namespace OTRadioLink
+{
+
+/**
+ * @brief   RX-only radio link that drains several OTRadioLink instances
+ *          as one stream, so that one OTMessageQueueHandler
+ *          (or handler thread) can serve all of them.
+ *
+ * Sources are served weighted round-robin: while it has frames queued a
+ * source supplies up to its weight in consecutive frames before the next
+ * source with frames queued is served. So no source with frames waiting
+ * ever waits more than the sum of the other sources' weights.
+ * Ordering is only preserved within each source: frames from one source
+ * stay in arrival order, but frames from different sources are not in
+ * arrival order relative to each other.
+ *
+ * Frames are not copied: peekRXMsg() returns the frame in the source's
+ * own queue and removeRXMsg() removes it from there. This gives per-source
+ * back-pressure. A slow handler fills each source's queue, and each source
+ * then drops its own excess frames (see getRXMsgsDroppedRecent() on the
+ * source), so a busy source cannot take queue space from a quieter one.
+ *
+ * The source (index, and the channel the frame was received on as
+ * recorded by the source's getRXMsgChannel()) of the frame returned by
+ * the last peekRXMsg() is available from getRXMsgSource() until removeRXMsg().
+ *
+ * Sending, listening and configuration are done on the sources directly;
+ * sendRaw() always fails and listen() has no effect.
+ * Not ISR-safe and, like the sources, not thread-safe.
+ *
+ * @param   maxSources: Maximum number of radios aggregated; in [1,127].
+ */
+template<uint8_t maxSources>
+class OTRadioLinkRXAggregator final : public OTRadioLink
+{
+    static_assert((maxSources > 0) && (maxSources <= 127), "maxSources must be in [1,127]");
+
+public:
+    // Where an RXed frame came from.
+    struct RXMsgSource
+    {
+        // Index as returned by addSource().
+        uint8_t source;
+        // Channel the frame was received on, or -1 if unknown.
+        int8_t channel;
+    };
+
+private:
+    OTRadioLink *sources[maxSources];
+    uint8_t weights[maxSources];
+    // Frames removed per source, wrapping; for monitoring fairness.
+    uint32_t delivered[maxSources];
+    uint8_t nSources = 0;
+
+    // Source currently being served, and frames it may still supply this turn.
+    // Advanced from peekRXMsg(), which is const.
+    mutable uint8_t current = 0;
+    mutable uint8_t credit = 0;
+
+    // Move to the next source, with a fresh allowance.
+    void advance() const
+    {
+        current = uint8_t((current + 1) % nSources);
+        credit = weights[current];
+    }
+
+    virtual void _dolisten() override { }
+
+public:
+    OTRadioLinkRXAggregator() { }
+    OTRadioLinkRXAggregator(const OTRadioLinkRXAggregator &) = delete;
+    OTRadioLinkRXAggregator &operator=(const OTRadioLinkRXAggregator &) = delete;
+
+    /**
+     * @brief   Add a radio to be drained.
+     * @param   rl: Radio; must outlive this object.
+     * @param   weight: Frames taken from this radio per turn; non-zero.
+     * @retval  Index of the source, or -1 if full or weight is 0.
+     */
+    int8_t addSource(OTRadioLink &rl, const uint8_t weight = 1)
+    {
+        if((nSources >= maxSources) || (0 == weight)) { return(-1); } // FAIL
+        sources[nSources] = &rl;
+        weights[nSources] = weight;
+        delivered[nSources] = 0;
+        // Start the first turn at the first source.
+        if(0 == nSources) { credit = weight; }
+        return(int8_t(nSources++));
+    }
+
+    // Number of sources added.
+    uint8_t getSourceCount() const { return(nSources); }
+    // Frames removed from source i since it was added; 0 if no such source.
+    uint32_t getDelivered(const uint8_t i) const { return((i < nSources) ? delivered[i] : 0); }
+
+    // Sum of the sources' minimum queue capacities and largest RX frame size; cannot TX.
+    virtual void getCapacity(uint8_t &queueRXMsgsMin, uint8_t &maxRXMsgLen, uint8_t &maxTXMsgLen) const override
+    {
+        uint16_t q = 0;
+        uint8_t rx = 0;
+        for(uint8_t i = 0; i < nSources; ++i) {
+            uint8_t sq, srx, stx;
+            sources[i]->getCapacity(sq, srx, stx);
+            q += sq;
+            if(srx > rx) { rx = srx; }
+        }
+        queueRXMsgsMin = (q > 255) ? 255 : uint8_t(q);
+        maxRXMsgLen = rx;
+        maxTXMsgLen = 0;
+    }
+
+    // Total frames queued over all sources, capped at 255.
+    virtual uint8_t getRXMsgsQueued() const override
+    {
+        uint16_t n = 0;
+        for(uint8_t i = 0; i < nSources; ++i) { n += sources[i]->getRXMsgsQueued(); }
+        return((n > 255) ? 255 : uint8_t(n));
+    }
+
+    // Peek at the next frame in the aggregated stream, or NULL if none.
+    // Repeated calls return the same frame until removeRXMsg().
+    virtual const volatile uint8_t *peekRXMsg() const override
+    {
+        if(0 == nSources) { return(NULL); }
+        // Check the current source (if it has allowance left), then each other in turn.
+        for(uint8_t tries = 0; tries <= nSources; ++tries) {
+            if(0 != credit) {
+                const volatile uint8_t *const msg = sources[current]->peekRXMsg();
+                if(NULL != msg) { return(msg); }
+            }
+            advance();
+        }
+        return(NULL);
+    }
+
+    // Source of the frame returned by the last peekRXMsg().
+    // Undefined if that returned NULL.
+    RXMsgSource getRXMsgSource() const
+        { return(RXMsgSource{ current, sources[current]->getRXMsgChannel() }); }
+
+    // Channel the frame returned by the last peekRXMsg() was received on,
+    // on its source; as getRXMsgSource().channel.
+    virtual int8_t getRXMsgChannel() const override
+        { return((0 == nSources) ? -1 : sources[current]->getRXMsgChannel()); }
+
+    // Remove the next frame in the aggregated stream, as returned by peekRXMsg().
+    // Does nothing if no source has a frame queued.
+    virtual void removeRXMsg() override
+    {
+        if(NULL == peekRXMsg()) { return; }
+        sources[current]->removeRXMsg();
+        ++delivered[current];
+        if(0 == --credit) { advance(); }
+    }
+
+    // Poll every source.
+    virtual void poll() override
+        { for(uint8_t i = 0; i < nSources; ++i) { sources[i]->poll(); } }
+
+    // RX only: always fails.
+    virtual bool sendRaw(const uint8_t * /*buf*/, uint8_t /*buflen*/,
+                         int8_t /*channel*/ = 0, TXpower /*power*/ = TXnormal, bool /*listenAfter*/ = false) override
+        { return(false); }
+};
+
+}
+
+#endif /* OTRADIOLINK_OTRADIOLINKRXAGGREGATOR_H_ */
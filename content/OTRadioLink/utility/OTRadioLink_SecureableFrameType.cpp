@@ -272,10 +272,8 @@ uint8_t SecurableFrameHeader::computeNonSecureCRC(const uint8_t *const buf, uint
     // Check that buffer is at least large enough for all but the CRC byte itself.
     if(buflen < fl) { return(0); } // ERROR
     // Initialise CRC with 0x7f;
-    uint8_t crc = 0x7f;
-    const uint8_t *p = buf;
     // Include in calc all bytes up to but not including the trailer/CRC byte.
-    for(uint8_t i = fl; i > 0; --i) { crc = OTV0P2BASE::crc7_5B_update(crc, *p++); }
+    uint8_t crc = OTV0P2BASE::crc7_5B_update_block(0x7f, buf, fl);
     // Ensure 0x00 result is converted to avoid forbidden value.
     if(0 == crc) { crc = 0x80; }
     return(crc);
@@ -379,6 +377,82 @@ uint8_t decodeNonsecure(OTDecodeData_T &fd)
     return(fl + 1);
     }
 
+// True if buf of length len may hold a complete non-secure frame whose
+// CRC trailer can be checked.
+static bool isCheckableNonsecureFrame(const uint8_t *const buf, const uint8_t len)
+    {
+    if(NULL == buf) { return(false); }
+    if(len < 2) { return(false); }
+    const uint8_t fl = buf[0];
+    if((fl < SecurableFrameHeader::minFrameSize) || (fl > SecurableFrameHeader::maxSmallFrameSize)) { return(false); }
+    if(fl >= len) { return(false); }
+    // Secure frames do not have a CRC trailer.
+    if(0 != (buf[1] & 0x80)) { return(false); }
+    return(true);
+    }
+
+/**
+ * @brief   Check the CRC trailers of a batch of non-secure small frames.
+ *
+ * Only the leading length byte, the secure bit of the frame type, and the
+ * CRC trailer are checked. Frames are checked in groups of four with
+ * crc7_5B_update_block_x4().
+ *
+ * @param   frames, INPUT: Array of nFrames pointers to raw frames, each
+ *              starting with the frame length byte fl. A NULL entry is
+ *              treated as invalid.
+ * @param   frameLens, INPUT: Array of nFrames available lengths of the
+ *              buffers in frames; a frame longer than this is invalid.
+ * @param   nFrames: Number of entries in frames and frameLens.
+ * @param   validBitmap, OUTPUT: (nFrames+7)/8 bytes; bit (i & 7) of byte
+ *              (i >> 3) is set iff frame i is valid. Never NULL.
+ * @retval  Number of valid frames; 0 if the arguments are unusable.
+ */
+uint8_t checkNonsecureCRCBatch(const uint8_t *const *const frames,
+                               const uint8_t *const frameLens,
+                               const uint8_t nFrames,
+                               uint8_t *const validBitmap)
+    {
+    if((NULL == frames) || (NULL == frameLens) || (NULL == validBitmap)) { return(0); } // ERROR
+    memset(validBitmap, 0, (nFrames + 7U) / 8U);
+    uint8_t nValid = 0;
+    // Checkable frames are gathered into groups of four.
+    const uint8_t *lane[4];
+    uint8_t laneIndex[4];
+    uint8_t nLanes = 0;
+    for(uint16_t i = 0; i <= nFrames; ++i)
+        {
+        const bool end = (i == nFrames);
+        if(!end)
+            {
+            if(!isCheckableNonsecureFrame(frames[i], frameLens[i])) { continue; }
+            lane[nLanes] = frames[i];
+            laneIndex[nLanes] = uint8_t(i);
+            if(++nLanes < 4) { continue; }
+            }
+        if(0 == nLanes) { continue; }
+        // Run all the lanes over their common length together,
+        // padding a short final group with repeats of its first frame,
+        // then finish each frame on its own.
+        uint8_t crc[4] = { 0x7f, 0x7f, 0x7f, 0x7f };
+        for(uint8_t k = nLanes; k < 4; ++k) { lane[k] = lane[0]; }
+        uint8_t common = lane[0][0];
+        for(uint8_t k = 1; k < 4; ++k) { if(lane[k][0] < common) { common = lane[k][0]; } }
+        OTV0P2BASE::crc7_5B_update_block_x4(crc, lane, common);
+        for(uint8_t k = 0; k < nLanes; ++k)
+            {
+            const uint8_t fl = lane[k][0];
+            uint8_t c = OTV0P2BASE::crc7_5B_update_block(crc[k], lane[k] + common, uint8_t(fl - common));
+            if(0 == c) { c = 0x80; }
+            if(lane[k][fl] != c) { continue; }
+            validBitmap[laneIndex[k] >> 3] |= uint8_t(1U << (laneIndex[k] & 7));
+            ++nValid;
+            }
+        nLanes = 0;
+        }
+    return(nValid);
+    }
+
 
 // Add specified small unsigned value to supplied counter value in place; false if failed.
 // This will fail (returning false) if the counter would overflow, leaving it unchanged.
@@ -397,7 +471,7 @@ bool SimpleSecureFrame32or0BodyRXBase::msgcounteradd(uint8_t *const counter, con
     if(allFF) { return(false); }
     // Safe from overflow, set lsbyte and ripple up the carry as necessary.
     counter[fullMsgCtrBytes-1] = bumped;
-    for(int8_t i = fullMsgCtrBytes-1; --i > 0; ) { if(0 != ++counter[i]) { break; } }
+    for(int8_t i = fullMsgCtrBytes-1; --i >= 0; ) { if(0 != ++counter[i]) { break; } }
     // Success!
     return(true);
     }
@@ -583,7 +657,7 @@ uint8_t SimpleSecureFrame32or0BodyRXBase::decodeRaw(
         decodeRaw_scratch_usage;
     if(scratchSpaceNeededHere > scratch.bufsize) { return(0); }
     // Create a new sub scratch space for callee.
-    OTV0P2BASE::ScratchSpaceL subScratch(scratch, scratchSpaceNeededHere);
+    OTV0P2BASE::ScratchSpaceL subScratch(scratch, scratchSpaceNeededHere, SCRATCH_SITE_decodeRaw);
 
     if((NULL == fd.ctext) || (NULL == key) || (NULL == iv)) { return(0); } // ERROR
 
@@ -607,6 +681,7 @@ uint8_t SimpleSecureFrame32or0BodyRXBase::decodeRaw(
     // Attempt to authenticate and decrypt.
     uint8_t * const decryptBuf = scratch.buf;
     //uint8_t decryptBuf[ENC_BODY_SMALL_FIXED_CTEXT_SIZE];
+    subScratch.noteUse(SCRATCH_SITE_decrypt);
     if(!d(scratch.buf+scratchSpaceNeededHere, scratch.bufsize-scratchSpaceNeededHere,
                 key, iv, buf, sfh.getHl(),
                 (0 == bl) ? NULL : buf + sfh.getBodyOffset(), buf + fl - 16,
@@ -753,6 +828,15 @@ bool fixed32BTextSize12BNonce16BTagSimpleDec_NULL_IMPL(
     }
 
 
+// NULL key setup: the context is a copy of the key.
+bool fixed32BTextSize12BNonce16BTagSimpleKeySetup_NULL_IMPL(
+        const uint8_t *const key, uint8_t *const keyContext)
+    {
+    if((nullptr == key) || (nullptr == keyContext)) { return(false); } // ERROR
+    memcpy(keyContext, key, fixed32BTextSize12BNonce16BTagSimpleKeyContextSize_NULL_IMPL);
+    return(true);
+    }
+
 // CONVENIENCE/BOILERPLATE METHODS
 
 /**
@@ -980,7 +1064,7 @@ uint8_t SimpleSecureFrame32or0BodyRXBase::_decodeFromID(
         _decodeFromID_scratch_usage;
     if(scratchSpaceNeededHere > scratch.bufsize) { return(0); }
     // Create a new sub scratch space for callee.
-    OTV0P2BASE::ScratchSpaceL subScratch(scratch, scratchSpaceNeededHere);
+    OTV0P2BASE::ScratchSpaceL subScratch(scratch, scratchSpaceNeededHere, SCRATCH_SITE__decodeFromID);
 
     if(adjID.bufsize < 6) { return(0); } // ERROR
 
@@ -1022,11 +1106,11 @@ uint8_t SimpleSecureFrame32or0BodyRXBase::_decodeFromID(
  *              decode_total_scratch_usage_OTAESGCM_3p0 bytes AND the scratch
  *              space required by the decryption function `d`.
  * @param   key, INPUT: 16-byte secret key. Never NULL.
- * @param   firstIDMatchOnly: IGNORED! If the 'firstMatchIDOnly' is true
- *              (the default) then this only checks the first ID prefix
- *              match found if any, else all possible entries may be tried
- *              depending on the implementation  and, for example,
- *              time/resource limits.
+ * @param   firstIDMatchOnly: If true (the default) then this only
+ *              checks the first ID prefix match found if any. Else the
+ *              associated nodes matching the ID prefix are tried, the
+ *              most recently authenticated first then in table order,
+ *              up to maxIDMatchAttempts nodes.
  * @retval  Total frame length + fl byte + 1, or 0 if there is an error, eg.
  *          because authentication failed, or this is a duplicate message.
  *          - If this returns 1, the frame was authenticated but had no body.
@@ -1039,14 +1123,14 @@ uint8_t SimpleSecureFrame32or0BodyRXBase::decode(
             fixed32BTextSize12BNonce16BTagSimpleDec_fn_t &d,
             OTV0P2BASE::ScratchSpaceL &scratch,
             const uint8_t *const key,
-            bool /*firstIDMatchOnly*/)
+            const bool firstIDMatchOnly)
     {
     // Scratch space for this function call alone (not called fns).
     constexpr uint8_t scratchSpaceNeededHere =
         decode_scratch_usage;
     if(scratchSpaceNeededHere > scratch.bufsize) { return(0); }
     // Create a new sub scratch space for callee.
-    OTV0P2BASE::ScratchSpaceL subScratch(scratch, scratchSpaceNeededHere);
+    OTV0P2BASE::ScratchSpaceL subScratch(scratch, scratchSpaceNeededHere, SCRATCH_SITE_decode);
 
     // Rely on _decodeSecureSmallFrameFromID() for validation of items
     // not directly needed here.
@@ -1056,16 +1140,11 @@ uint8_t SimpleSecureFrame32or0BodyRXBase::decode(
     // Abort if trailer not large enough to extract message counter from
     // safely (and not expected size/flavour).
     if(23 != fd.sfh.getTl()) { return(0); } // ERROR
-    // Look up the full node ID of the sender in the associations table.
-    // NOTE: this only tries the first match, ignoring firstIDMatchOnly.
-    // Use start of scratch space. This buffer should not be visible
-    // outside the decode stack (e.g. should not be part of fd).
+    // Use start of scratch space for the candidate sender ID.
+    // This buffer should not be visible outside the decode stack
+    // (e.g. should not be part of fd).
     uint8_t *const nodeID = scratch.buf;
-    const OTBuf_t senderNodeID(nodeID, OTV0P2BASE::OpenTRV_Node_ID_Bytes);
-    const int8_t index = _getNextMatchingNodeID(0, &fd.sfh, nodeID);
-    if(index < 0) { return(0); } // ERROR
-    // Extract the message counter and validate it
-    // (that it is higher than previously seen)...
+    // Extract the message counter, to be validated against each candidate.
     // Append to scratch space, after node id.
     uint8_t * const messageCounter = scratch.buf + OTV0P2BASE::OpenTRV_Node_ID_Bytes;
     // Assume counter positioning as for 0x80 type trailer,
@@ -1074,6 +1153,56 @@ uint8_t SimpleSecureFrame32or0BodyRXBase::decode(
     memcpy(messageCounter,
            fd.ctext + fd.sfh.getTrailerOffset(),
            SimpleSecureFrame32or0BodyBase::fullMsgCtrBytes);
+
+    // Look up the full node ID of the sender in the associations table.
+    if(firstIDMatchOnly) {
+        // Only try the first match.
+        const int8_t index = _getNextMatchingNodeID(0, &fd.sfh, nodeID);
+        if(index < 0) { return(0); } // ERROR
+        return(_decodeFromCandidate(fd, d, nodeID, messageCounter, subScratch, key));
+    }
+
+    // Try each association matching the ID prefix, within the budget.
+    // A wrong candidate fails the counter check or authentication.
+    uint8_t attempts = 0;
+    // Recently authenticated senders first, as the most likely.
+    for(uint8_t i = 0; i < recentSendersSize; ++i) {
+        const int8_t index = recentSenders[i];
+        if(index < 0) { break; }
+        // Skip if not a match for this prefix.
+        if(index != _getNextMatchingNodeID(uint8_t(index), &fd.sfh, nodeID)) { continue; }
+        const uint8_t result = _decodeFromCandidate(fd, d, nodeID, messageCounter, subScratch, key);
+        if(0 != result) { _noteRecentSender(index); return(result); }
+        if(++attempts >= maxIDMatchAttempts) { return(0); } // ERROR
+    }
+    // Then any others, in table order.
+    for(int8_t index = _getNextMatchingNodeID(0, &fd.sfh, nodeID);
+        index >= 0;
+        index = _getNextMatchingNodeID(uint8_t(index + 1), &fd.sfh, nodeID)) {
+        // Already tried.
+        if(_isRecentSender(index)) { continue; }
+        const uint8_t result = _decodeFromCandidate(fd, d, nodeID, messageCounter, subScratch, key);
+        if(0 != result) { _noteRecentSender(index); return(result); }
+        if(++attempts >= maxIDMatchAttempts) { return(0); } // ERROR
+        // Avoid wrapping the index.
+        if(INT8_MAX == index) { break; }
+    }
+    return(0); // ERROR
+    }
+
+// Check the counter of, decode with, and if successful update
+// the counter of, the sender with the full ID in nodeID.
+// Returns as for decode().
+uint8_t SimpleSecureFrame32or0BodyRXBase::_decodeFromCandidate(
+            OTDecodeData_T &fd,
+            fixed32BTextSize12BNonce16BTagSimpleDec_fn_t &d,
+            uint8_t *const nodeID,
+            const uint8_t *const messageCounter,
+            OTV0P2BASE::ScratchSpaceL &subScratch,
+            const uint8_t *const key)
+    {
+    const OTBuf_t senderNodeID(nodeID, OTV0P2BASE::OpenTRV_Node_ID_Bytes);
+    // Validate the message counter (that it is higher than previously seen)...
     if(!validateRXMsgCtr(senderNodeID.getBuf(), messageCounter)) { return(0); } // ERROR
 
     // Now attempt to decrypt.
@@ -1087,4 +1216,73 @@ uint8_t SimpleSecureFrame32or0BodyRXBase::decode(
     return(decodeResult);
     }
 
+// Move index to the front of recentSenders.
+void SimpleSecureFrame32or0BodyRXBase::_noteRecentSender(const int8_t index)
+    {
+    uint8_t i = 0;
+    // Find the existing entry, else drop the last.
+    while((i < recentSendersSize - 1) && (index != recentSenders[i])) { ++i; }
+    for( ; i > 0; --i) { recentSenders[i] = recentSenders[i - 1]; }
+    recentSenders[0] = index;
+    }
+
+// True if index is in recentSenders.
+bool SimpleSecureFrame32or0BodyRXBase::_isRecentSender(const int8_t index) const
+    {
+    for(uint8_t i = 0; i < recentSendersSize; ++i) {
+        if(index == recentSenders[i]) { return(true); }
+    }
+    return(false);
+    }
+
+// Copy the full ID of the only association matching the prefix in sfh.
+bool SimpleSecureFrame32or0BodyRXBase::getUniqueMatchingNodeID(const SecurableFrameHeader *const sfh, uint8_t *const nodeID) const
+    {
+    if((nullptr == sfh) || (nullptr == nodeID)) { return(false); } // ERROR
+    const int8_t index = _getNextMatchingNodeID(0, sfh, nodeID);
+    if(index < 0) { return(false); } // FAIL: no match.
+    if(INT8_MAX == index) { return(true); }
+    uint8_t otherID[OTV0P2BASE::OpenTRV_Node_ID_Bytes];
+    return(_getNextMatchingNodeID(uint8_t(index + 1), sfh, otherID) < 0);
+    }
+
+// Decode a batch of frames under one key, expanding the key only once.
+uint8_t SimpleSecureFrame32or0BodyRXBase::decodeBatch(
+            OTDecodeData_T *const *const fds,
+            const uint8_t nFrames,
+            fixed32BTextSize12BNonce16BTagSimpleKeySetup_fn_t &setup,
+            fixed32BTextSize12BNonce16BTagSimpleDecWithContext_fn_t &d,
+            const size_t keyContextSize,
+            OTV0P2BASE::ScratchSpaceL &scratch,
+            const uint8_t *const key,
+            uint8_t *const results,
+            const bool firstIDMatchOnly)
+    {
+    if((nullptr == fds) || (nullptr == key) || (0 == keyContextSize)) { return(0); } // ERROR
+    // Check the scratch space once for the whole batch, so that a bad
+    // workspace is reported as such rather than as nFrames failed frames.
+    // The context is rounded up to keep the sub-space for decode() aligned.
+    const size_t scratchSpaceNeededHere = OTV0P2BASE::ScratchSpaceL::alignedSize(keyContextSize);
+    if(scratchSpaceNeededHere + decode_scratch_usage >= scratch.bufsize) { return(0); } // ERROR
+    // Key context at the start of the scratch space, shared by all frames.
+    uint8_t *const keyContext = scratch.buf;
+    OTV0P2BASE::ScratchSpaceL subScratch(scratch, scratchSpaceNeededHere);
+
+    uint8_t nOK = 0;
+    if(setup(key, keyContext)) {
+        for(uint8_t i = 0; i < nFrames; ++i) {
+            OTDecodeData_T *const fd = fds[i];
+            // decode() hands its key argument through to d unread, so the
+            // context reaches d as the context-taking signature expects.
+            const uint8_t r = (nullptr == fd) ? 0 :
+                decode(*fd, d, subScratch, keyContext, firstIDMatchOnly);
+            if(nullptr != results) { results[i] = r; }
+            if(0 != r) { ++nOK; }
+        }
+    }
+    // Do not leave expanded key material lying around in the scratch space.
+    OTV0P2BASE::wipeSecret(keyContext, keyContextSize);
+    return(nOK);
+    }
+
 }
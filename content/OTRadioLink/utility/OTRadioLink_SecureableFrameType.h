@@ -31,6 +31,17 @@ Author(s) / Copyright (s): Damon Hart-Davis 2015--2016
 #include <stdint.h>
 #include <OTV0p2Base.h>
 
+// Select the message counter compare implementation at compile time.
+// Where OTRADIOLINK_MSGCTR_PACKED is defined, counters are loaded into a
+// 64-bit integer to be compared without per-byte branches,
+// and code holding many counters (eg SimpleSecureFrame32or0BodyTXBlockReserve)
+// may add to them in that form too; else they are worked on a byte at a time.
+// AVR keeps the byte-wise version by default as it has no cheap 64-bit ops;
+// define OTRADIOLINK_MSGCTR_BYTEWISE to force it elsewhere.
+#if !defined(OTRADIOLINK_MSGCTR_PACKED) && !defined(OTRADIOLINK_MSGCTR_BYTEWISE) && !defined(ARDUINO_ARCH_AVR)
+#define OTRADIOLINK_MSGCTR_PACKED
+#endif
+
 namespace OTRadioLink
     {
 
@@ -455,6 +466,33 @@ namespace OTRadioLink
      */
     uint8_t decodeNonsecure(OTDecodeData_T &fd);
 
+    /**
+     * @brief   Check the CRC trailers of a batch of non-secure small frames.
+     *
+     * Intended for hosts such as gateways replaying captured RX traffic,
+     * to cheaply weed out damaged frames before any full decode. Frames are
+     * checked four at a time with interleaved CRC computation.
+     *
+     * Only the leading length byte, the secure bit of the frame type, and the
+     * CRC trailer are checked: a frame marked valid here would pass the CRC
+     * check in decodeNonsecure() but should still have its header decoded
+     * before use.
+     *
+     * @param   frames, INPUT: Array of nFrames pointers to raw frames, each
+     *              starting with the frame length byte fl. A NULL entry is
+     *              treated as invalid.
+     * @param   frameLens, INPUT: Array of nFrames available lengths of the
+     *              buffers in frames; a frame longer than this is invalid.
+     * @param   nFrames: Number of entries in frames and frameLens.
+     * @param   validBitmap, OUTPUT: (nFrames+7)/8 bytes; bit (i & 7) of byte
+     *              (i >> 3) is set iff frame i is valid. Never NULL.
+     * @retval  Number of valid frames; 0 if the arguments are unusable.
+     */
+    uint8_t checkNonsecureCRCBatch(const uint8_t *const *frames,
+                                   const uint8_t *frameLens,
+                                   uint8_t nFrames,
+                                   uint8_t *validBitmap);
+
 //        // Round up to next 16 multiple, eg for encryption that works in fixed-size blocks for input [0,240].
 //        // Eg 0 -> 0, 1 -> 16, ... 16 -> 16, 17 -> 32 ...
 //        // Undefined for values above 240.
@@ -470,6 +508,46 @@ namespace OTRadioLink
         public:
             // Size of full message counter for type-0x80 AES-GCM security frames.
             static constexpr uint8_t fullMsgCtrBytes = 6;
+
+            // Full message counter packed into the low 48 bits of an integer.
+            // Stored and sent as fullMsgCtrBytes big-endian bytes;
+            // convert with msgctr48load() and msgctr48store() at that boundary.
+            typedef uint64_t msgctr48_t;
+            // Largest valid packed counter value.
+            static constexpr msgctr48_t msgctr48Max = 0xffffffffffffULL;
+
+            // Load a (6-byte, big-endian) message counter; never NULL.
+            static msgctr48_t msgctr48load(const uint8_t *const counter)
+                {
+                // Split 32+16 so that compilers can use a byte-swapping load for each.
+                const uint32_t hi = (uint32_t(counter[0]) << 24) | (uint32_t(counter[1]) << 16) |
+                                    (uint32_t(counter[2]) << 8) | uint32_t(counter[3]);
+                const uint16_t lo = uint16_t((counter[4] << 8) | counter[5]);
+                return((msgctr48_t(hi) << 16) | lo);
+                }
+            // Store a packed message counter as 6 big-endian bytes; never NULL.
+            static void msgctr48store(uint8_t *const counter, const msgctr48_t value)
+                {
+                counter[0] = uint8_t(value >> 40); counter[1] = uint8_t(value >> 32);
+                counter[2] = uint8_t(value >> 24); counter[3] = uint8_t(value >> 16);
+                counter[4] = uint8_t(value >> 8); counter[5] = uint8_t(value);
+                }
+
+            // Compare packed counters: -1, 0 or +1 as the sign of c1 - c2, without branches.
+            static constexpr int8_t msgctr48cmp(const msgctr48_t c1, const msgctr48_t c2)
+                { return(int8_t(int8_t(c1 > c2) - int8_t(c1 < c2))); }
+
+            // Add delta to packed counter in place; false if failed.
+            // This will fail (returning false) if the counter would pass msgctr48Max,
+            // leaving it unchanged.
+            // The counter must be valid (<= msgctr48Max) so the sum cannot wrap.
+            static bool msgctr48add(msgctr48_t &counter, const uint32_t delta)
+                {
+                const msgctr48_t sum = counter + delta;
+                const bool ok = (sum <= msgctr48Max);
+                counter = ok ? sum : counter;
+                return(ok);
+                }
         };
 
     // TX Base class for simple implementations that supports 0 or 32 byte encrypted body sections.
@@ -733,7 +811,7 @@ namespace OTRadioLink
                         OTV0P2BASE::ScratchSpaceL &scratch,
                         const uint8_t *key)
             {
-                OTEncodeData_T fd(buf.buf, buf.bufsize, NULL, 0);
+                OTEncodeData_T fd(NULL, 0, buf.buf, buf.bufsize);
                 fd.fType = OTRadioLink::FTS_ALIVE;
                 return(encode(fd, il_, e, scratch, key));
             }
@@ -787,6 +865,168 @@ namespace OTRadioLink
                         const uint8_t *key);
         };
 
+    /**
+     * @brief   Encoder for secure small frames of a single fixed shape.
+     *
+     * SimpleSecureFrame32or0BodyTXBase::encodeRaw() works out the header
+     * layout for any frame type, ID length and body length at runtime, via
+     * SecurableFrameHeader::encodeHeader(). A node that only ever sends one
+     * shape of frame, such as a valve sending 'O' frames, can use this
+     * instead: the layout, trailer offsets and scratch usage are constexpr
+     * and most checks are made at compile time, so the encode path is
+     * shorter and has far fewer branches.
+     *
+     * Output is byte-for-byte identical to the generic path.
+     * Unlike the generic path, fd.sfh is NOT filled in.
+     *
+     * @param   fType_: Frame type (without secure bit).
+     * @param   il_: ID length in the header.
+     * @param   bl_: Encrypted body length, 0 or ENC_BODY_SMALL_FIXED_CTEXT_SIZE.
+     */
+    template <FrameType_Secureable fType_, uint8_t il_, uint8_t bl_>
+    class SimpleSecureFrame32or0BodyTXFixed final
+        {
+        public:
+            static_assert((FTS_NONE != fType_) && (fType_ < FTS_INVALID_HIGH), "bad frame type");
+            static_assert((0 == bl_) || (ENC_BODY_SMALL_FIXED_CTEXT_SIZE == bl_), "body must be 0 or 32 bytes");
+            static_assert(il_ <= SecurableFrameHeader::maxIDLength, "ID too long");
+
+            // Header length, including the leading frame length byte.
+            static constexpr uint8_t hl = 4 + il_;
+            // 'O' style trailer: 6 bytes of message counter, 16-byte tag, 0x80.
+            static constexpr uint8_t tl = 23;
+            // Frame length, excluding the leading frame length byte.
+            static constexpr uint8_t fl = hl - 1 + bl_ + tl;
+            static_assert(fl <= SecurableFrameHeader::maxSmallFrameSize, "frame too long: reduce il");
+            static constexpr uint8_t bodyOffset = hl;
+            static constexpr uint8_t trailerOffset = hl + bl_;
+            static constexpr uint8_t tagOffset = fl - 16;
+            // Buffer size needed for the entire frame including length byte.
+            static constexpr uint8_t frameBufSize = fl + 1;
+
+            static constexpr uint8_t encodeRaw_scratch_usage = 0;
+            static constexpr size_t encodeRaw_total_scratch_usage_OTAESGCM_2p0 =
+                SimpleSecureFrame32or0BodyTXBase::workspaceRequred_GCM32B16B_OTAESGCM_2p0 +
+                encodeRaw_scratch_usage;
+
+            /**
+             * @brief   Encode an entire secure frame of this shape with the
+             *          supplied IV. As SimpleSecureFrame32or0BodyTXBase::encodeRaw().
+             *
+             * @param   buf, OUTPUT: Buffer of at least frameBufSize bytes. Never NULL.
+             * @param   ptext, MUTABLE INPUT: Body plain text, padded in situ to
+             *              32 bytes. Must be a 32-byte buffer if bl_ is not 0,
+             *              else ignored.
+             * @param   ptextLen: Length of the plain text before padding, < 32.
+             * @param   id, INPUT: il_ ID bytes for the header. Never NULL.
+             * @param   iv, INPUT: 12-byte IV/nonce. Never NULL.
+             * @param   e: Encryption function.
+             * @param   scratch: Scratch space. Size must be large enough to contain
+             *              encodeRaw_total_scratch_usage_OTAESGCM_2p0 bytes AND the
+             *              scratch space required by the encryption function `e`.
+             * @param   key, INPUT: 16-byte secret key. Never NULL.
+             * @retval  frameBufSize, or 0 in case of error.
+             */
+            static uint8_t encodeRaw(
+                        uint8_t *const buf,
+                        uint8_t *const ptext,
+                        const uint8_t ptextLen,
+                        const uint8_t *const id,
+                        const uint8_t *const iv,
+                        SimpleSecureFrame32or0BodyTXBase::fixed32BTextSize12BNonce16BTagSimpleEnc_fn_t &e,
+                        OTV0P2BASE::ScratchSpaceL &scratch,
+                        const uint8_t *const key)
+                {
+                if((NULL == buf) || (NULL == id) || (NULL == iv) || (NULL == key)) { return(0); } // ERROR
+                if(0 != bl_)
+                    {
+                    if(NULL == ptext) { return(0); } // ERROR
+                    if(0 == SimpleSecureFrame32or0BodyTXBase::pad32BBuffer(ptext, ptextLen)) { return(0); } // ERROR
+                    }
+                buf[0] = fl;
+                buf[1] = uint8_t(0x80 | fType_);
+                buf[2] = uint8_t(il_ | ((iv[11] & 0xf) << 4));
+                memcpy(buf + 3, id, il_);
+                buf[hl - 1] = bl_;
+                if(!e(scratch.buf, scratch.bufsize, key, iv, buf, hl, (0 == bl_) ? NULL : ptext, buf + bodyOffset, buf + tagOffset)) { return(0); } // ERROR
+                memcpy(buf + trailerOffset, iv + 6, 6);
+                buf[fl] = 0x80;
+                return(frameBufSize);
+                }
+
+            static constexpr uint8_t encodeValveFrame_scratch_usage = 12;
+            static constexpr size_t encodeValveFrame_total_scratch_usage_OTAESGCM_2p0 =
+                encodeRaw_total_scratch_usage_OTAESGCM_2p0 +
+                encodeValveFrame_scratch_usage;
+
+            /**
+             * @brief   Create simple 'O' frame with an optional stats section
+             *          for transmission, from tx.
+             *          As SimpleSecureFrame32or0BodyTXBase::encodeValveFrame().
+             *
+             * Only available for 'O' frames with a body and il_ <= 6.
+             *
+             * @param   tx: Supplies the ID and the next message counter.
+             * @param   fd: As for SimpleSecureFrame32or0BodyTXBase::encodeValveFrame(),
+             *              but ptext must be a 32-byte buffer and outbufSize
+             *              at least frameBufSize.
+             * @param   valvePC: Percentage valve is open or 0x7f if no valve to report on.
+             * @param   e: Encryption function.
+             * @param   scratch: Scratch space. Size must be large enough to contain
+             *              encodeValveFrame_total_scratch_usage_OTAESGCM_2p0 bytes AND
+             *              the scratch space required by the encryption function `e`.
+             * @param   key, INPUT: 16-byte secret key. Never NULL.
+             * @retval  Returns number of bytes written to fd.outbuf, or 0 in case of error.
+             */
+            static uint8_t encodeValveFrame(
+                        SimpleSecureFrame32or0BodyTXBase &tx,
+                        OTEncodeData_T &fd,
+                        const uint8_t valvePC,
+                        SimpleSecureFrame32or0BodyTXBase::fixed32BTextSize12BNonce16BTagSimpleEnc_fn_t &e,
+                        OTV0P2BASE::ScratchSpaceL &scratch,
+                        const uint8_t *const key)
+                {
+                static_assert(FTS_BasicSensorOrValve == fType_, "not an 'O' frame");
+                static_assert(ENC_BODY_SMALL_FIXED_CTEXT_SIZE == bl_, "valve frames have a body");
+                static_assert(il_ <= 6, "ID is taken from the IV");
+                if(scratch.bufsize < encodeValveFrame_total_scratch_usage_OTAESGCM_2p0) { return(0); } // ERROR
+                uint8_t *const ptext = fd.ptext;
+                if((NULL == ptext) || (fd.ptextbufSize < bl_)) { return(0); } // ERROR
+                if(fd.outbufSize < frameBufSize) { return(0); } // ERROR
+                // IV at start of scratch space; its first 6 bytes are the ID.
+                uint8_t *const iv = scratch.buf;
+                if(!tx.computeIVForTX12B(iv)) { return(0); } // FAIL
+                const char *const statsJSON = (const char *)&ptext[2];
+                const bool hasStats = ('{' == statsJSON[0]);
+                // Stats length including trailing '}' (not sent);
+                // must be '\0'-terminated within the body buffer.
+                const size_t slp1 = hasStats ? strnlen(statsJSON, bl_ - 2) : 1;
+                if(slp1 >= size_t(bl_ - 2)) { return(0); } // ERROR
+                ptext[0] = (valvePC <= 100) ? valvePC : 0x7f;
+                ptext[1] = hasStats ? 0x10 : 0;
+                OTV0P2BASE::ScratchSpaceL subscratch(scratch, encodeValveFrame_scratch_usage);
+                return(encodeRaw(fd.outbuf, ptext, uint8_t(hasStats ? 1 + slp1 : 2), iv, iv, e, subscratch, key));
+                }
+        };
+
+    // Encoder for the secure 'O' frames sent by valves, with the given ID length.
+    template <uint8_t il_>
+    using SimpleSecureValveFrameTX =
+        SimpleSecureFrame32or0BodyTXFixed<FTS_BasicSensorOrValve, il_, ENC_BODY_SMALL_FIXED_CTEXT_SIZE>;
+
+    // Call sites in the secure frame decode stack, for recording scratch
+    // space use with OTV0P2BASE::ScratchSpaceArena.
+    enum ScratchSite_t : uint8_t
+        {
+        SCRATCH_SITE_decodeAndHandleOTSecureOFrame = 1,
+        SCRATCH_SITE_authAndDecodeOTSecurableFrame,
+        SCRATCH_SITE_decode,
+        SCRATCH_SITE__decodeFromID,
+        SCRATCH_SITE_decodeRaw,
+        // Workspace offered to the decryption function.
+        SCRATCH_SITE_decrypt,
+        };
+
     // RX Base class for simple implementations that supports 0 or 32 byte encrypted body sections.
     // This wraps up any necessary state, persistent and ephemeral, such as message counters.
     // Some implementations make sense only as singletons,
@@ -803,17 +1043,55 @@ namespace OTRadioLink
     class SimpleSecureFrame32or0BodyRXBase : public SimpleSecureFrame32or0BodyBase
         {
         private:
+            // Find the first associated node at or after index whose ID
+            // starts with the ID prefix in sfh, copying its full ID to nodeID.
+            // Returns its index, or -1 if none.
             virtual int8_t _getNextMatchingNodeID(const uint8_t index, const SecurableFrameHeader *const sfh, uint8_t *nodeID) const = 0;
 
+            // Table indices of the senders most recently authenticated by
+            // decode(), most recent first, -1 if unused.
+            // Tried first when several associations match an ID prefix.
+            static constexpr uint8_t recentSendersSize = 4;
+            int8_t recentSenders[recentSendersSize] = { -1, -1, -1, -1 };
+            // Move index to the front of recentSenders.
+            void _noteRecentSender(int8_t index);
+            // True if index is in recentSenders.
+            bool _isRecentSender(int8_t index) const;
+
+        protected:
+            // Call _getNextMatchingNodeID() on another instance,
+            // for implementations that wrap an existing one.
+            static int8_t _getNextMatchingNodeIDOf(const SimpleSecureFrame32or0BodyRXBase &rx,
+                    const uint8_t index, const SecurableFrameHeader *const sfh, uint8_t *nodeID)
+                { return(rx._getNextMatchingNodeID(index, sfh, nodeID)); }
+
         public:
+            // Maximum number of associated nodes matching the ID prefix of a
+            // frame that decode() will try when firstIDMatchOnly is false.
+            // Bounds the work (and decryption attempts) per frame.
+            static constexpr uint8_t maxIDMatchAttempts = 4;
+
+            // If exactly one associated node has an ID starting with the ID
+            // prefix in sfh, copy its full ID to nodeID and return true,
+            // ie the sender of such a frame is known before authentication.
+            // Returns false if no node or more than one matches.
+            bool getUniqueMatchingNodeID(const SecurableFrameHeader *sfh, uint8_t *nodeID) const;
+
             // Check one (6-byte) message counter against another for magnitude.
             // Returns 0 if they are identical, +ve if the first counter is greater, -ve otherwise.
             // Logically like getting the sign of counter1 - counter2.
             static int16_t msgcountercmp(const uint8_t *counter1, const uint8_t *counter2)
+#if defined(OTRADIOLINK_MSGCTR_PACKED)
+                { return(msgctr48cmp(msgctr48load(counter1), msgctr48load(counter2))); }
+#else
                 { return(int16_t(memcmp(counter1, counter2, fullMsgCtrBytes))); }
+#endif
 
             // Add specified small unsigned value to supplied counter value in place; false if failed.
             // This will fail (returning false) if the counter would overflow, leaving it unchanged.
+            // Always byte-wise: the usual no-carry case touches one byte,
+            // which is cheaper than a round trip through msgctr48_t;
+            // callers already holding a packed counter should use msgctr48add().
             static bool msgcounteradd(uint8_t *counter, uint8_t delta);
 
 
@@ -860,6 +1138,25 @@ namespace OTRadioLink
                     const uint8_t *ciphertext, const uint8_t *tag,
                     uint8_t *plaintextOut);
 
+            // Signatures for decryption split into a per-key setup step and a
+            // per-frame step, so that a receiver seeing many frames under the
+            // same key need not redo key expansion (eg the AES-128 key schedule
+            // and GCM GHASH table) for every frame.
+            // The setup function expands the 16-byte key into an opaque key
+            // context of an implementation-defined size;
+            // returns true on success, false on failure.
+            typedef bool (fixed32BTextSize12BNonce16BTagSimpleKeySetup_fn_t)(
+                    const uint8_t *key, uint8_t *keyContext);
+            // As fixed32BTextSize12BNonce16BTagSimpleDec_fn_t but taking the
+            // output of the matching setup function in place of the raw key.
+            // Returns true on success, false on failure.
+            typedef bool (fixed32BTextSize12BNonce16BTagSimpleDecWithContext_fn_t)(
+                    uint8_t *workspace, size_t workspaceSize,
+                    const uint8_t *keyContext, const uint8_t *iv,
+                    const uint8_t *authtext, uint8_t authtextSize,
+                    const uint8_t *ciphertext, const uint8_t *tag,
+                    uint8_t *plaintextOut);
+
             /**
              * @brief   Decode entire secure small frame from raw frame bytes and crypto support.
              *
@@ -1037,11 +1334,11 @@ namespace OTRadioLink
              *              decode_total_scratch_usage_OTAESGCM_3p0 bytes AND the scratch
              *              space required by the decryption function `d`.
              * @param   key, INPUT: 16-byte secret key. Never NULL.
-             * @param   firstIDMatchOnly: IGNORED! If the 'firstMatchIDOnly' is true
-             *              (the default) then this only checks the first ID prefix
-             *              match found if any, else all possible entries may be tried
-             *              depending on the implementation  and, for example,
-             *              time/resource limits.
+             * @param   firstIDMatchOnly: If true (the default) then this only
+             *              checks the first ID prefix match found if any. Else the
+             *              associated nodes matching the ID prefix are tried, the
+             *              most recently authenticated first then in table order,
+             *              up to maxIDMatchAttempts nodes.
              * @retval  Total frame length + fl byte + 1, or 0 if there is an error, eg.
              *          because authentication failed, or this is a duplicate message.
              *          - If this returns 1, the frame was authenticated but had no body.
@@ -1062,7 +1359,200 @@ namespace OTRadioLink
                         const uint8_t *key,
                         bool firstIDMatchOnly = true);
 
+            /**
+             * @brief   Decode a batch of structurally correct secure small frames
+             *          that all use the same key, expanding the key only once.
+             *
+             * Intended for hosts such as concentrators/gateways that receive
+             * frames from many nodes and drain them in bursts. Each frame goes
+             * through exactly the same checks as decode(), in order, so counter
+             * updates from an earlier frame in the batch are seen by later ones.
+             *
+             * The key is expanded once with setup into a key context at the
+             * start of the scratch space, and d then uses that context for
+             * every frame, so the key schedule is not rebuilt per frame.
+             * The scratch space is checked and the sub-space for decode()
+             * carved once for the whole batch.
+             * The key context is wiped before returning.
+             *
+             * @param   fds: Array of nFrames pointers to frame data, each set up as
+             *              for decode(). A NULL entry is treated as a failed frame.
+             * @param   nFrames: Number of entries in fds and results.
+             * @param   setup: Key setup function matching d.
+             * @param   d: Decryption function taking the key context made by setup.
+             * @param   keyContextSize: Size of the key context made by setup.
+             * @param   scratch: Scratch space. Size must be large enough to contain
+             *              ScratchSpaceL::alignedSize(keyContextSize) bytes plus
+             *              decodeBatch_total_scratch_usage_OTAESGCM_3p0 bytes AND the
+             *              scratch space required by the decryption function `d`.
+             * @param   key, INPUT: 16-byte secret key. Never NULL.
+             * @param   results, OUTPUT: Array of nFrames bytes to receive the
+             *              decode() result for each frame (0 on failure). May be
+             *              NULL if only the count is wanted.
+             * @param   firstIDMatchOnly: As for decode().
+             * @retval  Number of frames successfully authenticated and decoded.
+             *          Returns 0 without touching any frame if the arguments,
+             *          key setup or scratch space are unusable.
+             */
+            static constexpr size_t decodeBatch_total_scratch_usage_OTAESGCM_3p0 =
+                decode_total_scratch_usage_OTAESGCM_3p0;
+            uint8_t decodeBatch(
+                        OTDecodeData_T *const *fds,
+                        uint8_t nFrames,
+                        fixed32BTextSize12BNonce16BTagSimpleKeySetup_fn_t &setup,
+                        fixed32BTextSize12BNonce16BTagSimpleDecWithContext_fn_t &d,
+                        size_t keyContextSize,
+                        OTV0P2BASE::ScratchSpaceL &scratch,
+                        const uint8_t *key,
+                        uint8_t *results,
+                        bool firstIDMatchOnly = true);
+
+        private:
+            // Check the counter of, decode with, and if successful update
+            // the counter of, the sender with the full ID in nodeID.
+            // Returns as for decode().
+            uint8_t _decodeFromCandidate(
+                        OTDecodeData_T &fd,
+                        fixed32BTextSize12BNonce16BTagSimpleDec_fn_t &d,
+                        uint8_t *nodeID,
+                        const uint8_t *messageCounter,
+                        OTV0P2BASE::ScratchSpaceL &subScratch,
+                        const uint8_t *key);
+        };
+
+
+    /**
+     * @brief   Small cache of precomputed decryption key contexts, indexed
+     *          by the raw 16-byte key.
+     *
+     * Intended for RX hosts where most frames arrive under one or a few keys,
+     * so that key setup is done once per key rather than once per frame.
+     * - On a miss the least recently used entry is wiped and replaced.
+     * - Holds copies of the keys and derived material in RAM, from the
+     *   first use of a key until its entry is evicted by a miss on another
+     *   key, clear() is called, or the cache is destroyed; each of those
+     *   zeroes the entry. Call clear() as soon as a key is changed or no
+     *   longer needed, eg when the building key is reset.
+     * - Not thread- or ISR-safe.
+     *
+     * @param   keyContextSize: Size of the context produced by the setup
+     *              function in use.
+     * @param   nEntries: Number of distinct keys held, at least 1.
+     *
+     * @note    Use with fixed32BTextSize12BNonce16BTagSimpleDecCached() to
+     *          present a cached decrypt to decode().
+     */
+    template <size_t keyContextSize, uint8_t nEntries = 1>
+    class SimpleDecKeyContextCache final
+    {
+        static_assert(nEntries > 0, "need at least one entry");
+    private:
+        struct Entry
+        {
+            bool valid;
+            uint8_t key[16];
+            uint8_t context[keyContextSize];
         };
+        Entry entries[nEntries];
+        // Entry indices, most recently used first.
+        uint8_t mru[nEntries];
+        // Number of key setups done since construction or clear().
+        uint16_t setups;
+
+        // Zero an entry, including the key.
+        static void wipe(Entry &e)
+            { OTV0P2BASE::wipeSecret(reinterpret_cast<uint8_t *>(&e), sizeof(e)); }
+
+        // Make entry at position pos in mru[] the most recently used.
+        void toFront(const uint8_t pos)
+        {
+            const uint8_t e = mru[pos];
+            for(uint8_t i = pos; i > 0; --i) { mru[i] = mru[i-1]; }
+            mru[0] = e;
+        }
+
+    public:
+        SimpleDecKeyContextCache() { clear(); }
+        ~SimpleDecKeyContextCache() { clear(); }
+
+        // Wipe all entries, including the cached keys.
+        void clear()
+        {
+            for(uint8_t i = 0; i < nEntries; ++i) { wipe(entries[i]); }
+            for(uint8_t i = 0; i < nEntries; ++i) { mru[i] = i; }
+            setups = 0;
+        }
+
+        // Number of key setups done, ie cache misses, since the last clear().
+        uint16_t getSetupCount() const { return(setups); }
+
+        /**
+         * @brief   Get the precomputed context for a key, doing the setup on
+         *          a miss.
+         * @param   key, INPUT: 16-byte secret key. Never NULL.
+         * @param   setup: Key setup function matching the decrypt in use.
+         * @retval  Pointer to keyContextSize bytes of context, valid until
+         *          the next call or clear(), or NULL on failure.
+         */
+        const uint8_t *getContext(const uint8_t *const key,
+            SimpleSecureFrame32or0BodyRXBase::fixed32BTextSize12BNonce16BTagSimpleKeySetup_fn_t &setup)
+        {
+            if(nullptr == key) { return(nullptr); } // ERROR
+            for(uint8_t i = 0; i < nEntries; ++i) {
+                Entry &e = entries[mru[i]];
+                if(!e.valid) { break; } // Valid entries are always first.
+                if(0 == memcmp(e.key, key, sizeof(e.key))) {
+                    toFront(i);
+                    return(e.context);
+                }
+            }
+            // Miss: wipe and replace the least recently used entry.
+            toFront(nEntries - 1);
+            Entry &e = entries[mru[0]];
+            wipe(e);
+            ++setups;
+            if(!setup(key, e.context)) {
+                wipe(e);
+                // Put the invalid entry back at the end.
+                for(uint8_t i = 0; i < nEntries - 1; ++i) { mru[i] = mru[i+1]; }
+                mru[nEntries - 1] = uint8_t(&e - entries);
+                return(nullptr); // FAIL
+            }
+            memcpy(e.key, key, sizeof(e.key));
+            e.valid = true;
+            return(e.context);
+        }
+    };
+
+    /**
+     * @brief   Adapter presenting a context-aware decrypt with a key context
+     *          cache as a plain fixed32BTextSize12BNonce16BTagSimpleDec_fn_t,
+     *          so that it can be passed to decode() and friends unchanged.
+     *
+     * The key argument is looked up in the cache and only expanded with
+     * setup on a miss.
+     *
+     * @param   cache_t: Type of the cache, eg SimpleDecKeyContextCache<N>.
+     * @param   cache: Cache instance, with static storage duration.
+     * @param   setup: Key setup function.
+     * @param   dec: Decrypt function using the context produced by setup.
+     * @retval  Returns true on success, false on failure.
+     */
+    template <typename cache_t, cache_t &cache,
+              SimpleSecureFrame32or0BodyRXBase::fixed32BTextSize12BNonce16BTagSimpleKeySetup_fn_t &setup,
+              SimpleSecureFrame32or0BodyRXBase::fixed32BTextSize12BNonce16BTagSimpleDecWithContext_fn_t &dec>
+    bool fixed32BTextSize12BNonce16BTagSimpleDecCached(
+            uint8_t *const workspace, const size_t workspaceSize,
+            const uint8_t *const key, const uint8_t *const iv,
+            const uint8_t *const authtext, const uint8_t authtextSize,
+            const uint8_t *const ciphertext, const uint8_t *const tag,
+            uint8_t *const plaintextOut)
+    {
+        const uint8_t *const keyContext = cache.getContext(key, setup);
+        if(nullptr == keyContext) { return(false); } // FAIL
+        return(dec(workspace, workspaceSize, keyContext, iv,
+                   authtext, authtextSize, ciphertext, tag, plaintextOut));
+    }
 
 
     /**
@@ -1105,6 +1595,18 @@ namespace OTRadioLink
      */
     SimpleSecureFrame32or0BodyRXBase::fixed32BTextSize12BNonce16BTagSimpleDec_fn_t fixed32BTextSize12BNonce16BTagSimpleDec_NULL_IMPL;
 
+    /**
+     * @brief   NULL key setup function to pair with
+     *          fixed32BTextSize12BNonce16BTagSimpleDec_NULL_IMPL() where a
+     *          key context is wanted, eg for decodeBatch().
+     *          DO NOT USE IN PRODUCTION SYSTEMS.
+     *
+     * The context is simply a copy of the 16-byte key, so the NULL decrypt
+     * can be used unchanged as the matching decrypt-with-context.
+     */
+    static constexpr size_t fixed32BTextSize12BNonce16BTagSimpleKeyContextSize_NULL_IMPL = 16;
+    SimpleSecureFrame32or0BodyRXBase::fixed32BTextSize12BNonce16BTagSimpleKeySetup_fn_t fixed32BTextSize12BNonce16BTagSimpleKeySetup_NULL_IMPL;
+
 
     // CONVENIENCE/BOILERPLATE METHODS
 
@@ -1137,30 +1639,39 @@ namespace OTRadioLink
      * - Note that the counter value must be LESS than the value you expect to use or decryption will fail!
      * - The counter will not be incremented between calls and the methods will always act as if they have
      *   succeeded.
+     * - Several candidate IDs may be set with setMockIDValues(), eg to
+     *   test decode() with firstIDMatchOnly false; each matches any frame.
      *
      * @note    See FrameHandlerTest.cpp for example use.
      */
     class SimpleSecureFrame32or0BodyRXFixedCounter final : public SimpleSecureFrame32or0BodyRXBase
     {
+    public:
+        // Maximum number of candidate IDs.
+        static constexpr uint8_t maxMockIDs = maxIDMatchAttempts;
+
     private:
-        uint8_t mockID[8];
+        uint8_t mockIDs[maxMockIDs][8];
+        uint8_t nMockIDs;
         uint8_t mockCounter[6];
 
         SimpleSecureFrame32or0BodyRXFixedCounter()
         {
-            memset(mockID, 0, sizeof(mockID));
+            memset(mockIDs, 0, sizeof(mockIDs));
+            nMockIDs = 1;
             memset(mockCounter, 0, sizeof(mockCounter));
         }
         /**
-         * @brief   Copies mockID into the provided buffer.
-         * @param   index: The index the caller expects you to search first. Should be >= 0
-         * @param   nodeID: Buffer to copy mockID too. Must be at least 6 bytes.
-         * @retval  always true.
+         * @brief   Copies the candidate ID at index into the provided buffer.
+         * @param   index: The index of the candidate to return.
+         * @param   nodeID: Buffer to copy the ID to. Must be at least 8 bytes.
+         * @retval  index, or -1 if there is no candidate at index.
          */
         virtual int8_t _getNextMatchingNodeID(const uint8_t index, const SecurableFrameHeader *const /* sfh */, uint8_t *nodeID) const override
         {
-            memcpy(nodeID, mockID, 6);
-            return (index);
+            if(index >= nMockIDs) { return(-1); }
+            memcpy(nodeID, mockIDs[index], 8);
+            return (int8_t(index));
         }
     public:
         static SimpleSecureFrame32or0BodyRXFixedCounter &getInstance()
@@ -1205,7 +1716,19 @@ namespace OTRadioLink
          */
         void setMockIDValue(const uint8_t * newID)
         {
-            memcpy(mockID, newID, 8);
+            memcpy(mockIDs[0], newID, 8);
+            nMockIDs = 1;
+        }
+        /**
+         * @brief   Set n candidate 8 byte IDs, tried in order by decode().
+         * @param   newIDs: n IDs, each 8 bytes, one after another.
+         * @param   n: Number of IDs, in [1,maxMockIDs].
+         */
+        void setMockIDValues(const uint8_t * newIDs, const uint8_t n)
+        {
+            if((0 == n) || (n > maxMockIDs)) { return; } // ERROR
+            memcpy(mockIDs, newIDs, 8 * n);
+            nMockIDs = n;
         }
         /**
          * @brief   Set the value of the internal 6 byte counter to allow us to decode a frame.
@@ -1218,6 +1741,504 @@ namespace OTRadioLink
     };
 
 
+    /**
+     * @brief   Write-back RX message counter cache in front of a persistent
+     *          RX counter store, for high-rate receivers such as hubs.
+     *
+     * Counters are validated and updated in RAM. The persistent store is
+     * only written when a counter passes the high-water mark last reserved
+     * in it, at which point a new mark reservationStep above the accepted
+     * counter is persisted. This is the RX-side analogue of the TX restart
+     * counter: what is persisted is always >= every counter accepted, so
+     * after a reboot (which reloads the mark as the last-seen counter) no
+     * frame accepted before the reboot can be replayed.
+     * - Store writes fall by a factor of ~reservationStep for a node sending
+     *   consecutive counters.
+     * - The cost is that after a receiver reboot up to reservationStep
+     *   legitimate frames from each node may be rejected as too old.
+     * - Each cached counter is tagged with its node ID so a changed
+     *   association at the same index is reloaded from the store; call
+     *   invalidate() or invalidateAll() if the store is changed directly.
+     * - Not thread- or ISR-safe.
+     *
+     * The deriving class supplies the ID lookups; the store is any RX
+     * implementation whose getLastRXMsgCtr() and authAndUpdateRXMsgCtr()
+     * persist counters, eg SimpleSecureFrame32or0BodyRXV0p2.
+     *
+     * @param   maxNodes: Number of association indices to cache counters for.
+     * @param   reservationStep: Counter headroom reserved per store write,
+     *              in [1,255].
+     */
+    template <uint16_t maxNodes, uint8_t reservationStep = 32>
+    class SimpleSecureFrame32or0BodyRXWriteBack : public SimpleSecureFrame32or0BodyRXBase
+    {
+        static_assert(reservationStep > 0, "reservationStep must be non-zero");
+    private:
+        // Per-node RAM state.
+        struct CounterSlot
+        {
+            bool loaded;
+            // Node the slot was loaded for, in case associations change.
+            uint8_t id[OTV0P2BASE::OpenTRV_Node_ID_Bytes];
+            // Last authenticated counter.
+            uint8_t last[fullMsgCtrBytes];
+            // Value held in the store, never less than last.
+            uint8_t reserved[fullMsgCtrBytes];
+        };
+        // Loaded lazily from getLastRXMsgCtr(), which is const.
+        mutable CounterSlot slots[maxNodes];
+
+        // Persistent store.
+        SimpleSecureFrame32or0BodyRXBase &store;
+
+        /**
+         * @brief   Get the association index of a full node ID.
+         * @param   ID: Full (8-byte) node ID. May be NULL (fails).
+         * @retval  Index in [0,maxNodes[, or -1 if not associated.
+         */
+        virtual int16_t _getNodeIndex(const uint8_t *ID) const = 0;
+
+        // Get the slot for ID, loading it from the store if need be;
+        // NULL on failure.
+        CounterSlot *getSlot(const uint8_t *const ID) const
+        {
+            const int16_t index = _getNodeIndex(ID);
+            if((index < 0) || (index >= int16_t(maxNodes))) { return(nullptr); } // FAIL
+            CounterSlot &s = slots[index];
+            if(!s.loaded || (0 != memcmp(s.id, ID, sizeof(s.id)))) {
+                // Whatever is in the store may have been reserved but never
+                // used, so it is all that can safely be assumed seen.
+                if(!store.getLastRXMsgCtr(ID, s.reserved)) { return(nullptr); } // FAIL
+                memcpy(s.last, s.reserved, fullMsgCtrBytes);
+                memcpy(s.id, ID, sizeof(s.id));
+                s.loaded = true;
+            }
+            return(&s);
+        }
+
+    protected:
+        // Store must outlive this object.
+        explicit SimpleSecureFrame32or0BodyRXWriteBack(SimpleSecureFrame32or0BodyRXBase &_store)
+            : store(_store) { invalidateAll(); }
+
+    public:
+        // Forget cached counters, forcing a reload from the store on next use.
+        void invalidateAll() { memset(slots, 0, sizeof(slots)); }
+        void invalidate(const uint16_t index) { if(index < maxNodes) { slots[index].loaded = false; } }
+
+        // Read current (last-authenticated) RX message count for specified node, or return false if failed.
+        // Served from RAM after the first call for each node.
+        virtual bool getLastRXMsgCtr(const uint8_t * const ID, uint8_t *counter) const override
+        {
+            if(nullptr == counter) { return(false); } // FAIL
+            const CounterSlot *const s = getSlot(ID);
+            if(nullptr == s) { return(false); } // FAIL
+            memcpy(counter, s->last, fullMsgCtrBytes);
+            return(true);
+        }
+
+        // Update message counter for received frame AFTER successful authentication.
+        // Only writes to the store when the new counter passes the reserved value.
+        // Returns false on failure, eg if the counter is not higher than the previous value,
+        // or the reservation could not be persisted (in which case nothing is changed).
+        virtual bool authAndUpdateRXMsgCtr(const uint8_t *ID, const uint8_t *newCounterValue) override
+        {
+            if(!validateRXMsgCtr(ID, newCounterValue)) { return(false); } // FAIL
+            CounterSlot *const s = getSlot(ID);
+            if(nullptr == s) { return(false); } // FAIL
+            if(msgcountercmp(newCounterValue, s->reserved) > 0) {
+                // Reserve headroom above the new value, or as much as is left.
+                uint8_t newReserved[fullMsgCtrBytes];
+                memcpy(newReserved, newCounterValue, fullMsgCtrBytes);
+                if(!msgcounteradd(newReserved, reservationStep))
+                    { memcpy(newReserved, newCounterValue, fullMsgCtrBytes); }
+                if(!store.authAndUpdateRXMsgCtr(ID, newReserved)) { return(false); } // FAIL
+                memcpy(s->reserved, newReserved, fullMsgCtrBytes);
+            }
+            memcpy(s->last, newCounterValue, fullMsgCtrBytes);
+            return(true);
+        }
+    };
+
+
+    /**
+     * @brief   LRU cache of recent sender sessions in front of an RX
+     *          implementation, so that frequent senders (eg boiler relays
+     *          and hubs) skip the association table scan and the stored
+     *          counter read before decryption.
+     *
+     * Each entry holds, for one sender, its resolved full node ID, its
+     * association index and its last accepted message counter.
+     * - An ID prefix lookup is served from the cache when an entry's ID
+     *   starts with the prefix and the entry is known to be the first match
+     *   at or after the requested start index.
+     * - A counter lookup is served from the cache once loaded, and kept in
+     *   step by authAndUpdateRXMsgCtr() on success.
+     * - Counter updates are always written through to the store.
+     *   For a cached sender the update is checked against the cached
+     *   counter and handed to _writeRXMsgCtr() with the cached association
+     *   index, so that the store need not look the sender up again;
+     *   use SimpleSecureFrame32or0BodyRXWriteBack as the store to also
+     *   avoid most store writes.
+     * - All sessions are dropped when _getAssociationsGeneration() changes,
+     *   ie when associations are added or removed.
+     *   Call invalidateAll() if stored counters are changed other than
+     *   through this object.
+     * - Hit/miss counts are kept to help size the cache.
+     * - Not thread- or ISR-safe.
+     *
+     * The deriving class supplies the uncached association table lookup.
+     *
+     * @param   cacheSize: Number of sender sessions to keep; in [1,127].
+     */
+    // Lookup statistics of SimpleSecureFrame32or0BodyRXSessionCache
+    // since construction or resetStats().
+    struct SecureRXSessionCacheStats
+    {
+        // Association table lookups by ID prefix.
+        uint32_t idHits;
+        uint32_t idMisses;
+        // Last accepted counter lookups.
+        uint32_t ctrHits;
+        uint32_t ctrMisses;
+    };
+    template <uint8_t cacheSize = 4>
+    class SimpleSecureFrame32or0BodyRXSessionCache : public SimpleSecureFrame32or0BodyRXBase
+    {
+        static_assert((cacheSize > 0) && (cacheSize <= 127), "cacheSize must be in [1,127]");
+    public:
+        typedef SecureRXSessionCacheStats Stats;
+
+    private:
+        struct Session
+        {
+            // Full node ID; only meaningful if inUse.
+            uint8_t id[OTV0P2BASE::OpenTRV_Node_ID_Bytes];
+            // Association index, or -1 if not yet known.
+            int8_t index;
+            // Lowest start index for which index is the first match
+            // for prefixes of at least il bytes.
+            uint8_t from;
+            uint8_t il;
+            bool inUse;
+            bool ctrLoaded;
+            // Last accepted counter; only meaningful if ctrLoaded.
+            uint8_t ctr[fullMsgCtrBytes];
+        };
+        // Most recently used first; updated from const lookups.
+        mutable Session sessions[cacheSize];
+        mutable Stats stats;
+        // _getAssociationsGeneration() when sessions were last valid.
+        mutable uint8_t generation;
+
+        // Persistent counter store.
+        SimpleSecureFrame32or0BodyRXBase &store;
+
+        /**
+         * @brief   Find the first associated node at or after index whose ID
+         *          starts with the il-byte prefix, bypassing the cache.
+         * @param   nodeID: Buffer for the full (8-byte) ID; never NULL.
+         * @retval  Association index, or -1 if none.
+         */
+        virtual int8_t _getNextMatchingNodeIDFromTable(uint8_t index, const uint8_t *prefix, uint8_t il, uint8_t *nodeID) const = 0;
+
+        // Drop all sessions if the associations have changed.
+        void checkGeneration() const
+        {
+            const uint8_t g = _getAssociationsGeneration();
+            if(g != generation) { memset(sessions, 0, sizeof(sessions)); generation = g; }
+        }
+        // Move entry i to the front, returning it.
+        Session &touch(const uint8_t i) const
+        {
+            if(0 != i) {
+                const Session s = sessions[i];
+                memmove(sessions + 1, sessions, i * sizeof(Session));
+                sessions[0] = s;
+            }
+            return(sessions[0]);
+        }
+        // Find the entry for a full ID and move it to the front;
+        // NULL if none.
+        Session *findByID(const uint8_t *const ID) const
+        {
+            for(uint8_t i = 0; i < cacheSize; ++i) {
+                if(sessions[i].inUse && (0 == memcmp(sessions[i].id, ID, OTV0P2BASE::OpenTRV_Node_ID_Bytes))) { return(&touch(i)); }
+            }
+            return(nullptr);
+        }
+        // Find or create (evicting the least recently used) the entry for
+        // a full ID, at the front.
+        Session &findOrAdd(const uint8_t *const ID) const
+        {
+            Session *const s = findByID(ID);
+            if(nullptr != s) { return(*s); }
+            Session &n = touch(cacheSize - 1);
+            memcpy(n.id, ID, sizeof(n.id));
+            n.index = -1;
+            n.inUse = true;
+            n.ctrLoaded = false;
+            return(n);
+        }
+
+        virtual int8_t _getNextMatchingNodeID(const uint8_t index, const SecurableFrameHeader *const sfh, uint8_t *nodeID) const override
+        {
+            checkGeneration();
+            const uint8_t il = sfh->getIl();
+            for(uint8_t i = 0; i < cacheSize; ++i) {
+                const Session &s = sessions[i];
+                // A shorter prefix than cached may match an earlier node.
+                if(!s.inUse || (s.index < 0) || (il < s.il) ||
+                   (index < s.from) || (index > uint8_t(s.index)) ||
+                   (0 != memcmp(s.id, sfh->id, il))) { continue; }
+                ++stats.idHits;
+                const Session &t = touch(i);
+                if(nullptr != nodeID) { memcpy(nodeID, t.id, sizeof(t.id)); }
+                return(t.index);
+            }
+            ++stats.idMisses;
+            uint8_t id[OTV0P2BASE::OpenTRV_Node_ID_Bytes];
+            const int8_t result = _getNextMatchingNodeIDFromTable(index, sfh->id, il, id);
+            if(result < 0) { return(result); }
+            Session &s = findOrAdd(id);
+            s.index = result;
+            s.from = index;
+            s.il = il;
+            if(nullptr != nodeID) { memcpy(nodeID, id, sizeof(id)); }
+            return(result);
+        }
+
+    protected:
+        // Store must outlive this object.
+        explicit SimpleSecureFrame32or0BodyRXSessionCache(SimpleSecureFrame32or0BodyRXBase &_store)
+            : generation(0), store(_store) { invalidateAll(); resetStats(); }
+
+        /**
+         * @brief   Count (mod 256) of association adds and removals;
+         *          any change drops all sessions.
+         *          The default never changes.
+         */
+        virtual uint8_t _getAssociationsGeneration() const { return(0); }
+
+        /**
+         * @brief   Write an update already checked against the cached
+         *          counter through to the store.
+         *          The default does a full store update, with its own
+         *          lookup and checks.
+         * @param   index: Cached association index of the sender.
+         * @retval  True if the store was updated.
+         */
+        virtual bool _writeRXMsgCtr(int8_t /*index*/, const uint8_t *ID, const uint8_t *newCounterValue)
+            { return(store.authAndUpdateRXMsgCtr(ID, newCounterValue)); }
+
+    public:
+        // Forget all sessions, forcing lookups from the table and store.
+        void invalidateAll() { memset(sessions, 0, sizeof(sessions)); }
+
+        const Stats &getStats() const { return(stats); }
+        void resetStats() { memset(&stats, 0, sizeof(stats)); }
+
+        // Read current (last-authenticated) RX message count for specified node, or return false if failed.
+        // Served from the cache for a recent sender.
+        virtual bool getLastRXMsgCtr(const uint8_t * const ID, uint8_t *counter) const override
+        {
+            if((nullptr == ID) || (nullptr == counter)) { return(false); } // FAIL
+            checkGeneration();
+            Session *const s = findByID(ID);
+            if((nullptr != s) && s->ctrLoaded) {
+                ++stats.ctrHits;
+                memcpy(counter, s->ctr, fullMsgCtrBytes);
+                return(true);
+            }
+            ++stats.ctrMisses;
+            if(!store.getLastRXMsgCtr(ID, counter)) { return(false); } // FAIL
+            Session &n = findOrAdd(ID);
+            memcpy(n.ctr, counter, fullMsgCtrBytes);
+            n.ctrLoaded = true;
+            return(true);
+        }
+
+        // Update message counter for received frame AFTER successful authentication.
+        // Written through to the store; the cached value follows on success.
+        virtual bool authAndUpdateRXMsgCtr(const uint8_t *ID, const uint8_t *newCounterValue) override
+        {
+            // Validation loads the sender's counter into the cache.
+            if(!validateRXMsgCtr(ID, newCounterValue)) { return(false); } // FAIL
+            Session *const s = findByID(ID);
+            const bool ok = ((nullptr != s) && s->ctrLoaded && (s->index >= 0)) ?
+                _writeRXMsgCtr(s->index, ID, newCounterValue) :
+                store.authAndUpdateRXMsgCtr(ID, newCounterValue);
+            if(!ok) {
+                // Stored value unknown: reload it next time.
+                if(nullptr != s) { s->ctrLoaded = false; }
+                return(false); // FAIL
+            }
+            Session &n = (nullptr != s) ? *s : findOrAdd(ID);
+            memcpy(n.ctr, newCounterValue, fullMsgCtrBytes);
+            n.ctrLoaded = true;
+            return(true);
+        }
+    };
+
+
+    /**
+     * @brief   TX message counter issued from RAM out of blocks reserved in
+     *          a persistent store, for busy senders such as hubs and relays.
+     *
+     * The store holds one 6-byte high-water mark that is never less than
+     * any counter issued. Counters are issued from RAM, and the store is
+     * only written when a new block of reservationBlock counters is needed,
+     * by raising the mark to the end of the block BEFORE any counter in it
+     * is used. After a restart (or invalidate()) counters resume above the
+     * persisted mark, ie any unused part of the last block is skipped, so no
+     * counter (and thus IV) is ever reused whenever power is lost.
+     * - Store writes fall to about one per reservationBlock frames; a
+     *   reservationBlock of 1 persists every counter before it is used.
+     * - The cost is up to reservationBlock - 1 counters skipped per restart.
+     * - The top 3 bytes of the mark act as the restart counter prefix.
+     * - Unlike SimpleSecureFrame32or0BodyTXV0p2, no entropy is injected into
+     *   the counter on restart.
+     * - Not thread- or ISR-safe.
+     *
+     * The deriving class supplies the TX ID and the store.
+     *
+     * @param   reservationBlock: Counters reserved per store write; non-zero.
+     */
+    template <uint16_t reservationBlock = 256>
+    class SimpleSecureFrame32or0BodyTXBlockReserve : public SimpleSecureFrame32or0BodyTXBase
+    {
+        static_assert(reservationBlock > 0, "reservationBlock must be non-zero");
+    private:
+        // True once the mark has been loaded from the store.
+        bool loaded = false;
+        // Last counter issued.
+        uint8_t last[fullMsgCtrBytes];
+        // Mark held in the store, never less than last.
+        uint8_t reserved[fullMsgCtrBytes];
+
+        /**
+         * @brief   Load the high-water mark from the persistent store.
+         * @param   buf: 6-byte buffer for the mark. Never NULL.
+         * @retval  false if the store is unreadable or corrupt.
+         *          A fresh store should read as all zeros.
+         */
+        virtual bool _loadTXCtrMark(uint8_t *buf) const = 0;
+        /**
+         * @brief   Persist a new high-water mark.
+         * @param   buf: 6-byte mark. Never NULL.
+         * @retval  false unless the mark is known to have been persisted.
+         */
+        virtual bool _saveTXCtrMark(const uint8_t *buf) = 0;
+
+        // Add delta to counter in place; false (counter unchanged) on overflow.
+        static bool ctradd(uint8_t *const counter, uint16_t delta)
+        {
+#if defined(OTRADIOLINK_MSGCTR_PACKED)
+            msgctr48_t c = msgctr48load(counter);
+            if(!msgctr48add(c, delta)) { return(false); }
+            msgctr48store(counter, c);
+            return(true);
+#else
+            uint8_t tmp[fullMsgCtrBytes];
+            memcpy(tmp, counter, fullMsgCtrBytes);
+            while(delta > 0) {
+                const uint8_t d = (delta > 0xff) ? 0xff : uint8_t(delta);
+                if(!SimpleSecureFrame32or0BodyRXBase::msgcounteradd(tmp, d)) { return(false); }
+                delta -= d;
+            }
+            memcpy(counter, tmp, fullMsgCtrBytes);
+            return(true);
+#endif
+        }
+
+        // Persist a new mark set directly (not by issuing counters),
+        // forcing the next counter to be issued from above it.
+        bool replaceMark(const uint8_t *const mark)
+        {
+            if(!_saveTXCtrMark(mark)) { return(false); } // FAIL
+            loaded = false;
+            return(true);
+        }
+
+    public:
+        // Forget the RAM state as if restarted, so that the next counter
+        // is issued from above the persisted mark.
+        void invalidate() { loaded = false; }
+
+        // Get the 3 bytes of persistent reboot/restart message counter, ie 3 MSBs of the mark; returns false on failure.
+        virtual bool getTXNVCtrPrefix(uint8_t *const buf) const override
+        {
+            if(nullptr == buf) { return(false); } // FAIL
+            uint8_t mark[fullMsgCtrBytes];
+            if(!_loadTXCtrMark(mark)) { return(false); } // FAIL
+            memcpy(buf, mark, txNVCtrPrefixBytes);
+            return(true);
+        }
+        // Reset the persistent mark; returns false on failure.
+        // TO BE USED WITH EXTREME CAUTION: reusing the message counts and resulting IVs
+        // destroys the security of the cipher.
+        // Probably only sensible to call this when changing either the ID or the key (or both).
+        // Unless allZeros, fills the restart prefix with entropy but keeps its top 4 bits clear
+        // to preserve most of the counter life, and guarantees it non-zero.
+        virtual bool resetTXNVCtrPrefix(const bool allZeros = false) override
+        {
+            uint8_t mark[fullMsgCtrBytes];
+            memset(mark, 0, sizeof(mark));
+            if(!allZeros) {
+                for(uint8_t i = 0; i < txNVCtrPrefixBytes; ++i) { mark[i] = OTV0P2BASE::getSecureRandomByte(); }
+                mark[0] = 0xf & (mark[0] ^ (mark[0] >> 4));
+                if((0 == mark[0]) && (0 == mark[1]) && (0 == mark[2])) { mark[txNVCtrPrefixBytes-1] = 1; }
+            }
+            return(replaceMark(mark));
+        }
+        // Increment persistent restart prefix, ie skip to the start of the next 2^24 counters;
+        // returns false on failure.
+        // Will refuse to increment such that the top byte overflows, ie when already at 0xff.
+        virtual bool incrementTXNVCtrPrefix() override
+        {
+            uint8_t mark[fullMsgCtrBytes];
+            if(!_loadTXCtrMark(mark)) { return(false); } // FAIL
+            for(uint8_t i = txNVCtrPrefixBytes; i-- > 0; ) {
+                if(0 != ++mark[i]) { break; }
+                if(0 == i) { return(false); } // FAIL: overflow from top byte not permitted.
+            }
+            memset(mark + txNVCtrPrefixBytes, 0, fullMsgCtrBytes - txNVCtrPrefixBytes);
+            return(replaceMark(mark));
+        }
+        // Fills the supplied 6-byte array with the next monotonically-increasing TX counter.
+        // Only touches the store on first use and when a new block must be reserved.
+        // Returns false on failure, eg counter exhausted or store unusable,
+        // in which case no counter is consumed.
+        // Never returns an all-zero count.
+        // Not ISR-safe.
+        virtual bool getNextTXMsgCtr(uint8_t *const buf) override
+        {
+            if(nullptr == buf) { return(false); } // FAIL
+            if(!loaded) {
+                // Anything up to the mark may have been issued before a restart.
+                if(!_loadTXCtrMark(reserved)) { return(false); } // FAIL
+                memcpy(last, reserved, fullMsgCtrBytes);
+                loaded = true;
+            }
+            uint8_t next[fullMsgCtrBytes];
+            memcpy(next, last, fullMsgCtrBytes);
+            if(!ctradd(next, 1)) { return(false); } // FAIL: counter exhausted.
+            if(SimpleSecureFrame32or0BodyRXBase::msgcountercmp(next, reserved) > 0) {
+                // Reserve the block starting at next, or as much as is left,
+                // persisting it before any of it is used.
+                uint8_t newReserved[fullMsgCtrBytes];
+                memcpy(newReserved, next, fullMsgCtrBytes);
+                if(!ctradd(newReserved, reservationBlock - 1)) { memset(newReserved, 0xff, fullMsgCtrBytes); }
+                if(!_saveTXCtrMark(newReserved)) { return(false); } // FAIL
+                memcpy(reserved, newReserved, fullMsgCtrBytes);
+            }
+            memcpy(last, next, fullMsgCtrBytes);
+            memcpy(buf, next, fullMsgCtrBytes);
+            return(true);
+        }
+    };
+
+
     }
 
 
@@ -0,0 +1,305 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * Portable AES-128-GCM for the fixed-size secure frame crypto interface.
+ *
+ * Byte-oriented and table-light (just the S-box, in Flash on AVR),
+ * following FIPS-197 and NIST SP 800-38D.
+ */
+
+#include <string.h>
+
+#include <OTV0p2Base.h>
+
+#include "OTRadioLink_SecureableFrameType_AESGCMImpl.h"
+
+
+namespace OTRadioLink
+    {
+
+// AES S-box.
+static const uint8_t AESSBox[256] PROGMEM =
+    {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16,
+    };
+
+static inline uint8_t sbox(const uint8_t b) { return(uint8_t(pgm_read_byte(AESSBox + b))); }
+
+// Multiply by x in GF(2^8).
+static inline uint8_t xtime(const uint8_t b) { return(uint8_t((b << 1) ^ ((b & 0x80) ? 0x1b : 0))); }
+
+// Sizes of the parts of the key context.
+static constexpr uint8_t AESBlockBytes = 16;
+static constexpr uint8_t AESScheduleBytes = 176;
+
+// Expand a 16-byte AES-128 key into the 176-byte round key schedule.
+static void aes128ExpandKey(const uint8_t *const key, uint8_t *const rk)
+    {
+    memcpy(rk, key, AESBlockBytes);
+    uint8_t rcon = 1;
+    for(uint8_t i = AESBlockBytes; i < AESScheduleBytes; i += 4)
+        {
+        uint8_t t0 = rk[i-4], t1 = rk[i-3], t2 = rk[i-2], t3 = rk[i-1];
+        if(0 == (i & 15))
+            {
+            // RotWord, SubWord and round constant.
+            const uint8_t t = t0;
+            t0 = uint8_t(sbox(t1) ^ rcon);
+            t1 = sbox(t2);
+            t2 = sbox(t3);
+            t3 = sbox(t);
+            rcon = xtime(rcon);
+            }
+        rk[i]   = uint8_t(rk[i-16] ^ t0);
+        rk[i+1] = uint8_t(rk[i-15] ^ t1);
+        rk[i+2] = uint8_t(rk[i-14] ^ t2);
+        rk[i+3] = uint8_t(rk[i-13] ^ t3);
+        }
+    }
+
+static inline void addRoundKey(uint8_t *const s, const uint8_t *const k)
+    { for(uint8_t i = 0; i < AESBlockBytes; ++i) { s[i] ^= k[i]; } }
+
+// SubBytes then ShiftRows, on the column-major state.
+static void subBytesShiftRows(uint8_t *const s)
+    {
+    for(uint8_t i = 0; i < AESBlockBytes; ++i) { s[i] = sbox(s[i]); }
+    uint8_t t;
+    // Row 1: rotate left by 1.
+    t = s[1]; s[1] = s[5]; s[5] = s[9]; s[9] = s[13]; s[13] = t;
+    // Row 2: rotate left by 2.
+    t = s[2]; s[2] = s[10]; s[10] = t;
+    t = s[6]; s[6] = s[14]; s[14] = t;
+    // Row 3: rotate left by 3, ie right by 1.
+    t = s[15]; s[15] = s[11]; s[11] = s[7]; s[7] = s[3]; s[3] = t;
+    }
+
+static void mixColumns(uint8_t *const s)
+    {
+    for(uint8_t c = 0; c < AESBlockBytes; c += 4)
+        {
+        const uint8_t a0 = s[c], a1 = s[c+1], a2 = s[c+2], a3 = s[c+3];
+        const uint8_t t = uint8_t(a0 ^ a1 ^ a2 ^ a3);
+        s[c]   = uint8_t(a0 ^ t ^ xtime(uint8_t(a0 ^ a1)));
+        s[c+1] = uint8_t(a1 ^ t ^ xtime(uint8_t(a1 ^ a2)));
+        s[c+2] = uint8_t(a2 ^ t ^ xtime(uint8_t(a2 ^ a3)));
+        s[c+3] = uint8_t(a3 ^ t ^ xtime(uint8_t(a3 ^ a0)));
+        }
+    }
+
+// Encrypt one block in place with an expanded key schedule.
+static void aes128EncryptBlock(const uint8_t *const rk, uint8_t *const s)
+    {
+    addRoundKey(s, rk);
+    for(uint8_t round = 1; round < 10; ++round)
+        {
+        subBytesShiftRows(s);
+        mixColumns(s);
+        addRoundKey(s, rk + AESBlockBytes * round);
+        }
+    subBytesShiftRows(s);
+    addRoundKey(s, rk + AESBlockBytes * 10);
+    }
+
+// Workspace layout for the routines taking a key context.
+struct GCMWorkspace
+    {
+    uint8_t x[AESBlockBytes]; // GHASH accumulator.
+    uint8_t z[AESBlockBytes]; // Multiply result; then counter/keystream block.
+    uint8_t v[AESBlockBytes]; // Multiply operand.
+    };
+static_assert(sizeof(GCMWorkspace) == fixed32BTextSize12BNonce16BTagSimpleWorkspaceWithContext_AESGCM_IMPL,
+    "workspace size mismatch");
+
+// GHASH step: x = (x ^ data) . H in GF(2^128), data zero-padded to a block.
+// Masks rather than branches on the secret bits.
+static void ghashBlock(GCMWorkspace &w, const uint8_t *const h,
+                       const uint8_t *const data, const uint8_t len)
+    {
+    for(uint8_t i = 0; i < len; ++i) { w.x[i] ^= data[i]; }
+    memset(w.z, 0, AESBlockBytes);
+    memcpy(w.v, h, AESBlockBytes);
+    for(uint8_t i = 0; i < AESBlockBytes; ++i)
+        {
+        const uint8_t xi = w.x[i];
+        for(uint8_t bit = 0x80; 0 != bit; bit >>= 1)
+            {
+            const uint8_t m = uint8_t(0 - uint8_t(0 != (xi & bit)));
+            for(uint8_t j = 0; j < AESBlockBytes; ++j) { w.z[j] ^= uint8_t(w.v[j] & m); }
+            // v = v . x, ie shift right with reduction.
+            const uint8_t r = uint8_t(0 - (w.v[15] & 1));
+            for(uint8_t j = AESBlockBytes - 1; j > 0; --j)
+                { w.v[j] = uint8_t((w.v[j] >> 1) | (w.v[j-1] << 7)); }
+            w.v[0] = uint8_t((w.v[0] >> 1) ^ (0xe1 & r));
+            }
+        }
+    memcpy(w.x, w.z, AESBlockBytes);
+    }
+
+// Compute the GHASH of authtext and (optional) 32-byte ciphertext into w.x.
+static void ghash(GCMWorkspace &w, const uint8_t *const h,
+                  const uint8_t *const authtext, const uint8_t authtextSize,
+                  const uint8_t *const ciphertext)
+    {
+    memset(w.x, 0, AESBlockBytes);
+    // Wide index so that a long authtext cannot wrap it.
+    for(uint16_t i = 0; i < authtextSize; i += AESBlockBytes)
+        {
+        const uint8_t rest = uint8_t(authtextSize - i);
+        ghashBlock(w, h, authtext + i, (rest < AESBlockBytes) ? rest : AESBlockBytes);
+        }
+    const uint8_t textSize = (nullptr == ciphertext) ? 0 : 32;
+    for(uint8_t i = 0; i < textSize; i += AESBlockBytes)
+        { ghashBlock(w, h, ciphertext + i, AESBlockBytes); }
+    // Lengths in bits as two 64-bit big-endian values; both small here.
+    uint8_t lens[AESBlockBytes] = { };
+    const uint16_t aBits = uint16_t(authtextSize) << 3;
+    const uint16_t cBits = uint16_t(textSize) << 3;
+    lens[6] = uint8_t(aBits >> 8);
+    lens[7] = uint8_t(aBits);
+    lens[14] = uint8_t(cBits >> 8);
+    lens[15] = uint8_t(cBits);
+    ghashBlock(w, h, lens, AESBlockBytes);
+    }
+
+// Fill w.z with E(K, IV || ctr) for a 32-bit block counter value < 256.
+static void counterBlock(GCMWorkspace &w, const uint8_t *const rk,
+                         const uint8_t *const iv, const uint8_t ctr)
+    {
+    memcpy(w.z, iv, 12);
+    w.z[12] = 0;
+    w.z[13] = 0;
+    w.z[14] = 0;
+    w.z[15] = ctr;
+    aes128EncryptBlock(rk, w.z);
+    }
+
+// Expand the key schedule then derive H = E(K, 0^128).
+bool fixed32BTextSize12BNonce16BTagSimpleKeySetup_AESGCM_IMPL(
+        const uint8_t *const key, uint8_t *const keyContext)
+    {
+    if((nullptr == key) || (nullptr == keyContext)) { return(false); } // ERROR
+    aes128ExpandKey(key, keyContext);
+    uint8_t *const h = keyContext + AESScheduleBytes;
+    memset(h, 0, AESBlockBytes);
+    aes128EncryptBlock(keyContext, h);
+    return(true);
+    }
+
+// Authenticate then decrypt with a precomputed key context.
+bool fixed32BTextSize12BNonce16BTagSimpleDecWithContext_AESGCM_IMPL(
+        uint8_t *const workspace, const size_t workspaceSize,
+        const uint8_t *const keyContext, const uint8_t *const iv,
+        const uint8_t *const authtext, const uint8_t authtextSize,
+        const uint8_t *const ciphertext, const uint8_t *const tag,
+        uint8_t *const plaintextOut)
+    {
+    if((nullptr == workspace) || (nullptr == keyContext) || (nullptr == iv) ||
+       (nullptr == authtext) || (nullptr == tag) || (nullptr == plaintextOut)) { return(false); } // ERROR
+    if(workspaceSize < sizeof(GCMWorkspace)) { return(false); } // ERROR
+    GCMWorkspace &w = *reinterpret_cast<GCMWorkspace *>(workspace);
+    const uint8_t *const rk = keyContext;
+    const uint8_t *const h = keyContext + AESScheduleBytes;
+    ghash(w, h, authtext, authtextSize, ciphertext);
+    // Expected tag is E(K, J0) ^ S, J0 = IV || 0^31 || 1; compare all bytes.
+    counterBlock(w, rk, iv, 1);
+    uint8_t diff = 0;
+    for(uint8_t i = 0; i < AESBlockBytes; ++i) { diff |= uint8_t(w.x[i] ^ w.z[i] ^ tag[i]); }
+    const bool ok = (0 == diff);
+    if(ok && (nullptr != ciphertext))
+        {
+        for(uint8_t b = 0; b < 2; ++b)
+            {
+            counterBlock(w, rk, iv, uint8_t(2 + b));
+            for(uint8_t i = 0; i < AESBlockBytes; ++i)
+                { plaintextOut[AESBlockBytes*b + i] = uint8_t(ciphertext[AESBlockBytes*b + i] ^ w.z[i]); }
+            }
+        }
+    OTV0P2BASE::wipeSecret(workspace, sizeof(GCMWorkspace));
+    return(ok);
+    }
+
+// Decrypt with a raw key, building the key context in the workspace.
+bool fixed32BTextSize12BNonce16BTagSimpleDec_AESGCM_IMPL(
+        uint8_t *const workspace, const size_t workspaceSize,
+        const uint8_t *const key, const uint8_t *const iv,
+        const uint8_t *const authtext, const uint8_t authtextSize,
+        const uint8_t *const ciphertext, const uint8_t *const tag,
+        uint8_t *const plaintextOut)
+    {
+    if((nullptr == workspace) || (nullptr == key)) { return(false); } // ERROR
+    if(workspaceSize < fixed32BTextSize12BNonce16BTagSimpleWorkspace_AESGCM_IMPL) { return(false); } // ERROR
+    constexpr size_t ctxSize = fixed32BTextSize12BNonce16BTagSimpleKeyContextSize_AESGCM_IMPL;
+    fixed32BTextSize12BNonce16BTagSimpleKeySetup_AESGCM_IMPL(key, workspace);
+    const bool ok = fixed32BTextSize12BNonce16BTagSimpleDecWithContext_AESGCM_IMPL(
+            workspace + ctxSize, workspaceSize - ctxSize,
+            workspace, iv, authtext, authtextSize, ciphertext, tag, plaintextOut);
+    OTV0P2BASE::wipeSecret(workspace, ctxSize);
+    return(ok);
+    }
+
+// Encrypt then authenticate with a raw key, building the key context in
+// the workspace.
+bool fixed32BTextSize12BNonce16BTagSimpleEnc_AESGCM_IMPL(
+        uint8_t *const workspace, const size_t workspaceSize,
+        const uint8_t *const key, const uint8_t *const iv,
+        const uint8_t *const authtext, const uint8_t authtextSize,
+        const uint8_t *const plaintext,
+        uint8_t *const ciphertextOut, uint8_t *const tagOut)
+    {
+    if((nullptr == workspace) || (nullptr == key) || (nullptr == iv) ||
+       (nullptr == authtext) || (nullptr == ciphertextOut) || (nullptr == tagOut)) { return(false); } // ERROR
+    if(workspaceSize < fixed32BTextSize12BNonce16BTagSimpleWorkspace_AESGCM_IMPL) { return(false); } // ERROR
+    constexpr size_t ctxSize = fixed32BTextSize12BNonce16BTagSimpleKeyContextSize_AESGCM_IMPL;
+    fixed32BTextSize12BNonce16BTagSimpleKeySetup_AESGCM_IMPL(key, workspace);
+    const uint8_t *const rk = workspace;
+    const uint8_t *const h = workspace + AESScheduleBytes;
+    GCMWorkspace &w = *reinterpret_cast<GCMWorkspace *>(workspace + ctxSize);
+    if(nullptr != plaintext)
+        {
+        for(uint8_t b = 0; b < 2; ++b)
+            {
+            counterBlock(w, rk, iv, uint8_t(2 + b));
+            for(uint8_t i = 0; i < AESBlockBytes; ++i)
+                { ciphertextOut[AESBlockBytes*b + i] = uint8_t(plaintext[AESBlockBytes*b + i] ^ w.z[i]); }
+            }
+        }
+    ghash(w, h, authtext, authtextSize, (nullptr == plaintext) ? nullptr : ciphertextOut);
+    counterBlock(w, rk, iv, 1);
+    for(uint8_t i = 0; i < AESBlockBytes; ++i) { tagOut[i] = uint8_t(w.x[i] ^ w.z[i]); }
+    OTV0P2BASE::wipeSecret(workspace, fixed32BTextSize12BNonce16BTagSimpleWorkspace_AESGCM_IMPL);
+    return(true);
+    }
+
+    }
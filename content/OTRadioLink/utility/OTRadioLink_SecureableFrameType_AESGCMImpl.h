@@ -0,0 +1,116 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * Portable AES-128-GCM for the fixed 32-byte text, 12-byte nonce, 16-byte
+ * tag shape used by secure frames, split into a per-key setup step and a
+ * per-frame step.
+ *
+ * The per-key setup expands the AES-128 key schedule and derives the GHASH
+ * key H = E(K, 0^128), so a receiver with a cached context (see
+ * SimpleDecKeyContextCache and decodeBatch()) only pays for the three
+ * block encryptions and GHASH of each frame.
+ *
+ * Output is interoperable with OTAESGCM's fixed-size routines; where
+ * OTAESGCM is available it remains the primary implementation on V0p2.
+ */
+
+#ifndef ARDUINO_LIB_OTRADIOLINK_SECUREABLEFRAMETYPE_AESGCMIMPL_H
+#define ARDUINO_LIB_OTRADIOLINK_SECUREABLEFRAMETYPE_AESGCMIMPL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "OTRadioLink_SecureableFrameType.h"
+
+
+namespace OTRadioLink
+    {
+
+    // Key context size: the 176-byte AES-128 key schedule then 16 bytes of H.
+    static constexpr size_t fixed32BTextSize12BNonce16BTagSimpleKeyContextSize_AESGCM_IMPL = 176 + 16;
+    // Workspace required by the routines taking a key context:
+    // GHASH accumulator plus two blocks for the multiply and counter.
+    static constexpr size_t fixed32BTextSize12BNonce16BTagSimpleWorkspaceWithContext_AESGCM_IMPL = 3 * 16;
+    // Workspace required by the routines taking a raw key, which build the
+    // key context in the workspace for every call.
+    static constexpr size_t fixed32BTextSize12BNonce16BTagSimpleWorkspace_AESGCM_IMPL =
+        fixed32BTextSize12BNonce16BTagSimpleKeyContextSize_AESGCM_IMPL +
+        fixed32BTextSize12BNonce16BTagSimpleWorkspaceWithContext_AESGCM_IMPL;
+
+    /**
+     * @brief   AES-128-GCM key setup: expand the 16-byte key into a
+     *          fixed32BTextSize12BNonce16BTagSimpleKeyContextSize_AESGCM_IMPL
+     *          byte context for
+     *          fixed32BTextSize12BNonce16BTagSimpleDecWithContext_AESGCM_IMPL().
+     *
+     * The context is as sensitive as the key itself and should be wiped
+     * when no longer needed.
+     *
+     * @param   key, INPUT: 16-byte secret key. Never NULL.
+     * @param   keyContext, OUTPUT: context buffer. Never NULL.
+     * @retval  Returns true on success, false on failure.
+     */
+    SimpleSecureFrame32or0BodyRXBase::fixed32BTextSize12BNonce16BTagSimpleKeySetup_fn_t fixed32BTextSize12BNonce16BTagSimpleKeySetup_AESGCM_IMPL;
+
+    /**
+     * @brief   AES-128-GCM authenticate and decrypt using a key context from
+     *          fixed32BTextSize12BNonce16BTagSimpleKeySetup_AESGCM_IMPL().
+     *
+     * - The tag is checked before any plaintext is written.
+     * - If ciphertext is NULL only the authtext is authenticated.
+     * - The workspace is zeroed before returning.
+     *
+     * @param   workspace: At least
+     *              fixed32BTextSize12BNonce16BTagSimpleWorkspaceWithContext_AESGCM_IMPL
+     *              bytes. Never NULL.
+     * @param   keyContext: Context from the matching setup. Never NULL.
+     * @retval  Returns true on success, false on failure.
+     */
+    SimpleSecureFrame32or0BodyRXBase::fixed32BTextSize12BNonce16BTagSimpleDecWithContext_fn_t fixed32BTextSize12BNonce16BTagSimpleDecWithContext_AESGCM_IMPL;
+
+    /**
+     * @brief   AES-128-GCM authenticate and decrypt with a raw key,
+     *          expanding the key for every call.
+     *
+     * As fixed32BTextSize12BNonce16BTagSimpleDecWithContext_AESGCM_IMPL()
+     * but the workspace must be at least
+     * fixed32BTextSize12BNonce16BTagSimpleWorkspace_AESGCM_IMPL bytes,
+     * the start of which holds the key context during the call.
+     *
+     * @retval  Returns true on success, false on failure.
+     */
+    SimpleSecureFrame32or0BodyRXBase::fixed32BTextSize12BNonce16BTagSimpleDec_fn_t fixed32BTextSize12BNonce16BTagSimpleDec_AESGCM_IMPL;
+
+    /**
+     * @brief   AES-128-GCM encrypt and authenticate with a raw key,
+     *          expanding the key for every call.
+     *
+     * - If plaintext is NULL only the authtext is authenticated and
+     *   no ciphertext is written.
+     * - The workspace must be at least
+     *   fixed32BTextSize12BNonce16BTagSimpleWorkspace_AESGCM_IMPL bytes
+     *   and is zeroed before returning.
+     *
+     * @retval  Returns true on success, false on failure.
+     */
+    SimpleSecureFrame32or0BodyTXBase::fixed32BTextSize12BNonce16BTagSimpleEnc_fn_t fixed32BTextSize12BNonce16BTagSimpleEnc_AESGCM_IMPL;
+
+    }
+
+#endif
@@ -349,8 +349,7 @@ static bool getLastRXMsgCtrFromTable(const uint8_t * const eepromLoc, uint8_t *
     // The two operations can be performed at once since the CRC msb should be 0, ie 1 when inverted.
     const uint8_t crcRAW = eeprom_read_byte(eepromLoc + SimpleSecureFrame32or0BodyBase::fullMsgCtrBytes);
     // Compute/validate the 7-bit CRC.
-    uint8_t crc = 0;
-    for(int i = 0; i < SimpleSecureFrame32or0BodyBase::fullMsgCtrBytes; ++i) { crc = OTV0P2BASE::crc7_5B_update(crc, counter[i]); }
+    const uint8_t crc = OTV0P2BASE::crc7_5B_update_block(0, counter, SimpleSecureFrame32or0BodyBase::fullMsgCtrBytes);
     if(crc != (uint8_t)~crcRAW) { /* OTV0P2BASE::serialPrintlnAndFlush(F("!RXmc")); */ return(false); } // FAIL
     return(true); // Done!
     }
@@ -402,8 +401,7 @@ static bool updateRXMessageCount(uint8_t * const eepromLoc, const uint8_t * cons
     uint8_t * const CRCptr = eepromLoc + SimpleSecureFrame32or0BodyBase::fullMsgCtrBytes;
     OTV0P2BASE::eeprom_smart_clear_bits(CRCptr, 0x7f);
     // Compute 7-bit CRC to use at the end, with the write-in-progress flag off (1).
-    uint8_t crc = 0;
-    for(int i = 0; i < SimpleSecureFrame32or0BodyBase::fullMsgCtrBytes; ++i) { crc = OTV0P2BASE::crc7_5B_update(crc, newCounterValue[i]); }
+    const uint8_t crc = OTV0P2BASE::crc7_5B_update_block(0, newCounterValue, SimpleSecureFrame32or0BodyBase::fullMsgCtrBytes);
     const uint8_t rawCRC = ~crc; // The CRC's high-bit should be 0, so 1 when inverted.
     // Byte-by-byte careful minimal update of EEPROM, checking after each byte, ie for gross immediate failure.
     uint8_t *p = eepromLoc;
@@ -427,7 +425,6 @@ static bool updateRXMessageCount(uint8_t * const eepromLoc, const uint8_t * cons
 // The implementation should be robust in the face of power failures / reboots, accidental or malicious,
 // not allowing replays nor other cryptographic attacks, nor forcing node dissociation.
 // Must only be called once the RXed message has passed authentication.
-// Use a unary count as proxy for LSBs to reduce wear; clear unary value after main count increment so as to never have too low a total value.
 bool SimpleSecureFrame32or0BodyRXV0p2::authAndUpdateRXMsgCtr(const uint8_t *ID, const uint8_t *newCounterValue)
     {
     // Validate node ID and new count.
@@ -436,6 +433,15 @@ bool SimpleSecureFrame32or0BodyRXV0p2::authAndUpdateRXMsgCtr(const uint8_t *ID,
     const int8_t index = OTV0P2BASE::getNextMatchingNodeID(0, ID, OTV0P2BASE::OpenTRV_Node_ID_Bytes, NULL);
     if(index < 0) { return(false); } // FAIL (shouldn't be possible after previous validation).
     // Note: nominal risk of race if associations table can be altered concurrently.
+    return(updateRXMsgCtrAt(uint8_t(index), newCounterValue));
+    }
+
+// Update persistent message counter for the node at association index,
+// once validated against the stored value.
+// Use a unary count as proxy for LSBs to reduce wear; clear unary value after main count increment so as to never have too low a total value.
+bool SimpleSecureFrame32or0BodyRXV0p2::updateRXMsgCtrAt(const uint8_t index, const uint8_t *const newCounterValue)
+    {
+    if((index >= OTV0P2BASE::V0P2BASE_EE_NODE_ASSOCIATIONS_MAX_SETS) || (NULL == newCounterValue)) { return(false); } // FAIL
     // Compute base location in EEPROM of association table entry/row.
     uint8_t * const rawPtr = (uint8_t *)(OTV0P2BASE::V0P2BASE_EE_START_NODE_ASSOCIATIONS + index*(uint16_t)OTV0P2BASE::V0P2BASE_EE_NODE_ASSOCIATIONS_SET_SIZE);
     if(!use_unary_counter)
@@ -528,9 +534,121 @@ bool SimpleSecureFrame32or0BodyTXV0p2SuppliedID::getTXID(uint8_t *const idOut) c
     return(getID(idOut));
     }
 
-int8_t SimpleSecureFrame32or0BodyRXV0p2::_getNextMatchingNodeID(const uint8_t /*index*/, const SecurableFrameHeader *const sfh, uint8_t *nodeID) const
+// Factory method to get singleton instance.
+SimpleSecureFrame32or0BodyTXV0p2BlockReserve &SimpleSecureFrame32or0BodyTXV0p2BlockReserve::getInstance()
+    {
+    // Lazily create/initialise singleton on first use, NOT statically.
+    static SimpleSecureFrame32or0BodyTXV0p2BlockReserve instance;
+    return(instance);
+    }
+
+// Get TX ID that will be used for transmission; returns false on failure.
+// Argument must be buffer of (at least) OTV0P2BASE::OpenTRV_Node_ID_Bytes bytes.
+bool SimpleSecureFrame32or0BodyTXV0p2BlockReserve::getTXID(uint8_t *const idOut) const
+    {
+    if(NULL == idOut) { return(false); }
+    // Copy ID from EEPROM.
+    eeprom_read_block(idOut, (uint8_t *)V0P2BASE_EE_START_ID, OTV0P2BASE::OpenTRV_Node_ID_Bytes);
+    return(true);
+    }
+
+// CRC over the 3 MSBs and 3 LSBs of a TX reservation mark.
+static uint8_t txCtrMarkCRC(const uint8_t *const mark)
+    {
+    uint8_t crc = 0;
+    for(uint8_t i = 0; i < SimpleSecureFrame32or0BodyTXBase::fullMsgCtrBytes; ++i) { crc = _crc8_ccitt_update(crc, mark[i]); }
+    return(crc);
+    }
+
+// Load the 6-byte mark: the restart counter then the LSBs (all 0xff if not valid for it).
+// Fails if the restart counter is unusable.
+bool SimpleSecureFrame32or0BodyTXV0p2BlockReserve::_loadTXCtrMark(uint8_t *const buf) const
+    {
+    uint8_t loadBuf[OTV0P2BASE::VOP2BASE_EE_LEN_PERSISTENT_MSG_RESTART_CTR];
+    SimpleSecureFrame32or0BodyTXV0p2::loadRaw3BytePersistentTXRestartCounterFromEEPROM(loadBuf);
+    if(!SimpleSecureFrame32or0BodyTXV0p2::read3BytePersistentTXRestartCounter(loadBuf, buf)) { return(false); } // FAIL
+    uint8_t lsbs[OTV0P2BASE::VOP2BASE_EE_LEN_PERSISTENT_MSG_TX_MARK_LSBS];
+    eeprom_read_block(lsbs,
+                    (uint8_t *)(OTV0P2BASE::VOP2BASE_EE_START_PERSISTENT_MSG_TX_MARK_LSBS),
+                    OTV0P2BASE::VOP2BASE_EE_LEN_PERSISTENT_MSG_TX_MARK_LSBS);
+    for(uint8_t i = 0; i < sizeof(lsbs); ) { lsbs[i++] ^= 0xff; }
+    memcpy(buf + txNVCtrPrefixBytes, lsbs, fullMsgCtrBytes - txNVCtrPrefixBytes);
+    // Anything in this prefix may have been used if the LSBs are not known good.
+    if(txCtrMarkCRC(buf) != lsbs[fullMsgCtrBytes - txNVCtrPrefixBytes])
+        { memset(buf + txNVCtrPrefixBytes, 0xff, fullMsgCtrBytes - txNVCtrPrefixBytes); }
+    return(true);
+    }
+
+// Save the 6-byte mark, restart counter first, checking each byte reads back.
+bool SimpleSecureFrame32or0BodyTXV0p2BlockReserve::_saveTXCtrMark(const uint8_t *const buf)
+    {
+    // Both copies of the restart counter, each with its CRC.
+    uint8_t loadBuf[OTV0P2BASE::VOP2BASE_EE_LEN_PERSISTENT_MSG_RESTART_CTR];
+    uint8_t crc = 0;
+    for(uint8_t i = 0; i < txNVCtrPrefixBytes; ++i) { crc = _crc8_ccitt_update(crc, buf[i]); }
+    for(uint8_t *base = loadBuf; base <= loadBuf + 4; base += 4)
+        {
+        memcpy(base, buf, txNVCtrPrefixBytes);
+        base[txNVCtrPrefixBytes] = crc;
+        }
+    if(!saveRaw3BytePersistentTXRestartCounterToEEPROM(loadBuf)) { return(false); } // FAIL
+    uint8_t lsbs[OTV0P2BASE::VOP2BASE_EE_LEN_PERSISTENT_MSG_TX_MARK_LSBS];
+    memcpy(lsbs, buf + txNVCtrPrefixBytes, fullMsgCtrBytes - txNVCtrPrefixBytes);
+    lsbs[fullMsgCtrBytes - txNVCtrPrefixBytes] = txCtrMarkCRC(buf);
+    for(uint8_t i = 0; i < sizeof(lsbs); ++i)
+        {
+        const uint8_t b = ~lsbs[i];
+        OTV0P2BASE::eeprom_smart_update_byte((uint8_t *)(OTV0P2BASE::VOP2BASE_EE_START_PERSISTENT_MSG_TX_MARK_LSBS) + i, b);
+        if(b != eeprom_read_byte((uint8_t *)(OTV0P2BASE::VOP2BASE_EE_START_PERSISTENT_MSG_TX_MARK_LSBS) + i)) { return(false); } // FAIL
+        }
+    return(true);
+    }
+
+int8_t SimpleSecureFrame32or0BodyRXV0p2::_getNextMatchingNodeID(const uint8_t index, const SecurableFrameHeader *const sfh, uint8_t *nodeID) const
+{
+        return (OTV0P2BASE::getNextMatchingNodeID(index, sfh->id, sfh->getIl(), nodeID));
+}
+
+// Factory method to get singleton instance.
+SimpleSecureFrame32or0BodyRXV0p2WriteBack &SimpleSecureFrame32or0BodyRXV0p2WriteBack::getInstance()
+    {
+    // Lazily create/initialise singleton on first use, NOT statically.
+    static SimpleSecureFrame32or0BodyRXV0p2WriteBack instance;
+    return(instance);
+    }
+
+int8_t SimpleSecureFrame32or0BodyRXV0p2WriteBack::_getNextMatchingNodeID(const uint8_t index, const SecurableFrameHeader *const sfh, uint8_t *nodeID) const
+{
+        return (OTV0P2BASE::getNextMatchingNodeID(index, sfh->id, sfh->getIl(), nodeID));
+}
+
+int16_t SimpleSecureFrame32or0BodyRXV0p2WriteBack::_getNodeIndex(const uint8_t *const ID) const
+{
+        // Rely on getNextMatchingNodeID() to reject a NULL ID.
+        return (OTV0P2BASE::getNextMatchingNodeID(0, ID, OTV0P2BASE::OpenTRV_Node_ID_Bytes, NULL));
+}
+
+// Factory method to get singleton instance.
+SimpleSecureFrame32or0BodyRXV0p2SessionCache &SimpleSecureFrame32or0BodyRXV0p2SessionCache::getInstance()
+    {
+    // Lazily create/initialise singleton on first use, NOT statically.
+    static SimpleSecureFrame32or0BodyRXV0p2SessionCache instance;
+    return(instance);
+    }
+
+int8_t SimpleSecureFrame32or0BodyRXV0p2SessionCache::_getNextMatchingNodeIDFromTable(const uint8_t index, const uint8_t *const prefix, const uint8_t il, uint8_t *const nodeID) const
+{
+        return (OTV0P2BASE::getNextMatchingNodeID(index, prefix, il, nodeID));
+}
+
+uint8_t SimpleSecureFrame32or0BodyRXV0p2SessionCache::_getAssociationsGeneration() const
+{
+        return (OTV0P2BASE::getNodeAssociationsGeneration());
+}
+
+bool SimpleSecureFrame32or0BodyRXV0p2SessionCache::_writeRXMsgCtr(const int8_t index, const uint8_t *, const uint8_t *const newCounterValue)
 {
-        return (OTV0P2BASE::getNextMatchingNodeID(0, sfh->id, sfh->getIl(), nodeID));
+        return (SimpleSecureFrame32or0BodyRXV0p2::updateRXMsgCtrAt(uint8_t(index), newCounterValue));
 }
 #endif // SimpleSecureFrame32or0BodyTXV0p2_DEFINED
 
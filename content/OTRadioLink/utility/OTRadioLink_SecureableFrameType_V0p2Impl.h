@@ -372,6 +372,42 @@ class SimpleSecureFrame32or0BodyTXV0p2Null : public SimpleSecureFrame32or0BodyTX
         };
 
 
+    // V0p2 TX implementation issuing counters from blocks reserved in EEPROM,
+    // for busy senders such as hubs and relays.
+    // See SimpleSecureFrame32or0BodyTXBlockReserve for the trade-offs.
+    //
+    // Storage format for the 6-byte reservation mark.
+    // The 3 MSBs are the restart counter, in the same place and format as
+    // for SimpleSecureFrame32or0BodyTXV0p2, so the two agree on the prefix.
+    // The 3 LSBs are stored inverted at VOP2BASE_EE_START_PERSISTENT_MSG_TX_MARK_LSBS
+    // with a CRC over the whole mark; if that CRC fails (eg a torn write,
+    // or the restart counter was moved on by SimpleSecureFrame32or0BodyTXV0p2)
+    // the LSBs are taken as all 0xff, ie the rest of that prefix is skipped.
+    // The restart counter is written first when both parts change,
+    // so the mark in EEPROM never appears to go backwards.
+    //
+    // Writes 3--4 EEPROM bytes per reservationBlock frames sent.
+// #define SimpleSecureFrame32or0BodyTXV0p2BlockReserve_DEFINED
+    class SimpleSecureFrame32or0BodyTXV0p2BlockReserve final
+        : public SimpleSecureFrame32or0BodyTXBlockReserve<256>
+        {
+        private:
+            // Constructor is private to force use of factory method to return singleton.
+            SimpleSecureFrame32or0BodyTXV0p2BlockReserve() { }
+
+            virtual bool _loadTXCtrMark(uint8_t *buf) const override;
+            virtual bool _saveTXCtrMark(const uint8_t *buf) override;
+
+        public:
+            // Factory method to get singleton instance.
+            static SimpleSecureFrame32or0BodyTXV0p2BlockReserve &getInstance();
+
+            // Get TX ID that will be used for transmission; returns false on failure.
+            // Argument must be buffer of (at least) OTV0P2BASE::OpenTRV_Node_ID_Bytes bytes.
+            virtual bool getTXID(uint8_t *id) const override;
+        };
+
+
 
     // V0p2 RX implementation for 0 or 32 byte encrypted body sections.
     //
@@ -420,6 +456,64 @@ class SimpleSecureFrame32or0BodyTXV0p2Null : public SimpleSecureFrame32or0BodyTX
             // not allowing replays nor other cryptographic attacks, nor forcing node dissociation.
             // Must only be called once the RXed message has passed authentication.
             virtual bool authAndUpdateRXMsgCtr(const uint8_t *ID, const uint8_t *newCounterValue);
+            // Update persistent message counter for the node at association index,
+            // skipping the ID lookup and the check against the stored value,
+            // eg for a caller holding the index and last counter in RAM.
+            // Must only be called once newCounterValue has been validated
+            // against the current stored value and the RXed message authenticated.
+            static bool updateRXMsgCtrAt(uint8_t index, const uint8_t *newCounterValue);
+        };
+
+    // V0p2 RX implementation with RX message counters cached in RAM,
+    // for hubs receiving from many nodes or at high rates.
+    // Uses SimpleSecureFrame32or0BodyRXV0p2 as the persistent store,
+    // so the EEPROM format is unchanged and the two may be swapped freely,
+    // but only writes EEPROM about once per 32 frames from each node
+    // rather than on every frame.
+    // See SimpleSecureFrame32or0BodyRXWriteBack for the trade-offs.
+    // Costs about 21 bytes of RAM per possible association.
+// #define SimpleSecureFrame32or0BodyRXV0p2WriteBack_DEFINED
+    class SimpleSecureFrame32or0BodyRXV0p2WriteBack final
+        : public SimpleSecureFrame32or0BodyRXWriteBack<OTV0P2BASE::V0P2BASE_EE_NODE_ASSOCIATIONS_MAX_SETS>
+        {
+        private:
+            // Constructor is private to force use of factory method to return singleton.
+            SimpleSecureFrame32or0BodyRXV0p2WriteBack()
+                : SimpleSecureFrame32or0BodyRXWriteBack(SimpleSecureFrame32or0BodyRXV0p2::getInstance()) { }
+
+            virtual int8_t _getNextMatchingNodeID(const uint8_t index, const SecurableFrameHeader *const sfh, uint8_t *nodeID) const override;
+            virtual int16_t _getNodeIndex(const uint8_t *ID) const override;
+
+        public:
+            // Factory method to get singleton instance.
+            static SimpleSecureFrame32or0BodyRXV0p2WriteBack &getInstance();
+        };
+
+    // V0p2 RX implementation with a small LRU cache of recent sender sessions,
+    // for receivers where a few nodes (eg boiler relays and hubs) send most frames.
+    // Uses SimpleSecureFrame32or0BodyRXV0p2 as the persistent store.
+    // A repeat sender skips the EEPROM association scan and counter read
+    // before decryption; counter updates are still written through, by
+    // cached association index.
+    // Sessions are dropped whenever node associations are changed.
+    // See SimpleSecureFrame32or0BodyRXSessionCache for the trade-offs.
+    // Costs about 19 bytes of RAM per session plus 16 bytes of statistics.
+// #define SimpleSecureFrame32or0BodyRXV0p2SessionCache_DEFINED
+    class SimpleSecureFrame32or0BodyRXV0p2SessionCache final
+        : public SimpleSecureFrame32or0BodyRXSessionCache<4>
+        {
+        private:
+            // Constructor is private to force use of factory method to return singleton.
+            SimpleSecureFrame32or0BodyRXV0p2SessionCache()
+                : SimpleSecureFrame32or0BodyRXSessionCache(SimpleSecureFrame32or0BodyRXV0p2::getInstance()) { }
+
+            virtual int8_t _getNextMatchingNodeIDFromTable(uint8_t index, const uint8_t *prefix, uint8_t il, uint8_t *nodeID) const override;
+            virtual uint8_t _getAssociationsGeneration() const override;
+            virtual bool _writeRXMsgCtr(int8_t index, const uint8_t *ID, const uint8_t *newCounterValue) override;
+
+        public:
+            // Factory method to get singleton instance.
+            static SimpleSecureFrame32or0BodyRXV0p2SessionCache &getInstance();
         };
 #else  // ARDUINO_ARCH_AVR
 
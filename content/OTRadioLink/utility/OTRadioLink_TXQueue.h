@@ -0,0 +1,229 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * Bounded asynchronous TX queue that radio drivers can opt into,
+ * so that queueToSend() does not block the main loop on radio TX.
+ */
+
+#ifndef OTRADIOLINK_TXQUEUE_H_
+#define OTRADIOLINK_TXQUEUE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include "OTRadioLink_OTRadioLink.h"
+
+namespace OTRadioLink
+{
+
+// Counters for an OTRadioLinkTXQueue; all wrap.
+struct OTRadioLinkTXQueueStats
+{
+    // Frames accepted into the queue, including those coalesced.
+    uint16_t queued;
+    // Frames that replaced a superseded frame still queued.
+    uint16_t coalesced;
+    // Frames refused or evicted for lack of space.
+    uint16_t dropped;
+    // Frames for which sendRaw() succeeded.
+    uint16_t sent;
+    // Frames for which sendRaw() failed; these are not retried.
+    uint16_t failed;
+};
+
+/**
+ * @brief   Fixed-size queue of frames waiting to be sent by a radio.
+ *
+ * A driver opts in by holding one of these, adding frames to it from
+ * queueToSend() and calling drain() from poll(), eg:
+ *
+ *     bool queueToSend(const uint8_t *buf, uint8_t buflen, int8_t channel, TXpower power) override
+ *         { return(txQueue.queue(buf, buflen, channel, power)); }
+ *     void poll() override { ...; txQueue.drain(*this); }
+ *
+ * OTVirtualEtherRadio does so when given a txQueueCapacity.
+ *
+ * Frames are copied in so the caller's buffer may be reused at once.
+ * Frames go out highest TX power (ie importance) first, so TXmax frames
+ * overtake TXnormal ones, and oldest first within each power.
+ *
+ * A frame queued with a non-zero coalesceKey supersedes any frame still
+ * queued with the same key and channel, eg so that only the latest stats
+ * frame from a source is sent. The new content takes the old frame's place
+ * in the queue, at the higher of the two powers.
+ *
+ * When full a new frame evicts the newest frame of the lowest power
+ * if that is lower than its own, else the new frame is refused.
+ *
+ * Not ISR-safe and not thread-safe: queue() and drain() are expected to
+ * be called from the main loop.
+ *
+ * @param   maxTXBytes: Largest frame that can be queued; >= 1.
+ * @param   capacity: Number of frames that can be queued; in [1,127].
+ */
+template<uint8_t maxTXBytes, uint8_t capacity>
+class OTRadioLinkTXQueue final
+{
+    static_assert(maxTXBytes > 0, "maxTXBytes must be at least 1");
+    static_assert((capacity > 0) && (capacity <= 127), "capacity must be in [1,127]");
+
+private:
+    struct Slot
+    {
+        // Frame length; 0 if the slot is free.
+        uint8_t len;
+        int8_t channel;
+        OTRadioLink::TXpower power;
+        uint8_t coalesceKey;
+        // Queueing order; older slots have smaller seq.
+        uint8_t seq;
+        uint8_t buf[maxTXBytes];
+    };
+    Slot slots[capacity];
+    uint8_t nQueued = 0;
+    uint8_t nextSeq = 0;
+    OTRadioLinkTXQueueStats stats = { };
+
+    // Renumber queued slots 0, 1, ... keeping their order,
+    // so that nextSeq never wraps while an old frame is still queued.
+    // Each pass takes the oldest slot not yet renumbered: as the new numbers
+    // are never larger than the old, that is the lowest seq above the last.
+    void renumber()
+    {
+        int16_t last = -1;
+        uint8_t n = 0;
+        for( ; ; ++n) {
+            Slot *oldest = NULL;
+            for(Slot &s : slots) {
+                if((0 != s.len) && (s.seq > last) && ((NULL == oldest) || (s.seq < oldest->seq))) { oldest = &s; }
+            }
+            if(NULL == oldest) { break; }
+            last = oldest->seq;
+            oldest->seq = n;
+        }
+        nextSeq = n;
+    }
+
+    // Index of the next slot to send, or -1 if none.
+    int8_t next() const
+    {
+        int8_t best = -1;
+        for(uint8_t i = 0; i < capacity; ++i) {
+            const Slot &s = slots[i];
+            if(0 == s.len) { continue; }
+            if((best < 0) || (s.power > slots[best].power) ||
+               ((s.power == slots[best].power) && (s.seq < slots[best].seq))) { best = int8_t(i); }
+        }
+        return(best);
+    }
+
+public:
+    OTRadioLinkTXQueue() { for(Slot &s : slots) { s.len = 0; } }
+
+    /**
+     * @brief   Queue a copy of a frame to be sent by drain().
+     * @param   buf: Frame to send, as for sendRaw(); non-NULL.
+     * @param   buflen: Length of buf; in [1,maxTXBytes].
+     * @param   channel: As for sendRaw().
+     * @param   power: As for sendRaw(); also sets the send order.
+     * @param   coalesceKey: If non-zero, supersedes any frame still queued
+     *          with the same key and channel.
+     * @retval  True if the frame was queued.
+     */
+    bool queue(const uint8_t *const buf, const uint8_t buflen, const int8_t channel = 0,
+               const OTRadioLink::TXpower power = OTRadioLink::TXnormal, const uint8_t coalesceKey = 0)
+    {
+        if((NULL == buf) || (0 == buflen) || (buflen > maxTXBytes)) { return(false); } // ERROR
+        Slot *target = NULL;
+        if(0 != coalesceKey) {
+            for(Slot &s : slots) {
+                if((0 != s.len) && (coalesceKey == s.coalesceKey) && (channel == s.channel)) { target = &s; break; }
+            }
+        }
+        if(NULL != target) {
+            // Keep the superseded frame's place.
+            if(power > target->power) { target->power = power; }
+            ++stats.coalesced;
+        } else {
+            if(nQueued < capacity) {
+                for(Slot &s : slots) { if(0 == s.len) { target = &s; break; } }
+                ++nQueued;
+            } else {
+                // Full: find the newest frame of the lowest power to evict.
+                for(Slot &s : slots) {
+                    if((NULL == target) || (s.power < target->power) ||
+                       ((s.power == target->power) && (s.seq > target->seq))) { target = &s; }
+                }
+                ++stats.dropped;
+                if(target->power >= power) { return(false); } // FAIL
+            }
+            target->channel = channel;
+            target->power = power;
+            target->coalesceKey = coalesceKey;
+            if(0xff == nextSeq) { renumber(); }
+            target->seq = nextSeq++;
+        }
+        memcpy(target->buf, buf, buflen);
+        target->len = buflen;
+        ++stats.queued;
+        return(true);
+    }
+
+    /**
+     * @brief   Send up to maxFrames queued frames with rl.sendRaw().
+     *
+     * Typically called from the driver's poll() with the driver as rl.
+     * Each frame is tried once and removed whether or not sendRaw()
+     * succeeds, as for a synchronous queueToSend().
+     *
+     * @param   rl: Radio to send with.
+     * @param   maxFrames: Most frames to send in this call, to bound the
+     *          time taken.
+     * @retval  Number of frames for which sendRaw() succeeded.
+     */
+    uint8_t drain(OTRadioLink &rl, uint8_t maxFrames = 1)
+    {
+        uint8_t nSent = 0;
+        for( ; maxFrames > 0; --maxFrames) {
+            const int8_t i = next();
+            if(i < 0) { break; }
+            Slot &s = slots[i];
+            if(rl.sendRaw(s.buf, s.len, s.channel, s.power)) { ++nSent; ++stats.sent; }
+            else { ++stats.failed; }
+            s.len = 0;
+            --nQueued;
+        }
+        return(nSent);
+    }
+
+    // Number of frames waiting to be sent.
+    uint8_t getQueued() const { return(nQueued); }
+    bool isEmpty() const { return(0 == nQueued); }
+    bool isFull() const { return(capacity == nQueued); }
+
+    // Drop all queued frames without sending them.
+    void clear() { for(Slot &s : slots) { s.len = 0; } nQueued = 0; }
+
+    const OTRadioLinkTXQueueStats &getStats() const { return(stats); }
+    void resetStats() { stats = OTRadioLinkTXQueueStats(); }
+};
+
+}
+
+#endif /* OTRADIOLINK_TXQUEUE_H_ */
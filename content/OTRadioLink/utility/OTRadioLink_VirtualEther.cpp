@@ -0,0 +1,140 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+#include "OTRadioLink_VirtualEther.h"
+
+#ifndef ARDUINO
+
+namespace OTRadioLink
+{
+
+VirtualEtherNode::VirtualEtherNode(VirtualEther &e)
+  : ether(e), nodeIndex(e.attach(this)) { }
+
+VirtualEtherNode::~VirtualEtherNode() { ether.detach(nodeIndex); }
+
+bool VirtualEtherNode::sendRaw(const uint8_t *const buf, const uint8_t buflen, const int8_t channel, TXpower, bool)
+{
+    if((channel < 0) || (channel >= ((nChannels > 0) ? nChannels : 1))) { return(false); } // ERROR
+    return(ether.transmit(nodeIndex, buf, buflen, channel));
+}
+
+uint32_t VirtualEther::attach(VirtualEtherNode *const n)
+{
+    nodes.push_back(n);
+    links.emplace_back();
+    inFlight.emplace_back();
+    return(uint32_t(nodes.size() - 1));
+}
+
+// Frames still on the air to a detached node are discarded on arrival.
+void VirtualEther::detach(const uint32_t index)
+{
+    nodes[index] = NULL;
+    links[index].clear();
+}
+
+bool VirtualEther::link(const uint32_t src, const uint32_t dst, const VirtualEtherLinkModel &model)
+{
+    if((src >= nodes.size()) || (dst >= nodes.size()) || (src == dst)) { return(false); } // ERROR
+    for(Link &l : links[src]) { if(dst == l.dst) { l.model = model; return(true); } }
+    links[src].push_back(Link{ dst, model });
+    return(true);
+}
+
+void VirtualEther::unlink(const uint32_t src, const uint32_t dst)
+{
+    if(src >= links.size()) { return; }
+    std::vector<Link> &ls = links[src];
+    for(size_t i = 0; i < ls.size(); ++i) {
+        if(dst == ls[i].dst) { ls[i] = ls.back(); ls.pop_back(); return; }
+    }
+}
+
+bool VirtualEther::transmit(const uint32_t src, const uint8_t *const buf, const uint8_t buflen, const int8_t channel)
+{
+    if((NULL == buf) || (0 == buflen) || (buflen > maxFrameBytes)) { return(false); } // ERROR
+    ++stats.framesSent;
+    const std::vector<Link> &ls = links[src];
+    if(ls.empty()) { ++stats.unheard; return(true); }
+    const vtime_t onAir = airtime(buflen);
+    for(const Link &l : ls) {
+        uint32_t index;
+        if(!freePool.empty()) { index = freePool.back(); freePool.pop_back(); }
+        else { index = uint32_t(pool.size()); pool.emplace_back(); }
+        Reception &r = pool[index];
+        r.start = t + l.model.latencyUs + ((0 == l.model.jitterUs) ? 0 : (random() % (l.model.jitterUs + 1)));
+        r.end = r.start + onAir;
+        r.dst = l.dst;
+        r.channel = channel;
+        r.lost = (0 != l.model.lossPerMille) && ((random() % 1000) < l.model.lossPerMille);
+        r.collided = false;
+        r.len = buflen;
+        memcpy(r.buf, buf, buflen);
+        // Any overlap on the same channel at the receiver spoils both.
+        for(const uint32_t o : inFlight[l.dst]) {
+            Reception &other = pool[o];
+            if((channel == other.channel) && (r.start < other.end) && (other.start < r.end)) {
+                other.collided = true;
+                r.collided = true;
+            }
+        }
+        inFlight[l.dst].push_back(index);
+        pending.push(Pending{ r.end, nextSeq++, index });
+    }
+    return(true);
+}
+
+void VirtualEther::deliverNext()
+{
+    const uint32_t index = pending.top().index;
+    pending.pop();
+    const Reception &r = pool[index];
+    std::vector<uint32_t> &f = inFlight[r.dst];
+    for(size_t i = 0; i < f.size(); ++i) {
+        if(index == f[i]) { f[i] = f.back(); f.pop_back(); break; }
+    }
+    VirtualEtherNode *const n = nodes[r.dst];
+    if(NULL == n) { } // Detached: discard.
+    else if(r.lost) { ++stats.lost; }
+    else if(r.collided) { ++stats.collided; }
+    else if(r.channel != n->getListenChannel()) { ++stats.notListening; }
+    else {
+        switch(n->_deliver(r.buf, r.len)) {
+            case VirtualEtherNode::DR_DELIVERED: { ++stats.delivered; break; }
+            case VirtualEtherNode::DR_FILTERED: { ++stats.filtered; break; }
+            case VirtualEtherNode::DR_QUEUE_FULL: { ++stats.rxQueueFull; break; }
+            case VirtualEtherNode::DR_TOO_LONG: { ++stats.tooLong; break; }
+        }
+    }
+    freePool.push_back(index);
+}
+
+void VirtualEther::advanceTo(const vtime_t tEnd)
+{
+    while(!pending.empty() && (pending.top().end <= tEnd)) {
+        // Receivers see time as when each frame arrives.
+        if(pending.top().end > t) { t = pending.top().end; }
+        deliverNext();
+    }
+    if(tEnd > t) { t = tEnd; }
+}
+
+}
+
+#endif // ARDUINO
@@ -0,0 +1,333 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * Simulated shared radio medium ("ether") and radios attached to it,
+ * for load-testing message handling, relays and boiler hubs at fleet
+ * scale on a host without radio hardware.
+ *
+ * Time is virtual: nothing is delivered until the ether is advanced,
+ * so runs are fast and, for a given seed, repeatable.
+ *
+ * Not available on Arduino targets.
+ */
+
+#ifndef OTRADIOLINK_VIRTUALETHER_H_
+#define OTRADIOLINK_VIRTUALETHER_H_
+
+#ifndef ARDUINO
+
+#include <stdint.h>
+#include <string.h>
+#include <queue>
+#include <vector>
+
+#include "OTRadioLink_OTRadioLink.h"
+#include "OTRadioLink_ISRRXQueue.h"
+#include "OTRadioLink_TXQueue.h"
+
+#define OTRADIOLINK_PLATFORM_HAS_VirtualEther
+
+namespace OTRadioLink
+{
+
+// Behaviour of a one-way link between two nodes on a VirtualEther.
+struct VirtualEtherLinkModel
+{
+    // Chance of each frame being lost (fading, noise), in 1000ths.
+    // A lost frame still occupies the air at the receiver.
+    uint16_t lossPerMille;
+    // Propagation and processing delay before the frame starts to arrive (us).
+    uint32_t latencyUs;
+    // Extra random delay, uniform in [0,jitterUs] (us).
+    uint32_t jitterUs;
+};
+
+// Fate of frames on a VirtualEther; per receiver except framesSent and unheard.
+struct VirtualEtherStats
+{
+    // Frames put on the air by sendRaw().
+    uint64_t framesSent;
+    // Frames sent with no link from the sender to any receiver.
+    uint64_t unheard;
+    // Frames queued by a receiver.
+    uint64_t delivered;
+    // Frames lost by the link model.
+    uint64_t lost;
+    // Frames overlapping another on the same channel at the receiver.
+    uint64_t collided;
+    // Frames arriving while the receiver was not listening on their channel.
+    uint64_t notListening;
+    // Frames refused by the receiver's RX filter.
+    uint64_t filtered;
+    // Frames for which the receiver's RX queue had no space.
+    uint64_t rxQueueFull;
+    // Frames longer than the receiver can take.
+    uint64_t tooLong;
+};
+
+class VirtualEther;
+
+/**
+ * @brief   Radio attached to a VirtualEther; see OTVirtualEtherRadio.
+ *
+ * Attaches itself to the ether on construction and detaches on
+ * destruction; the ether must outlive all its radios.
+ */
+class VirtualEtherNode : public OTRadioLink
+{
+    friend class VirtualEther;
+
+public:
+    // Outcome of offering a frame to a receiver.
+    enum DeliverResult : uint8_t { DR_DELIVERED, DR_FILTERED, DR_QUEUE_FULL, DR_TOO_LONG };
+
+protected:
+    VirtualEther &ether;
+    // Index of this node in the ether.
+    const uint32_t nodeIndex;
+
+    // Offer an RXed frame to this node, as its RX ISR would.
+    virtual DeliverResult _deliver(const uint8_t *buf, uint8_t buflen) = 0;
+
+    void _dolisten() override { }
+
+    explicit VirtualEtherNode(VirtualEther &e);
+
+public:
+    ~VirtualEtherNode();
+    VirtualEtherNode(const VirtualEtherNode &) = delete;
+    VirtualEtherNode &operator=(const VirtualEtherNode &) = delete;
+
+    // Index of this node, for VirtualEther::link() etc.
+    uint32_t getNodeIndex() const { return(nodeIndex); }
+
+    bool begin() override { return(true); }
+
+    /**
+     * @brief   Put a frame on the air of the ether at the ether's current time.
+     *
+     * It arrives at each linked receiver after the link's latency and
+     * the frame's airtime, as the ether is advanced.
+     * TX power and listenAfter are ignored.
+     *
+     * @param   channel: Channel index; must be valid for this radio's
+     *          configuration, or 0 if not configured.
+     * @retval  True if the frame was put on the air.
+     */
+    bool sendRaw(const uint8_t *buf, uint8_t buflen, int8_t channel = 0, TXpower power = TXnormal, bool listenAfter = false) override;
+};
+
+/**
+ * @brief   Shared in-process medium connecting any number of VirtualEtherNodes.
+ *
+ * Frames only reach nodes with a link from the sender (see link()), and
+ * only if the receiver is listening on the frame's channel when the frame
+ * has fully arrived. Two frames whose times on the air at a receiver
+ * overlap on the same channel are both lost there, with no capture effect.
+ * Links are stored per sender so fleets of thousands of nodes, each linked
+ * to a few others, are cheap.
+ *
+ * Frames are delivered to receivers' RX queues from advance() / advanceTo()
+ * in order of arrival; receivers' queues are then drained as usual,
+ * eg by an OTMessageQueueHandler.
+ *
+ * Not thread-safe.
+ */
+class VirtualEther final
+{
+public:
+    // Virtual time in microseconds.
+    typedef uint64_t vtime_t;
+
+    // Largest frame that can be sent, as for the RFM23B.
+    static constexpr uint8_t maxFrameBytes = 64;
+
+private:
+    struct Reception
+    {
+        vtime_t start;
+        vtime_t end;
+        uint32_t dst;
+        int8_t channel;
+        bool lost;
+        bool collided;
+        uint8_t len;
+        uint8_t buf[maxFrameBytes];
+    };
+    struct Link
+    {
+        uint32_t dst;
+        VirtualEtherLinkModel model;
+    };
+    // Pending arrival: (end time, sequence) then pool index.
+    struct Pending
+    {
+        vtime_t end;
+        uint64_t seq;
+        uint32_t index;
+        bool operator>(const Pending &o) const { return((end > o.end) || ((end == o.end) && (seq > o.seq))); }
+    };
+
+    vtime_t t = 0;
+    uint32_t usPerByte;
+    uint8_t overheadBytes;
+    uint32_t rng;
+    uint64_t nextSeq = 0;
+    VirtualEtherStats stats = { };
+
+    // Attached nodes by index; NULL once detached.
+    std::vector<VirtualEtherNode *> nodes;
+    // Outbound links by sender index.
+    std::vector<std::vector<Link>> links;
+    // Receptions not yet complete, by receiver index, for collision checks.
+    std::vector<std::vector<uint32_t>> inFlight;
+    // Reception storage and free slots.
+    std::vector<Reception> pool;
+    std::vector<uint32_t> freePool;
+    std::priority_queue<Pending, std::vector<Pending>, std::greater<Pending>> pending;
+
+    // xorshift32; never returns 0.
+    uint32_t random() { rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5; return(rng); }
+
+    // Complete the earliest pending reception.
+    void deliverNext();
+
+    friend class VirtualEtherNode;
+    uint32_t attach(VirtualEtherNode *n);
+    void detach(uint32_t index);
+    bool transmit(uint32_t src, const uint8_t *buf, uint8_t buflen, int8_t channel);
+
+public:
+    /**
+     * @param   seed: Seed for the loss and jitter models; non-zero.
+     * @param   usPerByte_: Airtime per frame byte; the default is
+     *          approximately the RFM23B's 49.26 kbps GFSK.
+     * @param   overheadBytes_: Airtime in bytes for preamble, sync etc.
+     */
+    explicit VirtualEther(uint32_t seed = 1, uint32_t usPerByte_ = 163, uint8_t overheadBytes_ = 10)
+      : usPerByte(usPerByte_), overheadBytes(overheadBytes_), rng((0 == seed) ? 1 : seed) { }
+    VirtualEther(const VirtualEther &) = delete;
+    VirtualEther &operator=(const VirtualEther &) = delete;
+
+    // Current virtual time (us).
+    vtime_t now() const { return(t); }
+    // Advance virtual time to tEnd (if later), delivering all frames
+    // that have fully arrived by then.
+    void advanceTo(vtime_t tEnd);
+    // Advance virtual time by us.
+    void advance(const vtime_t us) { advanceTo(t + us); }
+    // Time on the air of a frame of buflen bytes (us).
+    vtime_t airtime(const uint8_t buflen) const { return(vtime_t(buflen + overheadBytes) * usPerByte); }
+
+    // Number of nodes ever attached (including any since detached).
+    uint32_t getNodeCount() const { return(uint32_t(nodes.size())); }
+
+    // Make (or replace) a one-way link so that frames from src reach dst.
+    // Returns false if either index is invalid or they are the same.
+    bool link(uint32_t src, uint32_t dst, const VirtualEtherLinkModel &model = VirtualEtherLinkModel());
+    // Make links both ways between a and b.
+    bool linkBoth(const uint32_t a, const uint32_t b, const VirtualEtherLinkModel &model = VirtualEtherLinkModel())
+        { return(link(a, b, model) && link(b, a, model)); }
+    // Remove any link from src to dst.
+    void unlink(uint32_t src, uint32_t dst);
+
+    // Frames still on the air.
+    size_t getInFlight() const { return(pending.size()); }
+
+    const VirtualEtherStats &getStats() const { return(stats); }
+    void resetStats() { stats = VirtualEtherStats(); }
+};
+
+/**
+ * @brief   Radio on a VirtualEther with an RX queue like a real driver's.
+ *
+ * The RX filter (setFilterRXISR()) is applied on arrival, and frames that
+ * do not fit in the queue are dropped and counted as for a real radio.
+ *
+ * With a non-zero txQueueCapacity, queueToSend() puts frames in an
+ * OTRadioLinkTXQueue and each poll() sends the next one, at the ether's
+ * time of that poll; otherwise queueToSend() sends at once.
+ *
+ * @param   queueRXMsgsMin: Minimum number of maximum-size frames the RX queue holds.
+ * @param   maxRXMsgLen: Largest frame that can be received; <= VirtualEther::maxFrameBytes.
+ * @param   txQueueCapacity: Frames queueToSend() can queue; 0 to send at once.
+ */
+template<uint8_t queueRXMsgsMin = 2, uint8_t maxRXMsgLen = VirtualEther::maxFrameBytes, uint8_t txQueueCapacity = 0>
+class OTVirtualEtherRadio final : public VirtualEtherNode
+{
+    static_assert(maxRXMsgLen <= VirtualEther::maxFrameBytes, "maxRXMsgLen too large");
+
+public:
+    // Unused (1 deep) if txQueueCapacity is 0.
+    typedef OTRadioLinkTXQueue<VirtualEther::maxFrameBytes, ((txQueueCapacity > 0) ? txQueueCapacity : 1)> txQueue_t;
+
+private:
+    txQueue_t txQueue;
+    ISRRXQueueVarLenMsg<maxRXMsgLen, queueRXMsgsMin> queueRX;
+    // Channel each queued frame was received on.
+    RXChannelRuns<> rxChannels;
+
+    void _dolisten() override { rxChannels.listening(getListenChannel(), queueRX.getRXMsgsQueued()); }
+
+    DeliverResult _deliver(const uint8_t *const buf, const uint8_t buflen) override
+    {
+        volatile uint8_t len = buflen;
+        quickFrameFilter_t *const f = filterRXISR;
+        if((NULL != f) && !f(buf, len)) { ++filteredRXedMessageCountRecent; return(DR_FILTERED); }
+        if(len > maxRXMsgLen) { ++droppedRXedMessageCountRecent; return(DR_TOO_LONG); }
+        volatile uint8_t *const b = queueRX._getRXBufForInbound();
+        if(NULL == b) { queueRX._noteDroppedFull(); ++droppedRXedMessageCountRecent; return(DR_QUEUE_FULL); }
+        for(uint8_t i = 0; i < len; ++i) { b[i] = buf[i]; }
+        queueRX._loadedBuf(len);
+        return(DR_DELIVERED);
+    }
+
+public:
+    explicit OTVirtualEtherRadio(VirtualEther &e) : VirtualEtherNode(e) { }
+
+    void getCapacity(uint8_t &queueRXMsgsMin_, uint8_t &maxRXMsgLen_, uint8_t &maxTXMsgLen) const override
+        { queueRX.getRXCapacity(queueRXMsgsMin_, maxRXMsgLen_); maxTXMsgLen = VirtualEther::maxFrameBytes; }
+    uint8_t getRXMsgsQueued() const override { return(queueRX.getRXMsgsQueued()); }
+    const volatile uint8_t *peekRXMsg() const override { return(queueRX.peekRXMsg()); }
+    void removeRXMsg() override
+    {
+        if(NULL == queueRX.peekRXMsg()) { return; }
+        queueRX.removeRXMsg();
+        rxChannels.removed();
+    }
+    int8_t getRXMsgChannel() const override { return(rxChannels.oldest()); }
+
+    bool queueToSend(const uint8_t *const buf, const uint8_t buflen, const int8_t channel = 0, const TXpower power = TXnormal) override
+    {
+        if(0 == txQueueCapacity) { return(sendRaw(buf, buflen, channel, power)); }
+        return(txQueue.queue(buf, buflen, channel, power));
+    }
+    // Send the next queued frame, if any.
+    void poll() override { if(0 != txQueueCapacity) { txQueue.drain(*this); } }
+    // Frames waiting to be sent, and counters.
+    const txQueue_t &getTXQueue() const { return(txQueue); }
+    bool getRXQueueHealth(ISRRXQueueHealth &h) const override { return(queueRX.getHealth(h)); }
+    void resetRXQueueHealth() override { queueRX.resetHealth(); }
+};
+
+}
+
+#endif // ARDUINO
+
+#endif /* OTRADIOLINK_VIRTUALETHER_H_ */
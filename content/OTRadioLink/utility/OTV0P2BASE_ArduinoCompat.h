@@ -47,6 +47,11 @@ class __FlashStringHelper;
 #define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(static_cast<const char *>(string_literal)))
 #endif
 
+// PROGMEM attribute on Arduino places constant data in Flash.
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+
 // pgm_read_byte() macro for Arduino reads one byte from Flash.
 #ifndef pgm_read_byte
 #define pgm_read_byte(p) (*reinterpret_cast<const char *>(p))
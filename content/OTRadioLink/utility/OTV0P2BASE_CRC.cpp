@@ -24,6 +24,90 @@ namespace OTV0P2BASE
     {
 
 
+#ifdef OTV0P2BASE_CRC7_5B_USE_TABLE
+    // crc7_5B lookup tables for slice-by-4 working.
+    // crc7_5B_table[0][i] is the CRC after one byte for index i = (crc << 1) ^ datum,
+    // ie the CRC register held left-aligned in 8 bits;
+    // crc7_5B_table[k][x] is the CRC after byte x is followed by k zero bytes.
+    // As the CRC is linear (and the 7-bit register fits in the first byte)
+    // the CRC after 4 bytes is the XOR of one lookup per byte.
+    static const uint8_t crc7_5B_table[4][256] =
+        {
+            {
+            0x00, 0x37, 0x6e, 0x59, 0x6b, 0x5c, 0x05, 0x32, 0x61, 0x56, 0x0f, 0x38, 0x0a, 0x3d, 0x64, 0x53,
+            0x75, 0x42, 0x1b, 0x2c, 0x1e, 0x29, 0x70, 0x47, 0x14, 0x23, 0x7a, 0x4d, 0x7f, 0x48, 0x11, 0x26,
+            0x5d, 0x6a, 0x33, 0x04, 0x36, 0x01, 0x58, 0x6f, 0x3c, 0x0b, 0x52, 0x65, 0x57, 0x60, 0x39, 0x0e,
+            0x28, 0x1f, 0x46, 0x71, 0x43, 0x74, 0x2d, 0x1a, 0x49, 0x7e, 0x27, 0x10, 0x22, 0x15, 0x4c, 0x7b,
+            0x0d, 0x3a, 0x63, 0x54, 0x66, 0x51, 0x08, 0x3f, 0x6c, 0x5b, 0x02, 0x35, 0x07, 0x30, 0x69, 0x5e,
+            0x78, 0x4f, 0x16, 0x21, 0x13, 0x24, 0x7d, 0x4a, 0x19, 0x2e, 0x77, 0x40, 0x72, 0x45, 0x1c, 0x2b,
+            0x50, 0x67, 0x3e, 0x09, 0x3b, 0x0c, 0x55, 0x62, 0x31, 0x06, 0x5f, 0x68, 0x5a, 0x6d, 0x34, 0x03,
+            0x25, 0x12, 0x4b, 0x7c, 0x4e, 0x79, 0x20, 0x17, 0x44, 0x73, 0x2a, 0x1d, 0x2f, 0x18, 0x41, 0x76,
+            0x1a, 0x2d, 0x74, 0x43, 0x71, 0x46, 0x1f, 0x28, 0x7b, 0x4c, 0x15, 0x22, 0x10, 0x27, 0x7e, 0x49,
+            0x6f, 0x58, 0x01, 0x36, 0x04, 0x33, 0x6a, 0x5d, 0x0e, 0x39, 0x60, 0x57, 0x65, 0x52, 0x0b, 0x3c,
+            0x47, 0x70, 0x29, 0x1e, 0x2c, 0x1b, 0x42, 0x75, 0x26, 0x11, 0x48, 0x7f, 0x4d, 0x7a, 0x23, 0x14,
+            0x32, 0x05, 0x5c, 0x6b, 0x59, 0x6e, 0x37, 0x00, 0x53, 0x64, 0x3d, 0x0a, 0x38, 0x0f, 0x56, 0x61,
+            0x17, 0x20, 0x79, 0x4e, 0x7c, 0x4b, 0x12, 0x25, 0x76, 0x41, 0x18, 0x2f, 0x1d, 0x2a, 0x73, 0x44,
+            0x62, 0x55, 0x0c, 0x3b, 0x09, 0x3e, 0x67, 0x50, 0x03, 0x34, 0x6d, 0x5a, 0x68, 0x5f, 0x06, 0x31,
+            0x4a, 0x7d, 0x24, 0x13, 0x21, 0x16, 0x4f, 0x78, 0x2b, 0x1c, 0x45, 0x72, 0x40, 0x77, 0x2e, 0x19,
+            0x3f, 0x08, 0x51, 0x66, 0x54, 0x63, 0x3a, 0x0d, 0x5e, 0x69, 0x30, 0x07, 0x35, 0x02, 0x5b, 0x6c,
+            },
+            {
+            0x00, 0x34, 0x68, 0x5c, 0x67, 0x53, 0x0f, 0x3b, 0x79, 0x4d, 0x11, 0x25, 0x1e, 0x2a, 0x76, 0x42,
+            0x45, 0x71, 0x2d, 0x19, 0x22, 0x16, 0x4a, 0x7e, 0x3c, 0x08, 0x54, 0x60, 0x5b, 0x6f, 0x33, 0x07,
+            0x3d, 0x09, 0x55, 0x61, 0x5a, 0x6e, 0x32, 0x06, 0x44, 0x70, 0x2c, 0x18, 0x23, 0x17, 0x4b, 0x7f,
+            0x78, 0x4c, 0x10, 0x24, 0x1f, 0x2b, 0x77, 0x43, 0x01, 0x35, 0x69, 0x5d, 0x66, 0x52, 0x0e, 0x3a,
+            0x7a, 0x4e, 0x12, 0x26, 0x1d, 0x29, 0x75, 0x41, 0x03, 0x37, 0x6b, 0x5f, 0x64, 0x50, 0x0c, 0x38,
+            0x3f, 0x0b, 0x57, 0x63, 0x58, 0x6c, 0x30, 0x04, 0x46, 0x72, 0x2e, 0x1a, 0x21, 0x15, 0x49, 0x7d,
+            0x47, 0x73, 0x2f, 0x1b, 0x20, 0x14, 0x48, 0x7c, 0x3e, 0x0a, 0x56, 0x62, 0x59, 0x6d, 0x31, 0x05,
+            0x02, 0x36, 0x6a, 0x5e, 0x65, 0x51, 0x0d, 0x39, 0x7b, 0x4f, 0x13, 0x27, 0x1c, 0x28, 0x74, 0x40,
+            0x43, 0x77, 0x2b, 0x1f, 0x24, 0x10, 0x4c, 0x78, 0x3a, 0x0e, 0x52, 0x66, 0x5d, 0x69, 0x35, 0x01,
+            0x06, 0x32, 0x6e, 0x5a, 0x61, 0x55, 0x09, 0x3d, 0x7f, 0x4b, 0x17, 0x23, 0x18, 0x2c, 0x70, 0x44,
+            0x7e, 0x4a, 0x16, 0x22, 0x19, 0x2d, 0x71, 0x45, 0x07, 0x33, 0x6f, 0x5b, 0x60, 0x54, 0x08, 0x3c,
+            0x3b, 0x0f, 0x53, 0x67, 0x5c, 0x68, 0x34, 0x00, 0x42, 0x76, 0x2a, 0x1e, 0x25, 0x11, 0x4d, 0x79,
+            0x39, 0x0d, 0x51, 0x65, 0x5e, 0x6a, 0x36, 0x02, 0x40, 0x74, 0x28, 0x1c, 0x27, 0x13, 0x4f, 0x7b,
+            0x7c, 0x48, 0x14, 0x20, 0x1b, 0x2f, 0x73, 0x47, 0x05, 0x31, 0x6d, 0x59, 0x62, 0x56, 0x0a, 0x3e,
+            0x04, 0x30, 0x6c, 0x58, 0x63, 0x57, 0x0b, 0x3f, 0x7d, 0x49, 0x15, 0x21, 0x1a, 0x2e, 0x72, 0x46,
+            0x41, 0x75, 0x29, 0x1d, 0x26, 0x12, 0x4e, 0x7a, 0x38, 0x0c, 0x50, 0x64, 0x5f, 0x6b, 0x37, 0x03,
+            },
+            {
+            0x00, 0x31, 0x62, 0x53, 0x73, 0x42, 0x11, 0x20, 0x51, 0x60, 0x33, 0x02, 0x22, 0x13, 0x40, 0x71,
+            0x15, 0x24, 0x77, 0x46, 0x66, 0x57, 0x04, 0x35, 0x44, 0x75, 0x26, 0x17, 0x37, 0x06, 0x55, 0x64,
+            0x2a, 0x1b, 0x48, 0x79, 0x59, 0x68, 0x3b, 0x0a, 0x7b, 0x4a, 0x19, 0x28, 0x08, 0x39, 0x6a, 0x5b,
+            0x3f, 0x0e, 0x5d, 0x6c, 0x4c, 0x7d, 0x2e, 0x1f, 0x6e, 0x5f, 0x0c, 0x3d, 0x1d, 0x2c, 0x7f, 0x4e,
+            0x54, 0x65, 0x36, 0x07, 0x27, 0x16, 0x45, 0x74, 0x05, 0x34, 0x67, 0x56, 0x76, 0x47, 0x14, 0x25,
+            0x41, 0x70, 0x23, 0x12, 0x32, 0x03, 0x50, 0x61, 0x10, 0x21, 0x72, 0x43, 0x63, 0x52, 0x01, 0x30,
+            0x7e, 0x4f, 0x1c, 0x2d, 0x0d, 0x3c, 0x6f, 0x5e, 0x2f, 0x1e, 0x4d, 0x7c, 0x5c, 0x6d, 0x3e, 0x0f,
+            0x6b, 0x5a, 0x09, 0x38, 0x18, 0x29, 0x7a, 0x4b, 0x3a, 0x0b, 0x58, 0x69, 0x49, 0x78, 0x2b, 0x1a,
+            0x1f, 0x2e, 0x7d, 0x4c, 0x6c, 0x5d, 0x0e, 0x3f, 0x4e, 0x7f, 0x2c, 0x1d, 0x3d, 0x0c, 0x5f, 0x6e,
+            0x0a, 0x3b, 0x68, 0x59, 0x79, 0x48, 0x1b, 0x2a, 0x5b, 0x6a, 0x39, 0x08, 0x28, 0x19, 0x4a, 0x7b,
+            0x35, 0x04, 0x57, 0x66, 0x46, 0x77, 0x24, 0x15, 0x64, 0x55, 0x06, 0x37, 0x17, 0x26, 0x75, 0x44,
+            0x20, 0x11, 0x42, 0x73, 0x53, 0x62, 0x31, 0x00, 0x71, 0x40, 0x13, 0x22, 0x02, 0x33, 0x60, 0x51,
+            0x4b, 0x7a, 0x29, 0x18, 0x38, 0x09, 0x5a, 0x6b, 0x1a, 0x2b, 0x78, 0x49, 0x69, 0x58, 0x0b, 0x3a,
+            0x5e, 0x6f, 0x3c, 0x0d, 0x2d, 0x1c, 0x4f, 0x7e, 0x0f, 0x3e, 0x6d, 0x5c, 0x7c, 0x4d, 0x1e, 0x2f,
+            0x61, 0x50, 0x03, 0x32, 0x12, 0x23, 0x70, 0x41, 0x30, 0x01, 0x52, 0x63, 0x43, 0x72, 0x21, 0x10,
+            0x74, 0x45, 0x16, 0x27, 0x07, 0x36, 0x65, 0x54, 0x25, 0x14, 0x47, 0x76, 0x56, 0x67, 0x34, 0x05,
+            },
+            {
+            0x00, 0x3e, 0x7c, 0x42, 0x4f, 0x71, 0x33, 0x0d, 0x29, 0x17, 0x55, 0x6b, 0x66, 0x58, 0x1a, 0x24,
+            0x52, 0x6c, 0x2e, 0x10, 0x1d, 0x23, 0x61, 0x5f, 0x7b, 0x45, 0x07, 0x39, 0x34, 0x0a, 0x48, 0x76,
+            0x13, 0x2d, 0x6f, 0x51, 0x5c, 0x62, 0x20, 0x1e, 0x3a, 0x04, 0x46, 0x78, 0x75, 0x4b, 0x09, 0x37,
+            0x41, 0x7f, 0x3d, 0x03, 0x0e, 0x30, 0x72, 0x4c, 0x68, 0x56, 0x14, 0x2a, 0x27, 0x19, 0x5b, 0x65,
+            0x26, 0x18, 0x5a, 0x64, 0x69, 0x57, 0x15, 0x2b, 0x0f, 0x31, 0x73, 0x4d, 0x40, 0x7e, 0x3c, 0x02,
+            0x74, 0x4a, 0x08, 0x36, 0x3b, 0x05, 0x47, 0x79, 0x5d, 0x63, 0x21, 0x1f, 0x12, 0x2c, 0x6e, 0x50,
+            0x35, 0x0b, 0x49, 0x77, 0x7a, 0x44, 0x06, 0x38, 0x1c, 0x22, 0x60, 0x5e, 0x53, 0x6d, 0x2f, 0x11,
+            0x67, 0x59, 0x1b, 0x25, 0x28, 0x16, 0x54, 0x6a, 0x4e, 0x70, 0x32, 0x0c, 0x01, 0x3f, 0x7d, 0x43,
+            0x4c, 0x72, 0x30, 0x0e, 0x03, 0x3d, 0x7f, 0x41, 0x65, 0x5b, 0x19, 0x27, 0x2a, 0x14, 0x56, 0x68,
+            0x1e, 0x20, 0x62, 0x5c, 0x51, 0x6f, 0x2d, 0x13, 0x37, 0x09, 0x4b, 0x75, 0x78, 0x46, 0x04, 0x3a,
+            0x5f, 0x61, 0x23, 0x1d, 0x10, 0x2e, 0x6c, 0x52, 0x76, 0x48, 0x0a, 0x34, 0x39, 0x07, 0x45, 0x7b,
+            0x0d, 0x33, 0x71, 0x4f, 0x42, 0x7c, 0x3e, 0x00, 0x24, 0x1a, 0x58, 0x66, 0x6b, 0x55, 0x17, 0x29,
+            0x6a, 0x54, 0x16, 0x28, 0x25, 0x1b, 0x59, 0x67, 0x43, 0x7d, 0x3f, 0x01, 0x0c, 0x32, 0x70, 0x4e,
+            0x38, 0x06, 0x44, 0x7a, 0x77, 0x49, 0x0b, 0x35, 0x11, 0x2f, 0x6d, 0x53, 0x5e, 0x60, 0x22, 0x1c,
+            0x79, 0x47, 0x05, 0x3b, 0x36, 0x08, 0x4a, 0x74, 0x50, 0x6e, 0x2c, 0x12, 0x1f, 0x21, 0x63, 0x5d,
+            0x2b, 0x15, 0x57, 0x69, 0x64, 0x5a, 0x18, 0x26, 0x02, 0x3c, 0x7e, 0x40, 0x4d, 0x73, 0x31, 0x0f,
+            },
+        };
+#endif // OTV0P2BASE_CRC7_5B_USE_TABLE
+
     /**Update 7-bit CRC with next byte; result always has top bit zero.
      * Polynomial 0x5B (1011011, Koopman) = (x+1)(x^6 + x^5 + x^3 + x^2 + 1) = 0x37 (0110111, Normal)
      * <p>
@@ -37,11 +121,13 @@ namespace OTV0P2BASE
      * <p>
      * For 2 or 3 byte payloads this should have a Hamming distance of 4 and be within a factor of 2 of optimal error detection.
      * <p>
-     * TODO: provide table-driven optimised alternative,
-     *     eg see http://www.tty1.net/pycrc/index_en.html
+     * Table-driven where OTV0P2BASE_CRC7_5B_USE_TABLE is defined, else bitwise.
      */
     uint8_t crc7_5B_update(uint8_t crc, const uint8_t datum)
         {
+#ifdef OTV0P2BASE_CRC7_5B_USE_TABLE
+        return(crc7_5B_table[0][uint8_t((crc << 1) ^ datum)]);
+#else
         for(uint8_t i = 0x80; i != 0; i >>= 1)
             {
             bool bit = (0 != (crc & 0x40));
@@ -50,6 +136,61 @@ namespace OTV0P2BASE
             if(bit) { crc ^= 0x37; }
             }
         return(crc & 0x7f);
+#endif
+        }
+
+    /**Update 7-bit CRC with len bytes from buf; result always has top bit zero.
+     * Same result as calling crc7_5B_update() for each byte in turn.
+     * With tables, works 4 bytes per step (slice-by-4).
+     */
+    uint8_t crc7_5B_update_block(uint8_t crc, const uint8_t *buf, uint8_t len)
+        {
+#ifdef OTV0P2BASE_CRC7_5B_USE_TABLE
+        for( ; len >= 4; len -= 4, buf += 4)
+            {
+            crc = crc7_5B_table[3][uint8_t((crc << 1) ^ buf[0])] ^
+                  crc7_5B_table[2][buf[1]] ^
+                  crc7_5B_table[1][buf[2]] ^
+                  crc7_5B_table[0][buf[3]];
+            }
+#endif
+        while(len-- > 0) { crc = crc7_5B_update(crc, *buf++); }
+        return(crc);
+        }
+
+    /**Update four independent 7-bit CRCs, each with len bytes from its own buffer.
+     * Same results as calling crc7_5B_update_block() on each in turn.
+     * With tables the four dependency chains are interleaved,
+     * so the lookups for one stream overlap those of the others.
+     */
+    void crc7_5B_update_block_x4(uint8_t crc[4], const uint8_t *const buf[4], const uint8_t len)
+        {
+#ifdef OTV0P2BASE_CRC7_5B_USE_TABLE
+        uint8_t c0 = crc[0], c1 = crc[1], c2 = crc[2], c3 = crc[3];
+        const uint8_t *b0 = buf[0], *b1 = buf[1], *b2 = buf[2], *b3 = buf[3];
+        uint8_t i = 0;
+        for( ; i + 4 <= len; i += 4)
+            {
+            c0 = crc7_5B_table[3][uint8_t((c0 << 1) ^ b0[i])] ^ crc7_5B_table[2][b0[i+1]] ^
+                 crc7_5B_table[1][b0[i+2]] ^ crc7_5B_table[0][b0[i+3]];
+            c1 = crc7_5B_table[3][uint8_t((c1 << 1) ^ b1[i])] ^ crc7_5B_table[2][b1[i+1]] ^
+                 crc7_5B_table[1][b1[i+2]] ^ crc7_5B_table[0][b1[i+3]];
+            c2 = crc7_5B_table[3][uint8_t((c2 << 1) ^ b2[i])] ^ crc7_5B_table[2][b2[i+1]] ^
+                 crc7_5B_table[1][b2[i+2]] ^ crc7_5B_table[0][b2[i+3]];
+            c3 = crc7_5B_table[3][uint8_t((c3 << 1) ^ b3[i])] ^ crc7_5B_table[2][b3[i+1]] ^
+                 crc7_5B_table[1][b3[i+2]] ^ crc7_5B_table[0][b3[i+3]];
+            }
+        for( ; i < len; ++i)
+            {
+            c0 = crc7_5B_table[0][uint8_t((c0 << 1) ^ b0[i])];
+            c1 = crc7_5B_table[0][uint8_t((c1 << 1) ^ b1[i])];
+            c2 = crc7_5B_table[0][uint8_t((c2 << 1) ^ b2[i])];
+            c3 = crc7_5B_table[0][uint8_t((c3 << 1) ^ b3[i])];
+            }
+        crc[0] = c0; crc[1] = c1; crc[2] = c2; crc[3] = c3;
+#else
+        for(uint8_t k = 0; k < 4; ++k) { crc[k] = crc7_5B_update_block(crc[k], buf[k], len); }
+#endif
         }
 
     /**As crc7_5B_update() but if the output would be 0, this returns 0x80 instead.
@@ -25,6 +25,15 @@ Author(s) / Copyright (s): Damon Hart-Davis 2015--2016
 
 #include <stdint.h>
 
+// Select the crc7_5B implementation at compile time.
+// Where OTV0P2BASE_CRC7_5B_USE_TABLE is defined, 1kB of lookup tables are used
+// for speed, else a small bitwise implementation.
+// AVR keeps the small version by default to save flash;
+// define OTV0P2BASE_CRC7_5B_SMALL to force it elsewhere.
+#if !defined(OTV0P2BASE_CRC7_5B_USE_TABLE) && !defined(OTV0P2BASE_CRC7_5B_SMALL) && !defined(ARDUINO_ARCH_AVR)
+#define OTV0P2BASE_CRC7_5B_USE_TABLE
+#endif
+
 // Use namespaces to help avoid collisions.
 namespace OTV0P2BASE
     {
@@ -46,6 +55,21 @@ namespace OTV0P2BASE
      */
     extern uint8_t crc7_5B_update(uint8_t crc, uint8_t datum);
 
+    /**Update 7-bit CRC with len bytes from buf; result always has top bit zero.
+     * Gives the same result as crc7_5B_update() applied to each byte in turn,
+     * but faster for more than a few bytes when tables are in use.
+     * buf may only be NULL if len is 0.
+     */
+    extern uint8_t crc7_5B_update_block(uint8_t crc, const uint8_t *buf, uint8_t len);
+
+    /**Update four independent 7-bit CRCs, each with len bytes from its own buffer.
+     * Gives the same results as crc7_5B_update_block() on each in turn,
+     * but interleaves the four streams so that their table lookups overlap.
+     * Intended for checking many frames at once, eg on a gateway.
+     * No entry in buf may be NULL unless len is 0.
+     */
+    extern void crc7_5B_update_block_x4(uint8_t crc[4], const uint8_t *const buf[4], uint8_t len);
+
     // Value to use in place of 0 for final CRC value, eg for crc7_5B_update_nz_final();
     static const uint8_t crc7_5B_update_nz_ALT = 0x80;
 
@@ -160,6 +160,12 @@ static const intptr_t V0P2BASE_EE_END_RAW_INSPECTABLE = V0P2BASE_EE_START_RAW_IN
 static const intptr_t V0P2BASE_EE_START_SETBACK_LOCKOUT_COUNTDOWN_D_INV = 0 + V0P2BASE_EE_START_RAW_INSPECTABLE;
 
 
+// TX message counter reservation mark least-significant 3 bytes,
+// used with the restart bytes below by SimpleSecureFrame32or0BodyTXV0p2BlockReserve.
+// Stored inverted, followed by an (inverted) CRC over all 6 bytes of the mark
+// so that a copy left over from a different restart prefix is rejected.
+static const intptr_t VOP2BASE_EE_START_PERSISTENT_MSG_TX_MARK_LSBS = 100;
+static const uint8_t VOP2BASE_EE_LEN_PERSISTENT_MSG_TX_MARK_LSBS = 4;
 // TX message counter (most-significant) persistent reboot/restart 3 bytes.  (TODO-728)
 // Nominally the counter associated with the primary TX key,
 // which may be the primary building key for simple configurations,
@@ -70,24 +70,11 @@ uint8_t adjustJSONMsgForTXAndComputeCRC(char * const bptr)
   // Do initial quick validation before computing CRC, etc,
   if(!quickValidateRawSimpleJSONMessage(bptr)) { return(adjustJSONMsgForTXAndComputeCRC_ERR); }
 //  if('{' != *bptr) { return(adjustJSONMsgForTXAndComputeCRC_ERR); }
-  bool seenTrailingClosingBrace = false;
-  uint8_t crc = '{';
-  for(char *p = bptr; *++p; ) // Skip first char ('{'); loop until '\0'.
-    {
-    const char c = *p;
-//    if(c & 0x80) { return(adjustJSONMsgForTXAndComputeCRC_ERR); } // No high-bits should be set!
-    if(('}' == c) && ('\0' == *(p+1)))
-      {
-      seenTrailingClosingBrace = true;
-      const char newC = c | 0x80;
-      *p = newC; // Set high bit.
-      crc = crc7_5B_update(crc, (uint8_t)newC); // Update CRC.
-      return(crc);
-      }
-    crc = crc7_5B_update(crc, (uint8_t)c); // Update CRC.
-    }
-  if(!seenTrailingClosingBrace) { return(adjustJSONMsgForTXAndComputeCRC_ERR); } // Missing ending '}'.
-  return(crc);
+  // Validation ensures that the message is short and ends with '}'.
+  const uint8_t len = (uint8_t)strlen(bptr);
+  bptr[len-1] |= 0x80; // Set high bit on final '}'.
+  // CRC everything after the initial '{' up to and including the final '}'.
+  return(crc7_5B_update_block('{', (const uint8_t *)bptr + 1, len - 1));
   }
 
 
@@ -123,14 +110,12 @@ int8_t checkJSONMsgRXCRC(const uint8_t * const bptr, const uint8_t bufLen)
 #if 0 && defined(DEBUG)
   DEBUG_SERIAL_PRINT_FLASHSTRING("checkJSONMsgRXCRC_ERR()... {");
 #endif
-  uint8_t crc = '{';
   // Scan up to maximum length for terminating '}'-with-high-bit.
   const uint8_t ml = OTV0P2BASE::fnmin(MSG_JSON_ABS_MAX_LENGTH, bufLen);
   const uint8_t *p = bptr + 1;
   for(int8_t i = 1; i < ml; ++i)
     {
     const char c = char(*p++);
-    crc = crc7_5B_update(crc, (uint8_t)c); // Update CRC.
 //#ifdef ALLOW_RAW_JSON_RX
     if(('}' == c) && ('\0' == *p))
       {
@@ -142,12 +127,18 @@ int8_t checkJSONMsgRXCRC(const uint8_t * const bptr, const uint8_t bufLen)
       }
 //#endif
     // With a terminating '}' (followed by '\0') the message is superficially valid.
-    if((((char)('}' | 0x80)) == c) && ((crc == *p) || ((0 == crc) && (0x80 == *p))))
+    // The CRC covers everything after the initial '{' up to and including the final '}'.
+    if(((char)('}' | 0x80)) == c)
       {
+      const uint8_t crc = crc7_5B_update_block('{', bptr + 1, uint8_t(i));
+      if((crc == *p) || ((0 == crc) && (0x80 == *p)))
+        {
 #if 0 && defined(DEBUG)
-      DEBUG_SERIAL_PRINTLN_FLASHSTRING("} OK with CRC");
+        DEBUG_SERIAL_PRINTLN_FLASHSTRING("} OK with CRC");
 #endif
-      return(i+1);
+        return(i+1);
+        }
+      return(checkJSONMsgRXCRC_ERR);
       }
     // Non-printable/control character makes the message invalid.
     if((c < 32) || (c > 126))
@@ -154,6 +154,13 @@ bool getPrimaryBuilding16ByteSecretKey(uint8_t *key)
   }
 
 
+// RAM index over the EEPROM node associations.
+NodeAssociationIndexV0p2 V0p2_NodeIndex;
+
+// Bumped on every change to the node associations.
+static uint8_t V0p2_NodeAssociationsGeneration;
+uint8_t getNodeAssociationsGeneration() { return(V0p2_NodeAssociationsGeneration); }
+
 /**
  * @brief Clears all existing node IDs.
  */
@@ -169,6 +176,9 @@ void clearAllNodeAssociations()
         eeprom_smart_erase_byte(nodeIDPtr);
         nodeIDPtr += V0P2BASE_EE_NODE_ASSOCIATIONS_SET_SIZE; // increment ptr
     }
+    // Index is now valid and empty.
+    V0p2_NodeIndex.clear();
+    ++V0p2_NodeAssociationsGeneration;
 }
 
 /**Return current number of node ID associations.
@@ -176,6 +186,8 @@ void clearAllNodeAssociations()
  */
 uint8_t countNodeAssociations()
     {
+    // Use the RAM index if available.
+    if(V0p2_NodeIndex.isValid()) { return(uint8_t(V0p2_NodeIndex.size())); }
     // The first node ID starting with 0xff indicates that it and subsequent entries are empty.
     uint8_t *eepromPtr = (uint8_t *)V0P2BASE_EE_START_NODE_ASSOCIATIONS;
     // Loop through node ID locations checking for invalid byte (0xff).
@@ -219,6 +231,10 @@ int8_t addNodeAssociation(const uint8_t *nodeID)
                     eeprom_smart_erase_byte(eepromPtr++);
                 }
             }
+            // Keep the RAM index in step; nodeID has been advanced past the ID.
+            if(!V0p2_NodeIndex.insert(i, nodeID - V0P2BASE_EE_NODE_ASSOCIATIONS_8B_ID_LENGTH))
+                { V0p2_NodeIndex.invalidate(); }
+            ++V0p2_NodeAssociationsGeneration;
             return (i);
         }
         eepromPtr += V0P2BASE_EE_NODE_ASSOCIATIONS_SET_SIZE; // increment ptr
@@ -265,6 +281,9 @@ bool NodeAssociationTableV0p2::set(const uint8_t index, const uint8_t* const src
     uint8_t* const start = reinterpret_cast<uint8_t* const>(startAddr + (index * setSize));
 
     eeprom_update_block(src, start, idLength);
+    // IDs may have been reordered or removed; rebuild on next lookup.
+    V0p2_NodeIndex.invalidate();
+    ++V0p2_NodeAssociationsGeneration;
 
     return (true);
 }
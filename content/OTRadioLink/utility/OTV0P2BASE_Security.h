@@ -24,6 +24,7 @@ Author(s) / Copyright (s): Damon Hart-Davis 2015--2016
 #ifndef OTV0P2BASE_SECURITY_H
 #define OTV0P2BASE_SECURITY_H
 
+#include <stddef.h>
 #include <stdint.h>
 // #include <iostream>
 
@@ -89,6 +90,15 @@ bool setPrimaryBuilding16ByteSecretKey(const uint8_t *key);
 typedef bool (GetPrimary16ByteSecretKey_t)(uint8_t *key);
 GetPrimary16ByteSecretKey_t getPrimaryBuilding16ByteSecretKey;
 
+// Zero secret material (keys, expanded key contexts) in RAM.
+// Stores go through a volatile pointer so that they are not optimised
+// away, as a plain memset() of a buffer not read again may be.
+inline void wipeSecret(uint8_t *const buf, const size_t len)
+    {
+    volatile uint8_t *p = buf;
+    for(size_t i = len; i > 0; --i) { *p++ = 0; }
+    }
+
 // Verify that the stored key is that passed in.
 // Avoids leaking information about the key,
 // eg by printing any of it, or terminating early on mismatch.
@@ -200,6 +210,199 @@ int8_t getNextMatchingNodeIDGeneric(uint8_t _index, const uint8_t *prefix, uint8
     return(-1);
 }
 
+/**
+ * @brief   RAM node association table for hosts, eg concentrators, that need
+ *          more associations than fit in the V0p2 EEPROM layout.
+ *
+ * Same get/set contract as NodeAssociationTableBase but with 16-bit indices,
+ * so it does not derive from it. Empty entries start with 0xff.
+ *
+ * @param   maxSets_: Number of entries, at most 32767.
+ */
+template<uint16_t maxSets_>
+class NodeAssociationTableRAM final {
+public:
+    static constexpr uint16_t maxSets {maxSets_};
+    static constexpr uint8_t idLength {V0P2BASE_EE_NODE_ASSOCIATIONS_8B_ID_LENGTH};
+    static_assert(maxSets_ <= 32767, "index must fit in int16_t");
+
+    NodeAssociationTableRAM() { _reset(); }
+
+    // Set an ID; false if index out of range or src is NULL.
+    bool set(const uint16_t index, const uint8_t* const src)
+    {
+        if ((index >= maxSets) || (src == nullptr)) { return (false); }
+        memcpy(buf + (index * idLength), src, idLength);
+        return (true);
+    }
+    // Get an ID; dest left untouched if index out of range or NULL.
+    void get(const uint16_t index, uint8_t* const dest) const
+    {
+        if ((index >= maxSets) || (dest == nullptr)) { return; }
+        memcpy(dest, buf + (index * idLength), idLength);
+    }
+    // Clears all entries.
+    void _reset() { memset(buf, 0xff, sizeof(buf)); }
+
+private:
+    uint8_t buf[maxSets_ * idLength];
+};
+
+/**
+ * @brief   RAM index over a node association table, sorted by ID, so that
+ *          ID/prefix lookups take O(log n) comparisons in RAM rather than a
+ *          linear scan of the (eg EEPROM-backed) table.
+ *
+ * Holds a copy of each ID with its table index, so costs
+ * (idLength + 2) bytes of RAM per entry.
+ * - The index must be rebuilt (or invalidated) whenever the IDs in the table
+ *   change; it does not track other parts of the entries such as counters.
+ * - As for the table scan, the first entry starting with 0xff marks the end
+ *   of the valid entries.
+ * - Not thread- or ISR-safe.
+ *
+ * @param   NodeAssocTable_T: Table type; must provide maxSets, idLength and
+ *              get(index, dest).
+ * @param   maxEntries: Capacity of the index, at least NodeAssocTable_T::maxSets.
+ */
+template<class NodeAssocTable_T, uint16_t maxEntries>
+class NodeAssociationIndex final {
+public:
+    static constexpr uint8_t idLength {NodeAssocTable_T::idLength};
+    static_assert(maxEntries >= NodeAssocTable_T::maxSets, "index too small for table");
+    static_assert(maxEntries <= 32767, "index must fit in int16_t");
+
+    // Mark the index as needing a rebuild before use.
+    void invalidate() { valid = false; }
+    // True if the index has been built and not since invalidated.
+    bool isValid() const { return (valid); }
+    // Number of valid associations indexed.
+    uint16_t size() const { return (count); }
+
+    // Set to valid and empty, eg after clearing the table.
+    void clear() { count = 0; valid = true; }
+
+    /**
+     * @brief   Rebuild the index from the table.
+     *          Reads each valid entry of the table once.
+     */
+    void rebuild(const NodeAssocTable_T &nodes)
+    {
+        clear();
+        for (uint16_t i = 0; i != NodeAssocTable_T::maxSets; ++i) {
+            uint8_t temp[idLength];
+            nodes.get(i, temp);
+            if (0xff == temp[0]) { break; }
+            insert(i, temp);
+        }
+    }
+
+    /**
+     * @brief   Add an entry to a valid index, eg after appending to the table.
+     *          Does nothing if the index is not valid.
+     * @param   tableIndex: Index of the new entry in the table.
+     * @param   id: The new ID. Never NULL.
+     * @retval  false if the index is full or id is NULL.
+     */
+    bool insert(const uint16_t tableIndex, const uint8_t *const id)
+    {
+        if (!valid) { return (true); }
+        if ((count >= maxEntries) || (nullptr == id)) { return (false); }
+        // Keep sorted by ID then table index.
+        uint16_t pos = lowerBound(id, idLength);
+        while ((pos < count) && (0 == memcmp(entries[pos].id, id, idLength)) &&
+               (entries[pos].tableIndex < tableIndex)) { ++pos; }
+        memmove(entries + pos + 1, entries + pos, (count - pos) * sizeof(Entry));
+        memcpy(entries[pos].id, id, idLength);
+        entries[pos].tableIndex = tableIndex;
+        ++count;
+        return (true);
+    }
+
+    /**
+     * @brief   Returns first matching node ID at or after the table index
+     *          provided. Same contract as getNextMatchingNodeIDGeneric().
+     *          The index must be valid.
+     * @param   _index  Table index to start searching from.
+     *          prefix  Prefix to match; can be NULL if prefixLen == 0.
+     *          prefixLen  Length of prefix, [0,idLength] bytes.
+     *          nodeID  Buffer to write nodeID to; can be NULL.
+     * @retval  returns table index or -1 if no matching node ID found
+     */
+    int16_t getNextMatchingNodeID(const uint16_t _index, const uint8_t *const prefix,
+                                  const uint8_t prefixLen, uint8_t *const nodeID) const
+    {
+        if (!valid) { return (-1); } // ERROR
+        if (_index >= NodeAssocTable_T::maxSets) { return (-1); }
+        if (prefixLen > idLength) { return (-1); }
+        if ((NULL == prefix) && (0 != prefixLen)) { return (-1); }
+
+        // Every entry matches, and entries occupy table indices [0,count[.
+        if (0 == prefixLen) {
+            if (_index >= count) { return (-1); }
+            if (nullptr != nodeID) {
+                for (uint16_t i = 0; i != count; ++i) {
+                    if (entries[i].tableIndex == _index) {
+                        memcpy(nodeID, entries[i].id, idLength);
+                        break;
+                    }
+                }
+            }
+            return (int16_t(_index));
+        }
+
+        // Matches are contiguous in sorted order; pick the lowest table
+        // index not below _index. Usually there is at most one match.
+        const uint16_t lo = lowerBound(prefix, prefixLen);
+        const uint16_t hi = upperBound(prefix, prefixLen);
+        int16_t best = -1;
+        uint16_t bestPos = 0;
+        for (uint16_t i = lo; i != hi; ++i) {
+            const uint16_t t = entries[i].tableIndex;
+            if ((t >= _index) && ((best < 0) || (t < uint16_t(best)))) {
+                best = int16_t(t);
+                bestPos = i;
+            }
+        }
+        if ((best >= 0) && (nullptr != nodeID)) {
+            memcpy(nodeID, entries[bestPos].id, idLength);
+        }
+        return (best);
+    }
+
+private:
+    struct Entry {
+        uint8_t id[idLength];
+        uint16_t tableIndex;
+    };
+    Entry entries[maxEntries];
+    uint16_t count = 0;
+    bool valid = false;
+
+    // First position whose ID prefix is not less than key.
+    uint16_t lowerBound(const uint8_t *const key, const uint8_t len) const
+    {
+        uint16_t lo = 0, hi = count;
+        while (lo < hi) {
+            const uint16_t mid = lo + ((hi - lo) / 2);
+            if (memcmp(entries[mid].id, key, len) < 0) { lo = mid + 1; }
+            else { hi = mid; }
+        }
+        return (lo);
+    }
+    // First position whose ID prefix is greater than key.
+    uint16_t upperBound(const uint8_t *const key, const uint8_t len) const
+    {
+        uint16_t lo = 0, hi = count;
+        while (lo < hi) {
+            const uint16_t mid = lo + ((hi - lo) / 2);
+            if (memcmp(entries[mid].id, key, len) <= 0) { lo = mid + 1; }
+            else { hi = mid; }
+        }
+        return (lo);
+    }
+};
+
 #ifdef ARDUINO_ARCH_AVR
 #define OTV0P2BASE_NODE_ASSOCIATION_TABLE_V0P2
 /**
@@ -233,40 +436,40 @@ public:
 // Static instance of V0p2_Nodes for backwards compatibility.
 static constexpr NodeAssociationTableV0p2 V0p2_Nodes;
 
+// RAM index over the EEPROM node associations.
+// Built lazily on first lookup, kept up to date by addNodeAssociation() and
+// clearAllNodeAssociations(), and invalidated by NodeAssociationTableV0p2::set().
+// Costs (8 + 2) bytes of RAM per possible association.
+typedef NodeAssociationIndex<NodeAssociationTableV0p2, V0P2BASE_EE_NODE_ASSOCIATIONS_MAX_SETS> NodeAssociationIndexV0p2;
+extern NodeAssociationIndexV0p2 V0p2_NodeIndex;
+
+/**
+ * @brief   Count (mod 256) of changes to the node associations, by
+ *          addNodeAssociation(), clearAllNodeAssociations() and
+ *          NodeAssociationTableV0p2::set(); any change also resets or
+ *          moves the stored RX message counters.
+ *          RAM caches keyed on association index (eg of RX sessions)
+ *          should drop their entries when this changes.
+ */
+uint8_t getNodeAssociationsGeneration();
+
+/**
+ * @brief   Returns first matching node ID after the index provided. If no
+ *          matching ID found, it will return -1.
+ *          See getNextMatchingNodeIDGeneric() for parameters.
+ *
+ * Uses V0p2_NodeIndex (rebuilding it from EEPROM first if need be) so that
+ * the common full-ID and header-prefix lookups during secure frame RX do
+ * not need to scan the association table in EEPROM.
+ */
 inline int8_t getNextMatchingNodeID(
     uint8_t _index, 
     const uint8_t *prefix, 
     uint8_t prefixLen, 
     uint8_t *nodeID)
 {
-    // return (getNextMatchingNodeIDGeneric<decltype(V0p2_Nodes), V0p2_Nodes>(index, prefix, prefixLen, nodeID));
-        // // Validate inputs.
-    if(_index >= V0P2BASE_EE_NODE_ASSOCIATIONS_MAX_SETS) { return(-1); }
-    if(prefixLen > V0P2BASE_EE_NODE_ASSOCIATIONS_8B_ID_LENGTH) { return(-1); }
-    if((NULL == prefix) && (0 != prefixLen)) { return(-1); }
-
-    // Loop through node IDs until match or last entry tested.
-    //   - if a match is found, return index and fill nodeID
-    //   - if no match, exit loop.
-    for (uint8_t index = _index; index != V0p2_Nodes.maxSets; ++index) {
-        uint8_t temp[V0p2_Nodes.idLength] = {};
-        V0p2_Nodes.get(index, temp);
-
-        if (0xff == temp[0]) { return (-1); } 
-
-        // If no prefix is passed in, we match automatically and let the caller
-        // deal with scanning values.
-        const bool isMatch = (prefixLen == 0) || (memcmp(temp, prefix, prefixLen) == 0);
-
-        if (isMatch) {
-            if (nullptr != nodeID) { memcpy(nodeID, temp, V0p2_Nodes.idLength); }
-
-            return (index);
-        }
-    }
-
-    // No match has been found.
-    return(-1);
+    if(!V0p2_NodeIndex.isValid()) { V0p2_NodeIndex.rebuild(V0p2_Nodes); }
+    return (int8_t(V0p2_NodeIndex.getNextMatchingNodeID(_index, prefix, prefixLen, nodeID)));
 }
 #endif // ARDUINO_ARCH_AVR
 
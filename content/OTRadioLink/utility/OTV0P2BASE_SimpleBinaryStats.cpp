@@ -262,8 +262,7 @@ uint8_t *encodeFullStatsMessageCore(uint8_t * const buf, const uint8_t buflen, c
 
   // Finish off message by computing and appending the CRC and then terminating 0xff (and return pointer to 0xff).
   // Assumes that b now points just beyond the end of the payload.
-  uint8_t crc = MESSAGING_FULL_STATS_CRC_INIT; // Initialisation.
-  for(const uint8_t *p = buf; p < b; ) { crc = OTV0P2BASE::crc7_5B_update(crc, *p++); }
+  const uint8_t crc = OTV0P2BASE::crc7_5B_update_block(MESSAGING_FULL_STATS_CRC_INIT, buf, uint8_t(b - buf));
   *b++ = crc;
   *b = 0xff;
 #if 0 && defined(DEBUG)
@@ -360,8 +359,7 @@ const uint8_t *decodeFullStatsMessageCore(const uint8_t * const buf, const uint8
   // Finish off by computing and checking the CRC (and return pointer to just after CRC).
   // Assumes that b now points just beyond the end of the payload.
   if(b - buf >= buflen) { return(NULL); } // Fail if next byte not available.
-  uint8_t crc = MESSAGING_FULL_STATS_CRC_INIT; // Initialisation.
-  for(const uint8_t *p = buf; p < b; ) { crc = OTV0P2BASE::crc7_5B_update(crc, *p++); }
+  const uint8_t crc = OTV0P2BASE::crc7_5B_update_block(MESSAGING_FULL_STATS_CRC_INIT, buf, uint8_t(b - buf));
 //DEBUG_SERIAL_PRINTLN_FLASHSTRING(" chk CRC");
   if(crc != *b++) { return(NULL); } // Bad CRC.
 
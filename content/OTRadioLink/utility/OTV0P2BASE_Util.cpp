@@ -47,6 +47,60 @@ int parseHexByte(const char *const s)
     return((d0 << 4) | d1);
     }
 
+#ifdef OTV0P2BASE_SCRATCH_ARENA
+thread_local ScratchSpaceArena *ScratchSpaceArena::current;
+
+ScratchSpaceArena::ScratchSpaceArena(uint8_t *const buf_, const size_t bufsize_)
+  : base((bufsize_ <= size_t(alignUp(buf_) - buf_)) ? NULL : alignUp(buf_)),
+    size((NULL == base) ? 0 : bufsize_ - size_t(base - buf_)),
+    previous(current)
+    { reset(); current = this; }
+
+void ScratchSpaceArena::reset()
+    {
+    memset(siteHighWater, 0, sizeof(siteHighWater));
+    memset(siteKeptStart, 0, sizeof(siteKeptStart));
+    memset(siteOffered, 0, sizeof(siteOffered));
+    memset(siteSeen, 0, sizeof(siteSeen));
+    misaligned = 0;
+    if(NULL != base) { memset(base, paint, size); }
+    }
+
+void ScratchSpaceArena::record(const uint8_t site, const ScratchSpaceL &space, const size_t n)
+    {
+    if(site >= maxSites) { return; }
+    // Ignore unusable spaces and any from elsewhere.
+    if((NULL == space.buf) || (space.buf < base) || (space.buf >= base + size)) { return; }
+    const size_t start = size_t(space.buf - base);
+    const size_t end = start + ((n < space.bufsize) ? n : space.bufsize);
+    if(0 != (start & (alignment - 1))) { ++misaligned; }
+    if(end > siteHighWater[site]) { siteHighWater[site] = end; siteKeptStart[site] = start; }
+    if(space.bufsize > siteOffered[site]) { siteOffered[site] = space.bufsize; }
+    siteSeen[site] = true;
+    }
+
+size_t ScratchSpaceArena::getHighWater() const
+    {
+    size_t hw = 0;
+    for(uint8_t i = 0; i < maxSites; ++i) { if(siteHighWater[i] > hw) { hw = siteHighWater[i]; } }
+    return(hw);
+    }
+
+size_t ScratchSpaceArena::getSiteTouched(const uint8_t site) const
+    {
+    if(!seen(site)) { return(0); }
+    const size_t start = siteKeptStart[site];
+    for(size_t i = siteHighWater[site]; i > start; --i) { if(paint != base[i-1]) { return(i - start); } }
+    return(0);
+    }
+
+size_t ScratchSpaceArena::getTouchedHighWater() const
+    {
+    for(size_t i = size; i > 0; --i) { if(paint != base[i-1]) { return(i); } }
+    return(0);
+    }
+#endif // OTV0P2BASE_SCRATCH_ARENA
+
 #ifdef MemoryChecks_DEFINED
 #ifndef ARDUINO_ARCH_AVR
 size_t RAMEND = 0;
@@ -124,6 +124,15 @@ int parseHexByte(const char *s);
 #endif
 
 
+// Scratch space arenas, for measuring the scratch space actually needed.
+// Off unless OTV0P2BASE_SCRATCH_ARENA is defined for an instrumentation build
+// (eg meson -Dscratch_arena=true); each instrumented call site then costs
+// a check of a thread-local pointer.
+// Not available on AVR.
+#if defined(OTV0P2BASE_SCRATCH_ARENA) && defined(ARDUINO_ARCH_AVR)
+#error OTV0P2BASE_SCRATCH_ARENA is not supported on AVR
+#endif
+
 // Large scratch space that can be passed into callers to trim stack usage.
 // Possible to create tail end for use by nested callers
 // where a routine needs to keep some state during those calls.
@@ -150,6 +159,18 @@ class ScratchSpaceL final
     constexpr ScratchSpaceL(uint8_t *const buf_, const size_t bufsize_)
       : buf((0 == bufsize_) ? NULL : buf_), bufsize((NULL == buf_) ? 0 : bufsize_) { }
 
+    // Alignment that a reservation holding word-structured data (eg a key
+    // context) is rounded up to, so that the space after it stays aligned.
+    // Byte buffers are packed and do not need this.
+#ifdef ARDUINO_ARCH_AVR
+    static constexpr size_t alignment = 1;
+#else
+    static constexpr size_t alignment = sizeof(uint32_t);
+#endif
+    // Size n rounded up to a multiple of alignment.
+    static constexpr size_t alignedSize(size_t n)
+        { return((n + alignment - 1) & ~(alignment - 1)); }
+
     // Check if sub-space cannot be made (would not leave at least one byte available).
     static constexpr bool subSpaceCannotBeMade(size_t oldSize, size_t reserveN)
         { return((0 == reserveN) || (oldSize <= reserveN)); }
@@ -160,8 +181,113 @@ class ScratchSpaceL final
       : buf(subSpaceCannotBeMade(parent.bufsize, reserveN) ? NULL : parent.buf + reserveN),
         bufsize(subSpaceCannotBeMade(parent.bufsize, reserveN) ? 0 : parent.bufsize - reserveN)
         { }
+    // As above, also recording in the current arena (if any) that call site 'site'
+    // keeps the first reserveN bytes of parent for itself.
+    inline ScratchSpaceL(const ScratchSpaceL &parent, size_t reserveN, uint8_t site);
+
+    // Record in the current arena (if any) that call site 'site' was entered with
+    // this space and uses the first n bytes of it itself; no-op otherwise.
+    inline void noteUse(uint8_t site, size_t n = 0) const;
+  };
+
+#ifdef OTV0P2BASE_SCRATCH_ARENA
+// Scratch buffer that tracks how ScratchSpaceL sub-spaces are carved from it.
+// The start of the buffer is aligned to 'alignment' (trimming the size to
+// suit) and the space is painted so that bytes actually written can be found.
+// For each call site (a small integer as for MemoryChecks locations)
+// records the high-water mark, in bytes from the start of the arena,
+// of the end of the scratch that the site keeps for itself,
+// and the most space that the site was offered.
+// Sub-spaces that are not aligned are counted.
+// Spaces are attributed to the arena by address, so ScratchSpaceL carries
+// no arena pointer: while an arena exists it is the current one for its
+// thread (until another is made), and only spaces within it are recorded.
+// For measuring scratch requirements in tests; arenas must be destroyed
+// in reverse order of creation on each thread.
+class ScratchSpaceArena final
+  {
+  public:
+    // Alignment of the arena start; sub-space starts should keep to this.
+    static constexpr size_t alignment = ScratchSpaceL::alignment;
+    // Number of distinct call sites, numbered [0,maxSites).
+    static constexpr uint8_t maxSites = 16;
+    // Value painted into unused space.
+    static constexpr uint8_t paint = 0xa5;
+
+  private:
+    uint8_t *const base;
+    const size_t size;
+    size_t siteHighWater[maxSites];
+    size_t siteKeptStart[maxSites];
+    size_t siteOffered[maxSites];
+    bool siteSeen[maxSites];
+    uint16_t misaligned;
+    // Arena current on this thread when this one was made.
+    ScratchSpaceArena *const previous;
+    static thread_local ScratchSpaceArena *current;
+    static uint8_t *alignUp(uint8_t *const p)
+        { return((NULL == p) ? NULL : (uint8_t *)((uintptr_t(p) + alignment - 1) & ~uintptr_t(alignment - 1))); }
+
+  public:
+    // Wrap buf of bufsize bytes; buf may be NULL (unusable arena).
+    // Becomes the current arena for this thread.
+    ScratchSpaceArena(uint8_t *buf_, size_t bufsize_);
+    ~ScratchSpaceArena() { current = previous; }
+    ScratchSpaceArena(const ScratchSpaceArena &) = delete;
+    ScratchSpaceArena &operator=(const ScratchSpaceArena &) = delete;
+
+    // Current arena for this thread, or NULL if none.
+    static ScratchSpaceArena *getCurrent() { return(current); }
+
+    // Space covering the whole arena, to pass into the stack being measured.
+    ScratchSpaceL getSpace() { return(ScratchSpaceL(base, size)); }
+    // Usable (aligned) size.
+    size_t getSize() const { return(size); }
+
+    // Forget all records and repaint the space.
+    void reset();
+
+    // Record use of the first n bytes of space by call site 'site'.
+    // Sites out of range are ignored.
+    void record(uint8_t site, const ScratchSpaceL &space, size_t n);
+
+    // True if site has been recorded since the last reset().
+    bool seen(uint8_t site) const { return((site < maxSites) && siteSeen[site]); }
+    // End of the space kept by site for itself, from the start of the arena; 0 if never seen.
+    size_t getSiteHighWater(uint8_t site) const { return(seen(site) ? siteHighWater[site] : 0); }
+    // Bytes of the space kept by site for itself (at its high-water mark)
+    // up to and including the last one written, found from the paint;
+    // 0 if never seen.  Compare with the site's published reservation.
+    size_t getSiteTouched(uint8_t site) const;
+    // Most space offered to site; 0 if never seen.
+    size_t getSiteOffered(uint8_t site) const { return(seen(site) ? siteOffered[site] : 0); }
+    // Highest site high-water mark.
+    size_t getHighWater() const;
+    // Bytes from the start of the arena up to and including the last one
+    // written since the last reset(), found from the paint;
+    // may under-read by a byte or so where the paint value was written.
+    size_t getTouchedHighWater() const;
+    // Number of sub-spaces recorded that did not start aligned.
+    uint16_t getMisalignedCount() const { return(misaligned); }
   };
 
+inline ScratchSpaceL::ScratchSpaceL(const ScratchSpaceL &parent, const size_t reserveN, const uint8_t site)
+  : ScratchSpaceL(parent, reserveN)
+    {
+    ScratchSpaceArena *const arena = ScratchSpaceArena::getCurrent();
+    if(NULL != arena) { arena->record(site, parent, reserveN); }
+    }
+inline void ScratchSpaceL::noteUse(const uint8_t site, const size_t n) const
+    {
+    ScratchSpaceArena *const arena = ScratchSpaceArena::getCurrent();
+    if(NULL != arena) { arena->record(site, *this, n); }
+    }
+#else
+inline ScratchSpaceL::ScratchSpaceL(const ScratchSpaceL &parent, const size_t reserveN, uint8_t)
+  : ScratchSpaceL(parent, reserveN) { }
+inline void ScratchSpaceL::noteUse(uint8_t, size_t) const { }
+#endif
+
 // Class for scratch space that can be passed into callers to trim stack usage.
 // Possible to create tail end for use by nested callers
 // where a routine needs to keep some state during those calls.
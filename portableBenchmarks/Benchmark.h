@@ -0,0 +1,94 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * Common support for the portable benchmarks.
+ */
+
+#ifndef PORTABLEBENCHMARKS_BENCHMARK_H_
+#define PORTABLEBENCHMARKS_BENCHMARK_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace OTBench
+{
+    typedef std::chrono::steady_clock bench_clock;
+
+    // Print the column headings for run().
+    inline void printHeader()
+    {
+        printf("%-34s %9s %11s %8s %8s %8s %8s %6s\n",
+               "operation", "ns/op", "ops/s", "p50", "p90", "p99", "max", "fails");
+    }
+
+    /**
+     * @brief   Print one row of results.
+     * @param   lat: Per-operation latencies (ns); sorted in place; non-empty.
+     */
+    inline void printRow(const char *const name, const double nsPerOp, std::vector<uint32_t> &lat, const unsigned fails)
+    {
+        std::sort(lat.begin(), lat.end());
+        const size_t n = lat.size();
+        printf("%-34s %9.1f %11.0f %8u %8u %8u %8u %6u\n",
+               name, nsPerOp, 1e9 / nsPerOp,
+               unsigned(lat[n / 2]), unsigned(lat[(n * 9) / 10]),
+               unsigned(lat[(n * 99) / 100]), unsigned(lat[n - 1]), fails);
+    }
+
+    /**
+     * @brief   Time n calls of op and print one row of results.
+     *
+     * Reports mean ns/op and ops/s from a run without per-call timing,
+     * then the latency distribution (ns) from a second run timing every call.
+     *
+     * @param   name: Row label.
+     * @param   n: Calls per run; at least 100.
+     * @param   op: Callable returning true on success.
+     */
+    template<typename op_t>
+    void run(const char *const name, const unsigned n, op_t op)
+    {
+        for(unsigned i = 0; i < n / 16; ++i) { op(); } // Warm up.
+
+        unsigned fails = 0;
+        const bench_clock::time_point start = bench_clock::now();
+        for(unsigned i = 0; i < n; ++i) { if(!op()) { ++fails; } }
+        const double totalNs = std::chrono::duration<double, std::nano>(bench_clock::now() - start).count();
+
+        std::vector<uint32_t> lat(n);
+        for(unsigned i = 0; i < n; ++i) {
+            const bench_clock::time_point t0 = bench_clock::now();
+            op();
+            lat[i] = uint32_t(std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock::now() - t0).count());
+        }
+        printRow(name, totalNs / n, lat, fails);
+    }
+
+    // Benchmark suites, each running n iterations per operation.
+    void secureFrameBenchmarks(unsigned n);
+    void crcBenchmarks(unsigned n);
+    void msgCounterBenchmarks(unsigned n);
+    void rxQueueBenchmarks(unsigned n);
+    void virtualEtherBenchmarks(unsigned n);
+}
+
+#endif /* PORTABLEBENCHMARKS_BENCHMARK_H_ */
@@ -0,0 +1,112 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * Cross-thread RX queue benchmark.
+ *
+ * Passes n frames from a producer (driver) thread to the consumer (handler)
+ * thread through ISRRXQueueVarLenMsg with a mutex around each operation,
+ * and through the lock-free ISRRXQueueVarLenMsgSPSC.
+ * Reports ns per frame end to end, and the latency from queueing to
+ * the consumer seeing each frame.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <OTV0p2Base.h>
+#include <OTRadioLink.h>
+#include <OTRadioLink_ISRRXQueue.h>
+
+#include "Benchmark.h"
+
+
+namespace OTRXQBM
+{
+    static constexpr uint8_t maxLen = 64;
+    static constexpr uint8_t frameLen = 24;
+
+    // ISRRXQueueVarLenMsg made safe across threads with a lock.
+    class MutexQueue final
+    {
+    private:
+        OTRadioLink::ISRRXQueueVarLenMsg<maxLen, 2> q;
+        mutable std::mutex m;
+    public:
+        volatile uint8_t *_getRXBufForInbound() { std::lock_guard<std::mutex> l(m); return(q._getRXBufForInbound()); }
+        void _loadedBuf(const uint8_t len) { std::lock_guard<std::mutex> l(m); q._loadedBuf(len); }
+        const volatile uint8_t *peekRXMsg() const { std::lock_guard<std::mutex> l(m); return(q.peekRXMsg()); }
+        void removeRXMsg() { std::lock_guard<std::mutex> l(m); q.removeRXMsg(); }
+    };
+
+    typedef OTRadioLink::ISRRXQueueVarLenMsgSPSC<maxLen, 2> SPSCQueue;
+
+    // Nanoseconds on the benchmark clock.
+    uint64_t nowNs()
+    {
+        return(uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                OTBench::bench_clock::now().time_since_epoch()).count()));
+    }
+
+    // Run n frames through q and print a row.
+    template<typename queue_t>
+    void transfer(const char *const name, const unsigned n)
+    {
+        queue_t q;
+        std::vector<uint32_t> lat(n);
+        const OTBench::bench_clock::time_point start = OTBench::bench_clock::now();
+        std::thread producer([&]{
+            for(unsigned i = 0; i < n; ++i) {
+                volatile uint8_t *f;
+                while(NULL == (f = q._getRXBufForInbound())) { std::this_thread::yield(); }
+                // Frame carries its queueing time.
+                uint8_t frame[frameLen] = { };
+                const uint64_t t = nowNs();
+                memcpy(frame, &t, sizeof(t));
+                for(uint8_t j = 0; j < frameLen; ++j) { f[j] = frame[j]; }
+                q._loadedBuf(frameLen);
+            }
+        });
+        unsigned fails = 0;
+        for(unsigned i = 0; i < n; ) {
+            const volatile uint8_t *const m = q.peekRXMsg();
+            if(NULL == m) { std::this_thread::yield(); continue; }
+            uint8_t frame[frameLen];
+            for(uint8_t j = 0; j < frameLen; ++j) { frame[j] = m[j]; }
+            if(frameLen != m[-1]) { ++fails; }
+            q.removeRXMsg();
+            uint64_t t;
+            memcpy(&t, frame, sizeof(t));
+            lat[i++] = uint32_t(nowNs() - t);
+        }
+        producer.join();
+        const double totalNs = std::chrono::duration<double, std::nano>(OTBench::bench_clock::now() - start).count();
+        OTBench::printRow(name, totalNs / n, lat, fails);
+    }
+
+}
+
+void OTBench::rxQueueBenchmarks(const unsigned n)
+{
+    OTRXQBM::transfer<OTRXQBM::MutexQueue>("RX queue x-thread mutex", n);
+    OTRXQBM::transfer<OTRXQBM::SPSCQueue>("RX queue x-thread SPSC", n);
+
+}
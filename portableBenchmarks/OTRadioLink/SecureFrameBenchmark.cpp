@@ -0,0 +1,340 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * Throughput and latency benchmark for the secure frame layer.
+ *
+ * Times encode(), encodeValveFrame() (generic and fixed-shape),
+ * generateSecureBeacon(), decode() and decodeNonsecure() with the NULL crypto,
+ * and with OTAESGCM where available.
+ * Also compares decodeBatch() and a key context cache against per-frame
+ * decode() where each frame pays for key expansion, using the portable
+ * AES-GCM with its real key schedule and GHASH key setup.
+ * Also times decode() trying each of 1, 2, 4 and 8 associated senders that
+ * share an ID prefix (firstIDMatchOnly false), with the senders taking turns.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(EXT_AVAILABLE_ARDUINO_LIB_OTAESGCM)
+#include <OTAESGCM.h>
+#endif
+#include <OTV0p2Base.h>
+#include <OTRadioLink.h>
+
+#include "Benchmark.h"
+
+
+namespace OTSFBM
+{
+    static constexpr uint8_t id[8] = { 0xaa, 0xaa, 0xaa, 0xaa, 0x55, 0x55, 0x55, 0x55 };
+    static const uint8_t key[16] = { };
+
+    // Generous scratch for any of the operations with either crypto.
+    static constexpr size_t workspaceSize = 1024;
+    uint8_t workspace[workspaceSize];
+
+    // TX with a fixed ID and a RAM counter that never runs out.
+    class BenchTX final : public OTRadioLink::SimpleSecureFrame32or0BodyTXBase
+    {
+    private:
+        const uint8_t *const txID;
+        uint64_t counter = 0x10000;
+    public:
+        explicit BenchTX(const uint8_t *const txID_ = id) : txID(txID_) { }
+        virtual bool getTXID(uint8_t *buf) const override { memcpy(buf, txID, sizeof(id)); return(true); }
+        virtual bool getTXNVCtrPrefix(uint8_t *buf) const override { memset(buf, 0, txNVCtrPrefixBytes); return(true); }
+        virtual bool resetTXNVCtrPrefix(bool) override { return(false); }
+        virtual bool incrementTXNVCtrPrefix() override { return(false); }
+        virtual bool getNextTXMsgCtr(uint8_t *buf) override
+        {
+            uint64_t c = ++counter;
+            for(int i = fullMsgCtrBytes; --i >= 0; c >>= 8) { buf[i] = uint8_t(c); }
+            return(true);
+        }
+    };
+
+    // Benchmark all the operations with the given crypto.
+    void runAll(const char *const cryptoName, const unsigned n,
+                OTRadioLink::SimpleSecureFrame32or0BodyTXBase::fixed32BTextSize12BNonce16BTagSimpleEnc_fn_t &e,
+                OTRadioLink::SimpleSecureFrame32or0BodyRXBase::fixed32BTextSize12BNonce16BTagSimpleDec_fn_t &d)
+    {
+        static constexpr uint8_t il = 4;
+        static const char stats[] = "{\"b\":1,\"T|C16\":301}";
+        BenchTX tx;
+        uint8_t body[OTRadioLink::ENC_BODY_SMALL_FIXED_CTEXT_SIZE];
+        uint8_t out[64];
+        char name[64];
+
+        snprintf(name, sizeof(name), "encode() %s", cryptoName);
+        OTBench::run(name, n, [&]{
+            // Body is padded in place so must be refreshed.
+            memset(body, 0, sizeof(body));
+            memcpy(body, "\x7f\x11{b|", 5);
+            OTRadioLink::OTEncodeData_T fd(body, sizeof(body), out, sizeof(out));
+            fd.ptextLen = 5;
+            fd.fType = OTRadioLink::FTS_BasicSensorOrValve;
+            OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+            return(0 != tx.encode(fd, il, e, sW, key));
+        });
+
+        snprintf(name, sizeof(name), "encodeValveFrame() %s", cryptoName);
+        OTBench::run(name, n, [&]{
+            memset(body, 0, sizeof(body));
+            memcpy(body + 2, stats, sizeof(stats));
+            OTRadioLink::OTEncodeData_T fd(body, sizeof(body), out, sizeof(out));
+            OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+            return(0 != tx.encodeValveFrame(fd, il, 42, e, sW, key));
+        });
+
+        snprintf(name, sizeof(name), "encodeValveFrame() fixed %s", cryptoName);
+        OTBench::run(name, n, [&]{
+            memset(body, 0, sizeof(body));
+            memcpy(body + 2, stats, sizeof(stats));
+            OTRadioLink::OTEncodeData_T fd(body, sizeof(body), out, sizeof(out));
+            OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+            return(0 != OTRadioLink::SimpleSecureValveFrameTX<il>::encodeValveFrame(tx, fd, 42, e, sW, key));
+        });
+
+        snprintf(name, sizeof(name), "generateSecureBeacon() %s", cryptoName);
+        OTBench::run(name, n, [&]{
+            OTRadioLink::OTBuf_t buf(out, sizeof(out));
+            OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+            return(0 != tx.generateSecureBeacon(buf, il, e, sW, key));
+        });
+
+        // One frame, decoded repeatedly by an RX that accepts any counter
+        // above zero.
+        uint8_t frame[64];
+        memset(body, 0, sizeof(body));
+        memcpy(body, "\x7f\x11{b|", 5);
+        OTRadioLink::OTEncodeData_T efd(body, sizeof(body), frame, sizeof(frame));
+        efd.ptextLen = 5;
+        efd.fType = OTRadioLink::FTS_BasicSensorOrValve;
+        OTV0P2BASE::ScratchSpaceL eW(workspace, sizeof(workspace));
+        if(0 == tx.encode(efd, il, e, eW, key)) { fprintf(stderr, "encode failed\n"); exit(1); }
+        OTRadioLink::SimpleSecureFrame32or0BodyRXFixedCounter &rx =
+            OTRadioLink::SimpleSecureFrame32or0BodyRXFixedCounter::getInstance();
+        const uint8_t zeroCounter[6] = { };
+        rx.setMockIDValue(id);
+        rx.setMockCounterValue(zeroCounter);
+        uint8_t ptext[OTRadioLink::OTDecodeData_T::ptextLenMax];
+
+        snprintf(name, sizeof(name), "decode() %s", cryptoName);
+        OTBench::run(name, n, [&]{
+            OTRadioLink::OTDecodeData_T fd(frame, ptext);
+            if(0 == fd.sfh.decodeHeader(frame, frame[0] + 1)) { return(false); }
+            OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+            return(0 != rx.decode(fd, d, sW, key));
+        });
+    }
+
+    // Portable AES-GCM key context cache, one entry.
+    static constexpr size_t keyContextSize =
+        OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleKeyContextSize_AESGCM_IMPL;
+    typedef OTRadioLink::SimpleDecKeyContextCache<keyContextSize> cache_t;
+    cache_t cache;
+    OTRadioLink::SimpleSecureFrame32or0BodyRXBase::fixed32BTextSize12BNonce16BTagSimpleDec_fn_t &decCached =
+        OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDecCached<cache_t, cache,
+            OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleKeySetup_AESGCM_IMPL,
+            OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDecWithContext_AESGCM_IMPL>;
+
+    // Batch of frames from one sender under the portable AES-GCM, decoded
+    // one at a time with and without cached key setup, and as a batch.
+    void runBatch(const unsigned n)
+    {
+        static constexpr uint8_t il = 4;
+        static constexpr uint8_t nFrames = 32;
+        BenchTX tx;
+        static uint8_t frames[nFrames][64];
+        static uint8_t ptext[nFrames][OTRadioLink::OTDecodeData_T::ptextLenMax];
+        OTRadioLink::OTDecodeData_T *fds[nFrames];
+        for(uint8_t i = 0; i < nFrames; ++i) {
+            uint8_t body[OTRadioLink::ENC_BODY_SMALL_FIXED_CTEXT_SIZE] = { 0x7f, 0x11, '{', 'b', '|' };
+            OTRadioLink::OTEncodeData_T efd(body, sizeof(body), frames[i], sizeof(frames[i]));
+            efd.ptextLen = 5;
+            efd.fType = OTRadioLink::FTS_BasicSensorOrValve;
+            OTV0P2BASE::ScratchSpaceL eW(workspace, sizeof(workspace));
+            if(0 == tx.encode(efd, il, OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleEnc_AESGCM_IMPL, eW, key)) { fprintf(stderr, "encode failed\n"); exit(1); }
+            fds[i] = new OTRadioLink::OTDecodeData_T(frames[i], ptext[i]);
+            fds[i]->sfh.decodeHeader(frames[i], frames[i][0] + 1);
+        }
+        OTRadioLink::SimpleSecureFrame32or0BodyRXFixedCounter &rx =
+            OTRadioLink::SimpleSecureFrame32or0BodyRXFixedCounter::getInstance();
+        const uint8_t zeroCounter[6] = { };
+        rx.setMockIDValue(id);
+        rx.setMockCounterValue(zeroCounter);
+
+        OTBench::run("decode() x32 setup per frame", n / 32, [&]{
+            uint8_t nOK = 0;
+            for(uint8_t i = 0; i < nFrames; ++i) {
+                OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+                if(0 != rx.decode(*fds[i], OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDec_AESGCM_IMPL, sW, key)) { ++nOK; }
+            }
+            return(nFrames == nOK);
+        });
+        OTBench::run("decodeBatch() x32", n / 32, [&]{
+            OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+            return(nFrames == rx.decodeBatch(fds, nFrames,
+                    OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleKeySetup_AESGCM_IMPL,
+                    OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDecWithContext_AESGCM_IMPL,
+                    keyContextSize,
+                    sW, key, NULL));
+        });
+        OTBench::run("decode() x32 cached key context", n / 32, [&]{
+            uint8_t nOK = 0;
+            for(uint8_t i = 0; i < nFrames; ++i) {
+                OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+                if(0 != rx.decode(*fds[i], decCached, sW, key)) { ++nOK; }
+            }
+            return(nFrames == nOK);
+        });
+        for(uint8_t i = 0; i < nFrames; ++i) { delete fds[i]; }
+    }
+
+    // RX associated with n senders whose IDs all share the first 4 bytes,
+    // accepting any counter above zero.
+    class CollidingRX final : public OTRadioLink::SimpleSecureFrame32or0BodyRXBase
+    {
+    public:
+        static constexpr uint8_t maxSenders = 8;
+    private:
+        uint8_t ids[maxSenders][8];
+        const uint8_t n;
+        virtual int8_t _getNextMatchingNodeID(const uint8_t start, const OTRadioLink::SecurableFrameHeader *const sfh, uint8_t *nodeID) const override
+        {
+            for(uint8_t i = start; i < n; ++i) {
+                if(0 != memcmp(ids[i], sfh->id, sfh->getIl())) { continue; }
+                if(nullptr != nodeID) { memcpy(nodeID, ids[i], 8); }
+                return(int8_t(i));
+            }
+            return(-1);
+        }
+    public:
+        explicit CollidingRX(const uint8_t n_) : n((n_ > maxSenders) ? maxSenders : n_)
+            { for(uint8_t i = 0; i < maxSenders; ++i) { getID(i, ids[i]); } }
+        // ID of sender k.
+        static void getID(const uint8_t k, uint8_t *const buf)
+            { memcpy(buf, id, sizeof(id)); buf[4] = uint8_t(0x10 + k); }
+        virtual bool getLastRXMsgCtr(const uint8_t *const, uint8_t *counter) const override
+            { memset(counter, 0, fullMsgCtrBytes); return(true); }
+        virtual bool authAndUpdateRXMsgCtr(const uint8_t *, const uint8_t *) override { return(true); }
+    };
+
+    // One frame from each of nSenders colliding senders under the portable
+    // AES-GCM, decoded in turn with every matching association tried.
+    // Senders beyond maxIDMatchAttempts that are not recent show as fails.
+    void runColliding(const unsigned n)
+    {
+        static constexpr uint8_t il = 4;
+        const uint8_t nColliding[] = { 1, 2, 4, 8 };
+        for(const uint8_t nSenders : nColliding) {
+            static uint8_t frames[CollidingRX::maxSenders][64];
+            for(uint8_t k = 0; k < nSenders; ++k) {
+                uint8_t senderID[8];
+                CollidingRX::getID(k, senderID);
+                BenchTX tx(senderID);
+                uint8_t body[OTRadioLink::ENC_BODY_SMALL_FIXED_CTEXT_SIZE] = { 0x7f, 0x11, '{', 'b', '|' };
+                OTRadioLink::OTEncodeData_T efd(body, sizeof(body), frames[k], sizeof(frames[k]));
+                efd.ptextLen = 5;
+                efd.fType = OTRadioLink::FTS_BasicSensorOrValve;
+                OTV0P2BASE::ScratchSpaceL eW(workspace, sizeof(workspace));
+                if(0 == tx.encode(efd, il, OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleEnc_AESGCM_IMPL, eW, key)) { fprintf(stderr, "encode failed\n"); exit(1); }
+            }
+            CollidingRX rx(nSenders);
+            uint8_t ptext[OTRadioLink::OTDecodeData_T::ptextLenMax];
+            uint8_t next = 0;
+            char name[64];
+            snprintf(name, sizeof(name), "decode() %u colliding IDs", unsigned(nSenders));
+            OTBench::run(name, n, [&]{
+                const uint8_t *const frame = frames[next];
+                next = uint8_t((next + 1) % nSenders);
+                OTRadioLink::OTDecodeData_T fd(frame, ptext);
+                if(0 == fd.sfh.decodeHeader(frame, frame[0] + 1)) { return(false); }
+                OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+                return(0 != rx.decode(fd, OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDec_AESGCM_IMPL, sW, key, false));
+            });
+        }
+    }
+}
+
+void OTBench::secureFrameBenchmarks(const unsigned n)
+{
+    {
+        // Non-secure frame with a short body.
+        uint8_t body[] = { 0x7f, 0x11 };
+        uint8_t frame[64];
+        OTRadioLink::OTEncodeData_T efd(body, sizeof(body), frame, sizeof(frame));
+        efd.ptextLen = sizeof(body);
+        efd.fType = OTRadioLink::FTS_BasicSensorOrValve;
+        if(0 == OTRadioLink::encodeNonsecure(efd, 0, OTSFBM::id, 4)) { fprintf(stderr, "encodeNonsecure failed\n"); exit(1); }
+        run("decodeNonsecure()", n, [&]{
+            OTRadioLink::OTDecodeData_T fd(frame, NULL);
+            if(0 == fd.sfh.decodeHeader(frame, frame[0] + 1)) { return(false); }
+            return(0 != OTRadioLink::decodeNonsecure(fd));
+        });
+    }
+
+    {
+        // Batch of captured non-secure frames of assorted lengths.
+        static constexpr uint8_t nFrames = 64;
+        static uint8_t bufs[nFrames][64];
+        const uint8_t *frames[nFrames];
+        uint8_t lens[nFrames];
+        for(uint8_t i = 0; i < nFrames; ++i) {
+            uint8_t body[OTRadioLink::SecurableFrameHeader::maxSmallFrameBodySize - 4] = { };
+            OTRadioLink::OTEncodeData_T efd(body, uint8_t(8 + (i * 7) % (sizeof(body) - 8)), bufs[i], sizeof(bufs[i]));
+            efd.fType = OTRadioLink::FTS_BasicSensorOrValve;
+            lens[i] = OTRadioLink::encodeNonsecure(efd, i, OTSFBM::id, 4);
+            if(0 == lens[i]) { fprintf(stderr, "encodeNonsecure failed\n"); exit(1); }
+            frames[i] = bufs[i];
+        }
+        run("decodeNonsecure() x64", n / 16, [&]{
+            uint8_t nOK = 0;
+            for(uint8_t i = 0; i < nFrames; ++i) {
+                OTRadioLink::OTDecodeData_T fd(frames[i], NULL);
+                if((0 != fd.sfh.decodeHeader(frames[i], lens[i])) &&
+                   (0 != OTRadioLink::decodeNonsecure(fd))) { ++nOK; }
+            }
+            return(nFrames == nOK);
+        });
+        uint8_t bitmap[nFrames / 8];
+        run("checkNonsecureCRCBatch() x64", n / 16, [&]{
+            return(nFrames == OTRadioLink::checkNonsecureCRCBatch(frames, lens, nFrames, bitmap));
+        });
+    }
+
+    OTSFBM::runAll("NULL", n,
+                   OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleEnc_NULL_IMPL,
+                   OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDec_NULL_IMPL);
+    OTSFBM::runAll("AESGCM portable", n,
+                   OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleEnc_AESGCM_IMPL,
+                   OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDec_AESGCM_IMPL);
+    OTSFBM::runBatch(n);
+    OTSFBM::runColliding(n);
+#if defined(EXT_AVAILABLE_ARDUINO_LIB_OTAESGCM)
+    OTSFBM::runAll("AESGCM", n,
+                   OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleEnc_DEFAULT_WITH_LWORKSPACE,
+                   OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleDec_DEFAULT_WITH_LWORKSPACE);
+#else
+    printf("OTAESGCM not available: AESGCM runs skipped.\n");
+#endif
+}
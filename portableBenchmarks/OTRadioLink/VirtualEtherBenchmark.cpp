@@ -0,0 +1,129 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * Fleet-scale throughput harness on the virtual ether.
+ *
+ * Each valve sends a non-secure stats frame to one hub every 4 minutes
+ * (random phase, +/-10% jitter) over a link losing 2% of frames.
+ * The hub drains its radio with an OTMessageQueueHandler every 100ms
+ * of virtual time, checking each frame with decodeNonsecure().
+ * Reports frames handled per second of wall-clock time (ie simulator
+ * speed), per second of virtual time, and the fate of all frames sent.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <functional>
+#include <queue>
+#include <vector>
+
+#include <OTV0p2Base.h>
+#include <OTRadioLink.h>
+
+#include "Benchmark.h"
+
+
+namespace OTVEBM
+{
+    typedef OTRadioLink::VirtualEther::vtime_t vtime_t;
+    static constexpr vtime_t second = 1000000;
+    static constexpr vtime_t txInterval = 240 * second;
+    static constexpr vtime_t handleInterval = second / 10;
+    static constexpr vtime_t runTime = 3600 * second;
+
+    unsigned handledOK;
+    unsigned handledBad;
+    bool pollIO(bool) { return(false); }
+    bool checkFrame(const uint8_t *const msg)
+    {
+        const uint8_t len = msg[-1];
+        uint8_t buf[OTRadioLink::VirtualEther::maxFrameBytes];
+        for(uint8_t i = 0; i < len; ++i) { buf[i] = msg[i]; }
+        OTRadioLink::OTDecodeData_T fd(buf, NULL);
+        if((0 != fd.sfh.decodeHeader(buf, len)) && (0 != OTRadioLink::decodeNonsecure(fd))) { ++handledOK; }
+        else { ++handledBad; }
+        return(true);
+    }
+
+    typedef OTRadioLink::OTVirtualEtherRadio<2> radio_t;
+    const OTRadioLink::OTRadioChannelConfig config(NULL, true);
+
+    void runFleet(const uint32_t nValves)
+    {
+        OTRadioLink::VirtualEther e(nValves);
+        radio_t hub(e);
+        hub.configure(1, &config);
+        hub.listen(true);
+        std::vector<radio_t *> valves;
+        std::vector<std::vector<uint8_t>> frames;
+        const OTRadioLink::VirtualEtherLinkModel model = { 20, 0, 0 };
+        uint32_t rng = nValves;
+        auto random = [&rng]{ rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5; return(rng); };
+        // (next TX time, valve), soonest first.
+        typedef std::pair<vtime_t, uint32_t> due_t;
+        std::priority_queue<due_t, std::vector<due_t>, std::greater<due_t>> due;
+        for(uint32_t v = 0; v < nValves; ++v) {
+            valves.push_back(new radio_t(e));
+            e.link(valves.back()->getNodeIndex(), hub.getNodeIndex(), model);
+            uint8_t id[8] = { 0x80, 0x81, 0x82, 0x83 };
+            memcpy(id + 4, &v, 4);
+            uint8_t body[] = { 0x7f, 0x11, '{', '"', 'b', '"', ':', '1' };
+            uint8_t buf[OTRadioLink::VirtualEther::maxFrameBytes];
+            OTRadioLink::OTEncodeData_T efd(body, sizeof(body), buf, sizeof(buf));
+            efd.fType = OTRadioLink::FTS_BasicSensorOrValve;
+            const uint8_t len = OTRadioLink::encodeNonsecure(efd, 0, id, 4);
+            frames.emplace_back(buf, buf + len);
+            due.push(due_t(random() % txInterval, v));
+        }
+        OTRadioLink::OTMessageQueueHandler<pollIO, 4800, checkFrame> mqh;
+        handledOK = 0;
+        handledBad = 0;
+        const OTBench::bench_clock::time_point start = OTBench::bench_clock::now();
+        for(vtime_t tick = handleInterval; tick <= runTime; tick += handleInterval) {
+            while(due.top().first < tick) {
+                const due_t d = due.top();
+                due.pop();
+                e.advanceTo(d.first);
+                valves[d.second]->sendRaw(frames[d.second].data(), uint8_t(frames[d.second].size()));
+                due.push(due_t(d.first + txInterval - txInterval / 10 + random() % (txInterval / 5), d.second));
+            }
+            e.advanceTo(tick);
+            mqh.handle(false, hub);
+        }
+        const double wallS = std::chrono::duration<double>(OTBench::bench_clock::now() - start).count();
+        const OTRadioLink::VirtualEtherStats &s = e.getStats();
+        printf("%-8u %8lu %8u %11.0f %9.2f %6lu %8lu %9lu %6lu %4u\n",
+               unsigned(nValves), (unsigned long)s.framesSent, handledOK,
+               handledOK / wallS, double(handledOK) * second / runTime,
+               (unsigned long)s.lost, (unsigned long)s.collided,
+               (unsigned long)s.rxQueueFull, (unsigned long)(s.notListening + s.filtered + s.unheard + s.tooLong),
+               handledBad);
+        for(radio_t *const v : valves) { delete v; }
+    }
+}
+
+void OTBench::virtualEtherBenchmarks(unsigned)
+{
+    printf("\nVirtual ether fleet, 1h virtual: frames sent, handled at hub, handled per wall/virtual second, drops.\n");
+    printf("%-8s %8s %8s %11s %9s %6s %8s %9s %6s %4s\n",
+           "valves", "sent", "handled", "wall fr/s", "virt fr/s", "lost", "collided", "hub full", "other", "bad");
+    const uint32_t fleets[] = { 100, 1000, 5000 };
+    for(const uint32_t n : fleets) { OTVEBM::runFleet(n); }
+}
@@ -0,0 +1,76 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * crc7_5B benchmark: bitwise vs per-byte table vs block (slice-by-4),
+ * over typical message lengths.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <OTV0p2Base.h>
+
+#include "Benchmark.h"
+
+
+namespace OTCRCBM
+{
+    // Bitwise reference, as used on AVR.
+    uint8_t crc7_5B_update_bitwise(uint8_t crc, const uint8_t datum)
+    {
+        for(uint8_t i = 0x80; i != 0; i >>= 1) {
+            bool bit = (0 != (crc & 0x40));
+            if(0 != (datum & i)) { bit = !bit; }
+            crc <<= 1;
+            if(bit) { crc ^= 0x37; }
+        }
+        return(crc & 0x7f);
+    }
+
+    // Defeats optimising the CRC calls away.
+    volatile uint8_t sink;
+}
+
+void OTBench::crcBenchmarks(const unsigned n)
+{
+    uint8_t buf[63];
+    for(uint8_t i = 0; i < sizeof(buf); ++i) { buf[i] = uint8_t(0x5b * i + 7); }
+    const uint8_t lens[] = { 6, 24, 63 };
+    char name[64];
+    for(const uint8_t len : lens) {
+        snprintf(name, sizeof(name), "crc7_5B bitwise %uB", unsigned(len));
+        run(name, n, [&]{
+            uint8_t crc = 0x7f;
+            for(uint8_t i = 0; i < len; ++i) { crc = OTCRCBM::crc7_5B_update_bitwise(crc, buf[i]); }
+            OTCRCBM::sink = crc;
+            return(true);
+        });
+        snprintf(name, sizeof(name), "crc7_5B_update() %uB", unsigned(len));
+        run(name, n, [&]{
+            uint8_t crc = 0x7f;
+            for(uint8_t i = 0; i < len; ++i) { crc = OTV0P2BASE::crc7_5B_update(crc, buf[i]); }
+            OTCRCBM::sink = crc;
+            return(true);
+        });
+        snprintf(name, sizeof(name), "crc7_5B_update_block() %uB", unsigned(len));
+        run(name, n, [&]{
+            OTCRCBM::sink = OTV0P2BASE::crc7_5B_update_block(0x7f, buf, len);
+            return(true);
+        });
+    }
+}
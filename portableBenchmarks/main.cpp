@@ -0,0 +1,43 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * Driver for the portable benchmarks.
+ *
+ * Run as:
+ *     OTRadioLinkBenchmarks [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Benchmark.h"
+
+int main(int argc, char *argv[])
+{
+    const unsigned n = (argc > 1) ? unsigned(atoi(argv[1])) : 100000U;
+    if(n < 100) { fprintf(stderr, "need at least 100 iterations\n"); return(1); }
+    printf("%u iterations per operation; latencies in ns.\n", n);
+    OTBench::printHeader();
+    OTBench::secureFrameBenchmarks(n);
+    OTBench::crcBenchmarks(n);
+    OTBench::msgCounterBenchmarks(n);
+    OTBench::rxQueueBenchmarks(n);
+    OTBench::virtualEtherBenchmarks(n);
+    return(0);
+}
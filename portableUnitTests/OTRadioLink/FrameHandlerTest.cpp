@@ -457,6 +457,7 @@ TEST(FrameHandlerTest, decodeAndHandleOTSecurableFrameBasic)
     constexpr size_t workspaceRequired =
             OTRadioLink::SimpleSecureFrame32or0BodyRXBase::decode_total_scratch_usage_OTAESGCM_3p0
             + OTAESGCM::OTAES128GCMGenericWithWorkspace<>::workspaceRequiredDec
+            + OTRadioLink::decodeAndHandleOTSecureOFrame_scratch_usage // + space for the decrypted body
             + OTRadioLink::authAndDecodeOTSecurableFrameWithWorkspace_scratch_usage; // + space to hold the key
     uint8_t workspace[workspaceRequired];
     OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
@@ -481,6 +482,7 @@ TEST(FrameHandlerTest, decodeAndHandleOTSecurableFrameNoAuthSuccess)
     constexpr size_t workspaceRequired =
             OTRadioLink::SimpleSecureFrame32or0BodyRXBase::decode_total_scratch_usage_OTAESGCM_3p0
             + OTAESGCM::OTAES128GCMGenericWithWorkspace<>::workspaceRequiredDec
+            + OTRadioLink::decodeAndHandleOTSecureOFrame_scratch_usage // + space for the decrypted body
             + OTRadioLink::authAndDecodeOTSecurableFrameWithWorkspace_scratch_usage; // + space to hold the key
     uint8_t workspace[workspaceRequired];
     OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
@@ -536,6 +538,7 @@ TEST(FrameHandler, decodeAndHandleOTSecureOFrameStackCheck)
     constexpr size_t workspaceRequired =
             OTRadioLink::SimpleSecureFrame32or0BodyRXBase::decode_total_scratch_usage_OTAESGCM_3p0
             + OTAESGCM::OTAES128GCMGenericWithWorkspace<>::workspaceRequiredDec
+            + OTRadioLink::decodeAndHandleOTSecureOFrame_scratch_usage // + space for the decrypted body
             + OTRadioLink::authAndDecodeOTSecurableFrameWithWorkspace_scratch_usage; // + space to hold the key
     uint8_t workspace[workspaceRequired];
     OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
@@ -644,6 +647,7 @@ TEST(FrameHandlerTest, decodeAndHandleOTSecurableFrameDecryptSuccess)
     constexpr size_t workspaceRequired =
             OTRadioLink::SimpleSecureFrame32or0BodyRXBase::decode_total_scratch_usage_OTAESGCM_3p0
             + OTAESGCM::OTAES128GCMGenericWithWorkspace<>::workspaceRequiredDec
+            + OTRadioLink::decodeAndHandleOTSecureOFrame_scratch_usage // + space for the decrypted body
             + OTRadioLink::authAndDecodeOTSecurableFrameWithWorkspace_scratch_usage; // + space to hold the key
     uint8_t workspace[workspaceRequired];
     OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
@@ -669,12 +673,13 @@ constexpr bool inHubMode = true;
 OTRadValve::OTHubManager<false, false> hm;  // no EEPROM so parameters don't matter
 OTRadValve::BoilerLogic::OnOffBoilerDriverLogic<decltype(hm), hm, heatCallPin> b1;
 //
-bool decodeAndHandleSecureFrame(volatile const uint8_t *const msg)
+bool decodeAndHandleSecureFrame(const uint8_t *const msg)
 {
     // Workspace for decodeAndHandleOTSecureOFrameWithWorkspace
     constexpr size_t workspaceRequired =
             OTRadioLink::SimpleSecureFrame32or0BodyRXBase::decodeSecureSmallFrameSafely_total_scratch_usage_OTAESGCM_3p0
             + OTAESGCM::OTAES128GCMGenericWithWorkspace<>::workspaceRequiredDec
+            + OTRadioLink::decodeAndHandleOTSecureOFrame_scratch_usage // + space for the decrypted body
             + OTRadioLink::authAndDecodeOTSecurableFrameWithWorkspace_scratch_usage; // + space to hold the key
     uint8_t workspace[workspaceRequired];
     OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
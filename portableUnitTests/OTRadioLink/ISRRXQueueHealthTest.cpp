@@ -0,0 +1,122 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * RX queue health counters and high-water marks.
+ */
+
+#include <stdint.h>
+#include <gtest/gtest.h>
+#include <OTV0p2Base.h>
+#include <OTRadioLink.h>
+#include <OTRadioLink_ISRRXQueue.h>
+
+
+namespace OTRXQHT
+{
+    // Queue a frame of length len as a driver would; false if dropped for lack of space.
+    bool inject(OTRadioLink::ISRRXQueue &q, const uint8_t len)
+    {
+        volatile uint8_t *const b = q._getRXBufForInbound();
+        if(NULL == b) { q._noteDroppedFull(); return(false); }
+        q._loadedBuf(len);
+        return(true);
+    }
+}
+
+// Check the counters and peaks as a queue fills, overflows and drains.
+TEST(ISRRXQueueHealth, Counters)
+{
+    OTRadioLink::ISRRXQueueVarLenMsg<8, 2> q;
+    OTRadioLink::ISRRXQueueHealth h;
+#ifndef OTRADIOLINK_ISRRXQUEUE_HEALTH
+    EXPECT_FALSE(q.getHealth(h));
+#else
+    ASSERT_TRUE(q.getHealth(h));
+    EXPECT_EQ(24, h.bufferBytes);
+    EXPECT_EQ(0, h.accepted);
+    EXPECT_EQ(0, h.peakBytes);
+    // 2 byte frames take 3 bytes each with the length.
+    for(int i = 0; i < 3; ++i) { ASSERT_TRUE(OTRXQHT::inject(q, 2)); }
+    // Over-long frame is cut to 8 bytes.
+    ASSERT_TRUE(OTRXQHT::inject(q, 20));
+    ASSERT_TRUE(q.getHealth(h));
+    EXPECT_EQ(4, h.accepted);
+    EXPECT_EQ(1, h.truncated);
+    EXPECT_EQ(4, h.peakMsgs);
+    // Last frame wrapped, leaving no space.
+    EXPECT_EQ(24, h.peakBytes);
+    // Full: no space for another max-size frame.
+    EXPECT_FALSE(OTRXQHT::inject(q, 2));
+    EXPECT_FALSE(OTRXQHT::inject(q, 2));
+    // Only frames actually dropped count, not checks for space.
+    EXPECT_TRUE(NULL == q._getRXBufForInbound());
+    for(int i = 0; i < 4; ++i) { q.removeRXMsg(); }
+    ASSERT_TRUE(OTRXQHT::inject(q, 2));
+    ASSERT_TRUE(q.getHealth(h));
+    EXPECT_EQ(5, h.accepted);
+    EXPECT_EQ(2, h.droppedFull);
+    EXPECT_EQ(4, h.peakMsgs);
+    EXPECT_EQ(24, h.peakBytes);
+    q.resetHealth();
+    ASSERT_TRUE(q.getHealth(h));
+    EXPECT_EQ(0, h.accepted + h.droppedFull + h.truncated + h.peakMsgs + h.peakBytes);
+    // Queues without counters say so.
+    OTRadioLink::ISRRXQueue1Deep<8> q1;
+    EXPECT_FALSE(q1.getHealth(h));
+#endif // OTRADIOLINK_ISRRXQUEUE_HEALTH
+}
+
+// Check that the counters are visible through the radio under load,
+// and that a larger queue drops fewer frames for the same traffic.
+TEST(ISRRXQueueHealth, ViaRadio)
+{
+#ifdef OTRADIOLINK_ISRRXQUEUE_HEALTH
+    OTRadioLink::ISRRXQueueHealth h;
+    OTRadioLink::OTNullRadioLink null;
+    EXPECT_FALSE(null.getRXQueueHealth(h));
+    const OTRadioLink::OTRadioChannelConfig config(NULL, true);
+    uint16_t dropped[2];
+    for(int i = 0; i < 2; ++i) {
+        OTRadioLink::VirtualEther e(3);
+        OTRadioLink::OTVirtualEtherRadio<1, 32> tx(e);
+        OTRadioLink::OTVirtualEtherRadio<2, 32> small(e);
+        OTRadioLink::OTVirtualEtherRadio<4, 32> large(e);
+        OTRadioLink::OTRadioLink &rx = (0 == i) ? static_cast<OTRadioLink::OTRadioLink &>(small) : large;
+        e.link(tx.getNodeIndex(), (0 == i) ? small.getNodeIndex() : large.getNodeIndex());
+        ASSERT_TRUE(rx.configure(1, &config));
+        rx.listen(true);
+        uint8_t frame[24] = { 24 };
+        // Bursts of 1 to 4 frames, drained every 100ms.
+        for(int t = 0; t < 500; ++t) {
+            for(int k = t % 4; k >= 0; --k) { tx.sendRaw(frame, sizeof(frame)); e.advance(10000); }
+            e.advance(100000);
+            while(NULL != rx.peekRXMsg()) { rx.removeRXMsg(); }
+        }
+        ASSERT_TRUE(rx.getRXQueueHealth(h));
+        EXPECT_EQ(e.getStats().delivered, h.accepted);
+        EXPECT_EQ(e.getStats().rxQueueFull, h.droppedFull);
+        dropped[i] = h.droppedFull;
+        rx.resetRXQueueHealth();
+        ASSERT_TRUE(rx.getRXQueueHealth(h));
+        EXPECT_EQ(0, h.accepted);
+    }
+    EXPECT_LT(0, dropped[0]);
+    EXPECT_EQ(0, dropped[1]);
+#endif // OTRADIOLINK_ISRRXQUEUE_HEALTH
+}
@@ -0,0 +1,127 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * Lock-free single-producer/single-consumer RX queue.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <thread>
+#include <gtest/gtest.h>
+#include <OTV0p2Base.h>
+#include <OTRadioLink.h>
+#include <OTRadioLink_ISRRXQueue.h>
+
+
+namespace OTSPSCT
+{
+    // Fill a frame of length len with a pattern derived from seq.
+    void fillFrame(volatile uint8_t *const f, const uint8_t len, const uint32_t seq)
+    {
+        for(uint8_t i = 0; i < len; ++i) { f[i] = uint8_t(seq * 31 + i); }
+    }
+    // True if frame f of length len has the pattern for seq.
+    bool checkFrame(const volatile uint8_t *const f, const uint8_t len, const uint32_t seq)
+    {
+        for(uint8_t i = 0; i < len; ++i) { if(uint8_t(seq * 31 + i) != f[i]) { return(false); } }
+        return(true);
+    }
+    // Frame length for seq, in [1,maxLen].
+    uint8_t frameLen(const uint32_t seq, const uint8_t maxLen)
+        { return(uint8_t(1 + (seq * 7919U) % maxLen)); }
+}
+
+// Check the SPSC queue packs and wraps exactly as ISRRXQueueVarLenMsg
+// under the same random sequence of queue and dequeue operations.
+TEST(ISRRXQueueSPSC, MatchesVarLenMsg)
+{
+    static constexpr uint8_t maxLen = 64;
+    OTRadioLink::ISRRXQueueVarLenMsg<maxLen, 3> ref;
+    OTRadioLink::ISRRXQueueVarLenMsgSPSC<maxLen, 3> q;
+    uint8_t refMin, refMax, qMin, qMax;
+    ref.getRXCapacity(refMin, refMax);
+    q.getRXCapacity(qMin, qMax);
+    EXPECT_EQ(refMin, qMin);
+    EXPECT_EQ(refMax, qMax);
+    srand(17);
+    uint32_t seq = 0;
+    for(int i = 0; i < 100000; ++i) {
+        ASSERT_EQ(ref.isFull(), q.isFull());
+        ASSERT_EQ(ref.getRXMsgsQueued(), q.getRXMsgsQueued());
+        if(rand() & 1) {
+            volatile uint8_t *const rb = ref._getRXBufForInbound();
+            volatile uint8_t *const qb = q._getRXBufForInbound();
+            ASSERT_EQ(NULL == rb, NULL == qb);
+            if(NULL == rb) { continue; }
+            const uint8_t len = OTSPSCT::frameLen(seq, maxLen);
+            OTSPSCT::fillFrame(rb, len, seq);
+            OTSPSCT::fillFrame(qb, len, seq);
+            ++seq;
+            ref._loadedBuf(len);
+            q._loadedBuf(len);
+        } else {
+            const volatile uint8_t *const rm = ref.peekRXMsg();
+            const volatile uint8_t *const qm = q.peekRXMsg();
+            ASSERT_EQ(NULL == rm, NULL == qm);
+            if(NULL == rm) { continue; }
+            ASSERT_EQ(rm[-1], qm[-1]);
+            for(uint8_t j = 0; j < rm[-1]; ++j) { ASSERT_EQ(rm[j], qm[j]); }
+            ref.removeRXMsg();
+            q.removeRXMsg();
+        }
+    }
+    // Abandoned uploads do not queue anything.
+    while(!q.isEmpty()) { q.removeRXMsg(); }
+    ASSERT_TRUE(NULL != q._getRXBufForInbound());
+    q._loadedBuf(0);
+    EXPECT_TRUE(q.isEmpty());
+    EXPECT_TRUE(NULL == q.peekRXMsg());
+    q.removeRXMsg();
+    EXPECT_EQ(0, q.getRXMsgsQueued());
+}
+
+// Pass frames of varying length from a producer thread to a consumer
+// thread through a small queue, checking none is lost, reordered or torn.
+TEST(ISRRXQueueSPSC, Stress)
+{
+    static constexpr uint8_t maxLen = 63;
+    static constexpr uint32_t nFrames = 500000;
+    OTRadioLink::ISRRXQueueVarLenMsgSPSC<maxLen, 2> q;
+    std::thread producer([&]{
+        for(uint32_t seq = 0; seq < nFrames; ++seq) {
+            volatile uint8_t *f;
+            while(NULL == (f = q._getRXBufForInbound())) { std::this_thread::yield(); }
+            const uint8_t len = OTSPSCT::frameLen(seq, maxLen);
+            OTSPSCT::fillFrame(f, len, seq);
+            q._loadedBuf(len);
+        }
+    });
+    uint32_t bad = 0;
+    for(uint32_t seq = 0; seq < nFrames; ) {
+        const volatile uint8_t *const m = q.peekRXMsg();
+        if(NULL == m) { std::this_thread::yield(); continue; }
+        const uint8_t len = m[-1];
+        if((OTSPSCT::frameLen(seq, maxLen) != len) || !OTSPSCT::checkFrame(m, len, seq)) { ++bad; }
+        q.removeRXMsg();
+        ++seq;
+    }
+    producer.join();
+    EXPECT_EQ(0U, bad);
+    EXPECT_TRUE(q.isEmpty());
+}
@@ -0,0 +1,308 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * Multi-threaded message queue handler.
+ *
+ * Feeds secure 'O' frames from many nodes through a synthetic radio.
+ * Uses the NULL crypto padded with busy work standing in for AES-GCM,
+ * so does not need OTAESGCM.
+ */
+
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <OTV0p2Base.h>
+#include <OTRadioLink.h>
+#include "SecureFrameTestFixture.h"
+
+
+namespace OTMQHTT
+{
+    static constexpr uint8_t nNodes = 16;
+
+    // Node i has ID { 0x80+i, 0x81, 0x82, ... }.
+    void getNodeID(const uint8_t i, uint8_t *const id)
+    {
+        for(uint8_t j = 0; j < 8; ++j) { id[j] = uint8_t(0x80 + j); }
+        id[0] = uint8_t(0x80 + i);
+    }
+    int16_t findNode(const uint8_t *const id, const uint8_t len)
+    {
+        if((nullptr == id) || (0 == len)) { return(-1); }
+        for(uint8_t i = 0; i < nNodes; ++i) {
+            uint8_t nodeID[8];
+            getNodeID(i, nodeID);
+            if(0 == memcmp(nodeID, id, len)) { return(i); }
+        }
+        return(-1);
+    }
+
+    // Number of times any thread entered MultiNodeRX while another was
+    // already inside it.
+    std::atomic<unsigned> nOverlaps;
+    // Marks a thread as inside MultiNodeRX for its lifetime.
+    // Nested calls from the same thread are not counted as overlaps.
+    // Yields on entry to widen the window for other threads to collide.
+    class Inside final
+    {
+    private:
+        static std::atomic<unsigned> &threads() { static std::atomic<unsigned> c; return(c); }
+        static unsigned &depth() { thread_local unsigned d; return(d); }
+    public:
+        Inside()
+        {
+            if((0 == depth()++) && (0 != threads()++)) { ++nOverlaps; }
+            std::this_thread::yield();
+        }
+        ~Inside() { if(0 == --depth()) { --threads(); } }
+    };
+
+    // RX with a per-node counter store, shared by all nodes and so by all
+    // workers, and not thread-safe; records any concurrent use.
+    class MultiNodeRX final : public OTRadioLink::SimpleSecureFrame32or0BodyRXBase
+    {
+    private:
+        uint8_t counters[nNodes][fullMsgCtrBytes];
+        MultiNodeRX() { reset(); }
+        virtual int8_t _getNextMatchingNodeID(const uint8_t, const OTRadioLink::SecurableFrameHeader *const sfh, uint8_t *nodeID) const override
+        {
+            Inside in;
+            const int16_t i = findNode(sfh->id, sfh->getIl());
+            if(i < 0) { return(-1); }
+            getNodeID(uint8_t(i), nodeID);
+            return(int8_t(i));
+        }
+    public:
+        static MultiNodeRX &getInstance()
+        {
+            static MultiNodeRX instance;
+            return(instance);
+        }
+        void reset() { memset(counters, 0, sizeof(counters)); nOverlaps = 0; }
+        virtual bool getLastRXMsgCtr(const uint8_t * const ID, uint8_t *counter) const override
+        {
+            Inside in;
+            const int16_t i = findNode(ID, 8);
+            if((i < 0) || (nullptr == counter)) { return(false); }
+            memcpy(counter, counters[i], fullMsgCtrBytes);
+            return(true);
+        }
+        virtual bool authAndUpdateRXMsgCtr(const uint8_t *ID, const uint8_t *newCounterValue) override
+        {
+            Inside in;
+            if(!validateRXMsgCtr(ID, newCounterValue)) { return(false); }
+            memcpy(counters[findNode(ID, 8)], newCounterValue, fullMsgCtrBytes);
+            return(true);
+        }
+    };
+
+    // NULL decrypt plus a fixed amount of work, roughly the cost of
+    // decrypting a frame with a software AES on a small host.
+    bool slowDec(
+            uint8_t *const workspace, const size_t workspaceSize,
+            const uint8_t *const key, const uint8_t *const iv,
+            const uint8_t *const authtext, const uint8_t authtextSize,
+            const uint8_t *const ciphertext, const uint8_t *const tag,
+            uint8_t *const plaintextOut)
+    {
+        volatile uint32_t x = tag[1];
+        for(int i = 0; i < 20000; ++i) { x = x * 33u + uint32_t(i); }
+        return(OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDec_NULL_IMPL(
+                workspace, workspaceSize, key, iv, authtext, authtextSize,
+                ciphertext, tag, plaintextOut));
+    }
+
+    // Frames successfully decoded, per node.
+    std::atomic<unsigned> nHandled[nNodes];
+    void resetCounts() { for(uint8_t i = 0; i < nNodes; ++i) { nHandled[i] = 0; } }
+    bool countFrame(const OTRadioLink::OTDecodeData_T &fd)
+    {
+        const int16_t i = findNode(fd.id, 8);
+        if(i >= 0) { ++nHandled[i]; }
+        return(true);
+    }
+
+    typedef OTRadioLink::SimpleSecureFrame32or0BodyRXLocked<MultiNodeRX> rx_t;
+    typedef OTRadioLink::SecureFrameReplayFilterPerWorker<
+        OTRadioLink::SecureFrameReplayFilter<nNodes> > filter_t;
+
+    bool handleFrame(const uint8_t *const msg)
+    {
+        uint8_t workspace[
+            OTRadioLink::SimpleSecureFrame32or0BodyRXBase::decode_total_scratch_usage_OTAESGCM_3p0 +
+            OTRadioLink::decodeAndHandleOTSecureOFrame_scratch_usage +
+            OTRadioLink::authAndDecodeOTSecurableFrameWithWorkspace_scratch_usage + 16];
+        OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+        return(OTRadioLink::decodeAndHandleOTSecureOFrame<
+                rx_t, slowDec, OTSFTF::getKey, countFrame, OTRadioLink::nullFrameOperation, filter_t>(msg, sW));
+    }
+
+    bool pollIO(bool) { return(false); }
+
+    // Encode a secure 'O' frame from node with message counter ctr into buf.
+    void makeFrame(uint8_t *const buf, const uint8_t node, const uint64_t ctr)
+    {
+        uint8_t id[8];
+        getNodeID(node, id);
+        OTSFTF::makeFrameFrom(buf, id, ctr);
+    }
+
+    // Radio that RXes a preloaded list of frames.
+    class SyntheticRadio final : public OTRadioLink::OTRadioLink
+    {
+    public:
+        struct Frame { uint8_t buf[64]; };
+        std::vector<Frame> frames;
+        size_t next = 0;
+
+        // Queue framesPerNode frames from each node, interleaved,
+        // with counters counting up from 1 for each node.
+        void load(const unsigned framesPerNode)
+        {
+            frames.resize(framesPerNode * nNodes);
+            next = 0;
+            for(unsigned f = 0; f < framesPerNode; ++f) {
+                for(uint8_t n = 0; n < nNodes; ++n) {
+                    makeFrame(frames[f * nNodes + n].buf, n, f + 1);
+                }
+            }
+        }
+
+        const volatile uint8_t *peekRXMsg() const override
+            { return((next < frames.size()) ? &frames[next].buf[1] : nullptr); }
+        void removeRXMsg() override { if(next < frames.size()) { ++next; } }
+        uint8_t getRXMsgsQueued() const override
+            { return((frames.size() - next > 255) ? 255 : uint8_t(frames.size() - next)); }
+
+        bool begin() override { return(true); }
+        void getCapacity(uint8_t &queueRXMsgsMin, uint8_t &maxRXMsgLen, uint8_t &maxTXMsgLen) const override
+            { queueRXMsgsMin = 255; maxRXMsgLen = 63; maxTXMsgLen = 0; }
+        bool sendRaw(const uint8_t *, uint8_t, int8_t, TXpower, bool) override { return(false); }
+    private:
+        void _dolisten() override { }
+    };
+
+    typedef OTRadioLink::OTMessageQueueHandlerThreaded<pollIO, handleFrame> handler_t;
+}
+
+// Check that frames from the same node always go to the same worker
+// and that frames without an ID go to the first.
+TEST(MessageQueueHandlerThreaded, WorkerSelection)
+{
+    OTMQHTT::handler_t mqh(4);
+    EXPECT_EQ(4, mqh.getWorkerCount());
+    uint8_t a[64], b[64];
+    OTMQHTT::makeFrame(a, 3, 1);
+    OTMQHTT::makeFrame(b, 3, 2);
+    EXPECT_EQ(mqh.getWorkerFor(a), mqh.getWorkerFor(b));
+    OTMQHTT::makeFrame(b, 4, 1);
+    EXPECT_NE(mqh.getWorkerFor(a), mqh.getWorkerFor(b));
+    const uint8_t anon[] = { 4, 'O', 0x10, 0, 0 };
+    EXPECT_EQ(0, mqh.getWorkerFor(anon));
+    const uint8_t tiny[] = { 2, 'O', 0x14 };
+    EXPECT_EQ(0, mqh.getWorkerFor(tiny));
+    // Thread count is capped.
+    OTMQHTT::handler_t big(255);
+    EXPECT_EQ(8, big.getWorkerCount());
+    OTMQHTT::handler_t dflt;
+    EXPECT_LE(1, dflt.getWorkerCount());
+}
+
+// Feed interleaved frames from many nodes through a synthetic radio and
+// check that every one is accepted, ie that no node's frames were handled
+// out of counter order.
+TEST(MessageQueueHandlerThreaded, AllFramesHandledInNodeOrder)
+{
+    static constexpr unsigned framesPerNode = 100;
+    OTMQHTT::MultiNodeRX::getInstance().reset();
+    OTMQHTT::resetCounts();
+    OTMQHTT::SyntheticRadio radio;
+    radio.load(framesPerNode);
+    OTMQHTT::handler_t mqh(4);
+    EXPECT_TRUE(mqh.handle(false, radio));
+    EXPECT_EQ(nullptr, radio.peekRXMsg());
+    mqh.flush();
+    for(uint8_t i = 0; i < OTMQHTT::nNodes; ++i) {
+        EXPECT_EQ(framesPerNode, OTMQHTT::nHandled[i]) << int(i);
+    }
+    // Replaying the last round of frames is rejected by the counter checks.
+    OTMQHTT::resetCounts();
+    radio.next = radio.frames.size() - OTMQHTT::nNodes;
+    EXPECT_TRUE(mqh.handle(false, radio));
+    mqh.flush();
+    for(uint8_t i = 0; i < OTMQHTT::nNodes; ++i) {
+        EXPECT_EQ(0U, OTMQHTT::nHandled[i]) << int(i);
+    }
+    // Nothing queued: nothing done.
+    EXPECT_FALSE(mqh.handle(false, radio));
+}
+
+// Check that frames queued at destruction are still handled.
+TEST(MessageQueueHandlerThreaded, DrainsOnDestruction)
+{
+    OTMQHTT::MultiNodeRX::getInstance().reset();
+    OTMQHTT::resetCounts();
+    OTMQHTT::SyntheticRadio radio;
+    radio.load(10);
+    {
+        OTMQHTT::handler_t mqh(2);
+        mqh.handle(false, radio);
+    }
+    for(uint8_t i = 0; i < OTMQHTT::nNodes; ++i) {
+        EXPECT_EQ(10U, OTMQHTT::nHandled[i]) << int(i);
+    }
+}
+
+// Load many interleaved frames onto the default number of workers, all
+// sharing one non-thread-safe counter store through the locked RX and each
+// with its own replay filter, and check that every frame is handled once,
+// the store is never entered concurrently and ends with each node's last
+// counter, and the same frames are all rejected when replayed.
+TEST(MessageQueueHandlerThreaded, LoadTest)
+{
+    static constexpr unsigned framesPerNode = 200;
+    OTMQHTT::MultiNodeRX &rx = OTMQHTT::MultiNodeRX::getInstance();
+    rx.reset();
+    OTMQHTT::resetCounts();
+    OTMQHTT::SyntheticRadio radio;
+    radio.load(framesPerNode);
+    OTMQHTT::handler_t mqh(8);
+    ASSERT_LT(1, mqh.getWorkerCount());
+    EXPECT_TRUE(mqh.handle(false, radio));
+    mqh.flush();
+    EXPECT_EQ(0U, OTMQHTT::nOverlaps);
+    for(uint8_t i = 0; i < OTMQHTT::nNodes; ++i) {
+        EXPECT_EQ(framesPerNode, OTMQHTT::nHandled[i]) << int(i);
+        uint8_t id[8], counter[6];
+        OTMQHTT::getNodeID(i, id);
+        ASSERT_TRUE(rx.getLastRXMsgCtr(id, counter));
+        EXPECT_EQ(uint64_t(framesPerNode), OTSFTF::ctrValue(counter)) << int(i);
+    }
+    // Replay everything.
+    OTMQHTT::resetCounts();
+    radio.next = 0;
+    EXPECT_TRUE(mqh.handle(false, radio));
+    mqh.flush();
+    EXPECT_EQ(0U, OTMQHTT::nOverlaps);
+    for(uint8_t i = 0; i < OTMQHTT::nNodes; ++i) {
+        EXPECT_EQ(0U, OTMQHTT::nHandled[i]) << int(i);
+    }
+}
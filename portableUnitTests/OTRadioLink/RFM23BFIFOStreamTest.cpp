@@ -0,0 +1,232 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * RFM23B streaming FIFO handling against the host register model,
+ * running the driver's ISR service routines from the modelled
+ * interrupt line at a range of radio service intervals.
+ */
+
+#include <stdint.h>
+#include <gtest/gtest.h>
+#include <OTV0p2Base.h>
+#include <OTRadioLink.h>
+#include <OTRFM23BLink.h>
+
+
+namespace OTRFM23BFST
+{
+    typedef OTRFM23BLink::RFM23BRegisterModel model_t;
+
+    // Arbitrary frame content.
+    void fill(uint8_t *const buf, const uint8_t len)
+        { for(uint8_t i = 0; i < len; ++i) { buf[i] = uint8_t(i * 37 + len); } }
+
+    // Clear the FIFOs and enter RX with the interrupts the driver enables to stream.
+    template<class Stream_t>
+    void listen(model_t &m, Stream_t &s)
+    {
+        const uint8_t clr[2] = { model_t::FFCLRRX | model_t::FFCLRTX, 0 };
+        OTRFM23BLink::burstWrite(m, model_t::REG_OP_CTRL2, clr, 1);
+        OTRFM23BLink::burstWrite(m, model_t::REG_OP_CTRL2, clr + 1, 1);
+        m.setRegister(model_t::REG_RX_FIFO_CTRL, Stream_t::chunkBytes);
+        m.setRegister(model_t::REG_INT_ENABLE1, Stream_t::irqEnable1);
+        m.setRegister(model_t::REG_OP_CTRL1, model_t::RXON | 1);
+        s.reset();
+    }
+
+    // Receive one frame of len bytes into q, running the RX service
+    // whenever the interrupt line is found asserted every interval byte times,
+    // then go back to RX as the driver does once done with the frame.
+    template<class Stream_t, class Queue_t>
+    OTRFM23BLink::RFM23BRXResult rxOnce(model_t &m, Stream_t &s, Queue_t &q,
+                                        const uint8_t *const frame, const uint8_t len, const uint16_t interval,
+                                        OTRadioLink::quickFrameFilter_t *const filter = NULL)
+    {
+        m.receive(frame, len);
+        for(uint16_t t = 1; t <= 2U * len + 2U * interval; ++t) {
+            m.tick();
+            if((0 != (t % interval)) || !m.isIRQ()) { continue; }
+            uint8_t status1;
+            OTRFM23BLink::burstRead(m, model_t::REG_INT_STATUS1, &status1, 1);
+            const OTRFM23BLink::RFM23BRXResult r = s.service(m, q, status1, filter);
+            if(OTRFM23BLink::RFM23B_RX_NONE != r) { listen(m, s); return(r); }
+        }
+        return(OTRFM23BLink::RFM23B_RX_NONE);
+    }
+
+    // Send one frame of len bytes, running the TX service
+    // whenever the interrupt line is found asserted every interval byte times.
+    // Returns true if the frame was sent intact and reported sent.
+    bool txOnce(const uint8_t len, const uint16_t interval)
+    {
+        model_t m;
+        OTRFM23BLink::RFM23BTXStream s;
+        uint8_t frame[255];
+        fill(frame, len);
+        m.setRegister(model_t::REG_PACKET_LENGTH, len);
+        m.setRegister(model_t::REG_TX_FIFO_CTRL2, OTRFM23BLink::RFM23BTXStream::almostEmptyBytes);
+        s.start(m, frame, len);
+        m.setRegister(model_t::REG_INT_ENABLE1, OTRFM23BLink::RFM23BTXStream::irqEnable1);
+        const uint8_t txon = model_t::TXON | 1;
+        OTRFM23BLink::burstWrite(m, model_t::REG_OP_CTRL1, &txon, 1);
+        uint8_t status = 0;
+        for(uint16_t t = 1; m.isTransmitting(); ++t) {
+            m.tick();
+            if((0 == (t % interval)) && m.isIRQ()) { status |= s.serviceIRQ(m); }
+        }
+        if(m.isIRQ()) { status |= s.serviceIRQ(m); }
+        uint8_t sentLen;
+        const uint8_t *const sent = m.getSent(sentLen);
+        return((0 != (status & OTRFM23BLink::RFM23B_S1_IPKSENT)) && (0 == m.getFIFOErrors()) &&
+               (len == sentLen) && (0 == memcmp(frame, sent, len)));
+    }
+
+    // Reject every frame.
+    bool rejectAll(const volatile uint8_t *, volatile uint8_t &) { return(false); }
+}
+
+// Check streamed RX into the queue over a range of frame lengths
+// and service intervals: frames of any length arrive intact
+// if serviced often enough, and are lost to overrun if not.
+TEST(RFM23BFIFOStream, RX)
+{
+    typedef OTRadioLink::ISRRXQueueVarLenMsg<255, 1> queue_t;
+    typedef OTRFM23BLink::RFM23BRXStream<255> rxStream_t;
+    const uint8_t lens[] = { 16, 48, 64, 100, 200, 255 };
+    const uint16_t intervals[] = { 1, 8, 16, 32, 40, 200 };
+    // Safe if serviced before the FIFO fills again after an event.
+    const uint16_t headroom = OTRFM23BLink::RFM23B_FIFO_BYTES - rxStream_t::chunkBytes;
+    for(const uint8_t len : lens) {
+        for(const uint16_t interval : intervals) {
+            OTRFM23BFST::model_t m;
+            rxStream_t s;
+            queue_t q;
+            OTRFM23BFST::listen(m, s);
+            uint8_t frame[255];
+            OTRFM23BFST::fill(frame, len);
+            const OTRFM23BLink::RFM23BRXResult r = OTRFM23BFST::rxOnce(m, s, q, frame, len, interval);
+            if(len <= OTRFM23BLink::RFM23B_FIFO_BYTES) { } // Whole frame fits in the FIFO.
+            else if(interval >= OTRFM23BLink::RFM23B_FIFO_BYTES) {
+                // Cannot keep up at all.
+                EXPECT_EQ(OTRFM23BLink::RFM23B_RX_OVERRUN, r) << int(len) << " " << interval;
+                EXPECT_EQ(0, q.getRXMsgsQueued());
+                continue;
+            }
+            else if(interval > headroom) { continue; } // Depends on timing.
+            ASSERT_EQ(OTRFM23BLink::RFM23B_RX_QUEUED, r) << int(len) << " " << interval;
+            const volatile uint8_t *const rxed = q.peekRXMsg();
+            ASSERT_NE((const volatile uint8_t *)NULL, rxed);
+            EXPECT_EQ(len, rxed[-1]);
+            EXPECT_EQ(0, memcmp(frame, (const uint8_t *)rxed, len)) << int(len) << " " << interval;
+            EXPECT_EQ(0U, m.getFIFOErrors());
+        }
+    }
+}
+
+// Check that streaming keeps the queue's frame capacity
+// and that a frame with no space in the queue is noted as dropped.
+TEST(RFM23BFIFOStream, RXQueueFull)
+{
+    OTRadioLink::ISRRXQueueVarLenMsg<100, 2> q;
+    OTRFM23BLink::RFM23BRXStream<100> s;
+    const uint8_t capacity = decltype(q)::MinQueueCapacityMsgs;
+    EXPECT_EQ(2, capacity);
+    OTRFM23BFST::model_t m;
+    OTRFM23BFST::listen(m, s);
+    uint8_t frame[100];
+    for(int i = 0; i < 2; ++i) {
+        frame[0] = uint8_t(i);
+        EXPECT_EQ(OTRFM23BLink::RFM23B_RX_QUEUED, OTRFM23BFST::rxOnce(m, s, q, frame, sizeof(frame), 8));
+    }
+    EXPECT_EQ(OTRFM23BLink::RFM23B_RX_DROPPED, OTRFM23BFST::rxOnce(m, s, q, frame, sizeof(frame), 8));
+    EXPECT_EQ(2, q.getRXMsgsQueued());
+    EXPECT_EQ(0, q.peekRXMsg()[0]);
+    q.removeRXMsg();
+    frame[0] = 2;
+    EXPECT_EQ(OTRFM23BLink::RFM23B_RX_QUEUED, OTRFM23BFST::rxOnce(m, s, q, frame, sizeof(frame), 8));
+    EXPECT_EQ(1, q.peekRXMsg()[0]);
+    q.removeRXMsg();
+    EXPECT_EQ(2, q.peekRXMsg()[0]);
+    EXPECT_EQ(0, memcmp(frame, (const uint8_t *)q.peekRXMsg(), sizeof(frame)));
+#ifdef OTRADIOLINK_ISRRXQUEUE_HEALTH
+    OTRadioLink::ISRRXQueueHealth h;
+    ASSERT_TRUE(q.getHealth(h));
+    EXPECT_EQ(3, h.accepted);
+    EXPECT_EQ(1, h.droppedFull);
+#endif // OTRADIOLINK_ISRRXQUEUE_HEALTH
+}
+
+// Check that frames too long to stream are dropped without being counted
+// as queue-full, and that the RX filter can drop or trim frames.
+TEST(RFM23BFIFOStream, RXTooLongAndFiltered)
+{
+    OTRadioLink::ISRRXQueueVarLenMsg<64, 3> q;
+    OTRFM23BLink::RFM23BRXStream<40> s;
+    OTRFM23BFST::model_t m;
+    OTRFM23BFST::listen(m, s);
+    uint8_t frame[64];
+    OTRFM23BFST::fill(frame, sizeof(frame));
+    EXPECT_EQ(OTRFM23BLink::RFM23B_RX_DROPPED, OTRFM23BFST::rxOnce(m, s, q, frame, sizeof(frame), 8));
+    EXPECT_EQ(OTRFM23BLink::RFM23B_RX_FILTERED, OTRFM23BFST::rxOnce(m, s, q, frame, 40, 8, OTRFM23BFST::rejectAll));
+    EXPECT_EQ(0, q.getRXMsgsQueued());
+    memset(frame + 20, 0, 20);
+    EXPECT_EQ(OTRFM23BLink::RFM23B_RX_QUEUED, OTRFM23BFST::rxOnce(m, s, q, frame, 40, 8, OTRadioLink::frameFilterTrailingZeros));
+    ASSERT_EQ(1, q.getRXMsgsQueued());
+    EXPECT_EQ(21, q.peekRXMsg()[-1]);
+    EXPECT_EQ(0, memcmp(frame, (const uint8_t *)q.peekRXMsg(), 21));
+#ifdef OTRADIOLINK_ISRRXQUEUE_HEALTH
+    OTRadioLink::ISRRXQueueHealth h;
+    ASSERT_TRUE(q.getHealth(h));
+    EXPECT_EQ(0, h.droppedFull);
+#endif // OTRADIOLINK_ISRRXQUEUE_HEALTH
+    // Disabled streaming takes no space and does nothing.
+    EXPECT_GE(1U, sizeof(OTRFM23BLink::RFM23BRXStream<0>));
+    EXPECT_FALSE(OTRFM23BLink::RFM23BRXStream<0>::enabled);
+}
+
+// Check interrupt-driven streamed TX over a range of frame lengths and service intervals.
+TEST(RFM23BFIFOStream, TX)
+{
+    const uint8_t lens[] = { 16, 64, 65, 100, 200, 255 };
+    const uint16_t intervals[] = { 1, 8, 16, 24, 200 };
+    for(const uint8_t len : lens) {
+        for(const uint16_t interval : intervals) {
+            const bool ok = OTRFM23BFST::txOnce(len, interval);
+            if((interval <= OTRFM23BLink::RFM23BTXStream::almostEmptyBytes) || (len <= OTRFM23BLink::RFM23B_FIFO_BYTES)) {
+                EXPECT_TRUE(ok) << int(len) << " " << interval;
+            } else if(interval >= OTRFM23BLink::RFM23B_FIFO_BYTES) {
+                // Cannot keep up at all.
+                EXPECT_FALSE(ok) << int(len) << " " << interval;
+            }
+        }
+    }
+    // Without topping up a long frame underruns.
+    OTRFM23BFST::model_t m;
+    OTRFM23BLink::RFM23BTXStream s;
+    uint8_t frame[100];
+    OTRFM23BFST::fill(frame, sizeof(frame));
+    m.setRegister(OTRFM23BFST::model_t::REG_PACKET_LENGTH, sizeof(frame));
+    EXPECT_TRUE(s.start(m, frame, sizeof(frame)));
+    EXPECT_EQ(36, s.getRemaining());
+    m.setRegister(OTRFM23BFST::model_t::REG_OP_CTRL1, OTRFM23BFST::model_t::TXON);
+    m.tick(sizeof(frame));
+    EXPECT_FALSE(m.isTransmitting());
+    EXPECT_EQ(1U, m.getFIFOErrors());
+    EXPECT_NE(0, OTRFM23BLink::RFM23B_S1_IFFERROR & s.serviceIRQ(m));
+}
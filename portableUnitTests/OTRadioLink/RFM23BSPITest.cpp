@@ -0,0 +1,182 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * RFM23B burst SPI transfers against the host register model.
+ */
+
+#include <stdint.h>
+#include <gtest/gtest.h>
+#include <OTV0p2Base.h>
+#include <OTRadioLink.h>
+#include <OTRFM23BLink.h>
+
+
+namespace OTRFM23BSPIT
+{
+    // Real channel configs, as used for secure and FS20/FHT8V channels.
+    static const uint8_t (*const fullConfig)[2] = OTRFM23BLink::StandardRegSettingsGFSK57600;
+    static const uint8_t (*const ookConfig)[2] = OTRFM23BLink::StandardRegSettingsOOK5000;
+
+    // Write the list one register per transaction, as previously.
+    void writeSingly(OTRFM23BLink::RFM23BRegisterModel &m, const uint8_t registerValues[][2])
+    {
+        for( ; 0xff != registerValues[0][0]; ++registerValues) {
+            OTRFM23BLink::burstWrite(m, registerValues[0][0], &registerValues[0][1], 1);
+        }
+    }
+}
+
+// Check that burst configuration leaves the same register contents
+// with fewer transactions and bytes.
+TEST(RFM23BSPI, RegisterBlockBursts)
+{
+    OTRFM23BLink::RFM23BRegisterModel singly;
+    OTRFM23BSPIT::writeSingly(singly, OTRFM23BSPIT::fullConfig);
+    OTRFM23BLink::RFM23BRegisterModel burst;
+    const uint8_t n = OTRFM23BLink::writeRegisterBlock(burst, OTRFM23BSPIT::fullConfig);
+    EXPECT_EQ(n, burst.getTransactions());
+    for(uint8_t r = 0; r < 0x7f; ++r) { EXPECT_EQ(singly.getRegister(r), burst.getRegister(r)) << int(r); }
+    EXPECT_EQ(singly.getRegisterWrites(), burst.getRegisterWrites());
+    EXPECT_EQ(76U, singly.getTransactions());
+    EXPECT_EQ(16U, burst.getTransactions());
+    EXPECT_EQ(2 * 76U, singly.getBytes());
+    EXPECT_EQ(76U + 16U, burst.getBytes());
+}
+
+// Check where runs are split.
+TEST(RFM23BSPI, RegisterBlockRuns)
+{
+    OTRFM23BLink::RFM23BRegisterModel m;
+    static const uint8_t empty[][2] = { {0xff, 0xff} };
+    EXPECT_EQ(0, OTRFM23BLink::writeRegisterBlock(m, empty));
+    EXPECT_EQ(0U, m.getBytes());
+    // Descending and repeated registers each need a new transaction.
+    static const uint8_t unordered[][2] = { {0x15, 1}, {0x14, 2}, {0x14, 3}, {0x15, 4}, {0xff, 0xff} };
+    EXPECT_EQ(3, OTRFM23BLink::writeRegisterBlock(m, unordered));
+    EXPECT_EQ(3, m.getRegister(0x14));
+    EXPECT_EQ(4, m.getRegister(0x15));
+    // A run stops short of the FIFO, which does not auto-increment.
+    m.resetCounts();
+    static const uint8_t toFIFO[][2] = { {0x7d, 1}, {0x7e, 2}, {0x7f, 3}, {0xff, 0xff} };
+    EXPECT_EQ(2, OTRFM23BLink::writeRegisterBlock(m, toFIFO));
+    EXPECT_EQ(2U, m.getRegisterWrites());
+    uint8_t len;
+    const uint8_t *const fifo = m.getTXFIFO(len);
+    ASSERT_EQ(1, len);
+    EXPECT_EQ(3, fifo[0]);
+}
+
+// Check FIFO bursts and clearing.
+TEST(RFM23BSPI, FIFOBursts)
+{
+    OTRFM23BLink::RFM23BRegisterModel m;
+    uint8_t frame[48];
+    for(uint8_t i = 0; i < sizeof(frame); ++i) { frame[i] = uint8_t(i * 7 + 1); }
+    OTRFM23BLink::burstWrite(m, OTRFM23BLink::RFM23B_REG_FIFO, frame, sizeof(frame));
+    EXPECT_EQ(1U, m.getTransactions());
+    EXPECT_EQ(1U + sizeof(frame), m.getBytes());
+    EXPECT_EQ(0U, m.getRegisterWrites());
+    uint8_t len;
+    const uint8_t *fifo = m.getTXFIFO(len);
+    ASSERT_EQ(sizeof(frame), len);
+    EXPECT_EQ(0, memcmp(frame, fifo, len));
+    // Clearing the TX FIFO.
+    const uint8_t clr = OTRFM23BLink::RFM23BRegisterModel::FFCLRTX;
+    OTRFM23BLink::burstWrite(m, OTRFM23BLink::RFM23BRegisterModel::REG_OP_CTRL2, &clr, 1);
+    m.getTXFIFO(len);
+    EXPECT_EQ(0, len);
+    // RX FIFO reads back in one transaction; excess reads as 0.
+    m.setRXFIFO(frame, 40);
+    m.resetCounts();
+    uint8_t buf[42];
+    OTRFM23BLink::burstRead(m, OTRFM23BLink::RFM23B_REG_FIFO, buf, sizeof(buf));
+    EXPECT_EQ(1U, m.getTransactions());
+    EXPECT_EQ(0, memcmp(frame, buf, 40));
+    EXPECT_EQ(0, buf[40] | buf[41]);
+    // Register reads auto-increment; device type and version.
+    burstRead(m, 0, buf, 2);
+    EXPECT_EQ(0x08, buf[0]);
+    EXPECT_EQ(0x06, buf[1]);
+    // A deselected device ignores the bus.
+    EXPECT_EQ(0xff, m.io(0x80));
+    EXPECT_EQ(2U, m.getTransactions());
+}
+
+// Check that switching channels by delta leaves the same register state
+// as rewriting the whole config, with fewer writes.
+TEST(RFM23BSPI, ChannelDelta)
+{
+    const uint8_t (*const configs[2])[2] = { OTRFM23BSPIT::fullConfig, OTRFM23BSPIT::ookConfig };
+    uint8_t skip[2][12];
+    ASSERT_TRUE(OTRFM23BLink::computeRegisterDelta(configs[0], configs[1], skip[1], sizeof(skip[1])));
+    ASSERT_TRUE(OTRFM23BLink::computeRegisterDelta(configs[1], configs[0], skip[0], sizeof(skip[0])));
+    OTRFM23BLink::RFM23BRegisterModel full;
+    OTRFM23BLink::RFM23BRegisterModel delta;
+    OTRFM23BLink::writeRegisterBlock(full, configs[0]);
+    OTRFM23BLink::writeRegisterBlock(delta, configs[0]);
+    // Alternate, as between FS20/FHT8V and secure channels.
+    for(int i = 1; i <= 4; ++i) {
+        const int to = i & 1;
+        // The driver changes dynamic registers between switches.
+        full.setRegister(7, 5); delta.setRegister(7, 5);
+        full.setRegister(0x3e, 17); delta.setRegister(0x3e, 17);
+        full.resetCounts();
+        delta.resetCounts();
+        OTRFM23BLink::writeRegisterBlock(full, configs[to]);
+        OTRFM23BLink::writeRegisterBlock(delta, configs[to], skip[to]);
+        for(uint8_t r = 0; r < 0x7f; ++r) { ASSERT_EQ(full.getRegister(r), delta.getRegister(r)) << i << " " << int(r); }
+        EXPECT_GT(full.getRegisterWrites(), delta.getRegisterWrites());
+        EXPECT_GE(full.getTransactions(), delta.getTransactions());
+    }
+    // Switching to the same config writes only the dynamic registers.
+    uint8_t same[12];
+    ASSERT_TRUE(OTRFM23BLink::computeRegisterDelta(configs[0], configs[0], same, sizeof(same)));
+    delta.resetCounts();
+    OTRFM23BLink::writeRegisterBlock(delta, configs[0], same);
+    EXPECT_EQ(3U, delta.getTransactions());
+    EXPECT_EQ(7U, delta.getRegisterWrites());
+}
+
+// Check the cases where registers must still be written.
+TEST(RFM23BSPI, ChannelDeltaLimits)
+{
+    // Not set by from, set twice by to, or different value.
+    static const uint8_t from[][2] = { {0x10, 1}, {0x11, 2}, {0x12, 3}, {0x11, 4}, {0xff, 0xff} };
+    static const uint8_t to[][2] = { {0x10, 1}, {0x11, 4}, {0x12, 9}, {0x13, 0}, {0x10, 1}, {0x20, 0}, {0xff, 0xff} };
+    uint8_t skip[1];
+    ASSERT_TRUE(OTRFM23BLink::computeRegisterDelta(from, to, skip, sizeof(skip)));
+    EXPECT_EQ(0x2, skip[0]);
+    // Too many entries for the bitmap.
+    EXPECT_FALSE(OTRFM23BLink::computeRegisterDelta(from, OTRFM23BSPIT::fullConfig, skip, sizeof(skip)));
+    EXPECT_EQ(0, skip[0]);
+    // Skipped entries are trimmed from run ends only.
+    static const uint8_t run[][2] = { {1, 1}, {2, 2}, {3, 3}, {4, 4}, {0xff, 0xff} };
+    OTRFM23BLink::RFM23BRegisterModel m;
+    const uint8_t ends = 0x9;
+    EXPECT_EQ(1, OTRFM23BLink::writeRegisterBlock(m, run, &ends));
+    EXPECT_EQ(2U, m.getRegisterWrites());
+    m.resetCounts();
+    const uint8_t middle = 0x6;
+    EXPECT_EQ(1, OTRFM23BLink::writeRegisterBlock(m, run, &middle));
+    EXPECT_EQ(4U, m.getRegisterWrites());
+    m.resetCounts();
+    const uint8_t all = 0xf;
+    EXPECT_EQ(0, OTRFM23BLink::writeRegisterBlock(m, run, &all));
+    EXPECT_EQ(0U, m.getBytes());
+}
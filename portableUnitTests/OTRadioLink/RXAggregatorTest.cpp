@@ -0,0 +1,189 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * Multi-radio RX aggregator.
+ */
+
+#include <stdint.h>
+#include <gtest/gtest.h>
+#include <OTV0p2Base.h>
+#include <OTRadioLink.h>
+#include <OTRadioLink_ISRRXQueue.h>
+
+
+namespace OTRXAT
+{
+    // Radio with a real RX queue that frames can be injected into,
+    // as if by its ISR. Each frame is { source tag, sequence number }.
+    class QueueRadio final : public OTRadioLink::OTRadioLink
+    {
+    private:
+        ::OTRadioLink::ISRRXQueueVarLenMsg<8, 4> q;
+        ::OTRadioLink::RXChannelRuns<> rxChannels;
+        void _dolisten() override { rxChannels.listening(getListenChannel(), q.getRXMsgsQueued()); }
+    public:
+        unsigned polls = 0;
+        unsigned dropped = 0;
+        // Queue a frame, or count it as dropped if there is no space.
+        void inject(const uint8_t tag, const uint8_t seq)
+        {
+            volatile uint8_t *const b = q._getRXBufForInbound();
+            if(NULL == b) { q._noteDroppedFull(); ++dropped; return; }
+            b[0] = tag;
+            b[1] = seq;
+            q._loadedBuf(2);
+        }
+        const volatile uint8_t *peekRXMsg() const override { return(q.peekRXMsg()); }
+        void removeRXMsg() override { if(NULL != q.peekRXMsg()) { q.removeRXMsg(); rxChannels.removed(); } }
+        int8_t getRXMsgChannel() const override { return(rxChannels.oldest()); }
+        uint8_t getRXMsgsQueued() const override { return(q.getRXMsgsQueued()); }
+        void getCapacity(uint8_t &queueRXMsgsMin, uint8_t &maxRXMsgLen, uint8_t &maxTXMsgLen) const override
+            { q.getRXCapacity(queueRXMsgsMin, maxRXMsgLen); maxTXMsgLen = 0; }
+        void poll() override { ++polls; }
+        bool sendRaw(const uint8_t *, uint8_t, int8_t, TXpower, bool) override { return(false); }
+    };
+
+    typedef OTRadioLink::OTRadioLinkRXAggregator<3> agg_t;
+
+    // Take the next frame from agg, checking its source tag matches;
+    // returns the source index or -1 if none.
+    int next(agg_t &agg)
+    {
+        const volatile uint8_t *const m = agg.peekRXMsg();
+        if(NULL == m) { return(-1); }
+        const int source = agg.getRXMsgSource().source;
+        EXPECT_EQ(source, m[0]);
+        agg.removeRXMsg();
+        return(source);
+    }
+
+    const OTRadioLink::OTRadioChannelConfig configs[2] = { { NULL, true }, { NULL, true } };
+}
+
+// Check the weighted round-robin order, skipping empty sources,
+// and FIFO order within each source.
+TEST(RXAggregator, WeightedOrder)
+{
+    OTRXAT::QueueRadio r0, r1, r2;
+    OTRXAT::agg_t agg;
+    EXPECT_TRUE(NULL == agg.peekRXMsg());
+    EXPECT_EQ(0, agg.addSource(r0, 2));
+    EXPECT_EQ(1, agg.addSource(r1, 1));
+    EXPECT_EQ(-1, agg.addSource(r2, 0));
+    EXPECT_EQ(2, agg.addSource(r2, 1));
+    OTRXAT::QueueRadio spare;
+    EXPECT_EQ(-1, agg.addSource(spare, 1));
+    for(uint8_t s = 0; s < 4; ++s) { r0.inject(0, s); r1.inject(1, s); }
+    r2.inject(2, 0);
+    EXPECT_EQ(9, agg.getRXMsgsQueued());
+    // Peeking does not advance.
+    EXPECT_EQ(agg.peekRXMsg(), agg.peekRXMsg());
+    const int expected[] = { 0, 0, 1, 2, 0, 0, 1, 1, 1, -1 };
+    uint8_t seq[3] = { };
+    for(const int e : expected) {
+        const volatile uint8_t *const m = agg.peekRXMsg();
+        if(NULL != m) { EXPECT_EQ(seq[m[0]]++, m[1]); }
+        EXPECT_EQ(e, OTRXAT::next(agg));
+    }
+    EXPECT_EQ(4U, agg.getDelivered(0));
+    EXPECT_EQ(4U, agg.getDelivered(1));
+    EXPECT_EQ(1U, agg.getDelivered(2));
+    agg.removeRXMsg();
+    agg.poll();
+    EXPECT_EQ(1U, r0.polls);
+    EXPECT_EQ(1U, r2.polls);
+}
+
+// Check that source and RX channel are reported, even after the source
+// changes channel, and that the aggregator drives the ordinary
+// single-radio message queue handler.
+namespace OTRXAT
+{
+    agg_t *handlerAgg;
+    int8_t channels[3][4];
+    unsigned handled;
+    bool pollIO(bool) { return(false); }
+    bool recordFrame(const uint8_t *const msg)
+    {
+        const agg_t::RXMsgSource s = handlerAgg->getRXMsgSource();
+        EXPECT_EQ(s.source, msg[0]);
+        EXPECT_EQ(s.channel, handlerAgg->getRXMsgChannel());
+        channels[s.source][msg[1]] = s.channel;
+        ++handled;
+        return(true);
+    }
+}
+TEST(RXAggregator, SourceAndHandler)
+{
+    OTRXAT::QueueRadio r0, r1;
+    ASSERT_TRUE(r0.configure(2, OTRXAT::configs));
+    ASSERT_TRUE(r1.configure(2, OTRXAT::configs));
+    r0.listen(true, 1);
+    r1.listen(true, 0);
+    OTRXAT::agg_t agg;
+    agg.addSource(r0);
+    agg.addSource(r1);
+    OTRXAT::handlerAgg = &agg;
+    OTRXAT::handled = 0;
+    r0.inject(0, 0);
+    r1.inject(1, 0);
+    r1.inject(1, 1);
+    // Frames already queued keep the channel they arrived on.
+    r0.listen(true, 0);
+    r0.inject(0, 1);
+    r1.listen(true, 1);
+    r1.inject(1, 2);
+    r1.listen(false);
+    OTRadioLink::OTMessageQueueHandler<OTRXAT::pollIO, 4800, OTRXAT::recordFrame> mqh;
+    while(mqh.handle(false, agg)) { }
+    EXPECT_EQ(5U, OTRXAT::handled);
+    EXPECT_EQ(1, OTRXAT::channels[0][0]);
+    EXPECT_EQ(0, OTRXAT::channels[0][1]);
+    EXPECT_EQ(0, OTRXAT::channels[1][0]);
+    EXPECT_EQ(0, OTRXAT::channels[1][1]);
+    EXPECT_EQ(1, OTRXAT::channels[1][2]);
+    EXPECT_EQ(0, agg.getRXMsgsQueued());
+    // One poll per handle() call, including the last that found nothing.
+    EXPECT_EQ(6U, r0.polls);
+    EXPECT_FALSE(agg.sendRaw(NULL, 0));
+}
+
+// With a fast source always full and a slow handler, the slow source
+// still gets its share and the fast source only drops its own frames.
+TEST(RXAggregator, NoStarvation)
+{
+    OTRXAT::QueueRadio fast, slow;
+    OTRXAT::agg_t agg;
+    agg.addSource(fast, 3);
+    agg.addSource(slow, 1);
+    unsigned slowSent = 0;
+    uint8_t seq = 0;
+    for(int round = 0; round < 1000; ++round) {
+        // Fast source bursts several frames, slow source one every 4 rounds.
+        for(int i = 0; i < 4; ++i) { fast.inject(0, seq++); }
+        if(0 == (round & 3)) { slow.inject(1, seq++); ++slowSent; }
+        // Handler only keeps up with 2 frames per round.
+        OTRXAT::next(agg);
+        OTRXAT::next(agg);
+    }
+    while(OTRXAT::next(agg) >= 0) { }
+    EXPECT_EQ(slowSent, agg.getDelivered(1));
+    EXPECT_EQ(0U, slow.dropped);
+    EXPECT_NE(0U, fast.dropped);
+}
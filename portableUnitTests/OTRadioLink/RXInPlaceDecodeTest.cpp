@@ -0,0 +1,149 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * Zero-copy decode of secure frames straight from a radio's ISR RX queue
+ * by OTMessageQueueHandler.
+ *
+ * These use the NULL crypto implementations so do not need OTAESGCM.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <gtest/gtest.h>
+#include <OTV0p2Base.h>
+#include <OTRadioLink.h>
+#include <OTRadioLink_ISRRXQueue.h>
+#include "SecureFrameTestFixture.h"
+
+
+namespace OTRXIPDT
+{
+    // Radio with a real RX queue that frames can be injected into,
+    // as if by its ISR.
+    class QueueRadio final : public OTRadioLink::OTRadioLink
+    {
+    private:
+        ::OTRadioLink::ISRRXQueueVarLenMsg<64, 2> q;
+        void _dolisten() override { }
+    public:
+        // Queue secure frame with the given counter LSB.
+        bool inject(const uint8_t ctrLSB)
+        {
+            uint8_t buf[64];
+            OTSFTF::makeFrame(buf, ctrLSB);
+            const uint8_t len = buf[0];
+            volatile uint8_t *const slot = q._getRXBufForInbound();
+            if(NULL == slot) { return(false); }
+            for(uint8_t i = 0; i < len; ++i) { slot[i] = buf[i + 1]; }
+            q._loadedBuf(len);
+            return(true);
+        }
+        const volatile uint8_t *peekRXMsg() const override { return(q.peekRXMsg()); }
+        void removeRXMsg() override { q.removeRXMsg(); }
+        uint8_t getRXMsgsQueued() const override { return(q.getRXMsgsQueued()); }
+        void getCapacity(uint8_t &queueRXMsgsMin, uint8_t &maxRXMsgLen, uint8_t &maxTXMsgLen) const override
+            { q.getRXCapacity(queueRXMsgsMin, maxRXMsgLen); maxTXMsgLen = 0; }
+        bool sendRaw(const uint8_t *, uint8_t, int8_t, TXpower, bool) override { return(false); }
+    };
+    QueueRadio *radio;
+
+    // Caller-provided arena that decodes are done in.
+    uint8_t workspace[
+        OTRadioLink::SimpleSecureFrame32or0BodyRXBase::decode_total_scratch_usage_OTAESGCM_3p0 +
+        OTRadioLink::decodeAndHandleOTSecureOFrame_scratch_usage +
+        OTRadioLink::authAndDecodeOTSecurableFrameWithWorkspace_scratch_usage + 16];
+
+    // Where the handler and operator saw the frame and plaintext.
+    const uint8_t *seenMsg;
+    uint8_t queuedInHandler;
+    const uint8_t *seenCtext;
+    const uint8_t *seenPtext;
+    uint8_t seenBody;
+    bool recordOp(const OTRadioLink::OTDecodeData_T &fd)
+    {
+        seenCtext = fd.ctext;
+        seenPtext = fd.ptext;
+        seenBody = fd.ptext[2];
+        return(true);
+    }
+
+    bool handleFrame(const uint8_t *const msg)
+    {
+        seenMsg = msg;
+        queuedInHandler = radio->getRXMsgsQueued();
+        OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+        return(OTRadioLink::decodeAndHandleOTSecureOFrame<
+                OTRadioLink::SimpleSecureFrame32or0BodyRXFixedCounter,
+                OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDec_NULL_IMPL,
+                OTSFTF::getKey, recordOp>(msg, sW));
+    }
+
+    bool pollIO(bool) { return(false); }
+}
+
+// Check that the queue handler decodes each frame in its queue slot,
+// into the caller's arena, and releases the slot only afterwards.
+TEST(RXInPlaceDecode, HandlerDecodesFromSlot)
+{
+    OTSFTF::setUpMockRX();
+    OTRXIPDT::QueueRadio r;
+    OTRXIPDT::radio = &r;
+    OTRadioLink::OTMessageQueueHandler<OTRXIPDT::pollIO, 4800, OTRXIPDT::handleFrame> mqh;
+    ASSERT_TRUE(r.inject(1));
+    ASSERT_TRUE(r.inject(2));
+
+    for(uint8_t n = 2; n > 0; --n) {
+        const uint8_t *const slot = r.peekRXMsgPinned();
+        ASSERT_NE(nullptr, slot);
+        uint8_t copy[64];
+        memcpy(copy, slot - 1, size_t(slot[-1]) + 1);
+        OTRXIPDT::seenMsg = nullptr;
+        OTRXIPDT::seenCtext = nullptr;
+        OTRXIPDT::seenPtext = nullptr;
+        OTRXIPDT::seenBody = 0;
+        EXPECT_TRUE(mqh.handle(false, r));
+        // No copies: the handler and operator saw the queue slot
+        // and the plaintext went into the caller's arena.
+        EXPECT_EQ(slot, OTRXIPDT::seenMsg);
+        EXPECT_EQ(slot - 1, OTRXIPDT::seenCtext);
+        EXPECT_EQ(OTRXIPDT::workspace, OTRXIPDT::seenPtext);
+        EXPECT_EQ('{', OTRXIPDT::seenBody);
+        // The slot was still queued while the handler ran, and is unaltered.
+        EXPECT_EQ(n, OTRXIPDT::queuedInHandler);
+        EXPECT_EQ(n - 1, r.getRXMsgsQueued());
+        EXPECT_EQ(0, memcmp(copy, slot - 1, size_t(copy[0]) + 1));
+    }
+    EXPECT_FALSE(mqh.handle(false, r));
+}
+
+// Check that scratch too small to hold the decrypted body is rejected
+// before the frame is looked at.
+TEST(RXInPlaceDecode, ScratchTooSmall)
+{
+    OTSFTF::setUpMockRX();
+    uint8_t buf[64];
+    OTSFTF::makeFrame(buf, 1);
+    OTRXIPDT::seenCtext = nullptr;
+    OTV0P2BASE::ScratchSpaceL sW(OTRXIPDT::workspace, OTRadioLink::decodeAndHandleOTSecureOFrame_scratch_usage - 1);
+    EXPECT_FALSE((OTRadioLink::decodeAndHandleOTSecureOFrame<
+            OTRadioLink::SimpleSecureFrame32or0BodyRXFixedCounter,
+            OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDec_NULL_IMPL,
+            OTSFTF::getKey, OTRXIPDT::recordOp>(buf + 1, sW)));
+    EXPECT_EQ(nullptr, OTRXIPDT::seenCtext);
+}
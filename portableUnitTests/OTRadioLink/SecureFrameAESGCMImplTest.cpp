@@ -0,0 +1,291 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * Portable AES-128-GCM with per-key setup, against known answers,
+ * through decodeBatch() and the key context cache, and against OTAESGCM
+ * where that is available.
+ */
+
+#include <stdint.h>
+#include <gtest/gtest.h>
+#if defined(EXT_AVAILABLE_ARDUINO_LIB_OTAESGCM)
+#include <OTAESGCM.h>
+#endif
+#include <OTV0p2Base.h>
+#include <OTRadioLink.h>
+#include "SecureFrameTestFixture.h"
+
+
+namespace OTSFAGT
+{
+    static constexpr size_t ctxSize =
+        OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleKeyContextSize_AESGCM_IMPL;
+    static constexpr size_t wsSize =
+        OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleWorkspace_AESGCM_IMPL;
+    static constexpr size_t wsCtxSize =
+        OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleWorkspaceWithContext_AESGCM_IMPL;
+
+    // NIST GCMVS gcmEncryptExtIV128.rsp
+    // [Keylen = 128] [IVlen = 96] [PTlen = 256] [AADlen = 128] [Taglen = 128]
+    // Count = 0
+    static const uint8_t nistKey[16] = { 0x29, 0x8e, 0xfa, 0x1c, 0xcf, 0x29, 0xcf, 0x62, 0xae, 0x68, 0x24, 0xbf, 0xc1, 0x95, 0x57, 0xfc };
+    static const uint8_t nistIV[12] = { 0x6f, 0x58, 0xa9, 0x3f, 0xe1, 0xd2, 0x07, 0xfa, 0xe4, 0xed, 0x2f, 0x6d };
+    static const uint8_t nistPT[32] = { 0xcc, 0x38, 0xbc, 0xcd, 0x6b, 0xc5, 0x36, 0xad, 0x91, 0x9b, 0x13, 0x95, 0xf5, 0xd6, 0x38, 0x01, 0xf9, 0x9f, 0x80, 0x68, 0xd6, 0x5c, 0xa5, 0xac, 0x63, 0x87, 0x2d, 0xaf, 0x16, 0xb9, 0x39, 0x01 };
+    static const uint8_t nistAAD[16] = { 0x02, 0x1f, 0xaf, 0xd2, 0x38, 0x46, 0x39, 0x73, 0xff, 0xe8, 0x02, 0x56, 0xe5, 0xb1, 0xc6, 0xb1 };
+    static const uint8_t nistCT[32] = { 0xdf, 0xce, 0x4e, 0x9c, 0xd2, 0x91, 0x10, 0x3d, 0x7f, 0xe4, 0xe6, 0x33, 0x51, 0xd9, 0xe7, 0x9d, 0x3d, 0xfd, 0x39, 0x1e, 0x32, 0x67, 0x10, 0x46, 0x58, 0x21, 0x2d, 0xa9, 0x65, 0x21, 0xb7, 0xdb };
+    static const uint8_t nistTag[16] = { 0x54, 0x24, 0x65, 0xef, 0x59, 0x93, 0x16, 0xf7, 0x3a, 0x7a, 0x56, 0x05, 0x09, 0xa2, 0xd9, 0xf2 };
+
+    // Frame-sized authtext that is not a whole block, and authtext-only,
+    // as for beacons; answers from OpenSSL EVP_aes_128_gcm.
+    static const uint8_t hdrKey[16] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+    static const uint8_t hdrIV[12] = { 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x2b };
+    static const uint8_t hdrAAD[9] = { 0x4f, 0xaa, 0xbb, 0xcc, 0xdd, 0x10, 0x20, 0x30, 0x40 };
+    static const uint8_t hdrPT[32] = { 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e, 0x4f, 0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x5b, 0x5c, 0x5d, 0x5e, 0x5f };
+    static const uint8_t hdrCT[32] = { 0x80, 0xb4, 0x50, 0xe7, 0xc2, 0xb5, 0x3f, 0x4e, 0xf3, 0x01, 0xc5, 0x9f, 0x3d, 0x82, 0xda, 0x31, 0x98, 0xe0, 0x27, 0xcd, 0xd2, 0x03, 0x7c, 0xb3, 0x3f, 0x3a, 0x9d, 0x4c, 0xfb, 0x1e, 0xb3, 0x04 };
+    static const uint8_t hdrTag[16] = { 0xb7, 0x72, 0xd8, 0x26, 0xa1, 0xab, 0x81, 0x38, 0x27, 0xc7, 0x4b, 0x58, 0xcc, 0x4c, 0x4f, 0xec };
+    static const uint8_t hdrTagNoText[16] = { 0x5a, 0x11, 0x7d, 0xbc, 0x44, 0x55, 0x54, 0x7b, 0x40, 0x56, 0xf6, 0x3c, 0x66, 0x7f, 0x3a, 0xb2 };
+
+    bool allZero(const uint8_t *const buf, const size_t len)
+    {
+        for(size_t i = 0; i < len; ++i) { if(0 != buf[i]) { return(false); } }
+        return(true);
+    }
+
+    // TX as in the OTAESGCM O frame known-answer test: ID all 0x80 and
+    // an all-zeros counter.
+    class FixedTX final : public OTRadioLink::SimpleSecureFrame32or0BodyTXBase
+    {
+    public:
+        virtual bool getTXID(uint8_t *id) const override { memset(id, 0x80, OTV0P2BASE::OpenTRV_Node_ID_Bytes); return(true); }
+        virtual bool getTXNVCtrPrefix(uint8_t *buf) const override { memset(buf, 0, 3); return(true); }
+        virtual bool resetTXNVCtrPrefix(bool /*allZeros*/ = false) override { return(false); }
+        virtual bool incrementTXNVCtrPrefix() override { return(false); }
+        virtual bool getNextTXMsgCtr(uint8_t *buf) override { memset(buf, 0, 6); return(true); }
+    };
+
+    typedef OTRadioLink::SimpleDecKeyContextCache<ctxSize, 2> cache_t;
+    cache_t cache;
+}
+
+// Check the NIST vector through setup then decrypt-with-context.
+TEST(SecureFrameAESGCMImpl, NISTVectorWithContext)
+{
+    uint8_t ctx[OTSFAGT::ctxSize];
+    ASSERT_TRUE(OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleKeySetup_AESGCM_IMPL(OTSFAGT::nistKey, ctx));
+    uint8_t workspace[OTSFAGT::wsCtxSize];
+    uint8_t pt[32];
+    EXPECT_TRUE(OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDecWithContext_AESGCM_IMPL(
+        workspace, sizeof(workspace), ctx, OTSFAGT::nistIV,
+        OTSFAGT::nistAAD, sizeof(OTSFAGT::nistAAD),
+        OTSFAGT::nistCT, OTSFAGT::nistTag, pt));
+    EXPECT_EQ(0, memcmp(OTSFAGT::nistPT, pt, sizeof(pt)));
+    EXPECT_TRUE(OTSFAGT::allZero(workspace, sizeof(workspace)));
+    // The same context serves repeated decrypts.
+    memset(pt, 0, sizeof(pt));
+    EXPECT_TRUE(OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDecWithContext_AESGCM_IMPL(
+        workspace, sizeof(workspace), ctx, OTSFAGT::nistIV,
+        OTSFAGT::nistAAD, sizeof(OTSFAGT::nistAAD),
+        OTSFAGT::nistCT, OTSFAGT::nistTag, pt));
+    EXPECT_EQ(0, memcmp(OTSFAGT::nistPT, pt, sizeof(pt)));
+}
+
+// Check encryption and raw-key decryption against known answers, including
+// a partial authtext block and authtext only.
+TEST(SecureFrameAESGCMImpl, KnownAnswersRawKey)
+{
+    uint8_t workspace[OTSFAGT::wsSize];
+    uint8_t ct[32];
+    uint8_t tag[16];
+    ASSERT_TRUE(OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleEnc_AESGCM_IMPL(
+        workspace, sizeof(workspace), OTSFAGT::nistKey, OTSFAGT::nistIV,
+        OTSFAGT::nistAAD, sizeof(OTSFAGT::nistAAD), OTSFAGT::nistPT, ct, tag));
+    EXPECT_EQ(0, memcmp(OTSFAGT::nistCT, ct, sizeof(ct)));
+    EXPECT_EQ(0, memcmp(OTSFAGT::nistTag, tag, sizeof(tag)));
+    EXPECT_TRUE(OTSFAGT::allZero(workspace, sizeof(workspace)));
+
+    ASSERT_TRUE(OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleEnc_AESGCM_IMPL(
+        workspace, sizeof(workspace), OTSFAGT::hdrKey, OTSFAGT::hdrIV,
+        OTSFAGT::hdrAAD, sizeof(OTSFAGT::hdrAAD), OTSFAGT::hdrPT, ct, tag));
+    EXPECT_EQ(0, memcmp(OTSFAGT::hdrCT, ct, sizeof(ct)));
+    EXPECT_EQ(0, memcmp(OTSFAGT::hdrTag, tag, sizeof(tag)));
+    uint8_t pt[32];
+    EXPECT_TRUE(OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDec_AESGCM_IMPL(
+        workspace, sizeof(workspace), OTSFAGT::hdrKey, OTSFAGT::hdrIV,
+        OTSFAGT::hdrAAD, sizeof(OTSFAGT::hdrAAD), OTSFAGT::hdrCT, OTSFAGT::hdrTag, pt));
+    EXPECT_EQ(0, memcmp(OTSFAGT::hdrPT, pt, sizeof(pt)));
+    EXPECT_TRUE(OTSFAGT::allZero(workspace, sizeof(workspace)));
+
+    ASSERT_TRUE(OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleEnc_AESGCM_IMPL(
+        workspace, sizeof(workspace), OTSFAGT::hdrKey, OTSFAGT::hdrIV,
+        OTSFAGT::hdrAAD, sizeof(OTSFAGT::hdrAAD), NULL, ct, tag));
+    EXPECT_EQ(0, memcmp(OTSFAGT::hdrTagNoText, tag, sizeof(tag)));
+    EXPECT_TRUE(OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDec_AESGCM_IMPL(
+        workspace, sizeof(workspace), OTSFAGT::hdrKey, OTSFAGT::hdrIV,
+        OTSFAGT::hdrAAD, sizeof(OTSFAGT::hdrAAD), NULL, OTSFAGT::hdrTagNoText, pt));
+}
+
+// Check that any change to the inputs fails authentication without
+// releasing plaintext, and that bad arguments are rejected.
+TEST(SecureFrameAESGCMImpl, RejectsTamperingAndBadArgs)
+{
+    uint8_t ctx[OTSFAGT::ctxSize];
+    ASSERT_TRUE(OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleKeySetup_AESGCM_IMPL(OTSFAGT::hdrKey, ctx));
+    uint8_t workspace[OTSFAGT::wsCtxSize];
+    uint8_t pt[32];
+    for(uint8_t field = 0; field < 4; ++field) {
+        for(uint8_t bit = 0; bit < 8; bit += 3) {
+            uint8_t iv[12], aad[9], ct[32], tag[16];
+            memcpy(iv, OTSFAGT::hdrIV, sizeof(iv));
+            memcpy(aad, OTSFAGT::hdrAAD, sizeof(aad));
+            memcpy(ct, OTSFAGT::hdrCT, sizeof(ct));
+            memcpy(tag, OTSFAGT::hdrTag, sizeof(tag));
+            switch(field) {
+                case 0: iv[11] ^= uint8_t(1 << bit); break;
+                case 1: aad[8] ^= uint8_t(1 << bit); break;
+                case 2: ct[31] ^= uint8_t(1 << bit); break;
+                default: tag[0] ^= uint8_t(1 << bit); break;
+            }
+            memset(pt, 0xee, sizeof(pt));
+            EXPECT_FALSE(OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDecWithContext_AESGCM_IMPL(
+                workspace, sizeof(workspace), ctx, iv, aad, sizeof(aad), ct, tag, pt)) << int(field);
+            for(uint8_t i = 0; i < sizeof(pt); ++i) { ASSERT_EQ(0xee, pt[i]); }
+            EXPECT_TRUE(OTSFAGT::allZero(workspace, sizeof(workspace)));
+        }
+    }
+    // Workspace NULL or one byte short.
+    EXPECT_FALSE(OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDecWithContext_AESGCM_IMPL(
+        NULL, sizeof(workspace), ctx, OTSFAGT::hdrIV, OTSFAGT::hdrAAD, sizeof(OTSFAGT::hdrAAD),
+        OTSFAGT::hdrCT, OTSFAGT::hdrTag, pt));
+    EXPECT_FALSE(OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDecWithContext_AESGCM_IMPL(
+        workspace, sizeof(workspace) - 1, ctx, OTSFAGT::hdrIV, OTSFAGT::hdrAAD, sizeof(OTSFAGT::hdrAAD),
+        OTSFAGT::hdrCT, OTSFAGT::hdrTag, pt));
+    uint8_t bigWorkspace[OTSFAGT::wsSize];
+    uint8_t tag[16];
+    EXPECT_FALSE(OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleEnc_AESGCM_IMPL(
+        bigWorkspace, sizeof(bigWorkspace) - 1, OTSFAGT::hdrKey, OTSFAGT::hdrIV,
+        OTSFAGT::hdrAAD, sizeof(OTSFAGT::hdrAAD), OTSFAGT::hdrPT, pt, tag));
+    EXPECT_FALSE(OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDec_AESGCM_IMPL(
+        bigWorkspace, sizeof(bigWorkspace) - 1, OTSFAGT::hdrKey, OTSFAGT::hdrIV,
+        OTSFAGT::hdrAAD, sizeof(OTSFAGT::hdrAAD), OTSFAGT::hdrCT, OTSFAGT::hdrTag, pt));
+    EXPECT_FALSE(OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleKeySetup_AESGCM_IMPL(NULL, ctx));
+    EXPECT_FALSE(OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleKeySetup_AESGCM_IMPL(OTSFAGT::hdrKey, NULL));
+}
+
+// Check that an O frame encoded with this implementation is byte for byte
+// the one produced by OTAESGCM (see SecureFrameTest OFrameEncoding).
+TEST(SecureFrameAESGCMImpl, OFrameMatchesOTAESGCM)
+{
+    const uint8_t expected[63] = {62,207,4,128,128,128,128,32,102,58,109,143,127,209,106,16,122,170,41,17,135,168,193,220,188,110,36,204,190,21,125,138,196,172,122,155,149,87,43,4,0,0,0,0,0,0,162,222,15,42,215,77,210,0,127,19,255,121,139,199,19,12,128};
+    const uint8_t key[16] = { };
+    OTSFAGT::FixedTX tx;
+    uint8_t body[34] = { };
+    uint8_t buf[64];
+    uint8_t workspace[OTRadioLink::SimpleSecureFrame32or0BodyTXBase::encodeValveFrame_total_scratch_usage_OTAESGCM_2p0 +
+                      OTSFAGT::wsSize];
+    OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+    OTRadioLink::OTEncodeData_T fd(body, sizeof(body), buf, sizeof(buf));
+    ASSERT_EQ(63, tx.encodeValveFrame(fd, 4, 0x7f,
+        OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleEnc_AESGCM_IMPL, sW, key));
+    for(int i = 0; i < 63; ++i) { ASSERT_EQ(expected[i], buf[i]) << i; }
+}
+
+// Check real frames through decodeBatch() with one key setup, and
+// through decode() with the key context cache.
+TEST(SecureFrameAESGCMImpl, DecodeWithKeyContext)
+{
+    OTSFTF::setUpMockRX();
+    OTRadioLink::SimpleSecureFrame32or0BodyRXFixedCounter &rx =
+        OTRadioLink::SimpleSecureFrame32or0BodyRXFixedCounter::getInstance();
+    static constexpr uint8_t nFrames = 4;
+    uint8_t frames[nFrames][64];
+    uint8_t ptext[nFrames][OTRadioLink::OTDecodeData_T::ptextLenMax];
+    OTRadioLink::OTDecodeData_T *fds[nFrames];
+    for(uint8_t i = 0; i < nFrames; ++i) {
+        ASSERT_NE(0, OTSFTF::makeFrameFrom(frames[i], OTSFTF::id, OTSFTF::oldCounterValue + i + 1, 4,
+            OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleEnc_AESGCM_IMPL));
+        fds[i] = new OTRadioLink::OTDecodeData_T(frames[i], ptext[i]);
+        fds[i]->sfh.decodeHeader(frames[i], frames[i][0] + 1);
+    }
+    // Damage the body of one frame.
+    frames[2][10] ^= 1;
+    uint8_t key[16];
+    OTSFTF::getKey(key);
+    uint8_t workspace[OTRadioLink::SimpleSecureFrame32or0BodyRXBase::decodeBatch_total_scratch_usage_OTAESGCM_3p0 +
+                      OTSFAGT::ctxSize + OTSFAGT::wsCtxSize + 16];
+    OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+    uint8_t results[nFrames];
+    EXPECT_EQ(nFrames - 1, rx.decodeBatch(fds, nFrames,
+        OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleKeySetup_AESGCM_IMPL,
+        OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDecWithContext_AESGCM_IMPL,
+        OTSFAGT::ctxSize, sW, key, results));
+    EXPECT_EQ(0, results[2]);
+    for(uint8_t i = 0; i < nFrames; ++i) {
+        if(2 == i) { continue; }
+        EXPECT_NE(0, results[i]);
+        EXPECT_EQ(0, memcmp(OTSFTF::valveBody, fds[i]->ptext, sizeof(OTSFTF::valveBody)));
+    }
+    EXPECT_TRUE(OTSFAGT::allZero(workspace, OTSFAGT::ctxSize));
+
+    // Cached: one setup for all the frames.
+    OTSFAGT::cache.clear();
+    OTRadioLink::SimpleSecureFrame32or0BodyRXBase::fixed32BTextSize12BNonce16BTagSimpleDec_fn_t &dCached =
+        OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDecCached<OTSFAGT::cache_t, OTSFAGT::cache,
+            OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleKeySetup_AESGCM_IMPL,
+            OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDecWithContext_AESGCM_IMPL>;
+    for(uint8_t i = 0; i < nFrames; ++i) {
+        OTV0P2BASE::ScratchSpaceL sWi(workspace, sizeof(workspace));
+        const uint8_t r = rx.decode(*fds[i], dCached, sWi, key);
+        if(2 == i) { EXPECT_EQ(0, r); } else { EXPECT_NE(0, r); }
+    }
+    EXPECT_EQ(1U, OTSFAGT::cache.getSetupCount());
+    OTSFAGT::cache.clear();
+    for(uint8_t i = 0; i < nFrames; ++i) { delete fds[i]; }
+}
+
+#if defined(EXT_AVAILABLE_ARDUINO_LIB_OTAESGCM)
+// Cross-check against OTAESGCM in both directions, with and without text.
+TEST(SecureFrameAESGCMImpl, MatchesOTAESGCM)
+{
+    uint8_t ctx[OTSFAGT::ctxSize];
+    uint8_t ws[OTAESGCM::OTAES128GCMGenericWithWorkspace<>::workspaceRequired];
+    uint8_t wsLocal[OTSFAGT::wsSize];
+    uint8_t key[16], iv[12], aad[13], pt[32];
+    for(uint8_t n = 0; n < 16; ++n) {
+        for(uint8_t i = 0; i < sizeof(key); ++i) { key[i] = uint8_t(n * 17 + i * 3); }
+        for(uint8_t i = 0; i < sizeof(iv); ++i) { iv[i] = uint8_t(n + i * 29); }
+        for(uint8_t i = 0; i < sizeof(aad); ++i) { aad[i] = uint8_t(n * 5 ^ i); }
+        for(uint8_t i = 0; i < sizeof(pt); ++i) { pt[i] = uint8_t(n * 7 + i); }
+        const uint8_t *const text = (0 == (n & 1)) ? pt : NULL;
+        const uint8_t aadLen = uint8_t(4 + (n % 10));
+        uint8_t ct[32], tag[16], ctLocal[32], tagLocal[16], out[32];
+        ASSERT_TRUE(OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleEnc_DEFAULT_WITH_LWORKSPACE(
+            ws, sizeof(ws), key, iv, aad, aadLen, text, ct, tag));
+        ASSERT_TRUE(OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleEnc_AESGCM_IMPL(
+            wsLocal, sizeof(wsLocal), key, iv, aad, aadLen, text, ctLocal, tagLocal));
+        EXPECT_EQ(0, memcmp(tag, tagLocal, sizeof(tag)));
+        if(NULL != text) { EXPECT_EQ(0, memcmp(ct, ctLocal, sizeof(ct))); }
+        ASSERT_TRUE(OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleKeySetup_AESGCM_IMPL(key, ctx));
+        EXPECT_TRUE(OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDecWithContext_AESGCM_IMPL(
+            wsLocal, OTSFAGT::wsCtxSize, ctx, iv, aad, aadLen, (NULL != text) ? ct : NULL, tag, out));
+        if(NULL != text) { EXPECT_EQ(0, memcmp(pt, out, sizeof(pt))); }
+        EXPECT_TRUE(OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleDec_DEFAULT_WITH_LWORKSPACE(
+            ws, sizeof(ws), key, iv, aad, aadLen, (NULL != text) ? ctLocal : NULL, tagLocal, out));
+    }
+}
+#endif // defined(EXT_AVAILABLE_ARDUINO_LIB_OTAESGCM)
@@ -0,0 +1,222 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * Batch decode of secure frames, and batch CRC checks of non-secure frames.
+ *
+ * These use the NULL crypto implementations so do not need OTAESGCM.
+ */
+
+#include <stdint.h>
+#include <gtest/gtest.h>
+#include <OTV0p2Base.h>
+#include <OTRadioLink.h>
+#include "SecureFrameTestFixture.h"
+
+
+namespace OTSFBT
+{
+    bool getKeyFail(uint8_t *) { return(false); }
+
+    // NULL key setup, counting calls.
+    unsigned nSetups;
+    bool countingSetup(const uint8_t *const key, uint8_t *const keyContext)
+    {
+        ++nSetups;
+        return(OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleKeySetup_NULL_IMPL(key, keyContext));
+    }
+    bool failingSetup(const uint8_t *, uint8_t *) { return(false); }
+    static constexpr size_t keyContextSize =
+        OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleKeyContextSize_NULL_IMPL;
+
+    // Scratch space large enough for the NULL crypto.
+    static constexpr size_t workspaceSize =
+        OTRadioLink::authAndDecodeOTSecurableFrameWithWorkspace_scratch_usage +
+        OTRadioLink::SimpleSecureFrame32or0BodyRXBase::decodeBatch_total_scratch_usage_OTAESGCM_3p0 +
+        keyContextSize + 16;
+
+    static constexpr uint8_t nFrames = 32;
+    struct Batch
+    {
+        uint8_t frames[nFrames][64];
+        uint8_t ptext[nFrames][OTRadioLink::OTDecodeData_T::ptextLenMax];
+        OTRadioLink::OTDecodeData_T *fds[nFrames];
+        Batch()
+        {
+            for(uint8_t i = 0; i < nFrames; ++i) {
+                OTSFTF::makeFrame(frames[i], uint8_t(i + 1));
+                fds[i] = new OTRadioLink::OTDecodeData_T(frames[i], ptext[i]);
+                fds[i]->sfh.decodeHeader(frames[i], frames[i][0] + 1);
+            }
+        }
+        ~Batch() { for(uint8_t i = 0; i < nFrames; ++i) { delete fds[i]; } }
+    };
+
+    void setUpMockRX()
+    {
+        OTSFTF::setUpMockRX();
+        nSetups = 0;
+    }
+}
+
+// Check that every frame in a batch decodes and reports per-frame status.
+TEST(SecureFrameBatch, DecodeBatchAllGood)
+{
+    OTSFBT::setUpMockRX();
+    OTSFBT::Batch b;
+    // Sanity check the first test frame.
+    ASSERT_NE(0, b.frames[0][0]);
+    ASSERT_FALSE(b.fds[0]->sfh.isInvalid());
+
+    uint8_t workspace[OTSFBT::workspaceSize];
+    OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+    uint8_t results[OTSFBT::nFrames];
+    const uint8_t nOK = OTRadioLink::authAndDecodeOTSecurableFrameBatch<
+        OTRadioLink::SimpleSecureFrame32or0BodyRXFixedCounter,
+        OTSFBT::countingSetup,
+        OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDec_NULL_IMPL,
+        OTSFBT::keyContextSize,
+        OTSFTF::getKey>(b.fds, OTSFBT::nFrames, results, sW);
+    EXPECT_EQ(OTSFBT::nFrames, nOK);
+    // The key is expanded once for the whole batch.
+    EXPECT_EQ(1U, OTSFBT::nSetups);
+    for(uint8_t i = 0; i < OTSFBT::nFrames; ++i) {
+        EXPECT_EQ(b.frames[i][0] + 1, results[i]);
+        EXPECT_EQ(5, b.fds[i]->ptextLen);
+        EXPECT_EQ('{', b.fds[i]->ptext[2]);
+        EXPECT_EQ(0, memcmp(OTSFTF::id, b.fds[i]->id, 6));
+    }
+}
+
+// Check that bad frames and NULL entries fail individually without
+// affecting the rest of the batch.
+TEST(SecureFrameBatch, DecodeBatchPartialFailure)
+{
+    OTSFBT::setUpMockRX();
+    OTSFBT::Batch b;
+    // Corrupt the tag of frame 1 so that the NULL decrypt rejects it.
+    b.frames[1][b.frames[1][0]] = 0xff;
+    OTRadioLink::OTDecodeData_T *const saved = b.fds[3];
+    b.fds[3] = nullptr;
+
+    uint8_t workspace[OTSFBT::workspaceSize];
+    OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+    uint8_t key[16];
+    OTSFTF::getKey(key);
+    uint8_t results[OTSFBT::nFrames];
+    const uint8_t nOK = OTRadioLink::SimpleSecureFrame32or0BodyRXFixedCounter::getInstance().decodeBatch(
+        b.fds, OTSFBT::nFrames,
+        OTSFBT::countingSetup,
+        OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDec_NULL_IMPL,
+        OTSFBT::keyContextSize,
+        sW, key, results);
+    b.fds[3] = saved;
+    EXPECT_EQ(OTSFBT::nFrames - 2, nOK);
+    EXPECT_NE(0, results[0]);
+    EXPECT_EQ(0, results[1]);
+    EXPECT_NE(0, results[2]);
+    EXPECT_EQ(0, results[3]);
+    EXPECT_NE(0, results[4]);
+    // The key context is not left in the scratch space.
+    for(size_t i = 0; i < OTSFBT::keyContextSize; ++i) { EXPECT_EQ(0, workspace[i]); }
+}
+
+// Check the batch is refused as a whole if the key or workspace is unusable.
+TEST(SecureFrameBatch, DecodeBatchBadArgs)
+{
+    OTSFBT::setUpMockRX();
+    OTSFBT::Batch b;
+    uint8_t workspace[OTSFBT::workspaceSize];
+    OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+    uint8_t results[OTSFBT::nFrames];
+    EXPECT_EQ(0, (OTRadioLink::authAndDecodeOTSecurableFrameBatch<
+        OTRadioLink::SimpleSecureFrame32or0BodyRXFixedCounter,
+        OTSFBT::countingSetup,
+        OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDec_NULL_IMPL,
+        OTSFBT::keyContextSize,
+        OTSFBT::getKeyFail>(b.fds, OTSFBT::nFrames, results, sW)));
+    OTV0P2BASE::ScratchSpaceL sWSmall(workspace, 8);
+    EXPECT_EQ(0, (OTRadioLink::authAndDecodeOTSecurableFrameBatch<
+        OTRadioLink::SimpleSecureFrame32or0BodyRXFixedCounter,
+        OTSFBT::countingSetup,
+        OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDec_NULL_IMPL,
+        OTSFBT::keyContextSize,
+        OTSFTF::getKey>(b.fds, OTSFBT::nFrames, results, sWSmall)));
+    // A failed key setup fails every frame.
+    memset(results, 0xff, sizeof(results));
+    uint8_t key[16];
+    OTSFTF::getKey(key);
+    EXPECT_EQ(0, OTRadioLink::SimpleSecureFrame32or0BodyRXFixedCounter::getInstance().decodeBatch(
+        b.fds, OTSFBT::nFrames,
+        OTSFBT::failingSetup,
+        OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDec_NULL_IMPL,
+        OTSFBT::keyContextSize,
+        sW, key, results));
+    EXPECT_EQ(0xff, results[0]);
+}
+
+// Check the batch CRC check of non-secure frames against decodeNonsecure(),
+// with frames of assorted lengths, some damaged, and a partial last group.
+TEST(SecureFrameBatch, NonsecureCRCBatch)
+{
+    static constexpr uint8_t n = 39;
+    uint8_t bufs[n][64];
+    const uint8_t *frames[n];
+    uint8_t lens[n];
+    const uint8_t id[4] = { 0x01, 0x02, 0x03, 0x04 };
+    for(uint8_t i = 0; i < n; ++i) {
+        uint8_t body[OTRadioLink::SecurableFrameHeader::maxSmallFrameBodySize - 4];
+        for(uint8_t j = 0; j < sizeof(body); ++j) { body[j] = uint8_t(i * 31 + j); }
+        OTRadioLink::OTEncodeData_T fd(body, uint8_t((i * 7) % sizeof(body)), bufs[i], sizeof(bufs[i]));
+        fd.fType = OTRadioLink::FTS_BasicSensorOrValve;
+        lens[i] = OTRadioLink::encodeNonsecure(fd, i, id, uint8_t(i % 5));
+        ASSERT_NE(0, lens[i]);
+        frames[i] = bufs[i];
+    }
+    // Damage: body bit flip, trailer change, truncated buffer,
+    // secure bit, bad length byte, missing frame.
+    bufs[3][4] ^= 0x10;
+    bufs[8][bufs[8][0]] ^= 0x01;
+    --lens[13];
+    bufs[21][1] |= 0x80;
+    bufs[30][0] = 2;
+    frames[34] = NULL;
+
+    uint8_t bitmap[(n + 7) / 8];
+    memset(bitmap, 0xff, sizeof(bitmap));
+    const uint8_t nValid = OTRadioLink::checkNonsecureCRCBatch(frames, lens, n, bitmap);
+    uint8_t nExpected = 0;
+    for(uint8_t i = 0; i < n; ++i) {
+        bool expected = false;
+        // The per-frame path needs the whole frame in the buffer.
+        if((NULL != frames[i]) && (lens[i] > frames[i][0])) {
+            OTRadioLink::OTDecodeData_T fd(frames[i], NULL);
+            expected = (0 != fd.sfh.decodeHeader(frames[i], lens[i])) &&
+                       (0 != OTRadioLink::decodeNonsecure(fd));
+        }
+        if(expected) { ++nExpected; }
+        EXPECT_EQ(expected, 0 != (bitmap[i >> 3] & (1 << (i & 7)))) << int(i);
+    }
+    EXPECT_EQ(n - 6, nExpected);
+    EXPECT_EQ(nExpected, nValid);
+    // Unused bits in the last byte stay clear.
+    EXPECT_EQ(0, bitmap[sizeof(bitmap) - 1] >> (n & 7));
+
+    EXPECT_EQ(0, OTRadioLink::checkNonsecureCRCBatch(NULL, lens, n, bitmap));
+    EXPECT_EQ(0, OTRadioLink::checkNonsecureCRCBatch(frames, lens, 0, bitmap));
+}
@@ -0,0 +1,194 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * Fixed-shape secure frame encoder vs the generic encode path.
+ *
+ * Uses the NULL crypto so does not need OTAESGCM.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <gtest/gtest.h>
+#include <OTV0p2Base.h>
+#include <OTRadioLink.h>
+
+
+namespace OTSFFST
+{
+    static constexpr uint8_t id[8] = { 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff };
+
+    // TX with a fixed ID and a RAM counter.
+    class CountingTX final : public OTRadioLink::SimpleSecureFrame32or0BodyTXBase
+    {
+    private:
+        uint64_t counter = 0x2a0000;
+    public:
+        virtual bool getTXID(uint8_t *buf) const override { memcpy(buf, id, sizeof(id)); return(true); }
+        virtual bool getTXNVCtrPrefix(uint8_t *buf) const override { memset(buf, 0, txNVCtrPrefixBytes); return(true); }
+        virtual bool resetTXNVCtrPrefix(bool) override { return(false); }
+        virtual bool incrementTXNVCtrPrefix() override { return(false); }
+        virtual bool getNextTXMsgCtr(uint8_t *buf) override
+        {
+            uint64_t c = ++counter;
+            for(int i = fullMsgCtrBytes; --i >= 0; c >>= 8) { buf[i] = uint8_t(c); }
+            return(true);
+        }
+    };
+
+    // Encode the same valve frame with the generic and fixed encoders and
+    // check that the frames are identical.
+    template <uint8_t il>
+    void checkValveFrame(const char *const stats, const uint8_t valvePC)
+    {
+        typedef OTRadioLink::SimpleSecureValveFrameTX<il> fixed_t;
+        const uint8_t key[16] = { };
+        uint8_t workspace[fixed_t::encodeValveFrame_total_scratch_usage_OTAESGCM_2p0];
+        CountingTX genericTX, fixedTX;
+        uint8_t body[2][OTRadioLink::ENC_BODY_SMALL_FIXED_CTEXT_SIZE] = { };
+        if(NULL != stats) { strcpy((char *)body[0] + 2, stats); strcpy((char *)body[1] + 2, stats); }
+        uint8_t out[2][64];
+        memset(out, 0x55, sizeof(out));
+
+        OTRadioLink::OTEncodeData_T gfd(body[0], sizeof(body[0]), out[0], sizeof(out[0]));
+        OTV0P2BASE::ScratchSpaceL gsW(workspace, sizeof(workspace));
+        const uint8_t gl = genericTX.encodeValveFrame(gfd, il, valvePC,
+            OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleEnc_NULL_IMPL, gsW, key);
+        ASSERT_NE(0, gl);
+
+        OTRadioLink::OTEncodeData_T ffd(body[1], sizeof(body[1]), out[1], sizeof(out[1]));
+        OTV0P2BASE::ScratchSpaceL fsW(workspace, sizeof(workspace));
+        const uint8_t fl = fixed_t::encodeValveFrame(fixedTX, ffd, valvePC,
+            OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleEnc_NULL_IMPL, fsW, key);
+        EXPECT_EQ(gl, fl);
+        EXPECT_EQ(0, memcmp(out[0], out[1], sizeof(out[0])));
+        // The generic path computes the same layout at runtime.
+        const uint8_t frameBufSize = fixed_t::frameBufSize;
+        const uint8_t fixedFl = fixed_t::fl;
+        const uint8_t bodyOffset = fixed_t::bodyOffset;
+        const uint8_t trailerOffset = fixed_t::trailerOffset;
+        EXPECT_EQ(frameBufSize, fl);
+        EXPECT_EQ(fixedFl, gfd.sfh.fl);
+        EXPECT_EQ(bodyOffset, gfd.sfh.getBodyOffset());
+        EXPECT_EQ(trailerOffset, gfd.sfh.getTrailerOffset());
+    }
+}
+
+// Layout is fully known at compile time.
+static_assert(63 == OTRadioLink::SimpleSecureValveFrameTX<5>::fl, "max 'O' frame");
+static_assert(8 == OTRadioLink::SimpleSecureValveFrameTX<4>::bodyOffset, "");
+static_assert(40 == OTRadioLink::SimpleSecureValveFrameTX<4>::trailerOffset, "");
+
+// Check that fixed-shape valve frames match generic ones byte for byte.
+TEST(SecureFrameFixedShape, ValveFrameMatchesGeneric)
+{
+    OTSFFST::checkValveFrame<0>(NULL, 0);
+    OTSFFST::checkValveFrame<2>("{\"b\":1}", 42);
+    OTSFFST::checkValveFrame<4>("{\"b\":1,\"T|C16\":301}", 100);
+    OTSFFST::checkValveFrame<4>(NULL, 200);
+    OTSFFST::checkValveFrame<5>("{\"@\":\"0123\",\"v|%\":99,\"b\"}", 7);
+}
+
+// Check a frame without a body against the generic raw encoder.
+TEST(SecureFrameFixedShape, RawNoBodyMatchesGeneric)
+{
+    typedef OTRadioLink::SimpleSecureFrame32or0BodyTXFixed<OTRadioLink::FTS_ALIVE, 8, 0> fixed_t;
+    const uint8_t key[16] = { };
+    uint8_t iv[12];
+    memcpy(iv, OTSFFST::id, 6);
+    memcpy(iv + 6, "\x00\x00\x2a\x00\x03\x1b", 6);
+    uint8_t workspace[fixed_t::encodeRaw_total_scratch_usage_OTAESGCM_2p0];
+    uint8_t out[2][64];
+    memset(out, 0, sizeof(out));
+
+    OTRadioLink::OTEncodeData_T gfd(NULL, 0, out[0], sizeof(out[0]));
+    gfd.fType = OTRadioLink::FTS_ALIVE;
+    OTV0P2BASE::ScratchSpaceL gsW(workspace, sizeof(workspace));
+    const uint8_t gl = OTRadioLink::SimpleSecureFrame32or0BodyTXBase::encodeRaw(gfd, OTSFFST::id, 8, iv,
+        OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleEnc_NULL_IMPL, gsW, key);
+    ASSERT_NE(0, gl);
+    OTV0P2BASE::ScratchSpaceL fsW(workspace, sizeof(workspace));
+    EXPECT_EQ(gl, fixed_t::encodeRaw(out[1], NULL, 0, OTSFFST::id, iv,
+        OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleEnc_NULL_IMPL, fsW, key));
+    EXPECT_EQ(0, memcmp(out[0], out[1], sizeof(out[0])));
+}
+
+// Check that a secure beacon is the empty-bodied FTS_ALIVE frame that
+// the generic encoder makes from the same ID and counter.
+TEST(SecureFrameFixedShape, SecureBeaconMatchesGeneric)
+{
+    const uint8_t key[16] = { };
+    uint8_t workspace[OTRadioLink::SimpleSecureFrame32or0BodyTXBase::encode_total_scratch_usage_OTAESGCM_2p0];
+    uint8_t out[2][OTRadioLink::SimpleSecureFrame32or0BodyTXBase::generateSecureBeaconMaxBufSize];
+    memset(out, 0x55, sizeof(out));
+    OTSFFST::CountingTX beaconTX, genericTX;
+
+    OTRadioLink::OTBuf_t buf(out[0], sizeof(out[0]));
+    OTV0P2BASE::ScratchSpaceL bsW(workspace, sizeof(workspace));
+    const uint8_t bl = beaconTX.generateSecureBeacon(buf, 4,
+        OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleEnc_NULL_IMPL, bsW, key);
+    EXPECT_EQ(27 + 4, bl);
+
+    OTRadioLink::OTEncodeData_T gfd(NULL, 0, out[1], sizeof(out[1]));
+    gfd.fType = OTRadioLink::FTS_ALIVE;
+    OTV0P2BASE::ScratchSpaceL gsW(workspace, sizeof(workspace));
+    EXPECT_EQ(bl, genericTX.encode(gfd, 4,
+        OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleEnc_NULL_IMPL, gsW, key));
+    EXPECT_EQ(0, memcmp(out[0], out[1], sizeof(out[0])));
+
+    OTRadioLink::SecurableFrameHeader sfh;
+    EXPECT_NE(0, sfh.decodeHeader(out[0], bl));
+    EXPECT_TRUE(sfh.isSecure());
+    EXPECT_EQ(OTRadioLink::FTS_ALIVE, 0x7f & sfh.fType);
+    EXPECT_EQ(4, sfh.getIl());
+    EXPECT_EQ(0, sfh.bl);
+}
+
+// Check argument and buffer size errors.
+TEST(SecureFrameFixedShape, Errors)
+{
+    typedef OTRadioLink::SimpleSecureValveFrameTX<4> fixed_t;
+    const uint8_t key[16] = { };
+    uint8_t workspace[fixed_t::encodeValveFrame_total_scratch_usage_OTAESGCM_2p0];
+    uint8_t body[OTRadioLink::ENC_BODY_SMALL_FIXED_CTEXT_SIZE] = { };
+    uint8_t out[64];
+    OTSFFST::CountingTX tx;
+    {
+        OTRadioLink::OTEncodeData_T fd(body, sizeof(body), out, fixed_t::frameBufSize - 1);
+        OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+        EXPECT_EQ(0, fixed_t::encodeValveFrame(tx, fd, 0, OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleEnc_NULL_IMPL, sW, key));
+    }
+    {
+        OTRadioLink::OTEncodeData_T fd(body, sizeof(body), out, sizeof(out));
+        OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace) - 1);
+        EXPECT_EQ(0, fixed_t::encodeValveFrame(tx, fd, 0, OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleEnc_NULL_IMPL, sW, key));
+    }
+    {
+        OTRadioLink::OTEncodeData_T fd(NULL, 0, out, sizeof(out));
+        OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+        EXPECT_EQ(0, fixed_t::encodeValveFrame(tx, fd, 0, OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleEnc_NULL_IMPL, sW, key));
+    }
+    {
+        // Stats too long.
+        memset(body, 'x', sizeof(body));
+        body[2] = '{';
+        OTRadioLink::OTEncodeData_T fd(body, sizeof(body), out, sizeof(out));
+        OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+        EXPECT_EQ(0, fixed_t::encodeValveFrame(tx, fd, 0, OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleEnc_NULL_IMPL, sW, key));
+    }
+}
@@ -0,0 +1,312 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * Multi-candidate sender ID matching in decode() (firstIDMatchOnly false).
+ *
+ * Uses the NULL crypto with a decrypt that checks the whole nonce
+ * (so the full sender ID) echoed in the tag, so does not need OTAESGCM.
+ */
+
+#include <stdint.h>
+#include <gtest/gtest.h>
+#include <OTV0p2Base.h>
+#include <OTRadioLink.h>
+#include "SecureFrameTestFixture.h"
+
+
+namespace OTSFIMT
+{
+    static constexpr uint8_t maxNodes = 64;
+    // On-air ID prefix length.
+    static constexpr uint8_t il = 4;
+
+    // Node k of a colliding group: all share the same 4-byte prefix.
+    void getNodeID(const uint8_t k, uint8_t *const id)
+    {
+        const uint8_t base[8] = { 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88 };
+        memcpy(id, base, 8);
+        id[4] = uint8_t(0x90 + k);
+        id[5] = uint8_t(0xa0 + k);
+    }
+
+    typedef OTV0P2BASE::NodeAssociationTableRAM<maxNodes> table_t;
+
+    // RX with an association table, sorted ID index and per-node counters.
+    class IndexedRX final : public OTRadioLink::SimpleSecureFrame32or0BodyRXBase
+    {
+    private:
+        table_t table;
+        OTV0P2BASE::NodeAssociationIndex<table_t, maxNodes> index;
+        uint8_t counters[maxNodes][fullMsgCtrBytes];
+        virtual int8_t _getNextMatchingNodeID(const uint8_t start, const OTRadioLink::SecurableFrameHeader *const sfh, uint8_t *nodeID) const override
+            { return(int8_t(index.getNextMatchingNodeID(start, sfh->id, sfh->getIl(), nodeID))); }
+        int16_t find(const uint8_t *const ID) const
+            { return((nullptr == ID) ? -1 : index.getNextMatchingNodeID(0, ID, 8, nullptr)); }
+    public:
+        // Associate nodes 0 to n-1, with all counters zero.
+        explicit IndexedRX(const uint8_t n)
+        {
+            for(uint8_t k = 0; k < n; ++k) {
+                uint8_t id[8];
+                getNodeID(k, id);
+                table.set(k, id);
+            }
+            index.rebuild(table);
+            memset(counters, 0, sizeof(counters));
+        }
+        virtual bool getLastRXMsgCtr(const uint8_t * const ID, uint8_t *counter) const override
+        {
+            const int16_t i = find(ID);
+            if((i < 0) || (nullptr == counter)) { return(false); }
+            memcpy(counter, counters[i], fullMsgCtrBytes);
+            return(true);
+        }
+        virtual bool authAndUpdateRXMsgCtr(const uint8_t *ID, const uint8_t *newCounterValue) override
+        {
+            if(!validateRXMsgCtr(ID, newCounterValue)) { return(false); }
+            memcpy(counters[find(ID)], newCounterValue, fullMsgCtrBytes);
+            return(true);
+        }
+    };
+
+    // NULL decrypt that also checks the nonce echoed in the tag by the
+    // NULL encrypt, ie rejects a frame tried with the wrong sender ID.
+    unsigned nDecrypts;
+    bool nonceCheckingDec(
+            uint8_t *const workspace, const size_t workspaceSize,
+            const uint8_t *const key, const uint8_t *const iv,
+            const uint8_t *const authtext, const uint8_t authtextSize,
+            const uint8_t *const ciphertext, const uint8_t *const tag,
+            uint8_t *const plaintextOut)
+    {
+        ++nDecrypts;
+        if((nullptr == iv) || (nullptr == tag) || (0 != memcmp(iv, tag, 12))) { return(false); }
+        return(OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDec_NULL_IMPL(
+                workspace, workspaceSize, key, iv, authtext, authtextSize,
+                ciphertext, tag, plaintextOut));
+    }
+
+    // Encode a secure 'O' frame from node k with message counter ctr.
+    void makeFrame(uint8_t *const buf, const uint8_t k, const uint32_t ctr)
+    {
+        uint8_t id[8];
+        getNodeID(k, id);
+        OTSFTF::makeFrameFrom(buf, id, ctr, il);
+    }
+
+    // Decode frame in buf with rx, returning the sender index or -1.
+    int decodeFrom(IndexedRX &rx, const uint8_t *const buf, const bool firstIDMatchOnly)
+    {
+        uint8_t ptext[OTRadioLink::OTDecodeData_T::ptextLenMax];
+        OTRadioLink::OTDecodeData_T fd(buf, ptext);
+        if(0 == fd.sfh.decodeHeader(buf, buf[0] + 1)) { return(-1); }
+        uint8_t workspace[OTRadioLink::SimpleSecureFrame32or0BodyRXBase::decode_total_scratch_usage_OTAESGCM_3p0 + 16];
+        OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+        const uint8_t key[16] = {};
+        if(0 == rx.decode(fd, nonceCheckingDec, sW, key, firstIDMatchOnly)) { return(-1); }
+        for(uint8_t k = 0; k < maxNodes; ++k) {
+            uint8_t id[8];
+            getNodeID(k, id);
+            if(0 == memcmp(id, fd.id, 8)) { return(k); }
+        }
+        return(-1);
+    }
+
+    // Full sender ID of the last frame handled.
+    uint8_t lastSender[8];
+    bool noteSender(const OTRadioLink::OTDecodeData_T &fd) { memcpy(lastSender, fd.id, 8); return(true); }
+
+    // Handle frame in buf through decodeAndHandleOTSecureOFrame(),
+    // with the mock RX offering its candidate IDs.
+    template<bool firstIDMatchOnly>
+    bool handleFrame(const uint8_t *const buf)
+    {
+        uint8_t workspace[
+            OTRadioLink::SimpleSecureFrame32or0BodyRXBase::decode_total_scratch_usage_OTAESGCM_3p0 +
+            OTRadioLink::decodeAndHandleOTSecureOFrame_scratch_usage +
+            OTRadioLink::authAndDecodeOTSecurableFrameWithWorkspace_scratch_usage + 16];
+        OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+        return(OTRadioLink::decodeAndHandleOTSecureOFrame<
+                OTRadioLink::SimpleSecureFrame32or0BodyRXFixedCounter,
+                nonceCheckingDec, OTSFTF::getKey, noteSender,
+                OTRadioLink::nullFrameOperation, OTRadioLink::SecureFrameReplayFilterNull,
+                firstIDMatchOnly>(buf + 1, sW));
+    }
+}
+
+// Check that a sender whose prefix collides with an earlier association is
+// only found when not restricted to the first match.
+TEST(SecureFrameIDMatch, CollidingPrefix)
+{
+    OTSFIMT::IndexedRX rx(2);
+    uint8_t buf[64];
+    OTSFIMT::makeFrame(buf, 1, 1);
+    EXPECT_EQ(-1, OTSFIMT::decodeFrom(rx, buf, true));
+    EXPECT_EQ(1, OTSFIMT::decodeFrom(rx, buf, false));
+    // Replay rejected.
+    EXPECT_EQ(-1, OTSFIMT::decodeFrom(rx, buf, false));
+    // The first association still decodes either way.
+    OTSFIMT::makeFrame(buf, 0, 1);
+    EXPECT_EQ(0, OTSFIMT::decodeFrom(rx, buf, true));
+    OTSFIMT::makeFrame(buf, 0, 2);
+    EXPECT_EQ(0, OTSFIMT::decodeFrom(rx, buf, false));
+    // Unknown prefix.
+    OTSFIMT::IndexedRX empty(0);
+    EXPECT_EQ(-1, OTSFIMT::decodeFrom(empty, buf, false));
+}
+
+// Check that the most recently authenticated sender is tried first.
+TEST(SecureFrameIDMatch, RecentSenderFirst)
+{
+    OTSFIMT::IndexedRX rx(3);
+    uint8_t buf[64];
+    OTSFIMT::makeFrame(buf, 2, 1);
+    OTSFIMT::nDecrypts = 0;
+    EXPECT_EQ(2, OTSFIMT::decodeFrom(rx, buf, false));
+    EXPECT_EQ(3U, OTSFIMT::nDecrypts);
+    OTSFIMT::makeFrame(buf, 2, 2);
+    OTSFIMT::nDecrypts = 0;
+    EXPECT_EQ(2, OTSFIMT::decodeFrom(rx, buf, false));
+    EXPECT_EQ(1U, OTSFIMT::nDecrypts);
+    // Others are then tried in table order, skipping the recent one.
+    // (Counter above node 2's so that node 2 gets as far as a decrypt.)
+    OTSFIMT::makeFrame(buf, 1, 5);
+    OTSFIMT::nDecrypts = 0;
+    EXPECT_EQ(1, OTSFIMT::decodeFrom(rx, buf, false));
+    EXPECT_EQ(3U, OTSFIMT::nDecrypts);
+}
+
+// Check that no more than maxIDMatchAttempts candidates are tried.
+TEST(SecureFrameIDMatch, AttemptBudget)
+{
+    constexpr uint8_t budget = OTRadioLink::SimpleSecureFrame32or0BodyRXBase::maxIDMatchAttempts;
+    OTSFIMT::IndexedRX rx(budget + 2);
+    uint8_t buf[64];
+    OTSFIMT::makeFrame(buf, budget + 1, 1);
+    OTSFIMT::nDecrypts = 0;
+    EXPECT_EQ(-1, OTSFIMT::decodeFrom(rx, buf, false));
+    EXPECT_EQ(budget, OTSFIMT::nDecrypts);
+    OTSFIMT::makeFrame(buf, budget - 1, 1);
+    EXPECT_EQ(budget - 1, OTSFIMT::decodeFrom(rx, buf, false));
+}
+
+// Check that firstIDMatchOnly is passed through decodeAndHandleOTSecureOFrame()
+// and that the sender is found among several candidates for its prefix.
+TEST(SecureFrameIDMatch, ThroughFrameHandler)
+{
+    static constexpr uint8_t n = 3;
+    uint8_t ids[n][8];
+    for(uint8_t k = 0; k < n; ++k) { OTSFIMT::getNodeID(k, ids[k]); }
+    OTRadioLink::SimpleSecureFrame32or0BodyRXFixedCounter &rx =
+        OTRadioLink::SimpleSecureFrame32or0BodyRXFixedCounter::getInstance();
+    rx.setMockIDValues(ids[0], n);
+    rx.setMockCounterValue(OTSFTF::oldCounter);
+    const uint8_t none[8] = { };
+    for(uint8_t k = 0; k < n; ++k) {
+        uint8_t buf[64];
+        OTSFIMT::makeFrame(buf, k, uint32_t(OTSFTF::oldCounterValue + 1));
+        // Only the first candidate is tried.
+        memset(OTSFIMT::lastSender, 0, 8);
+        OTSFIMT::nDecrypts = 0;
+        EXPECT_TRUE(OTSFIMT::handleFrame<true>(buf));
+        EXPECT_EQ(1U, OTSFIMT::nDecrypts);
+        EXPECT_EQ(0, memcmp((0 == k) ? ids[0] : none, OTSFIMT::lastSender, 8)) << int(k);
+        // Every candidate may be tried: the one that authenticates is k.
+        memset(OTSFIMT::lastSender, 0, 8);
+        EXPECT_TRUE(OTSFIMT::handleFrame<false>(buf));
+        EXPECT_EQ(0, memcmp(ids[k], OTSFIMT::lastSender, 8)) << int(k);
+    }
+    OTSFTF::setUpMockRX();
+}
+
+// Check that firstIDMatchOnly is passed through
+// authAndDecodeOTSecurableFrameBatch().
+TEST(SecureFrameIDMatch, ThroughBatch)
+{
+    static constexpr uint8_t n = 3;
+    uint8_t ids[n][8];
+    for(uint8_t k = 0; k < n; ++k) { OTSFIMT::getNodeID(k, ids[k]); }
+    OTRadioLink::SimpleSecureFrame32or0BodyRXFixedCounter &rx =
+        OTRadioLink::SimpleSecureFrame32or0BodyRXFixedCounter::getInstance();
+    rx.setMockIDValues(ids[0], n);
+    rx.setMockCounterValue(OTSFTF::oldCounter);
+    uint8_t frames[n][64];
+    uint8_t ptext[n][OTRadioLink::OTDecodeData_T::ptextLenMax];
+    OTRadioLink::OTDecodeData_T *fds[n];
+    for(uint8_t k = 0; k < n; ++k) {
+        OTSFIMT::makeFrame(frames[k], k, uint32_t(OTSFTF::oldCounterValue + 1));
+        fds[k] = new OTRadioLink::OTDecodeData_T(frames[k], ptext[k]);
+        fds[k]->sfh.decodeHeader(frames[k], frames[k][0] + 1);
+    }
+    uint8_t workspace[
+        OTRadioLink::SimpleSecureFrame32or0BodyRXBase::decodeBatch_total_scratch_usage_OTAESGCM_3p0 +
+        OTRadioLink::authAndDecodeOTSecurableFrameWithWorkspace_scratch_usage +
+        OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleKeyContextSize_NULL_IMPL + 16];
+    OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+    uint8_t results[n];
+    // Only the first candidate is tried, so only node 0 is found.
+    EXPECT_EQ(1, (OTRadioLink::authAndDecodeOTSecurableFrameBatch<
+        OTRadioLink::SimpleSecureFrame32or0BodyRXFixedCounter,
+        OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleKeySetup_NULL_IMPL,
+        OTSFIMT::nonceCheckingDec,
+        OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleKeyContextSize_NULL_IMPL,
+        OTSFTF::getKey, true>(fds, n, results, sW)));
+    EXPECT_NE(0, results[0]);
+    // Every candidate may be tried.
+    EXPECT_EQ(n, (OTRadioLink::authAndDecodeOTSecurableFrameBatch<
+        OTRadioLink::SimpleSecureFrame32or0BodyRXFixedCounter,
+        OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleKeySetup_NULL_IMPL,
+        OTSFIMT::nonceCheckingDec,
+        OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleKeyContextSize_NULL_IMPL,
+        OTSFTF::getKey, false>(fds, n, results, sW)));
+    for(uint8_t k = 0; k < n; ++k) {
+        EXPECT_EQ(0, memcmp(ids[k], fds[k]->id, 8)) << int(k);
+        delete fds[k];
+    }
+    OTSFTF::setUpMockRX();
+}
+
+// Decrypts per frame as the number of associations sharing a prefix grows,
+// with senders taking turns: never more than the attempt budget.
+// Senders beyond the budget that are not recent are not found.
+TEST(SecureFrameIDMatch, CollisionCost)
+{
+    static constexpr unsigned rounds = 50;
+    constexpr uint8_t budget = OTRadioLink::SimpleSecureFrame32or0BodyRXBase::maxIDMatchAttempts;
+    const uint8_t nColliding[] = { 1, 2, 4, 8, 16, 32 };
+    for(const uint8_t n : nColliding) {
+        OTSFIMT::IndexedRX rx(n);
+        uint8_t buf[64];
+        unsigned nOK = 0;
+        OTSFIMT::nDecrypts = 0;
+        for(unsigned r = 1; r <= rounds; ++r) {
+            for(uint8_t k = 0; k < n; ++k) {
+                OTSFIMT::makeFrame(buf, k, r);
+                if(k == OTSFIMT::decodeFrom(rx, buf, false)) { ++nOK; }
+            }
+        }
+        const unsigned nFrames = rounds * n;
+        EXPECT_LE(OTSFIMT::nDecrypts, nFrames * budget) << int(n);
+        if(n <= budget) {
+            EXPECT_EQ(nFrames, nOK) << int(n);
+        } else {
+            EXPECT_LT(nOK, nFrames) << int(n);
+        }
+    }
+}
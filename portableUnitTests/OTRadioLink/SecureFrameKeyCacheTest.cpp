@@ -0,0 +1,196 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * Precomputed decryption key context cache.
+ *
+ * Uses a mock split key-setup/decrypt pair built around the NULL crypto,
+ * with a deliberately costly key setup standing in for AES key expansion,
+ * so does not need OTAESGCM.
+ */
+
+#include <stdint.h>
+#include <gtest/gtest.h>
+#include <OTV0p2Base.h>
+#include <OTRadioLink.h>
+#include "SecureFrameTestFixture.h"
+
+
+namespace OTSFKCT
+{
+    static constexpr uint8_t key1[16] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+    static constexpr uint8_t key2[16] = { 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1 };
+
+    // Same size as an AES-128 key schedule.
+    static constexpr size_t contextSize = 176;
+
+    // Mock key setup: copies the key to the start of the context then
+    // churns out the rest, roughly as costly as a real key expansion.
+    bool mockSetup(const uint8_t *const key, uint8_t *const ctx)
+    {
+        memcpy(ctx, key, 16);
+        for(uint8_t round = 0; round < 10; ++round) {
+            for(size_t i = 16; i < contextSize; ++i) {
+                ctx[i] = uint8_t((ctx[i - 16] * 31u) ^ (ctx[i - 1] >> 1) ^ round);
+            }
+        }
+        return(true);
+    }
+    bool mockSetupFail(const uint8_t *, uint8_t *) { return(false); }
+
+    // Mock decrypt with context: behaves as the NULL decrypt.
+    bool mockDecWithContext(
+            uint8_t *const workspace, const size_t workspaceSize,
+            const uint8_t *const ctx, const uint8_t *const iv,
+            const uint8_t *const authtext, const uint8_t authtextSize,
+            const uint8_t *const ciphertext, const uint8_t *const tag,
+            uint8_t *const plaintextOut)
+    {
+        return(OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDec_NULL_IMPL(
+                workspace, workspaceSize, ctx, iv, authtext, authtextSize,
+                ciphertext, tag, plaintextOut));
+    }
+
+    // Uncached decrypt: does the key setup for every frame,
+    // as a plain decrypt implementation must.
+    bool mockDecUncached(
+            uint8_t *const workspace, const size_t workspaceSize,
+            const uint8_t *const key, const uint8_t *const iv,
+            const uint8_t *const authtext, const uint8_t authtextSize,
+            const uint8_t *const ciphertext, const uint8_t *const tag,
+            uint8_t *const plaintextOut)
+    {
+        uint8_t ctx[contextSize];
+        if(!mockSetup(key, ctx)) { return(false); }
+        return(mockDecWithContext(workspace, workspaceSize, ctx, iv,
+                authtext, authtextSize, ciphertext, tag, plaintextOut));
+    }
+
+    typedef OTRadioLink::SimpleDecKeyContextCache<contextSize, 2> cache_t;
+    cache_t cache;
+    OTRadioLink::SimpleSecureFrame32or0BodyRXBase::fixed32BTextSize12BNonce16BTagSimpleDec_fn_t &mockDecCached =
+        OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDecCached<cache_t, cache, mockSetup, mockDecWithContext>;
+
+    // True if the 16-byte key appears anywhere in the n bytes at p.
+    bool holds(const uint8_t *const p, const size_t n, const uint8_t *const key)
+    {
+        for(size_t i = 0; i + 16 <= n; ++i) { if(0 == memcmp(p + i, key, 16)) { return(true); } }
+        return(false);
+    }
+
+    // Decode frame in buf with the given decrypt function and key.
+    bool decodeFrame(const uint8_t *buf,
+                     OTRadioLink::SimpleSecureFrame32or0BodyRXBase::fixed32BTextSize12BNonce16BTagSimpleDec_fn_t &d,
+                     const uint8_t *key)
+    {
+        uint8_t ptext[OTRadioLink::OTDecodeData_T::ptextLenMax];
+        OTRadioLink::OTDecodeData_T fd(buf, ptext);
+        if(0 == fd.sfh.decodeHeader(buf, buf[0] + 1)) { return(false); }
+        uint8_t workspace[OTRadioLink::SimpleSecureFrame32or0BodyRXBase::decode_total_scratch_usage_OTAESGCM_3p0 + 16];
+        OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+        OTSFTF::setUpMockRX();
+        return(0 != OTRadioLink::SimpleSecureFrame32or0BodyRXFixedCounter::getInstance().decode(fd, d, sW, key));
+    }
+}
+
+// Check that the cache only does key setup on a miss and evicts LRU.
+TEST(SecureFrameKeyCache, HitsAndMisses)
+{
+    OTSFKCT::cache_t c;
+    EXPECT_EQ(0, c.getSetupCount());
+    const uint8_t *const ctx1 = c.getContext(OTSFKCT::key1, OTSFKCT::mockSetup);
+    ASSERT_NE(nullptr, ctx1);
+    EXPECT_EQ(0, memcmp(OTSFKCT::key1, ctx1, 16));
+    EXPECT_EQ(1, c.getSetupCount());
+    EXPECT_EQ(ctx1, c.getContext(OTSFKCT::key1, OTSFKCT::mockSetup));
+    EXPECT_EQ(1, c.getSetupCount());
+    const uint8_t *const ctx2 = c.getContext(OTSFKCT::key2, OTSFKCT::mockSetup);
+    ASSERT_NE(nullptr, ctx2);
+    EXPECT_NE(ctx1, ctx2);
+    EXPECT_EQ(2, c.getSetupCount());
+    // Both keys fit.
+    EXPECT_EQ(ctx1, c.getContext(OTSFKCT::key1, OTSFKCT::mockSetup));
+    EXPECT_EQ(ctx2, c.getContext(OTSFKCT::key2, OTSFKCT::mockSetup));
+    EXPECT_EQ(2, c.getSetupCount());
+    // A third key evicts the least recently used (key1).
+    uint8_t key3[16];
+    memset(key3, 0x33, sizeof(key3));
+    EXPECT_EQ(ctx1, c.getContext(key3, OTSFKCT::mockSetup));
+    EXPECT_EQ(3, c.getSetupCount());
+    EXPECT_EQ(ctx2, c.getContext(OTSFKCT::key2, OTSFKCT::mockSetup));
+    EXPECT_EQ(3, c.getSetupCount());
+    // clear() forces setup again.
+    c.clear();
+    EXPECT_EQ(0, c.getSetupCount());
+    EXPECT_NE(nullptr, c.getContext(OTSFKCT::key2, OTSFKCT::mockSetup));
+    EXPECT_EQ(1, c.getSetupCount());
+}
+
+// Check that a failed setup is not cached.
+TEST(SecureFrameKeyCache, SetupFailure)
+{
+    OTSFKCT::cache_t c;
+    EXPECT_EQ(nullptr, c.getContext(OTSFKCT::key1, OTSFKCT::mockSetupFail));
+    EXPECT_EQ(nullptr, c.getContext(OTSFKCT::key1, OTSFKCT::mockSetupFail));
+    EXPECT_EQ(2, c.getSetupCount());
+    EXPECT_NE(nullptr, c.getContext(OTSFKCT::key1, OTSFKCT::mockSetup));
+    EXPECT_EQ(nullptr, c.getContext(nullptr, OTSFKCT::mockSetup));
+}
+
+// Check that decode() works through the cached adapter and only sets up
+// the key once.
+TEST(SecureFrameKeyCache, DecodeThroughCache)
+{
+    OTSFKCT::cache.clear();
+    uint8_t buf[64];
+    ASSERT_NE(0, OTSFTF::makeFrame(buf, 1));
+    EXPECT_TRUE(OTSFKCT::decodeFrame(buf, OTSFKCT::mockDecUncached, OTSFKCT::key1));
+    for(int i = 0; i < 10; ++i) {
+        EXPECT_TRUE(OTSFKCT::decodeFrame(buf, OTSFKCT::mockDecCached, OTSFKCT::key1));
+    }
+    EXPECT_EQ(1, OTSFKCT::cache.getSetupCount());
+}
+
+// Check that keys do not linger in RAM once evicted or cleared.
+TEST(SecureFrameKeyCache, WipesKeys)
+{
+    OTSFKCT::cache_t c;
+    const uint8_t *const raw = reinterpret_cast<const uint8_t *>(&c);
+    ASSERT_NE(nullptr, c.getContext(OTSFKCT::key1, OTSFKCT::mockSetup));
+    ASSERT_NE(nullptr, c.getContext(OTSFKCT::key2, OTSFKCT::mockSetup));
+    EXPECT_TRUE(OTSFKCT::holds(raw, sizeof(c), OTSFKCT::key1));
+    // A third key evicts key1, which must then be gone entirely.
+    uint8_t key3[16];
+    memset(key3, 0x33, sizeof(key3));
+    ASSERT_NE(nullptr, c.getContext(key3, OTSFKCT::mockSetup));
+    EXPECT_FALSE(OTSFKCT::holds(raw, sizeof(c), OTSFKCT::key1));
+    EXPECT_TRUE(OTSFKCT::holds(raw, sizeof(c), OTSFKCT::key2));
+    // A failed setup leaves nothing behind either.
+    EXPECT_EQ(nullptr, c.getContext(OTSFKCT::key1, OTSFKCT::mockSetupFail));
+    EXPECT_FALSE(OTSFKCT::holds(raw, sizeof(c), OTSFKCT::key1));
+    // clear() zeroes everything, including the contexts.
+    c.clear();
+    EXPECT_FALSE(OTSFKCT::holds(raw, sizeof(c), OTSFKCT::key2));
+    EXPECT_FALSE(OTSFKCT::holds(raw, sizeof(c), key3));
+    for(size_t i = 0; i < sizeof(c); ++i) {
+        if(0 != raw[i]) {
+            // Only the recency order may be non-zero.
+            EXPECT_LT(raw[i], 2) << i;
+        }
+    }
+}
@@ -0,0 +1,155 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * 48-bit message counter packed form, and the byte-array compare and
+ * add, checked against a simple byte-wise reference.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <gtest/gtest.h>
+#include <OTV0p2Base.h>
+#include <OTRadioLink.h>
+
+
+namespace OTSFMCT
+{
+    typedef OTRadioLink::SimpleSecureFrame32or0BodyRXBase rx_t;
+
+    // Reference add: ripple carry from the LS byte, refusing to roll over.
+    bool refAdd(uint8_t *const counter, const uint8_t delta)
+    {
+        uint8_t tmp[6];
+        memcpy(tmp, counter, 6);
+        unsigned carry = delta;
+        for(int i = 6; (--i >= 0) && (0 != carry); ) {
+            carry += tmp[i];
+            tmp[i] = uint8_t(carry);
+            carry >>= 8;
+        }
+        if(0 != carry) { return(false); }
+        memcpy(counter, tmp, 6);
+        return(true);
+    }
+
+    // Reference compare: sign of memcmp().
+    int refCmp(const uint8_t *const c1, const uint8_t *const c2)
+    {
+        const int r = memcmp(c1, c2, 6);
+        return((r > 0) - (r < 0));
+    }
+
+    // Counter values concentrated around byte boundaries to exercise carries.
+    void randomCounter(uint8_t *const c)
+    {
+        for(int i = 0; i < 6; ++i) {
+            switch(rand() & 3) {
+                case 0: c[i] = 0; break;
+                case 1: c[i] = 0xff; break;
+                default: c[i] = uint8_t(rand()); break;
+            }
+        }
+    }
+}
+
+// Check load and store are inverses, and big-endian.
+TEST(SecureFrameMsgCounter, LoadStore)
+{
+    const uint8_t c[6] = { 0x01, 0x23, 0x45, 0x67, 0x89, 0xab };
+    const uint64_t expected = 0x0123456789abULL;
+    EXPECT_EQ(expected, OTSFMCT::rx_t::msgctr48load(c));
+    uint8_t out[7];
+    out[6] = 0x5a;
+    OTSFMCT::rx_t::msgctr48store(out, expected);
+    EXPECT_EQ(0, memcmp(c, out, 6));
+    // Must not write beyond the counter.
+    EXPECT_EQ(0x5a, out[6]);
+    const uint8_t allFF[6] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+    const uint64_t max = OTSFMCT::rx_t::msgctr48Max;
+    EXPECT_EQ(max, OTSFMCT::rx_t::msgctr48load(allFF));
+}
+
+// Check packed compare and add at the edges.
+TEST(SecureFrameMsgCounter, PackedEdges)
+{
+    typedef OTSFMCT::rx_t::msgctr48_t ctr_t;
+    const ctr_t max = OTSFMCT::rx_t::msgctr48Max;
+    EXPECT_EQ(0, OTSFMCT::rx_t::msgctr48cmp(0, 0));
+    EXPECT_EQ(1, OTSFMCT::rx_t::msgctr48cmp(max, max - 1));
+    EXPECT_EQ(-1, OTSFMCT::rx_t::msgctr48cmp(0, max));
+    ctr_t c = max - 2;
+    EXPECT_TRUE(OTSFMCT::rx_t::msgctr48add(c, 0));
+    EXPECT_EQ(max - 2, c);
+    EXPECT_TRUE(OTSFMCT::rx_t::msgctr48add(c, 2));
+    EXPECT_EQ(max, c);
+    EXPECT_FALSE(OTSFMCT::rx_t::msgctr48add(c, 1));
+    EXPECT_EQ(max, c);
+    c = max - 0xfe;
+    EXPECT_FALSE(OTSFMCT::rx_t::msgctr48add(c, 0xff));
+    EXPECT_EQ(max - 0xfe, c);
+    c = 0xffffffffffULL;
+    EXPECT_TRUE(OTSFMCT::rx_t::msgctr48add(c, 1));
+    EXPECT_EQ(0x10000000000ULL, c);
+}
+
+// Check the byte-array compare and add against the reference over values
+// with many carries and near-overflows.
+TEST(SecureFrameMsgCounter, MatchesReference)
+{
+    srand(42);
+    for(int i = 0; i < 100000; ++i) {
+        uint8_t c1[6], c2[6];
+        OTSFMCT::randomCounter(c1);
+        if(0 == (i & 7)) { memcpy(c2, c1, 6); } else { OTSFMCT::randomCounter(c2); }
+        const int16_t r = OTSFMCT::rx_t::msgcountercmp(c1, c2);
+        EXPECT_EQ(OTSFMCT::refCmp(c1, c2), (r > 0) - (r < 0));
+        const uint8_t delta = uint8_t(rand());
+        uint8_t expected[6];
+        memcpy(expected, c1, 6);
+        const bool ok = OTSFMCT::refAdd(expected, delta);
+        ASSERT_EQ(ok, OTSFMCT::rx_t::msgcounteradd(c1, delta));
+        ASSERT_EQ(0, memcmp(expected, c1, 6));
+    }
+}
+
+// Check that the byte-array add carries all the way into the top byte.
+TEST(SecureFrameMsgCounter, CarryIntoTopByte)
+{
+    const uint8_t before[6] = { 0x00, 0xff, 0xff, 0xff, 0xff, 0xff };
+    const uint8_t plus1[6] = { 0x01, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    const uint8_t plus42[6] = { 0x01, 0x00, 0x00, 0x00, 0x00, 0x29 };
+    uint8_t c[6];
+    memcpy(c, before, 6);
+    EXPECT_TRUE(OTSFMCT::rx_t::msgcounteradd(c, 1));
+    EXPECT_EQ(0, memcmp(plus1, c, 6));
+    memcpy(c, before, 6);
+    EXPECT_TRUE(OTSFMCT::rx_t::msgcounteradd(c, 42));
+    EXPECT_EQ(0, memcmp(plus42, c, 6));
+    const uint8_t before7f[6] = { 0x7f, 0xff, 0xff, 0xff, 0xff, 0xfe };
+    const uint8_t plus2_7f[6] = { 0x80, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    memcpy(c, before7f, 6);
+    EXPECT_TRUE(OTSFMCT::rx_t::msgcounteradd(c, 2));
+    EXPECT_EQ(0, memcmp(plus2_7f, c, 6));
+    // Only all 0xff above the LS byte cannot take the carry.
+    const uint8_t allFF[6] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+    memcpy(c, allFF, 6);
+    EXPECT_FALSE(OTSFMCT::rx_t::msgcounteradd(c, 1));
+    EXPECT_EQ(0, memcmp(allFF, c, 6));
+}
@@ -0,0 +1,216 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * Write-back RX message counter cache.
+ */
+
+#include <stdint.h>
+#include <gtest/gtest.h>
+#include <OTV0p2Base.h>
+#include <OTRadioLink.h>
+
+
+namespace OTSFWBT
+{
+    static constexpr uint8_t nNodes = 2;
+    static constexpr uint8_t ids[nNodes][8] = {
+        { 0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87 },
+        { 0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97 },
+    };
+
+    int16_t findNode(const uint8_t *const ID)
+    {
+        if(nullptr == ID) { return(-1); }
+        for(uint8_t i = 0; i < nNodes; ++i) { if(0 == memcmp(ids[i], ID, 8)) { return(i); } }
+        return(-1);
+    }
+
+    // Stands in for an EEPROM-backed counter store, eg
+    // SimpleSecureFrame32or0BodyRXV0p2, counting persistent writes.
+    class MockCounterStore final : public OTRadioLink::SimpleSecureFrame32or0BodyRXBase
+    {
+    private:
+        virtual int8_t _getNextMatchingNodeID(const uint8_t, const OTRadioLink::SecurableFrameHeader *const, uint8_t *) const override
+            { return(-1); }
+    public:
+        uint8_t counters[nNodes][fullMsgCtrBytes];
+        unsigned long writes;
+        MockCounterStore() { reset(); }
+        void reset() { memset(counters, 0, sizeof(counters)); writes = 0; }
+        virtual bool getLastRXMsgCtr(const uint8_t * const ID, uint8_t *counter) const override
+        {
+            const int16_t i = findNode(ID);
+            if((i < 0) || (nullptr == counter)) { return(false); }
+            memcpy(counter, counters[i], fullMsgCtrBytes);
+            return(true);
+        }
+        virtual bool authAndUpdateRXMsgCtr(const uint8_t *ID, const uint8_t *newCounterValue) override
+        {
+            if(!validateRXMsgCtr(ID, newCounterValue)) { return(false); }
+            memcpy(counters[findNode(ID)], newCounterValue, fullMsgCtrBytes);
+            ++writes;
+            return(true);
+        }
+    };
+
+    class WriteBack final : public OTRadioLink::SimpleSecureFrame32or0BodyRXWriteBack<nNodes, 32>
+    {
+    private:
+        virtual int8_t _getNextMatchingNodeID(const uint8_t, const OTRadioLink::SecurableFrameHeader *const, uint8_t *) const override
+            { return(-1); }
+        virtual int16_t _getNodeIndex(const uint8_t *ID) const override { return(findNode(ID)); }
+    public:
+        explicit WriteBack(OTRadioLink::SimpleSecureFrame32or0BodyRXBase &store)
+            : SimpleSecureFrame32or0BodyRXWriteBack(store) { }
+    };
+
+    // Set counter to the 48-bit value v.
+    void setCounter(uint8_t *const c, uint64_t v)
+    {
+        for(int i = 6; --i >= 0; v >>= 8) { c[i] = uint8_t(v); }
+    }
+
+    // 48-bit counter value.
+    uint64_t ctrValue(const uint8_t *const c)
+    {
+        uint64_t v = 0;
+        for(int i = 0; i < 6; ++i) { v = (v << 8) | c[i]; }
+        return(v);
+    }
+}
+
+// Check what is persisted over 1000 consecutive frames from one node.
+// The store is written only when a frame passes the reserved mark, and then
+// holds exactly that counter plus the step; in between it is untouched and
+// never behind any accepted counter, so losing power at any point is safe.
+TEST(SecureFrameRXWriteBack, PersistedMarkPer1000Frames)
+{
+    static constexpr int nFrames = 1000;
+    static constexpr uint64_t start = 0x20000;
+    OTSFWBT::MockCounterStore store;
+    OTSFWBT::WriteBack wb(store);
+    uint8_t c[6];
+    uint64_t mark = 0;
+    for(int i = 1; i <= nFrames; ++i) {
+        const uint64_t v = start + uint64_t(i);
+        OTSFWBT::setCounter(c, v);
+        const unsigned long w = store.writes;
+        ASSERT_TRUE(wb.authAndUpdateRXMsgCtr(OTSFWBT::ids[0], c));
+        if(v > mark) {
+            mark = v + 32;
+            EXPECT_EQ(w + 1, store.writes) << i;
+        } else {
+            EXPECT_EQ(w, store.writes) << i;
+        }
+        ASSERT_EQ(mark, OTSFWBT::ctrValue(store.counters[0])) << i;
+    }
+    // One reservation per 33 frames (the frame that passes the mark plus 32).
+    EXPECT_EQ((unsigned long)((nFrames + 32) / 33), store.writes);
+    // The other node's persisted counter is untouched.
+    EXPECT_EQ(0U, OTSFWBT::ctrValue(store.counters[1]));
+}
+
+// Check that the cache enforces the same ordering rules as the store.
+TEST(SecureFrameRXWriteBack, RejectsOldAndDuplicateCounters)
+{
+    OTSFWBT::MockCounterStore store;
+    OTSFWBT::WriteBack wb(store);
+    uint8_t c[6];
+    OTSFWBT::setCounter(c, 100);
+    EXPECT_TRUE(wb.authAndUpdateRXMsgCtr(OTSFWBT::ids[0], c));
+    // Duplicate.
+    EXPECT_FALSE(wb.validateRXMsgCtr(OTSFWBT::ids[0], c));
+    EXPECT_FALSE(wb.authAndUpdateRXMsgCtr(OTSFWBT::ids[0], c));
+    // Older, though still within the reservation.
+    OTSFWBT::setCounter(c, 99);
+    EXPECT_FALSE(wb.authAndUpdateRXMsgCtr(OTSFWBT::ids[0], c));
+    // Newer within the reservation: accepted without a store write.
+    const unsigned long w = store.writes;
+    OTSFWBT::setCounter(c, 101);
+    EXPECT_TRUE(wb.authAndUpdateRXMsgCtr(OTSFWBT::ids[0], c));
+    EXPECT_EQ(w, store.writes);
+    uint8_t last[6];
+    EXPECT_TRUE(wb.getLastRXMsgCtr(OTSFWBT::ids[0], last));
+    EXPECT_EQ(0, memcmp(c, last, 6));
+    // Nodes are independent.
+    OTSFWBT::setCounter(c, 1);
+    EXPECT_TRUE(wb.authAndUpdateRXMsgCtr(OTSFWBT::ids[1], c));
+    // Unknown node and bad args.
+    uint8_t unknown[8] = { 0xa0 };
+    EXPECT_FALSE(wb.getLastRXMsgCtr(unknown, last));
+    EXPECT_FALSE(wb.authAndUpdateRXMsgCtr(unknown, c));
+    EXPECT_FALSE(wb.getLastRXMsgCtr(OTSFWBT::ids[0], nullptr));
+    EXPECT_FALSE(wb.getLastRXMsgCtr(nullptr, last));
+}
+
+// Check that frames accepted before a receiver reboot cannot be replayed
+// after it, even though the store was not written for every frame.
+TEST(SecureFrameRXWriteBack, ReplaySafeAcrossReboot)
+{
+    OTSFWBT::MockCounterStore store;
+    uint8_t c[6];
+    {
+        OTSFWBT::WriteBack wb(store);
+        for(int i = 1; i <= 10; ++i) {
+            OTSFWBT::setCounter(c, 1000 + i);
+            ASSERT_TRUE(wb.authAndUpdateRXMsgCtr(OTSFWBT::ids[0], c));
+        }
+        EXPECT_EQ(1UL, store.writes);
+        // Persisted: the first accepted counter plus the step.
+        EXPECT_EQ(1001U + 32, OTSFWBT::ctrValue(store.counters[0]));
+    }
+    // Power loss: the cache is lost with no chance to write anything back,
+    // and a new one starts over the same store.
+    OTSFWBT::WriteBack wb(store);
+    uint8_t last[6];
+    ASSERT_TRUE(wb.getLastRXMsgCtr(OTSFWBT::ids[0], last));
+    EXPECT_EQ(1001U + 32, OTSFWBT::ctrValue(last));
+    // Every previously accepted counter is rejected...
+    for(int i = 1; i <= 10; ++i) {
+        OTSFWBT::setCounter(c, 1000 + i);
+        EXPECT_FALSE(wb.validateRXMsgCtr(OTSFWBT::ids[0], c)) << i;
+    }
+    // ... as is anything within the reservation ...
+    OTSFWBT::setCounter(c, 1001 + 32);
+    EXPECT_FALSE(wb.validateRXMsgCtr(OTSFWBT::ids[0], c));
+    // ... but the sender's counter soon passes it.
+    OTSFWBT::setCounter(c, 1001 + 33);
+    EXPECT_TRUE(wb.authAndUpdateRXMsgCtr(OTSFWBT::ids[0], c));
+}
+
+// Check that a failed store write leaves the cached counter unchanged.
+TEST(SecureFrameRXWriteBack, StoreFailureIsNotCached)
+{
+    OTSFWBT::MockCounterStore store;
+    OTSFWBT::WriteBack wb(store);
+    uint8_t c[6];
+    OTSFWBT::setCounter(c, 10);
+    ASSERT_TRUE(wb.authAndUpdateRXMsgCtr(OTSFWBT::ids[0], c));
+    // Make the store refuse the next reservation.
+    OTSFWBT::setCounter(store.counters[0], 1000);
+    OTSFWBT::setCounter(c, 500);
+    EXPECT_FALSE(wb.authAndUpdateRXMsgCtr(OTSFWBT::ids[0], c));
+    uint8_t last[6], expected[6];
+    OTSFWBT::setCounter(expected, 10);
+    EXPECT_TRUE(wb.getLastRXMsgCtr(OTSFWBT::ids[0], last));
+    EXPECT_EQ(0, memcmp(expected, last, 6));
+    // After invalidation the store's value is picked up.
+    wb.invalidate(0);
+    EXPECT_FALSE(wb.validateRXMsgCtr(OTSFWBT::ids[0], c));
+}
@@ -0,0 +1,257 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * Pre-crypto replay and duplicate filter for secure frames.
+ *
+ * These use the NULL crypto implementations so do not need OTAESGCM.
+ */
+
+#include <stdint.h>
+#include <gtest/gtest.h>
+#include <OTV0p2Base.h>
+#include <OTRadioLink.h>
+#include "SecureFrameTestFixture.h"
+
+
+namespace OTSFRFT
+{
+    // NULL decrypt, counting calls.
+    unsigned nDecrypts;
+    bool countingDec(
+            uint8_t *const workspace, const size_t workspaceSize,
+            const uint8_t *const key, const uint8_t *const iv,
+            const uint8_t *const authtext, const uint8_t authtextSize,
+            const uint8_t *const ciphertext, const uint8_t *const tag,
+            uint8_t *const plaintextOut)
+    {
+        ++nDecrypts;
+        return(OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDec_NULL_IMPL(
+                workspace, workspaceSize, key, iv, authtext, authtextSize,
+                ciphertext, tag, plaintextOut));
+    }
+
+    unsigned nOps;
+    bool countOp(const OTRadioLink::OTDecodeData_T &) { ++nOps; return(true); }
+
+    typedef OTRadioLink::SecureFrameReplayFilter<2, 4> filter_t;
+
+    // RX associated with up to 4 nodes, matched on the header ID prefix,
+    // all holding OTSFTF::oldCounter. Never updates its counters, so only
+    // the filter stops replays reaching the decrypt.
+    class TableRX final : public OTRadioLink::SimpleSecureFrame32or0BodyRXBase
+    {
+    private:
+        uint8_t ids[4][8];
+        uint8_t nIDs = 0;
+        virtual int8_t _getNextMatchingNodeID(const uint8_t index, const OTRadioLink::SecurableFrameHeader *const sfh, uint8_t *nodeID) const override
+        {
+            for(uint8_t i = index; i < nIDs; ++i) {
+                if(0 != memcmp(ids[i], sfh->id, sfh->getIl())) { continue; }
+                memcpy(nodeID, ids[i], 8);
+                return(int8_t(i));
+            }
+            return(-1);
+        }
+    public:
+        static TableRX &getInstance()
+        {
+            static TableRX instance;
+            return(instance);
+        }
+        void clear() { nIDs = 0; }
+        void add(const uint8_t *const id) { if(nIDs < 4) { memcpy(ids[nIDs++], id, 8); } }
+        virtual bool getLastRXMsgCtr(const uint8_t * const, uint8_t *counter) const override
+        {
+            memcpy(counter, OTSFTF::oldCounter, fullMsgCtrBytes);
+            return(true);
+        }
+        virtual bool authAndUpdateRXMsgCtr(const uint8_t *, const uint8_t *) override { return(true); }
+    };
+
+    bool handleFrame(const uint8_t *const buf)
+    {
+        uint8_t workspace[
+            OTRadioLink::SimpleSecureFrame32or0BodyRXBase::decode_total_scratch_usage_OTAESGCM_3p0 +
+            OTRadioLink::decodeAndHandleOTSecureOFrame_scratch_usage +
+            OTRadioLink::authAndDecodeOTSecurableFrameWithWorkspace_scratch_usage + 16];
+        OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+        return(OTRadioLink::decodeAndHandleOTSecureOFrame<
+                TableRX, countingDec, OTSFTF::getKey, countOp, OTRadioLink::nullFrameOperation,
+                filter_t>(buf + 1, sW));
+    }
+
+    void reset()
+    {
+        TableRX::getInstance().clear();
+        TableRX::getInstance().add(OTSFTF::id);
+        filter_t::getInstance().clear();
+        filter_t::getInstance().resetStats();
+        nDecrypts = 0;
+        nOps = 0;
+    }
+
+    // Frame data as decodeAndHandleOTSecureOFrame() presents it to the
+    // filter, with the full sender ID filled in as after a good decode.
+    struct Frame
+    {
+        uint8_t buf[64];
+        uint8_t ptext[OTRadioLink::OTDecodeData_T::ptextLenMax];
+        OTRadioLink::OTDecodeData_T fd;
+        Frame(const uint8_t ctrLSB, const uint8_t *const sender) : fd(buf, ptext)
+        {
+            OTSFTF::makeFrame(buf, ctrLSB, sender);
+            fd.sfh.decodeHeader(buf, buf[0] + 1);
+            memcpy(fd.id, sender, sizeof(fd.id));
+        }
+    };
+}
+
+// Check that duplicates and stale counters are dropped before decryption
+// and that newer frames still get through.
+TEST(SecureFrameReplayFilter, DropsBeforeCrypto)
+{
+    OTSFRFT::reset();
+    OTSFRFT::filter_t &f = OTSFRFT::filter_t::getInstance();
+    uint8_t f1[64], f2[64], f3[64];
+    OTSFTF::makeFrame(f1, 1);
+    OTSFTF::makeFrame(f2, 2);
+    OTSFTF::makeFrame(f3, 3);
+
+    EXPECT_TRUE(OTSFRFT::handleFrame(f1));
+    EXPECT_EQ(1U, OTSFRFT::nDecrypts);
+    EXPECT_EQ(1U, OTSFRFT::nOps);
+    // Exact duplicate.
+    EXPECT_TRUE(OTSFRFT::handleFrame(f1));
+    EXPECT_EQ(1U, OTSFRFT::nDecrypts);
+    EXPECT_EQ(1U, OTSFRFT::nOps);
+    EXPECT_EQ(1, f.getDuplicateCount());
+    // Newer.
+    EXPECT_TRUE(OTSFRFT::handleFrame(f2));
+    EXPECT_EQ(2U, OTSFRFT::nDecrypts);
+    EXPECT_EQ(2U, OTSFRFT::nOps);
+    // Older than already accepted, with a different tail: stale.
+    f1[f1[0] - 1] ^= 1;
+    EXPECT_TRUE(OTSFRFT::handleFrame(f1));
+    EXPECT_EQ(2U, OTSFRFT::nDecrypts);
+    EXPECT_EQ(1, f.getStaleCount());
+    EXPECT_TRUE(OTSFRFT::handleFrame(f3));
+    EXPECT_EQ(3U, OTSFRFT::nOps);
+    EXPECT_EQ(3, f.getPassedCount());
+    // Non-secure and malformed frames are not the filter's business.
+    const uint8_t bad[] = { 5, 'O', 1, 2, 3, 4 };
+    EXPECT_FALSE(OTSFRFT::handleFrame(bad));
+    EXPECT_EQ(3, f.getPassedCount());
+}
+
+// Check that a frame failing authentication is not recorded,
+// so cannot be used to block the genuine frame.
+TEST(SecureFrameReplayFilter, ForgeryNotRecorded)
+{
+    OTSFRFT::reset();
+    OTSFRFT::Frame f(5, OTSFTF::id);
+    const uint8_t *const genuine = f.buf;
+    uint8_t forged[64];
+    memcpy(forged, genuine, sizeof(forged));
+    // First tag byte (after the 6 byte counter) is checked by the NULL decrypt.
+    forged[f.fd.sfh.getTrailerOffset() + 6] ^= 1;
+    EXPECT_TRUE(OTSFRFT::handleFrame(forged));
+    EXPECT_EQ(0U, OTSFRFT::nOps);
+    EXPECT_TRUE(OTSFRFT::handleFrame(genuine));
+    EXPECT_EQ(1U, OTSFRFT::nOps);
+}
+
+// Check node eviction, duplicate detection for evicted nodes,
+// and that a prefix shared by several associations never marks a frame
+// stale, as it may be from any of them.
+TEST(SecureFrameReplayFilter, NodeWindow)
+{
+    OTSFRFT::filter_t f;
+    const uint8_t a[8] = { 0x81, 1, 2, 3, 4, 5, 6, 7 };
+    const uint8_t b[8] = { 0x82, 1, 2, 3, 4, 5, 6, 7 };
+    const uint8_t c[8] = { 0x83, 1, 2, 3, 4, 5, 6, 7 };
+    // Same 4-byte header prefix as a.
+    const uint8_t a2[8] = { 0x81, 1, 2, 3, 0xf4, 0xf5, 0xf6, 0xf7 };
+    // Associations without and with a2.
+    OTSFRFT::TableRX rxUnique, rxShared;
+    rxUnique.add(a); rxUnique.add(b); rxUnique.add(c);
+    rxShared.add(a); rxShared.add(a2); rxShared.add(b); rxShared.add(c);
+
+    OTSFRFT::Frame a10(10, a), a5(5, a), b1(1, b), c1(1, c), a2_6(6, a2);
+    f.recordAccepted(a10.fd);
+    EXPECT_TRUE(f.isReplay(a5.fd, rxUnique));
+    // With a2 associated, frames with a's prefix may be from a2.
+    EXPECT_FALSE(f.isReplay(a5.fd, rxShared));
+    EXPECT_FALSE(f.isReplay(a2_6.fd, rxShared));
+    // b then c evict a (the window holds 2 nodes).
+    f.recordAccepted(b1.fd);
+    f.recordAccepted(c1.fd);
+    EXPECT_FALSE(f.isReplay(a5.fd, rxUnique));
+    // a10 is still in the tail window (4 entries), whatever the prefix.
+    EXPECT_TRUE(f.isReplay(a10.fd, rxShared));
+    EXPECT_TRUE(f.isReplay(b1.fd, rxUnique));
+    EXPECT_EQ(2, f.getDuplicateCount());
+    EXPECT_EQ(1, f.getStaleCount());
+    EXPECT_EQ(3, f.getPassedCount());
+    // Refreshing b keeps it over c when a is recorded again.
+    OTSFRFT::Frame b2(2, b), b1x(1, b);
+    f.recordAccepted(b2.fd);
+    f.recordAccepted(a10.fd);
+    b1x.buf[b1x.buf[0] - 1] ^= 1; // Change tail: not an exact duplicate.
+    EXPECT_TRUE(f.isReplay(b1x.fd, rxShared));
+    EXPECT_EQ(2, f.getStaleCount());
+    f.clear();
+    EXPECT_FALSE(f.isReplay(a10.fd, rxUnique));
+}
+
+// Check end to end that a frame from a node sharing its prefix with one
+// already heard, with a lower counter, still reaches the decrypt.
+TEST(SecureFrameReplayFilter, SharedPrefixReachesDecode)
+{
+    OTSFRFT::reset();
+    uint8_t other[8];
+    memcpy(other, OTSFTF::id, 8);
+    other[5] ^= 0xff;
+    OTSFRFT::TableRX::getInstance().add(other);
+    uint8_t f1[64], f2[64];
+    OTSFTF::makeFrame(f1, 9);
+    OTSFTF::makeFrame(f2, 5, other);
+    EXPECT_TRUE(OTSFRFT::handleFrame(f1));
+    EXPECT_EQ(1U, OTSFRFT::nDecrypts);
+    EXPECT_TRUE(OTSFRFT::handleFrame(f2));
+    EXPECT_EQ(2U, OTSFRFT::nDecrypts);
+    EXPECT_EQ(0, OTSFRFT::filter_t::getInstance().getStaleCount());
+}
+
+// Relay-heavy traffic: every frame is heard directly and via two relays.
+// Only the first copy of each should be decrypted.
+TEST(SecureFrameReplayFilter, RelayHeavyTraffic)
+{
+    static constexpr uint8_t nFrames = 100;
+    static constexpr uint8_t copies = 3;
+    OTSFRFT::reset();
+    for(uint8_t i = 1; i <= nFrames; ++i) {
+        uint8_t buf[64];
+        OTSFTF::makeFrame(buf, i);
+        for(uint8_t c = 0; c < copies; ++c) { OTSFRFT::handleFrame(buf); }
+    }
+    const OTSFRFT::filter_t &f = OTSFRFT::filter_t::getInstance();
+    EXPECT_EQ(nFrames, OTSFRFT::nOps);
+    EXPECT_EQ(nFrames, OTSFRFT::nDecrypts);
+    EXPECT_EQ(nFrames * (copies - 1), f.getDuplicateCount() + f.getStaleCount());
+}
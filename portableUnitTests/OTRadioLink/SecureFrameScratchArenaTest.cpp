@@ -0,0 +1,239 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * Scratch space use of the secure frame decode stack, measured with
+ * OTV0P2BASE::ScratchSpaceArena.
+ *
+ * Uses the portable AES-GCM so does not need OTAESGCM; the decryption
+ * function's workspace comes on top of the stack's own use, as the
+ * published totals exclude it.
+ *
+ * Only built when OTV0P2BASE_SCRATCH_ARENA is defined (meson -Dscratch_arena=true).
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <gtest/gtest.h>
+#include <OTV0p2Base.h>
+#include <OTRadioLink.h>
+#include "SecureFrameTestFixture.h"
+
+#ifdef OTV0P2BASE_SCRATCH_ARENA
+
+namespace OTSFSAT
+{
+    bool decoded;
+    bool noteDecoded(const OTRadioLink::OTDecodeData_T &) { decoded = true; return(true); }
+
+    // Encode a secure 'O' frame from OTSFTF::id with a maximum-length body,
+    // with the portable AES-GCM; returns the encoded length, 0 on failure.
+    uint8_t makeFullFrame(uint8_t *const buf)
+    {
+        uint8_t iv[12];
+        memcpy(iv, OTSFTF::id, 6);
+        memcpy(iv + 6, OTSFTF::oldCounter, 6);
+        ++iv[11];
+        uint8_t body[32];
+        memset(body, '}', sizeof(body));
+        memcpy(body, OTSFTF::valveBody, sizeof(OTSFTF::valveBody));
+        OTRadioLink::OTEncodeData_T fd(body, sizeof(body), buf, 64);
+        fd.ptextLen = OTRadioLink::OTDecodeData_T::ptextLenMax;
+        fd.fType = OTRadioLink::FTS_BasicSensorOrValve;
+        uint8_t key[16];
+        OTSFTF::getKey(key);
+        uint8_t workspace[OTRadioLink::SimpleSecureFrame32or0BodyTXBase::encodeRaw_total_scratch_usage_OTAESGCM_2p0 +
+                          OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleWorkspace_AESGCM_IMPL];
+        OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+        return(OTRadioLink::SimpleSecureFrame32or0BodyTXBase::encodeRaw(
+                fd, OTSFTF::id, 4, iv, OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleEnc_AESGCM_IMPL, sW, key));
+    }
+}
+
+// Check the arena alignment and recording on its own.
+TEST(ScratchSpaceArena, Basics)
+{
+    uint8_t buf[67];
+    // Deliberately misaligned start.
+    uint8_t *const start = (0 == (uintptr_t(buf) & 3)) ? buf + 1 : buf;
+    OTV0P2BASE::ScratchSpaceArena arena(start, 64);
+    OTV0P2BASE::ScratchSpaceL root = arena.getSpace();
+    EXPECT_EQ(0U, uintptr_t(root.buf) & (OTV0P2BASE::ScratchSpaceArena::alignment - 1));
+    EXPECT_EQ(64 - size_t(root.buf - start), root.bufsize);
+    EXPECT_EQ(root.bufsize, arena.getSize());
+    EXPECT_EQ(0U, arena.getTouchedHighWater());
+    {
+        OTV0P2BASE::ScratchSpaceL sub(root, 8, 1);
+        OTV0P2BASE::ScratchSpaceL subsub(sub, 3, 2);
+        subsub.noteUse(3, 4);
+        subsub.buf[4] = 0;
+    }
+    EXPECT_TRUE(arena.seen(1));
+    EXPECT_FALSE(arena.seen(4));
+    EXPECT_EQ(8U, arena.getSiteHighWater(1));
+    EXPECT_EQ(11U, arena.getSiteHighWater(2));
+    EXPECT_EQ(15U, arena.getSiteHighWater(3));
+    EXPECT_EQ(root.bufsize - 11, arena.getSiteOffered(3));
+    EXPECT_EQ(15U, arena.getHighWater());
+    EXPECT_EQ(16U, arena.getTouchedHighWater());
+    // Sub-spaces at offsets 8 and 11; the latter is misaligned.
+    EXPECT_EQ(1U, arena.getMisalignedCount());
+    // Spaces not from an arena are not recorded, nor out-of-range sites.
+    uint8_t other[8];
+    OTV0P2BASE::ScratchSpaceL plain(other, sizeof(other));
+    OTV0P2BASE::ScratchSpaceL plainSub(plain, 2, 5);
+    EXPECT_FALSE(arena.seen(5));
+    root.noteUse(OTV0P2BASE::ScratchSpaceArena::maxSites, 60);
+    EXPECT_EQ(15U, arena.getHighWater());
+    arena.reset();
+    EXPECT_FALSE(arena.seen(1));
+    EXPECT_EQ(0U, arena.getTouchedHighWater());
+    // Unusable arena.
+    {
+        OTV0P2BASE::ScratchSpaceArena none(NULL, 64);
+        EXPECT_EQ(0U, none.getSize());
+        EXPECT_EQ(NULL, none.getSpace().buf);
+    }
+    // Sizes round up to keep sub-spaces aligned.
+    EXPECT_EQ(0U, OTV0P2BASE::ScratchSpaceL::alignedSize(0));
+    const size_t alignment = OTV0P2BASE::ScratchSpaceL::alignment;
+    EXPECT_EQ(alignment, OTV0P2BASE::ScratchSpaceL::alignedSize(1));
+    EXPECT_EQ(16U, OTV0P2BASE::ScratchSpaceL::alignedSize(14));
+    EXPECT_EQ(32U, OTV0P2BASE::ScratchSpaceL::alignedSize(32));
+}
+
+// Check that only the newest arena on a thread records, and only its own spaces.
+TEST(ScratchSpaceArena, Nesting)
+{
+    EXPECT_EQ(NULL, OTV0P2BASE::ScratchSpaceArena::getCurrent());
+    static uint8_t outerBuf[32], innerBuf[32];
+    OTV0P2BASE::ScratchSpaceArena outer(outerBuf, sizeof(outerBuf));
+    EXPECT_EQ(&outer, OTV0P2BASE::ScratchSpaceArena::getCurrent());
+    const OTV0P2BASE::ScratchSpaceL outerRoot = outer.getSpace();
+    {
+        OTV0P2BASE::ScratchSpaceArena inner(innerBuf, sizeof(innerBuf));
+        EXPECT_EQ(&inner, OTV0P2BASE::ScratchSpaceArena::getCurrent());
+        OTV0P2BASE::ScratchSpaceL(inner.getSpace(), 4, 1);
+        OTV0P2BASE::ScratchSpaceL(outerRoot, 4, 2);
+        EXPECT_TRUE(inner.seen(1));
+        EXPECT_FALSE(inner.seen(2));
+        EXPECT_FALSE(outer.seen(2));
+    }
+    EXPECT_EQ(&outer, OTV0P2BASE::ScratchSpaceArena::getCurrent());
+    OTV0P2BASE::ScratchSpaceL(outerRoot, 4, 2);
+    EXPECT_TRUE(outer.seen(2));
+}
+
+// Measure what the secure 'O' frame RX path really uses of its scratch,
+// and check that it matches the published per-level reservations.
+// Decodes a maximum-length body with the portable AES-GCM so that every
+// level, and the decryption function, does its full work.
+TEST(ScratchSpaceArena, SecureFrameDecodeStack)
+{
+    OTSFTF::setUpMockRX();
+
+    typedef OTRadioLink::SimpleSecureFrame32or0BodyRXBase rxb_t;
+    static constexpr size_t published =
+        OTRadioLink::decodeAndHandleOTSecureOFrame_scratch_usage +
+        OTRadioLink::authAndDecodeOTSecurableFrameWithWorkspace_scratch_usage +
+        rxb_t::decode_total_scratch_usage_OTAESGCM_3p0;
+    static constexpr size_t decryptWorkspace = OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleWorkspace_AESGCM_IMPL;
+    static uint8_t workspace[published + decryptWorkspace + 8];
+    OTV0P2BASE::ScratchSpaceArena arena(workspace, sizeof(workspace));
+
+    uint8_t frame[64];
+    ASSERT_NE(0, OTSFSAT::makeFullFrame(frame));
+    OTV0P2BASE::ScratchSpaceL sW = arena.getSpace();
+    OTSFSAT::decoded = false;
+    ASSERT_TRUE((OTRadioLink::decodeAndHandleOTSecureOFrame<
+            OTRadioLink::SimpleSecureFrame32or0BodyRXFixedCounter,
+            OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDec_AESGCM_IMPL,
+            OTSFTF::getKey, OTSFSAT::noteDecoded>(frame + 1, sW)));
+    ASSERT_TRUE(OTSFSAT::decoded);
+
+    // Each level keeps exactly its published reservation, in order.
+    // The decrypted body is the first thing carved from the caller's space.
+    size_t expected = OTRadioLink::decodeAndHandleOTSecureOFrame_scratch_usage;
+    EXPECT_EQ(expected, arena.getSiteHighWater(OTRadioLink::SCRATCH_SITE_decodeAndHandleOTSecureOFrame));
+    expected += OTRadioLink::authAndDecodeOTSecurableFrameWithWorkspace_scratch_usage;
+    EXPECT_EQ(expected, arena.getSiteHighWater(OTRadioLink::SCRATCH_SITE_authAndDecodeOTSecurableFrame));
+    expected += rxb_t::decode_scratch_usage;
+    EXPECT_EQ(expected, arena.getSiteHighWater(OTRadioLink::SCRATCH_SITE_decode));
+    // (_decodeFromID() is not public: its share is what is left of decode()'s total.)
+    static constexpr size_t decodeFromID_scratch_usage =
+        rxb_t::decode_total_scratch_usage_OTAESGCM_3p0 - rxb_t::decode_scratch_usage -
+        rxb_t::decodeRaw_total_scratch_usage_OTAESGCM_3p0;
+    expected += decodeFromID_scratch_usage;
+    EXPECT_EQ(expected, arena.getSiteHighWater(OTRadioLink::SCRATCH_SITE__decodeFromID));
+    expected += rxb_t::decodeRaw_scratch_usage;
+    EXPECT_EQ(expected, arena.getSiteHighWater(OTRadioLink::SCRATCH_SITE_decodeRaw));
+    EXPECT_EQ(expected, arena.getSiteHighWater(OTRadioLink::SCRATCH_SITE_decrypt));
+    EXPECT_EQ(expected, arena.getHighWater());
+    // The published total covers the stack's own use only;
+    // whatever is left over is offered to the decryption function.
+    EXPECT_EQ(published, expected);
+    EXPECT_EQ(arena.getSize() - expected, arena.getSiteOffered(OTRadioLink::SCRATCH_SITE_decrypt));
+
+    // Each level writes all of its reservation, so none can shrink.
+    EXPECT_EQ(size_t(OTRadioLink::decodeAndHandleOTSecureOFrame_scratch_usage),
+              arena.getSiteTouched(OTRadioLink::SCRATCH_SITE_decodeAndHandleOTSecureOFrame));
+    EXPECT_EQ(size_t(OTRadioLink::authAndDecodeOTSecurableFrameWithWorkspace_scratch_usage),
+              arena.getSiteTouched(OTRadioLink::SCRATCH_SITE_authAndDecodeOTSecurableFrame));
+    EXPECT_EQ(size_t(rxb_t::decode_scratch_usage), arena.getSiteTouched(OTRadioLink::SCRATCH_SITE_decode));
+    EXPECT_EQ(decodeFromID_scratch_usage, arena.getSiteTouched(OTRadioLink::SCRATCH_SITE__decodeFromID));
+    EXPECT_EQ(size_t(rxb_t::decodeRaw_scratch_usage), arena.getSiteTouched(OTRadioLink::SCRATCH_SITE_decodeRaw));
+    // Nothing is written beyond the stack's own reservations
+    // and the decryption function's published workspace.
+    EXPECT_LE(arena.getTouchedHighWater(), published + decryptWorkspace);
+    EXPECT_LT(published, arena.getTouchedHighWater());
+}
+
+// Check that decodeBatch() keeps the sub-space for decode() aligned
+// whatever the key context size.
+TEST(ScratchSpaceArena, DecodeBatchAlignment)
+{
+    OTSFTF::setUpMockRX();
+    // Not a multiple of any alignment; the NULL setup fills the first 16.
+    static constexpr size_t keyContextSize = 17;
+    static uint8_t workspace[
+        OTV0P2BASE::ScratchSpaceL::alignedSize(keyContextSize) +
+        OTRadioLink::SimpleSecureFrame32or0BodyRXBase::decodeBatch_total_scratch_usage_OTAESGCM_3p0 + 8];
+    OTV0P2BASE::ScratchSpaceArena arena(workspace, sizeof(workspace));
+    uint8_t frame[64];
+    uint8_t ptext[OTRadioLink::OTDecodeData_T::ptextLenMax];
+    OTSFTF::makeFrame(frame, 1);
+    OTRadioLink::OTDecodeData_T fd(frame, ptext);
+    ASSERT_NE(0, fd.sfh.decodeHeader(frame, frame[0] + 1));
+    OTRadioLink::OTDecodeData_T *const fds[1] = { &fd };
+    uint8_t key[16];
+    OTSFTF::getKey(key);
+    OTV0P2BASE::ScratchSpaceL sW = arena.getSpace();
+    EXPECT_EQ(1, OTRadioLink::SimpleSecureFrame32or0BodyRXFixedCounter::getInstance().decodeBatch(
+        fds, 1,
+        OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleKeySetup_NULL_IMPL,
+        OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDec_NULL_IMPL,
+        keyContextSize, sW, key, NULL));
+    // decode()'s own space starts just after the rounded-up key context.
+    // (The byte buffers below it are packed, so may be misaligned.)
+    const size_t decodeStart = arena.getSiteHighWater(OTRadioLink::SCRATCH_SITE_decode) -
+                               OTRadioLink::SimpleSecureFrame32or0BodyRXBase::decode_scratch_usage;
+    EXPECT_EQ(OTV0P2BASE::ScratchSpaceL::alignedSize(keyContextSize), decodeStart);
+    EXPECT_EQ(0U, decodeStart % OTV0P2BASE::ScratchSpaceL::alignment);
+}
+
+#endif // OTV0P2BASE_SCRATCH_ARENA
@@ -0,0 +1,307 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * Hot-sender session cache for secure RX.
+ *
+ * Uses the NULL crypto so does not need OTAESGCM.
+ */
+
+#include <stdint.h>
+#include <gtest/gtest.h>
+#include <OTV0p2Base.h>
+#include <OTRadioLink.h>
+#include "SecureFrameTestFixture.h"
+
+
+namespace OTSFSCT
+{
+    static constexpr uint8_t maxNodes = 16;
+    // On-air ID prefix length.
+    static constexpr uint8_t il = 4;
+
+    // Node k; nodes 0 and 1 share a prefix.
+    void getNodeID(const uint8_t k, uint8_t *const id)
+    {
+        const uint8_t base[8] = { 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88 };
+        memcpy(id, base, 8);
+        if(k > 1) { id[3] = uint8_t(0x90 + k); }
+        id[5] = uint8_t(0xa0 + k);
+    }
+
+    // Stands in for the EEPROM association table and counters,
+    // eg SimpleSecureFrame32or0BodyRXV0p2, counting slow accesses.
+    class MockStore final : public OTRadioLink::SimpleSecureFrame32or0BodyRXBase
+    {
+    private:
+        virtual int8_t _getNextMatchingNodeID(const uint8_t, const OTRadioLink::SecurableFrameHeader *const, uint8_t *) const override
+            { return(-1); }
+    public:
+        uint8_t n;
+        // Node associated at each index.
+        uint8_t nodeAt[maxNodes];
+        // Counters by association index.
+        uint8_t counters[maxNodes][fullMsgCtrBytes];
+        // Bumped on each association change.
+        uint8_t generation;
+        mutable unsigned long tableScans;
+        mutable unsigned long counterReads;
+        unsigned long indexedWrites;
+        bool failWrites;
+        explicit MockStore(const uint8_t _n) : n(_n), generation(0), tableScans(0), counterReads(0), indexedWrites(0), failWrites(false)
+        {
+            for(uint8_t i = 0; i < maxNodes; ++i) { nodeAt[i] = i; }
+            memset(counters, 0, sizeof(counters));
+        }
+        // Scan associations in order.
+        int8_t find(uint8_t index, const uint8_t *const prefix, const uint8_t len, uint8_t *const nodeID) const
+        {
+            ++tableScans;
+            for( ; index < n; ++index) {
+                uint8_t id[8];
+                getNodeID(nodeAt[index], id);
+                if(0 == memcmp(id, prefix, len)) {
+                    if(nullptr != nodeID) { memcpy(nodeID, id, 8); }
+                    return(int8_t(index));
+                }
+            }
+            return(-1);
+        }
+        virtual bool getLastRXMsgCtr(const uint8_t * const ID, uint8_t *counter) const override
+        {
+            ++counterReads;
+            const int8_t i = (nullptr == ID) ? -1 : find(0, ID, 8, nullptr);
+            if((i < 0) || (nullptr == counter)) { return(false); }
+            memcpy(counter, counters[i], fullMsgCtrBytes);
+            return(true);
+        }
+        virtual bool authAndUpdateRXMsgCtr(const uint8_t *ID, const uint8_t *newCounterValue) override
+        {
+            if(failWrites || !validateRXMsgCtr(ID, newCounterValue)) { return(false); }
+            memcpy(counters[find(0, ID, 8, nullptr)], newCounterValue, fullMsgCtrBytes);
+            return(true);
+        }
+        // Write by index without lookup or checks.
+        bool updateAt(const int8_t index, const uint8_t *const newCounterValue)
+        {
+            if(failWrites || (index < 0) || (index >= n)) { return(false); }
+            ++indexedWrites;
+            memcpy(counters[index], newCounterValue, fullMsgCtrBytes);
+            return(true);
+        }
+        // Reassociate nodes a and b in each other's slots,
+        // resetting their counters as a fresh association does.
+        void swap(const uint8_t a, const uint8_t b)
+        {
+            const uint8_t t = nodeAt[a]; nodeAt[a] = nodeAt[b]; nodeAt[b] = t;
+            memset(counters[a], 0, fullMsgCtrBytes);
+            memset(counters[b], 0, fullMsgCtrBytes);
+            ++generation;
+        }
+    };
+
+    template<uint8_t cacheSize>
+    class CachedRX final : public OTRadioLink::SimpleSecureFrame32or0BodyRXSessionCache<cacheSize>
+    {
+    private:
+        MockStore &table;
+        virtual int8_t _getNextMatchingNodeIDFromTable(const uint8_t index, const uint8_t *const prefix, const uint8_t len, uint8_t *const nodeID) const override
+            { return(table.find(index, prefix, len, nodeID)); }
+        virtual uint8_t _getAssociationsGeneration() const override { return(table.generation); }
+        virtual bool _writeRXMsgCtr(const int8_t index, const uint8_t *, const uint8_t *const newCounterValue) override
+            { return(table.updateAt(index, newCounterValue)); }
+    public:
+        explicit CachedRX(MockStore &store)
+            : OTRadioLink::SimpleSecureFrame32or0BodyRXSessionCache<cacheSize>(store), table(store) { }
+    };
+
+    // Encode a secure 'O' frame from node k with message counter ctr.
+    void makeFrame(uint8_t *const buf, const uint8_t k, const uint32_t ctr)
+    {
+        uint8_t id[8];
+        getNodeID(k, id);
+        OTSFTF::makeFrameFrom(buf, id, ctr, il);
+    }
+
+    // Decode frame in buf with rx, returning true if successful.
+    bool decode(OTRadioLink::SimpleSecureFrame32or0BodyRXBase &rx, const uint8_t *const buf, const bool firstIDMatchOnly = true)
+    {
+        uint8_t ptext[OTRadioLink::OTDecodeData_T::ptextLenMax];
+        OTRadioLink::OTDecodeData_T fd(buf, ptext);
+        if(0 == fd.sfh.decodeHeader(buf, buf[0] + 1)) { return(false); }
+        uint8_t workspace[OTRadioLink::SimpleSecureFrame32or0BodyRXBase::decode_total_scratch_usage_OTAESGCM_3p0 + 16];
+        OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+        const uint8_t key[16] = {};
+        return(0 != rx.decode(fd, OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleDec_NULL_IMPL, sW, key, firstIDMatchOnly));
+    }
+}
+
+// Check that a repeat sender needs no table scan or counter read before
+// decryption, and that replays are still rejected.
+TEST(SecureFrameSessionCache, RepeatSender)
+{
+    OTSFSCT::MockStore store(8);
+    OTSFSCT::CachedRX<4> rx(store);
+    uint8_t buf[64];
+    OTSFSCT::makeFrame(buf, 3, 1);
+    ASSERT_TRUE(OTSFSCT::decode(rx, buf));
+    EXPECT_FALSE(OTSFSCT::decode(rx, buf));
+    EXPECT_EQ(1U, rx.getStats().idMisses);
+    EXPECT_EQ(1U, rx.getStats().ctrMisses);
+    const unsigned long counterReads = store.counterReads;
+    const unsigned long tableScans = store.tableScans;
+    const unsigned long indexedWrites = store.indexedWrites;
+    for(uint32_t c = 2; c < 12; ++c) {
+        OTSFSCT::makeFrame(buf, 3, c);
+        ASSERT_TRUE(OTSFSCT::decode(rx, buf));
+    }
+    EXPECT_EQ(1U, rx.getStats().idMisses);
+    EXPECT_EQ(1U, rx.getStats().ctrMisses);
+    // Counters are written through by cached index, without store lookups.
+    EXPECT_EQ(0U, store.counterReads - counterReads);
+    EXPECT_EQ(0U, store.tableScans - tableScans);
+    EXPECT_EQ(10U, store.indexedWrites - indexedWrites);
+    EXPECT_EQ(11, store.counters[3][5]);
+    // Old counter rejected from the cache.
+    OTSFSCT::makeFrame(buf, 3, 5);
+    EXPECT_FALSE(OTSFSCT::decode(rx, buf));
+    // A failed store update is not reflected in the cache.
+    store.failWrites = true;
+    OTSFSCT::makeFrame(buf, 3, 20);
+    EXPECT_FALSE(OTSFSCT::decode(rx, buf));
+    store.failWrites = false;
+    uint8_t id[8], c[6];
+    OTSFSCT::getNodeID(3, id);
+    ASSERT_TRUE(rx.getLastRXMsgCtr(id, c));
+    EXPECT_EQ(11, c[5]);
+    OTSFSCT::makeFrame(buf, 3, 20);
+    EXPECT_TRUE(OTSFSCT::decode(rx, buf));
+}
+
+// Check that senders sharing a prefix are resolved correctly, and that the
+// least recently used session is evicted.
+TEST(SecureFrameSessionCache, PrefixesAndEviction)
+{
+    OTSFSCT::MockStore store(8);
+    OTSFSCT::CachedRX<2> rx(store);
+    uint8_t buf[64];
+    // Node 1 shares node 0's prefix so is only found when not restricted to
+    // the first match, including once node 0's session is cached.
+    OTSFSCT::makeFrame(buf, 0, 1);
+    ASSERT_TRUE(OTSFSCT::decode(rx, buf));
+    OTSFSCT::makeFrame(buf, 1, 1);
+    EXPECT_FALSE(OTSFSCT::decode(rx, buf));
+    EXPECT_TRUE(OTSFSCT::decode(rx, buf, false));
+    OTSFSCT::makeFrame(buf, 1, 2);
+    EXPECT_TRUE(OTSFSCT::decode(rx, buf, false));
+    OTSFSCT::makeFrame(buf, 0, 2);
+    EXPECT_TRUE(OTSFSCT::decode(rx, buf, false));
+    // A third sender evicts the least recent (node 1)...
+    OTSFSCT::makeFrame(buf, 5, 1);
+    ASSERT_TRUE(OTSFSCT::decode(rx, buf));
+    rx.resetStats();
+    OTSFSCT::makeFrame(buf, 0, 3);
+    ASSERT_TRUE(OTSFSCT::decode(rx, buf));
+    EXPECT_EQ(0U, rx.getStats().idMisses);
+    EXPECT_EQ(0U, rx.getStats().ctrMisses);
+    // ... which is then reloaded from the store.
+    OTSFSCT::makeFrame(buf, 1, 2);
+    EXPECT_FALSE(OTSFSCT::decode(rx, buf, false));
+    OTSFSCT::makeFrame(buf, 1, 3);
+    EXPECT_TRUE(OTSFSCT::decode(rx, buf, false));
+    EXPECT_NE(0U, rx.getStats().ctrMisses);
+    // Forgetting everything still leaves the stored counters in force.
+    rx.invalidateAll();
+    EXPECT_FALSE(OTSFSCT::decode(rx, buf, false));
+}
+
+// Check that changing the associations drops cached indices and counters.
+TEST(SecureFrameSessionCache, AssociationChange)
+{
+    OTSFSCT::MockStore store(8);
+    OTSFSCT::CachedRX<4> rx(store);
+    uint8_t buf[64];
+    OTSFSCT::makeFrame(buf, 3, 5);
+    ASSERT_TRUE(OTSFSCT::decode(rx, buf));
+    OTSFSCT::makeFrame(buf, 4, 7);
+    ASSERT_TRUE(OTSFSCT::decode(rx, buf));
+    EXPECT_EQ(5, store.counters[3][5]);
+    // Node 3 is reassociated at index 4 with its counter reset, and node 4 at 3.
+    store.swap(3, 4);
+    const unsigned long tableScans = store.tableScans;
+    OTSFSCT::makeFrame(buf, 3, 1);
+    ASSERT_TRUE(OTSFSCT::decode(rx, buf));
+    EXPECT_LT(tableScans, store.tableScans);
+    EXPECT_EQ(1, store.counters[4][5]);
+    EXPECT_EQ(0, store.counters[3][5]);
+    OTSFSCT::makeFrame(buf, 4, 2);
+    ASSERT_TRUE(OTSFSCT::decode(rx, buf));
+    EXPECT_EQ(2, store.counters[3][5]);
+    EXPECT_EQ(1, store.counters[4][5]);
+    // Unchanged associations keep the sessions.
+    rx.resetStats();
+    OTSFSCT::makeFrame(buf, 3, 2);
+    ASSERT_TRUE(OTSFSCT::decode(rx, buf));
+    EXPECT_EQ(0U, rx.getStats().idMisses);
+    EXPECT_EQ(0U, rx.getStats().ctrMisses);
+}
+
+// Hit rate and slow store accesses per frame with cache size, for a
+// stream where 2 hot nodes send 3 in 4 frames and 13 others the rest.
+namespace OTSFSCT
+{
+    // Check the hit rates (%) are at least the minimums given and the
+    // table scans and counter reads per 100 frames at most the maximums.
+    template<uint8_t cacheSize>
+    void hitRate(const unsigned minIDHitPC, const unsigned minCtrHitPC,
+                 const unsigned maxScansPer100, const unsigned maxReadsPer100)
+    {
+        static constexpr unsigned nFrames = 4000;
+        MockStore store(maxNodes);
+        CachedRX<cacheSize> rx(store);
+        uint32_t ctr[maxNodes] = {};
+        uint8_t buf[64];
+        unsigned nOK = 0;
+        for(unsigned i = 0; i < nFrames; ++i) {
+            // Skip node 1, which shares a prefix with node 0.
+            const uint8_t k = ((i & 3) != 3) ? uint8_t(2 * (i & 1)) : uint8_t(3 + (i / 4) % (maxNodes - 3));
+            makeFrame(buf, k, ++ctr[k]);
+            if(decode(rx, buf)) { ++nOK; }
+        }
+        EXPECT_EQ(nFrames, nOK);
+        const OTRadioLink::SecureRXSessionCacheStats &s = rx.getStats();
+        EXPECT_EQ(nFrames, s.idHits + s.idMisses) << int(cacheSize);
+        // Counters are looked up to validate and again to update.
+        EXPECT_EQ(2 * nFrames, s.ctrHits + s.ctrMisses) << int(cacheSize);
+        EXPECT_LE(minIDHitPC * nFrames, 100 * s.idHits) << int(cacheSize);
+        EXPECT_LE(2 * minCtrHitPC * nFrames, 100 * s.ctrHits) << int(cacheSize);
+        EXPECT_GE(maxScansPer100 * nFrames, 100 * store.tableScans) << int(cacheSize);
+        EXPECT_GE(maxReadsPer100 * nFrames, 100 * store.counterReads) << int(cacheSize);
+    }
+}
+TEST(SecureFrameSessionCache, HitRate)
+{
+    // A single session thrashes between the two hot senders.
+    OTSFSCT::hitRate<1>(0, 50, 200, 100);
+    // Hits for about half of the frames, the cold senders evicting the hot.
+    // (Slack on the store accesses is for the first frames from each node.)
+    OTSFSCT::hitRate<2>(45, 70, 101, 51);
+    // Both hot senders held: store only touched for the cold ones.
+    OTSFSCT::hitRate<4>(70, 85, 51, 26);
+    OTSFSCT::hitRate<8>(70, 85, 51, 26);
+}
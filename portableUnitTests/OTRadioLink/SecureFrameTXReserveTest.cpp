@@ -0,0 +1,288 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * TX message counter block reservation.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <gtest/gtest.h>
+#include <OTV0p2Base.h>
+#include <OTRadioLink.h>
+#include "SecureFrameTestFixture.h"
+
+
+namespace OTSFTXRT
+{
+    // Stands in for EEPROM holding the high-water mark, counting writes.
+    struct MockStore
+    {
+        uint8_t mark[6];
+        unsigned long writes;
+        bool failWrites;
+        MockStore() { memset(mark, 0, sizeof(mark)); writes = 0; failWrites = false; }
+    };
+
+    template<uint16_t block>
+    class ReservingTX final : public OTRadioLink::SimpleSecureFrame32or0BodyTXBlockReserve<block>
+    {
+    private:
+        MockStore &store;
+        virtual bool _loadTXCtrMark(uint8_t *buf) const override
+            { memcpy(buf, store.mark, 6); return(true); }
+        virtual bool _saveTXCtrMark(const uint8_t *buf) override
+        {
+            if(store.failWrites) { return(false); }
+            memcpy(store.mark, buf, 6);
+            ++store.writes;
+            return(true);
+        }
+    public:
+        // Construction over an existing store is a restart.
+        explicit ReservingTX(MockStore &_store) : store(_store) { }
+        virtual bool getTXID(uint8_t *id) const override { memset(id, 0x80, 8); return(true); }
+    };
+
+    // 48-bit counter value.
+    uint64_t ctrValue(const uint8_t *const c)
+    {
+        uint64_t v = 0;
+        for(int i = 0; i < 6; ++i) { v = (v << 8) | c[i]; }
+        return(v);
+    }
+
+    void setCounter(uint8_t *const c, uint64_t v)
+    {
+        for(int i = 6; --i >= 0; v >>= 8) { c[i] = uint8_t(v); }
+    }
+}
+
+// Measure store writes per 10k encoded frames, for blocks of 1 (persisting
+// every counter) and of 256.
+// See V0p2StoreWritesPer10kFrames for the comparison with the V0p2 TX path.
+TEST(SecureFrameTXReserve, BlockSizeStoreWritesPer10kFrames)
+{
+    static constexpr unsigned nFrames = 10000;
+    uint8_t body[32] = { };
+    memcpy(body, OTSFTF::valveBody, sizeof(OTSFTF::valveBody));
+    uint8_t key[16];
+    OTSFTF::getKey(key);
+    uint8_t buf[64];
+    uint8_t workspace[OTRadioLink::SimpleSecureFrame32or0BodyTXBase::encode_total_scratch_usage_OTAESGCM_2p0];
+
+    OTSFTXRT::MockStore perFrame;
+    OTSFTXRT::ReservingTX<1> tx1(perFrame);
+    for(unsigned i = 0; i < nFrames; ++i) {
+        OTRadioLink::OTEncodeData_T fd(body, sizeof(body), buf, sizeof(buf));
+        fd.ptextLen = sizeof(OTSFTF::valveBody);
+        fd.fType = OTRadioLink::FTS_BasicSensorOrValve;
+        OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+        ASSERT_NE(0, tx1.encode(fd, 4, OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleEnc_NULL_IMPL, sW, key));
+    }
+
+    OTSFTXRT::MockStore reserving;
+    OTSFTXRT::ReservingTX<256> tx256(reserving);
+    for(unsigned i = 0; i < nFrames; ++i) {
+        OTRadioLink::OTEncodeData_T fd(body, sizeof(body), buf, sizeof(buf));
+        fd.ptextLen = sizeof(OTSFTF::valveBody);
+        fd.fType = OTRadioLink::FTS_BasicSensorOrValve;
+        OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+        ASSERT_NE(0, tx256.encode(fd, 4, OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleEnc_NULL_IMPL, sW, key));
+    }
+
+    EXPECT_EQ(nFrames, perFrame.writes);
+    EXPECT_EQ((nFrames + 255) / 256, reserving.writes);
+    // Both issued counters 1 to nFrames.
+    EXPECT_EQ(nFrames, OTSFTXRT::ctrValue(perFrame.mark));
+    EXPECT_EQ(256U * reserving.writes, OTSFTXRT::ctrValue(reserving.mark));
+}
+
+// Check that counters never repeat over restarts, and that no counter is
+// consumed when the reservation cannot be persisted.
+TEST(SecureFrameTXReserve, RestartSafety)
+{
+    OTSFTXRT::MockStore store;
+    uint8_t c[6];
+    uint64_t prev = 0;
+    for(int restart = 0; restart < 5; ++restart) {
+        OTSFTXRT::ReservingTX<16> tx(store);
+        for(int i = 0; i < 7 * restart + 3; ++i) {
+            ASSERT_TRUE(tx.getNextTXMsgCtr(c));
+            EXPECT_LT(prev, OTSFTXRT::ctrValue(c));
+            EXPECT_LE(OTSFTXRT::ctrValue(c), OTSFTXRT::ctrValue(store.mark));
+            prev = OTSFTXRT::ctrValue(c);
+        }
+    }
+    // Jumps straight to the block above the mark.
+    OTSFTXRT::ReservingTX<16> tx(store);
+    const uint64_t mark = OTSFTXRT::ctrValue(store.mark);
+    store.failWrites = true;
+    EXPECT_FALSE(tx.getNextTXMsgCtr(c));
+    EXPECT_EQ(mark, OTSFTXRT::ctrValue(store.mark));
+    store.failWrites = false;
+    ASSERT_TRUE(tx.getNextTXMsgCtr(c));
+    EXPECT_EQ(mark + 1, OTSFTXRT::ctrValue(c));
+    EXPECT_EQ(mark + 16, OTSFTXRT::ctrValue(store.mark));
+    // Within the block no writes are needed, so none can fail.
+    store.failWrites = true;
+    ASSERT_TRUE(tx.getNextTXMsgCtr(c));
+    EXPECT_EQ(mark + 2, OTSFTXRT::ctrValue(c));
+    tx.invalidate();
+    EXPECT_FALSE(tx.getNextTXMsgCtr(c));
+    store.failWrites = false;
+    ASSERT_TRUE(tx.getNextTXMsgCtr(c));
+    EXPECT_EQ(mark + 17, OTSFTXRT::ctrValue(c));
+}
+
+// Check the restart prefix operations and counter exhaustion.
+TEST(SecureFrameTXReserve, PrefixAndLimits)
+{
+    OTSFTXRT::MockStore store;
+    OTSFTXRT::ReservingTX<256> tx(store);
+    uint8_t c[6];
+    uint8_t prefix[3];
+    ASSERT_TRUE(tx.getNextTXMsgCtr(c));
+    EXPECT_EQ(1U, OTSFTXRT::ctrValue(c));
+    ASSERT_TRUE(tx.getTXNVCtrPrefix(prefix));
+    EXPECT_EQ(0, prefix[0] | prefix[1] | prefix[2]);
+    // Increment skips to the next 2^24 counters.
+    ASSERT_TRUE(tx.incrementTXNVCtrPrefix());
+    ASSERT_TRUE(tx.getTXNVCtrPrefix(prefix));
+    EXPECT_EQ(1, prefix[2]);
+    ASSERT_TRUE(tx.getNextTXMsgCtr(c));
+    EXPECT_EQ(0x1000001U, OTSFTXRT::ctrValue(c));
+    // Reset with entropy leaves a non-zero prefix with top bits clear.
+    ASSERT_TRUE(tx.resetTXNVCtrPrefix());
+    ASSERT_TRUE(tx.getTXNVCtrPrefix(prefix));
+    EXPECT_NE(0, prefix[0] | prefix[1] | prefix[2]);
+    EXPECT_EQ(0, prefix[0] & 0xf0);
+    ASSERT_TRUE(tx.resetTXNVCtrPrefix(true));
+    ASSERT_TRUE(tx.getNextTXMsgCtr(c));
+    EXPECT_EQ(1U, OTSFTXRT::ctrValue(c));
+    // Carry must ripple all the way to the top byte.
+    OTSFTXRT::setCounter(store.mark, 0xffffffffffULL);
+    tx.invalidate();
+    ASSERT_TRUE(tx.getNextTXMsgCtr(c));
+    EXPECT_EQ(0x10000000000ULL, OTSFTXRT::ctrValue(c));
+    // The last block is truncated at the maximum, then counters run out.
+    OTSFTXRT::setCounter(store.mark, 0xfffffffffffdULL);
+    tx.invalidate();
+    ASSERT_TRUE(tx.getNextTXMsgCtr(c));
+    EXPECT_EQ(0xffffffffffffULL, OTSFTXRT::ctrValue(store.mark));
+    ASSERT_TRUE(tx.getNextTXMsgCtr(c));
+    EXPECT_EQ(0xffffffffffffULL, OTSFTXRT::ctrValue(c));
+    EXPECT_FALSE(tx.getNextTXMsgCtr(c));
+    EXPECT_FALSE(tx.getNextTXMsgCtr(nullptr));
+    ASSERT_TRUE(tx.getTXNVCtrPrefix(prefix));
+    EXPECT_FALSE(tx.incrementTXNVCtrPrefix());
+}
+
+#if defined(SimpleSecureFrame32or0BodyV0p2Impl_DEFINED) // DEPENDS ON AVR ARCH (EEPROM)
+namespace OTSFTXRT
+{
+    // EEPROM holding the V0p2 restart counter (both copies) and mark LSBs.
+    static constexpr intptr_t eeStart = OTV0P2BASE::VOP2BASE_EE_START_PERSISTENT_MSG_TX_MARK_LSBS;
+    static constexpr uint8_t eeLen = OTV0P2BASE::VOP2BASE_EE_LEN_PERSISTENT_MSG_TX_MARK_LSBS +
+                                     OTV0P2BASE::VOP2BASE_EE_LEN_PERSISTENT_MSG_RESTART_CTR;
+    static_assert(eeStart + OTV0P2BASE::VOP2BASE_EE_LEN_PERSISTENT_MSG_TX_MARK_LSBS ==
+                  OTV0P2BASE::VOP2BASE_EE_START_PERSISTENT_MSG_RESTART_CTR, "EEPROM areas must be adjacent");
+
+    void snapshotEEPROM(uint8_t *const buf)
+        { for(uint8_t i = 0; i < eeLen; ++i) { buf[i] = eeprom_read_byte((uint8_t *)(eeStart) + i); } }
+
+    // Encode nFrames with tx, returning the number of EEPROM bytes changed.
+    unsigned long encodeCountingEEPROMChanges(OTRadioLink::SimpleSecureFrame32or0BodyTXBase &tx, const unsigned nFrames)
+    {
+        uint8_t body[32] = { };
+        memcpy(body, OTSFTF::valveBody, sizeof(OTSFTF::valveBody));
+        uint8_t key[16];
+        OTSFTF::getKey(key);
+        uint8_t buf[64];
+        uint8_t workspace[OTRadioLink::SimpleSecureFrame32or0BodyTXBase::encode_total_scratch_usage_OTAESGCM_2p0];
+        uint8_t before[eeLen], after[eeLen];
+        snapshotEEPROM(before);
+        unsigned long changes = 0;
+        for(unsigned i = 0; i < nFrames; ++i) {
+            OTRadioLink::OTEncodeData_T fd(body, sizeof(body), buf, sizeof(buf));
+            fd.ptextLen = sizeof(OTSFTF::valveBody);
+            fd.fType = OTRadioLink::FTS_BasicSensorOrValve;
+            OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+            if(0 == tx.encode(fd, 4, OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleEnc_NULL_IMPL, sW, key)) { return(~0UL); }
+            snapshotEEPROM(after);
+            for(uint8_t j = 0; j < eeLen; ++j) { if(before[j] != after[j]) { ++changes; } }
+            memcpy(before, after, eeLen);
+        }
+        return(changes);
+    }
+}
+
+// Measure EEPROM bytes changed per 10k encoded frames by the V0p2 TX path,
+// which persists only the restart counter, and the V0p2 block reserve.
+TEST(SecureFrameTXReserve, V0p2StoreWritesPer10kFrames)
+{
+    static constexpr unsigned nFrames = 10000;
+    // At most one restart counter bump (both copies with CRCs) per boot.
+    const unsigned long v0p2 = OTSFTXRT::encodeCountingEEPROMChanges(
+        OTRadioLink::SimpleSecureFrame32or0BodyTXV0p2::getInstance(), nFrames);
+    EXPECT_GE(8UL, v0p2);
+    // At most 3 LSBs and the CRC per block, plus a restart counter bump.
+    OTRadioLink::SimpleSecureFrame32or0BodyTXV0p2BlockReserve &br =
+        OTRadioLink::SimpleSecureFrame32or0BodyTXV0p2BlockReserve::getInstance();
+    br.invalidate();
+    const unsigned long reserving = OTSFTXRT::encodeCountingEEPROMChanges(br, nFrames);
+    EXPECT_LT(0UL, reserving);
+    EXPECT_GE((nFrames / 256 + 1) * 4 + 8UL, reserving);
+}
+
+// Check the V0p2 block reserve mark in EEPROM: it shares its prefix with
+// the V0p2 TX restart counter, survives reloads, and a damaged mark skips
+// the rest of the prefix rather than reissuing counters.
+TEST(SecureFrameTXReserve, V0p2BlockReserveStore)
+{
+    OTRadioLink::SimpleSecureFrame32or0BodyTXV0p2BlockReserve &br =
+        OTRadioLink::SimpleSecureFrame32or0BodyTXV0p2BlockReserve::getInstance();
+    uint8_t c[6];
+    uint8_t prefix[3];
+    br.invalidate();
+    ASSERT_TRUE(br.getNextTXMsgCtr(c));
+    ASSERT_TRUE(OTRadioLink::SimpleSecureFrame32or0BodyTXV0p2::getInstance().getTXNVCtrPrefix(prefix));
+    EXPECT_EQ(0, memcmp(prefix, c, sizeof(prefix)));
+    // Reloading the mark jumps to the next block, never backwards.
+    uint64_t prev = OTSFTXRT::ctrValue(c);
+    for(int i = 0; i < 3; ++i) {
+        br.invalidate();
+        ASSERT_TRUE(br.getNextTXMsgCtr(c));
+        EXPECT_LT(prev, OTSFTXRT::ctrValue(c));
+        prev = OTSFTXRT::ctrValue(c);
+    }
+    // Damage the CRC on the LSBs, as if by a torn write.
+    uint8_t *const crcPtr = (uint8_t *)(OTV0P2BASE::VOP2BASE_EE_START_PERSISTENT_MSG_TX_MARK_LSBS) + 3;
+    eeprom_write_byte(crcPtr, uint8_t(~eeprom_read_byte(crcPtr)));
+    br.invalidate();
+    ASSERT_TRUE(br.getNextTXMsgCtr(c));
+    EXPECT_EQ(((prev >> 24) + 1) << 24, OTSFTXRT::ctrValue(c));
+    ASSERT_TRUE(OTRadioLink::SimpleSecureFrame32or0BodyTXV0p2::getInstance().getTXNVCtrPrefix(prefix));
+    EXPECT_EQ(0, memcmp(prefix, c, sizeof(prefix)));
+    // The rewritten mark is good again.
+    prev = OTSFTXRT::ctrValue(c);
+    br.invalidate();
+    ASSERT_TRUE(br.getNextTXMsgCtr(c));
+    EXPECT_EQ(prev + 256, OTSFTXRT::ctrValue(c));
+}
+#endif // defined(SimpleSecureFrame32or0BodyV0p2Impl_DEFINED)
@@ -0,0 +1,104 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * Shared secure frame fixture for the portable unit tests:
+ * a default sender and key, and an encoder for valve-style 'O' frames
+ * using the NULL crypto, so that tests do not need OTAESGCM.
+ */
+
+#ifndef PUT_OTRADIOLINK_SECUREFRAMETESTFIXTURE_H
+#define PUT_OTRADIOLINK_SECUREFRAMETESTFIXTURE_H
+
+#include <stdint.h>
+#include <string.h>
+#include <OTV0p2Base.h>
+#include <OTRadioLink.h>
+
+namespace OTSFTF
+{
+    // Default sender ID; also the ID the mock RX looks up.
+    static constexpr uint8_t id[8] = { 0xaa, 0xaa, 0xaa, 0xaa, 0x55, 0x55, 0x55, 0x55 };
+    // Counter held by the mock RX, lower than that in any frame built
+    // with makeFrame().
+    static constexpr uint8_t oldCounter[6] = { 0x00, 0x00, 0x2a, 0x00, 0x03, 0x18 };
+    static constexpr uint64_t oldCounterValue = 0x00002a000318ULL;
+
+    // Start of the usual valve body: valve 127%, stats "{b|".
+    static constexpr uint8_t valveBody[5] = { 0x7f, 0x11, '{', 'b', '|' };
+
+    // 48-bit value of a 6-byte message counter.
+    inline uint64_t ctrValue(const uint8_t *const c)
+    {
+        uint64_t v = 0;
+        for(int i = 0; i < 6; ++i) { v = (v << 8) | c[i]; }
+        return(v);
+    }
+
+    // Fill key with the 16-byte test key; always succeeds.
+    inline bool getKey(uint8_t *const key) { memset(key, 0x5a, 16); return(true); }
+
+    /**
+     * @brief   Encode a secure 'O' frame with valveBody, by default using
+     *          the NULL crypto.
+     * @param   buf, OUTPUT: At least 64 bytes.
+     * @param   sender: Full 8-byte ID of the sender, the first il bytes of
+     *              which go in the header.
+     * @param   ctr: 48-bit message counter.
+     * @param   il: ID length in the header.
+     * @param   e: Encryption function.
+     * @retval  As for encodeRaw(): encoded length + 1, or 0 on failure.
+     */
+    inline uint8_t makeFrameFrom(uint8_t *const buf, const uint8_t *const sender,
+                                 uint64_t ctr, const uint8_t il = 4,
+                                 OTRadioLink::SimpleSecureFrame32or0BodyTXBase::fixed32BTextSize12BNonce16BTagSimpleEnc_fn_t &e =
+                                     OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleEnc_NULL_IMPL)
+    {
+        uint8_t iv[12];
+        memcpy(iv, sender, 6);
+        for(int i = 12; --i >= 6; ctr >>= 8) { iv[i] = uint8_t(ctr); }
+        uint8_t body[32] = { };
+        memcpy(body, valveBody, sizeof(valveBody));
+        OTRadioLink::OTEncodeData_T fd(body, sizeof(body), buf, 64);
+        fd.ptextLen = sizeof(valveBody);
+        fd.fType = OTRadioLink::FTS_BasicSensorOrValve;
+        uint8_t key[16];
+        getKey(key);
+        // Room for the portable AES-GCM, which expands the key in the workspace.
+        uint8_t workspace[OTRadioLink::SimpleSecureFrame32or0BodyTXBase::encodeRaw_total_scratch_usage_OTAESGCM_2p0 +
+                          OTRadioLink::fixed32BTextSize12BNonce16BTagSimpleWorkspace_AESGCM_IMPL];
+        OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+        return(OTRadioLink::SimpleSecureFrame32or0BodyTXBase::encodeRaw(
+                fd, sender, il, iv, e, sW, key));
+    }
+
+    // As makeFrameFrom() with counter oldCounter + ctrLSB.
+    inline uint8_t makeFrame(uint8_t *const buf, const uint8_t ctrLSB, const uint8_t *const sender = id)
+        { return(makeFrameFrom(buf, sender, oldCounterValue + ctrLSB)); }
+
+    // Set the mock RX to look up id and to hold oldCounter.
+    inline void setUpMockRX()
+    {
+        OTRadioLink::SimpleSecureFrame32or0BodyRXFixedCounter &rx =
+            OTRadioLink::SimpleSecureFrame32or0BodyRXFixedCounter::getInstance();
+        rx.setMockIDValue(id);
+        rx.setMockCounterValue(oldCounter);
+    }
+}
+
+#endif
@@ -184,6 +184,7 @@ namespace SOSDT
 
         constexpr size_t workspaceSize =
             (176+112) /* for OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleDec_DEFAULT_WITH_LWORKSPACE for AES+Dec */ +
+            OTRadioLink::decodeAndHandleOTSecureOFrame_scratch_usage +
             OTRadioLink::authAndDecodeOTSecurableFrameWithWorkspace_scratch_usage +
             OTRadioLink::SimpleSecureFrame32or0BodyRXBase::decode_total_scratch_usage_OTAESGCM_3p0;
 
@@ -230,10 +231,11 @@ TEST(SecureOpStackDepth, SimpleSecureFrame32or0BodyRXFixedCounterWithWorkspaceSt
 }
 
 namespace OTMQHSB{
-    bool decodeAndHandleSecFrame(volatile const uint8_t *const msg){
+    bool decodeAndHandleSecFrame(const uint8_t *const msg){
         constexpr size_t workspaceRequired =
             OTRadioLink::SimpleSecureFrame32or0BodyRXBase::decode_total_scratch_usage_OTAESGCM_3p0
             + OTAESGCM::OTAES128GCMGenericWithWorkspace<>::workspaceRequiredDec
+            + OTRadioLink::decodeAndHandleOTSecureOFrame_scratch_usage // + space for the decrypted body
             + OTRadioLink::authAndDecodeOTSecurableFrameWithWorkspace_scratch_usage; // + space to hold the key
         uint8_t workspace[workspaceRequired];
     OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
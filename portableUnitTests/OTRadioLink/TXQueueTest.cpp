@@ -0,0 +1,212 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * Bounded asynchronous TX queue.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+#include <gtest/gtest.h>
+#include <OTV0p2Base.h>
+#include <OTRadioLink.h>
+
+
+namespace OTTXQT
+{
+    typedef OTRadioLink::OTRadioLinkTXQueue<8, 4> queue_t;
+
+    // Radio that queues TX and records what it sends from poll().
+    class QueuedTXRadio final : public OTRadioLink::OTRadioLink
+    {
+    private:
+        void _dolisten() override { }
+    public:
+        queue_t txQueue;
+        // First byte, channel and power of each frame sent.
+        struct Sent { uint8_t tag; int8_t channel; TXpower power; };
+        std::vector<Sent> sent;
+        bool failSends = false;
+        void getCapacity(uint8_t &queueRXMsgsMin, uint8_t &maxRXMsgLen, uint8_t &maxTXMsgLen) const override
+            { queueRXMsgsMin = 0; maxRXMsgLen = 0; maxTXMsgLen = 8; }
+        uint8_t getRXMsgsQueued() const override { return(0); }
+        const volatile uint8_t *peekRXMsg() const override { return(NULL); }
+        void removeRXMsg() override { }
+        bool sendRaw(const uint8_t *buf, uint8_t, int8_t channel, TXpower power, bool) override
+        {
+            if(failSends) { return(false); }
+            sent.push_back(Sent{ buf[0], channel, power });
+            return(true);
+        }
+        bool queueToSend(const uint8_t *buf, uint8_t buflen, int8_t channel, TXpower power) override
+            { return(txQueue.queue(buf, buflen, channel, power)); }
+        void poll() override { txQueue.drain(*this); }
+    };
+
+    // Queue a one-byte frame tagged tag.
+    bool q(queue_t &tq, const uint8_t tag, const OTRadioLink::OTRadioLink::TXpower power,
+           const uint8_t key = 0, const int8_t channel = 0)
+        { return(tq.queue(&tag, 1, channel, power, key)); }
+}
+
+// Check that queueToSend() does not send, and poll() sends
+// highest power first then oldest first.
+TEST(TXQueue, PriorityOrder)
+{
+    typedef OTRadioLink::OTRadioLink rl_t;
+    OTTXQT::QueuedTXRadio r;
+    const uint8_t f[] = { 1, 2, 3, 4 };
+    EXPECT_TRUE(r.queueToSend(f + 0, 1, 0, rl_t::TXnormal));
+    EXPECT_TRUE(r.queueToSend(f + 1, 1, 1, rl_t::TXmax));
+    EXPECT_TRUE(r.queueToSend(f + 2, 1, 0, rl_t::TXnormal));
+    EXPECT_TRUE(r.queueToSend(f + 3, 1, 0, rl_t::TXmax));
+    EXPECT_TRUE(r.sent.empty());
+    EXPECT_TRUE(r.txQueue.isFull());
+    // Too long.
+    uint8_t big[9] = { };
+    EXPECT_FALSE(r.queueToSend(big, sizeof(big), 0, rl_t::TXmax));
+    for(int i = 0; i < 5; ++i) { r.poll(); }
+    ASSERT_EQ(4U, r.sent.size());
+    const uint8_t expected[] = { 2, 4, 1, 3 };
+    for(int i = 0; i < 4; ++i) { EXPECT_EQ(expected[i], r.sent[i].tag); }
+    EXPECT_EQ(1, r.sent[0].channel);
+    EXPECT_EQ(rl_t::TXmax, r.sent[1].power);
+    EXPECT_TRUE(r.txQueue.isEmpty());
+    EXPECT_EQ(4U, r.txQueue.getStats().sent);
+    // Failed sends are counted and not retried.
+    r.failSends = true;
+    EXPECT_TRUE(r.queueToSend(f, 1, 0, rl_t::TXnormal));
+    r.poll();
+    EXPECT_TRUE(r.txQueue.isEmpty());
+    EXPECT_EQ(1U, r.txQueue.getStats().failed);
+}
+
+// Check that a frame supersedes a queued one with the same key and
+// channel, keeping its place, and that others are not touched.
+TEST(TXQueue, Coalescing)
+{
+    typedef OTRadioLink::OTRadioLink rl_t;
+    OTTXQT::QueuedTXRadio r;
+    OTTXQT::queue_t &tq = r.txQueue;
+    EXPECT_TRUE(OTTXQT::q(tq, 10, rl_t::TXnormal, 7));
+    EXPECT_TRUE(OTTXQT::q(tq, 20, rl_t::TXnormal));
+    EXPECT_TRUE(OTTXQT::q(tq, 11, rl_t::TXnormal, 7));
+    EXPECT_TRUE(OTTXQT::q(tq, 30, rl_t::TXnormal, 7, 1));
+    EXPECT_TRUE(OTTXQT::q(tq, 12, rl_t::TXloud, 7));
+    EXPECT_EQ(3, tq.getQueued());
+    EXPECT_EQ(2U, tq.getStats().coalesced);
+    EXPECT_EQ(3, tq.drain(r, 255));
+    ASSERT_EQ(3U, r.sent.size());
+    // Latest content, raised to the higher power, sent first.
+    EXPECT_EQ(12, r.sent[0].tag);
+    EXPECT_EQ(rl_t::TXloud, r.sent[0].power);
+    EXPECT_EQ(20, r.sent[1].tag);
+    EXPECT_EQ(30, r.sent[2].tag);
+}
+
+// Check that when full only lower-power frames are displaced,
+// newest first.
+TEST(TXQueue, Overflow)
+{
+    typedef OTRadioLink::OTRadioLink rl_t;
+    OTTXQT::QueuedTXRadio r;
+    OTTXQT::queue_t &tq = r.txQueue;
+    EXPECT_TRUE(OTTXQT::q(tq, 1, rl_t::TXnormal));
+    EXPECT_TRUE(OTTXQT::q(tq, 2, rl_t::TXnormal));
+    EXPECT_TRUE(OTTXQT::q(tq, 3, rl_t::TXmax));
+    EXPECT_TRUE(OTTXQT::q(tq, 4, rl_t::TXnormal));
+    EXPECT_FALSE(OTTXQT::q(tq, 5, rl_t::TXnormal));
+    EXPECT_TRUE(OTTXQT::q(tq, 6, rl_t::TXmax));
+    EXPECT_TRUE(OTTXQT::q(tq, 7, rl_t::TXloud));
+    EXPECT_EQ(3U, tq.getStats().dropped);
+    tq.drain(r, 255);
+    ASSERT_EQ(4U, r.sent.size());
+    const uint8_t expected[] = { 3, 6, 7, 1 };
+    for(int i = 0; i < 4; ++i) { EXPECT_EQ(expected[i], r.sent[i].tag); }
+    tq.resetStats();
+    EXPECT_EQ(0U, tq.getStats().queued);
+    EXPECT_TRUE(OTTXQT::q(tq, 8, rl_t::TXnormal));
+    tq.clear();
+    EXPECT_EQ(0, tq.drain(r));
+}
+
+// Check that order is kept while more than 256 frames pass through
+// the queue past a frame that stays queued throughout.
+TEST(TXQueue, LongQueued)
+{
+    typedef OTRadioLink::OTRadioLink rl_t;
+    for(unsigned passing = 250; passing <= 1030; passing += (passing < 260) ? 1 : 97) {
+        OTTXQT::QueuedTXRadio r;
+        OTTXQT::queue_t &tq = r.txQueue;
+        // Starved by the louder frames sent one at a time.
+        ASSERT_TRUE(OTTXQT::q(tq, 1, rl_t::TXquiet));
+        ASSERT_TRUE(OTTXQT::q(tq, 2, rl_t::TXnormal));
+        for(unsigned i = 0; i < passing; ++i) {
+            ASSERT_TRUE(OTTXQT::q(tq, 100, rl_t::TXmax));
+            ASSERT_EQ(1, tq.drain(r));
+        }
+        ASSERT_TRUE(OTTXQT::q(tq, 3, rl_t::TXnormal));
+        ASSERT_TRUE(OTTXQT::q(tq, 4, rl_t::TXquiet));
+        EXPECT_TRUE(tq.isFull());
+        // The newest of the quietest frames is the one evicted.
+        EXPECT_TRUE(OTTXQT::q(tq, 5, rl_t::TXloud));
+        r.sent.clear();
+        EXPECT_EQ(4, tq.drain(r, 255));
+        ASSERT_EQ(4U, r.sent.size()) << passing;
+        const uint8_t expected[] = { 5, 2, 3, 1 };
+        for(int i = 0; i < 4; ++i) { EXPECT_EQ(expected[i], r.sent[i].tag) << passing; }
+    }
+}
+
+// Check the queue in a real driver: queueToSend() puts nothing on the air
+// and each poll() sends the next frame in priority order.
+TEST(TXQueue, VirtualEtherRadio)
+{
+    typedef OTRadioLink::OTRadioLink rl_t;
+    OTRadioLink::VirtualEther e;
+    OTRadioLink::OTVirtualEtherRadio<2, OTRadioLink::VirtualEther::maxFrameBytes, 4> tx(e);
+    OTRadioLink::OTVirtualEtherRadio<8> rx(e);
+    ASSERT_TRUE(e.link(tx.getNodeIndex(), rx.getNodeIndex()));
+    const OTRadioLink::OTRadioChannelConfig config(NULL, true);
+    ASSERT_TRUE(rx.configure(1, &config));
+    rx.listen(true);
+    const uint8_t f[] = { 1, 2, 3 };
+    EXPECT_TRUE(tx.queueToSend(f + 0, 1, 0, rl_t::TXnormal));
+    EXPECT_TRUE(tx.queueToSend(f + 1, 1, 0, rl_t::TXquiet));
+    EXPECT_TRUE(tx.queueToSend(f + 2, 1, 0, rl_t::TXmax));
+    e.advance(1000000);
+    EXPECT_EQ(0U, e.getStats().framesSent);
+    EXPECT_EQ(3, tx.getTXQueue().getQueued());
+    // One frame per poll, each clear of the last on the air.
+    for(int i = 0; i < 4; ++i) { tx.poll(); e.advance(1000000); }
+    EXPECT_EQ(3U, e.getStats().framesSent);
+    EXPECT_EQ(3U, tx.getTXQueue().getStats().sent);
+    ASSERT_EQ(3, rx.getRXMsgsQueued());
+    const uint8_t expected[] = { 3, 1, 2 };
+    for(const uint8_t t : expected) {
+        EXPECT_EQ(t, rx.peekRXMsg()[0]);
+        rx.removeRXMsg();
+    }
+    // Without a TX queue, queueToSend() sends at once.
+    OTRadioLink::OTVirtualEtherRadio<> direct(e);
+    ASSERT_TRUE(e.link(direct.getNodeIndex(), rx.getNodeIndex()));
+    EXPECT_TRUE(direct.queueToSend(f, 1));
+    e.advance(1000000);
+    EXPECT_EQ(1, rx.getRXMsgsQueued());
+}
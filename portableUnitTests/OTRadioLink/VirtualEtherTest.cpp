@@ -0,0 +1,194 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * Simulated radio medium (virtual ether).
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <gtest/gtest.h>
+#include <OTV0p2Base.h>
+#include <OTRadioLink.h>
+
+
+namespace OTVET
+{
+    typedef OTRadioLink::OTVirtualEtherRadio<> radio_t;
+    const OTRadioLink::OTRadioChannelConfig configs[2] = { { NULL, true }, { NULL, true } };
+
+    // Send a frame of len bytes, each tag.
+    bool send(radio_t &r, const uint8_t tag, const uint8_t len = 8, const int8_t channel = 0)
+    {
+        uint8_t buf[OTRadioLink::VirtualEther::maxFrameBytes];
+        memset(buf, tag, len);
+        return(r.sendRaw(buf, len, channel));
+    }
+}
+
+// Check that a frame arrives after latency plus airtime, only where linked
+// and only on the channel being listened on.
+TEST(VirtualEther, DeliveryAndChannels)
+{
+    OTRadioLink::VirtualEther e;
+    OTVET::radio_t a(e), b(e), c(e);
+    ASSERT_TRUE(b.configure(2, OTVET::configs));
+    ASSERT_TRUE(c.configure(2, OTVET::configs));
+    b.listen(true, 0);
+    c.listen(true, 1);
+    EXPECT_EQ(3U, e.getNodeCount());
+    EXPECT_FALSE(e.link(0, 0));
+    EXPECT_FALSE(e.link(0, 3));
+    const OTRadioLink::VirtualEtherLinkModel slow = { 0, 1000, 0 };
+    ASSERT_TRUE(e.link(a.getNodeIndex(), b.getNodeIndex(), slow));
+    ASSERT_TRUE(e.link(a.getNodeIndex(), c.getNodeIndex(), slow));
+    // Channel 1 is invalid for the unconfigured sender.
+    EXPECT_FALSE(OTVET::send(a, 1, 8, 1));
+    ASSERT_TRUE(OTVET::send(a, 1));
+    const OTRadioLink::VirtualEther::vtime_t arrival = 1000 + e.airtime(8);
+    e.advanceTo(arrival - 1);
+    EXPECT_EQ(0, b.getRXMsgsQueued());
+    e.advanceTo(arrival);
+    ASSERT_EQ(1, b.getRXMsgsQueued());
+    EXPECT_EQ(8, b.peekRXMsg()[-1]);
+    EXPECT_EQ(1, b.peekRXMsg()[7]);
+    EXPECT_EQ(0, c.getRXMsgsQueued());
+    // Nothing comes back: no link from b to a.
+    ASSERT_TRUE(OTVET::send(b, 2));
+    e.advance(1000000);
+    const OTRadioLink::VirtualEtherStats &s = e.getStats();
+    EXPECT_EQ(2U, s.framesSent);
+    EXPECT_EQ(1U, s.unheard);
+    EXPECT_EQ(1U, s.delivered);
+    EXPECT_EQ(1U, s.notListening);
+    EXPECT_EQ(0U, e.getInFlight());
+}
+
+// Check that each queued frame reports the channel it arrived on after
+// the receiver changes channel, until too many changes are outstanding.
+TEST(VirtualEther, RXChannelRecorded)
+{
+    OTRadioLink::VirtualEther e;
+    OTVET::radio_t a(e), b(e);
+    ASSERT_TRUE(a.configure(2, OTVET::configs));
+    ASSERT_TRUE(b.configure(2, OTVET::configs));
+    ASSERT_TRUE(e.link(a.getNodeIndex(), b.getNodeIndex()));
+    const int8_t channels[] = { 0, 1, 0, 1 };
+    for(const int8_t c : channels) {
+        b.listen(true, c);
+        ASSERT_TRUE(OTVET::send(a, uint8_t(c), 8, c));
+        e.advance(1000000);
+    }
+    ASSERT_EQ(4, b.getRXMsgsQueued());
+    // Only two runs are held, so the third is merged into the second
+    // and their channel is unknown; the last frame is on the current channel.
+    const int8_t expected[] = { 0, -1, -1, 1 };
+    for(const int8_t c : expected) {
+        EXPECT_EQ(c, b.getRXMsgChannel());
+        b.removeRXMsg();
+    }
+    EXPECT_EQ(0, b.getRXMsgsQueued());
+    b.removeRXMsg();
+    // With the queue drained, frames are on the current channel again.
+    ASSERT_TRUE(OTVET::send(a, 1, 8, 1));
+    e.advance(1000000);
+    b.listen(true, 0);
+    ASSERT_TRUE(OTVET::send(a, 0, 8, 0));
+    e.advance(1000000);
+    ASSERT_EQ(2, b.getRXMsgsQueued());
+    EXPECT_EQ(1, b.getRXMsgChannel());
+    b.removeRXMsg();
+    EXPECT_EQ(0, b.getRXMsgChannel());
+}
+
+// Check that frames overlapping at a receiver on the same channel are
+// both lost, and that other channels and later frames are unaffected.
+TEST(VirtualEther, Collisions)
+{
+    OTRadioLink::VirtualEther e;
+    OTVET::radio_t a(e), b(e), hub(e);
+    ASSERT_TRUE(a.configure(2, OTVET::configs));
+    ASSERT_TRUE(b.configure(2, OTVET::configs));
+    ASSERT_TRUE(hub.configure(2, OTVET::configs));
+    hub.listen(true, 0);
+    e.link(a.getNodeIndex(), hub.getNodeIndex());
+    e.link(b.getNodeIndex(), hub.getNodeIndex());
+    ASSERT_TRUE(OTVET::send(a, 1));
+    e.advance(e.airtime(8) - 1);
+    ASSERT_TRUE(OTVET::send(b, 2));
+    e.advance(e.airtime(8) * 2);
+    EXPECT_EQ(2U, e.getStats().collided);
+    EXPECT_EQ(0, hub.getRXMsgsQueued());
+    // Back to back: no overlap.
+    ASSERT_TRUE(OTVET::send(a, 3));
+    e.advance(e.airtime(8));
+    ASSERT_TRUE(OTVET::send(b, 4));
+    e.advance(e.airtime(8));
+    EXPECT_EQ(2, hub.getRXMsgsQueued());
+    hub.removeRXMsg();
+    hub.removeRXMsg();
+    // Simultaneous on different channels: only the one listened for arrives.
+    ASSERT_TRUE(OTVET::send(a, 5, 8, 1));
+    ASSERT_TRUE(OTVET::send(b, 6, 8, 0));
+    e.advance(e.airtime(8));
+    ASSERT_EQ(1, hub.getRXMsgsQueued());
+    EXPECT_EQ(6, hub.peekRXMsg()[0]);
+    EXPECT_EQ(2U, e.getStats().collided);
+}
+
+// Check the loss model rate, repeatability for a seed, and RX queue
+// overflow at a receiver that is not drained.
+TEST(VirtualEther, LossAndOverflow)
+{
+    unsigned lost[2];
+    for(int run = 0; run < 2; ++run) {
+        OTRadioLink::VirtualEther e(42);
+        OTVET::radio_t tx(e), rx(e);
+        rx.listen(false);
+        e.link(tx.getNodeIndex(), rx.getNodeIndex(), OTRadioLink::VirtualEtherLinkModel{ 100, 0, 50 });
+        for(int i = 0; i < 10000; ++i) { OTVET::send(tx, 1); e.advance(100000); }
+        lost[run] = unsigned(e.getStats().lost);
+    }
+    EXPECT_EQ(lost[0], lost[1]);
+    EXPECT_NEAR(1000, lost[0], 150);
+
+    OTRadioLink::VirtualEther e;
+    OTVET::radio_t tx(e);
+    OTRadioLink::OTVirtualEtherRadio<2, 8> rx(e);
+    ASSERT_TRUE(rx.configure(1, OTVET::configs));
+    rx.listen(true);
+    e.link(tx.getNodeIndex(), rx.getNodeIndex());
+    for(int i = 0; i < 5; ++i) { OTVET::send(tx, uint8_t(i)); e.advance(100000); }
+    // Too long for this receiver.
+    OTVET::send(tx, 9, 9);
+    e.advance(100000);
+    EXPECT_EQ(2U, e.getStats().delivered);
+    EXPECT_EQ(3U, e.getStats().rxQueueFull);
+    EXPECT_EQ(1U, e.getStats().tooLong);
+    EXPECT_EQ(4, rx.getRXMsgsDroppedRecent());
+    // Too long even with the queue empty.
+    while(0 != rx.getRXMsgsQueued()) { rx.removeRXMsg(); }
+    OTVET::send(tx, 9, 9);
+    e.advance(100000);
+    EXPECT_EQ(2U, e.getStats().tooLong);
+    EXPECT_EQ(3U, e.getStats().rxQueueFull);
+    EXPECT_EQ(0, rx.getRXMsgsQueued());
+    OTVET::send(tx, 0);
+    e.advance(100000);
+    EXPECT_EQ(0, rx.peekRXMsg()[0]);
+}
@@ -0,0 +1,93 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): agent 2026
+*/
+
+/*
+ * Driver for OTV0p2Base CRC tests.
+ */
+
+#include <stdint.h>
+#include <gtest/gtest.h>
+#include <OTV0p2Base.h>
+
+#include "OTV0P2BASE_CRC.h"
+
+
+namespace OTCRCT
+{
+    // Bitwise reference implementation of crc7_5B_update().
+    uint8_t crc7_5B_update_ref(uint8_t crc, const uint8_t datum)
+    {
+        for(uint8_t i = 0x80; i != 0; i >>= 1) {
+            bool bit = (0 != (crc & 0x40));
+            if(0 != (datum & i)) { bit = !bit; }
+            crc <<= 1;
+            if(bit) { crc ^= 0x37; }
+        }
+        return(crc & 0x7f);
+    }
+}
+
+// Check the (possibly table-driven) single byte update against the
+// reference for every CRC and datum value, including a stray top bit.
+TEST(CRC, crc7_5BAllValues)
+{
+    for(unsigned crc = 0; crc < 256; ++crc) {
+        for(unsigned d = 0; d < 256; ++d) {
+            ASSERT_EQ(OTCRCT::crc7_5B_update_ref(uint8_t(crc), uint8_t(d)),
+                      OTV0P2BASE::crc7_5B_update(uint8_t(crc), uint8_t(d))) << crc << " " << d;
+        }
+    }
+    EXPECT_EQ(OTV0P2BASE::crc7_5B_update_nz_ALT, OTV0P2BASE::crc7_5B_update_nz_final(0, 0));
+}
+
+// Check the block update against the single byte update for all lengths
+// and alignments a frame may have.
+TEST(CRC, crc7_5BBlock)
+{
+    uint8_t buf[80];
+    for(uint8_t i = 0; i < sizeof(buf); ++i) { buf[i] = uint8_t(OTV0P2BASE::randRNG8()); }
+    for(uint8_t offset = 0; offset < 4; ++offset) {
+        for(uint8_t len = 0; len <= 64; ++len) {
+            for(const uint8_t init : { 0x00, 0x7f, 0x7b }) {
+                uint8_t crc = init;
+                for(uint8_t i = 0; i < len; ++i) { crc = OTCRCT::crc7_5B_update_ref(crc, buf[offset + i]); }
+                EXPECT_EQ(crc, OTV0P2BASE::crc7_5B_update_block(init, buf + offset, len));
+            }
+        }
+    }
+    EXPECT_EQ(0x7f, OTV0P2BASE::crc7_5B_update_block(0x7f, NULL, 0));
+}
+
+// Check the four-stream update against the block update of each stream.
+TEST(CRC, crc7_5BBlockX4)
+{
+    uint8_t buf[4][64];
+    for(uint8_t k = 0; k < 4; ++k) {
+        for(uint8_t i = 0; i < sizeof(buf[k]); ++i) { buf[k][i] = uint8_t(OTV0P2BASE::randRNG8()); }
+    }
+    const uint8_t *const bufs[4] = { buf[0], buf[1] + 1, buf[2] + 2, buf[3] + 3 };
+    for(uint8_t len = 0; len <= 60; ++len) {
+        const uint8_t init[4] = { 0x00, 0x7f, 0x11, 0x7b };
+        uint8_t crc[4];
+        memcpy(crc, init, sizeof(crc));
+        OTV0P2BASE::crc7_5B_update_block_x4(crc, bufs, len);
+        for(uint8_t k = 0; k < 4; ++k) {
+            EXPECT_EQ(OTV0P2BASE::crc7_5B_update_block(init[k], bufs[k], len), crc[k]);
+        }
+    }
+}
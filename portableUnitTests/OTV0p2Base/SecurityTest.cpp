@@ -500,3 +500,125 @@ TEST(getNextMatchingNodeID, ReturnCorrectIDWithPartialPrefix)
     EXPECT_EQ(7, i7);
     EXPECT_THAT(outbuf, ::testing::ElementsAreArray(id7));
 }
+
+
+namespace NAI
+{
+typedef OTV0P2BASE::NodeAssociationIndex<OTV0P2BASE::NodeAssociationTableMock, OTV0P2BASE::NodeAssociationTableMock::maxSets> index_t;
+}
+
+// Test that the index gives the same results as the linear scan for every
+// start index and prefix length, including duplicate prefixes and a
+// partially filled table.
+TEST(NodeAssociationIndex, MatchesLinearScan)
+{
+    GNMNID::nodes._reset();
+    // Entries deliberately out of order and sharing prefixes.
+    const uint8_t ids[6][8] = {
+        { 0x90, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07 },
+        { 0x80, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17 },
+        { 0x90, 0x01, 0x02, 0x03, 0xa4, 0xa5, 0xa6, 0xa7 },
+        { 0x80, 0x11, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27 },
+        { 0xfe, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe },
+        { 0x90, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07 },
+    };
+    for (uint8_t i = 0; i != 6; ++i) { ASSERT_TRUE(GNMNID::nodes.set(i, ids[i])); }
+
+    NAI::index_t index;
+    EXPECT_FALSE(index.isValid());
+    uint8_t out[8];
+    EXPECT_EQ(-1, index.getNextMatchingNodeID(0, nullptr, 0, out));
+    index.rebuild(GNMNID::nodes);
+    EXPECT_TRUE(index.isValid());
+    EXPECT_EQ(6, index.size());
+
+    uint8_t probes[8][8];
+    for (uint8_t i = 0; i != 6; ++i) { memcpy(probes[i], ids[i], 8); }
+    const uint8_t absent[8] = { 0x90, 0x01, 0x03, 0, 0, 0, 0, 0 };
+    memcpy(probes[6], absent, 8);
+    memset(probes[7], 0x00, 8);
+    for (uint8_t p = 0; p != 8; ++p) {
+        for (uint8_t len = 0; len <= 8; ++len) {
+            for (uint8_t start = 0; start != 9; ++start) {
+                uint8_t expectedID[8] = {}, actualID[8] = {};
+                const int8_t expected = GNMNID::getNextMatchingNodeID(start, probes[p], len, expectedID);
+                const int16_t actual = index.getNextMatchingNodeID(start, probes[p], len, actualID);
+                ASSERT_EQ(expected, actual) << int(p) << " " << int(len) << " " << int(start);
+                if (expected >= 0) { EXPECT_EQ(0, memcmp(expectedID, actualID, 8)); }
+            }
+        }
+    }
+    // Bad args.
+    EXPECT_EQ(-1, index.getNextMatchingNodeID(0, nullptr, 1, out));
+    EXPECT_EQ(-1, index.getNextMatchingNodeID(0, ids[0], 9, out));
+}
+
+// Test that incremental inserts keep the index consistent with the table.
+TEST(NodeAssociationIndex, InsertAndClear)
+{
+    GNMNID::nodes._reset();
+    NAI::index_t index;
+    // Inserts are ignored until the index is valid.
+    EXPECT_TRUE(index.insert(0, (const uint8_t *)"\x81\x82\x83\x84\x85\x86\x87\x88"));
+    EXPECT_EQ(0, index.size());
+    index.clear();
+    for (uint8_t i = 0; i != GNMNID::nodes.maxSets; ++i) {
+        uint8_t id[8];
+        memset(id, 0x80 + (7 - i), sizeof(id));
+        ASSERT_TRUE(GNMNID::nodes.set(i, id));
+        ASSERT_TRUE(index.insert(i, id));
+    }
+    const uint16_t maxSets = GNMNID::nodes.maxSets;
+    EXPECT_EQ(maxSets, index.size());
+    // Full.
+    EXPECT_FALSE(index.insert(0, (const uint8_t *)"\x81\x82\x83\x84\x85\x86\x87\x88"));
+    for (uint8_t i = 0; i != GNMNID::nodes.maxSets; ++i) {
+        uint8_t id[8];
+        memset(id, 0x80 + (7 - i), sizeof(id));
+        uint8_t out[8] = {};
+        EXPECT_EQ(i, index.getNextMatchingNodeID(0, id, 8, out));
+        EXPECT_EQ(0, memcmp(id, out, 8));
+        EXPECT_EQ(i, index.getNextMatchingNodeID(0, id, 1, nullptr));
+    }
+    index.clear();
+    EXPECT_EQ(0, index.size());
+    EXPECT_EQ(-1, index.getNextMatchingNodeID(0, nullptr, 0, nullptr));
+    index.invalidate();
+    EXPECT_FALSE(index.isValid());
+}
+
+// Test that a large host-side table and index find every entry, as
+// needed by concentrators with thousands of associations.
+TEST(NodeAssociationIndex, LargeHostTable)
+{
+    static constexpr uint16_t n = 4000;
+    typedef OTV0P2BASE::NodeAssociationTableRAM<n> table_t;
+    static table_t table;
+    static OTV0P2BASE::NodeAssociationIndex<table_t, n> index;
+    table._reset();
+    // Pseudo-random distinct IDs: top bit set, low bytes from the index.
+    for (uint16_t i = 0; i != n; ++i) {
+        uint8_t id[8];
+        const uint32_t h = (uint32_t(i) * 2654435761UL);
+        id[0] = uint8_t(0x80 | ((h >> 25) & 0x3f)); // Never 0xff.
+        id[1] = uint8_t(0x80 | (h >> 17));
+        id[2] = uint8_t(0x80 | (h >> 9));
+        id[3] = uint8_t(0x80 | (h >> 1));
+        id[4] = 0x80;
+        id[5] = 0x80;
+        id[6] = uint8_t(0x80 | (i >> 7));
+        id[7] = uint8_t(0x80 | (i & 0x7f));
+        ASSERT_TRUE(table.set(i, id));
+    }
+    index.rebuild(table);
+    ASSERT_EQ(n, index.size());
+    for (uint16_t i = 0; i != n; ++i) {
+        uint8_t id[8], out[8];
+        table.get(i, id);
+        ASSERT_EQ(int16_t(i), index.getNextMatchingNodeID(0, id, 8, out));
+        ASSERT_EQ(0, memcmp(id, out, 8));
+    }
+    // With no prefix every entry matches, so the start index is returned.
+    EXPECT_EQ(n - 2, index.getNextMatchingNodeID(n - 2, nullptr, 0, nullptr));
+    EXPECT_EQ(-1, index.getNextMatchingNodeID(n, nullptr, 0, nullptr));
+}